@@ -19,6 +19,10 @@ class Model
 private:
     std::vector<Vertex> m_vertices;
     std::vector<uint32_t> m_indicies;
+    // 模型本身（不包括地板）的包围盒和包围球，SetVertices 时统计，Reconstruct 后同步更新
+    XMFLOAT3 m_boundsMin = XMFLOAT3(0.f, 0.f, 0.f);
+    XMFLOAT3 m_boundsMax = XMFLOAT3(0.f, 0.f, 0.f);
+    XMFLOAT4 m_boundingSphere = XMFLOAT4(0.f, 0.f, 0.f, 0.f); // xyz 为球心，w 为半径
 
     void SetVertices(std::vector<std::array<double, 3>>&);
     void SetIndicies(std::vector<std::vector<uint32_t>>&);
@@ -35,6 +39,9 @@ public:
     std::vector<uint32_t> GetIndicies() const;
     uint32_t GetVerticesNum() const;
     uint32_t GetIndiciesNum() const;
+    // 用于剔除和阴影视锥拟合
+    void GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const;
+    void GetBoundingSphere(XMFLOAT3& center, float& radius) const;
 };
 
 #endif
\ No newline at end of file
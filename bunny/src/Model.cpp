@@ -3,6 +3,9 @@
 #include "path.h"
 #include <locale>
 #include <codecvt>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
 
 inline static std::string to_byte_string(const std::wstring& input)
 {
@@ -30,40 +33,35 @@ void Model::Reconstruct(bool addFloor)
 {
     if (m_vertices.size() == 0) return;
 
-    float maxX, minX, maxY, minY, maxZ, minZ;
-    maxX = minX = m_vertices[0].position.x;
-    maxY = minY = m_vertices[0].position.y;
-    maxZ = minZ = m_vertices[0].position.z;
-
-    for (int i = 1; i < m_vertices.size(); ++i)
+    // 包围盒在 SetVertices 中已经统计，这里只遍历一遍：p * scale + offset，同时求包围球半径
+    XMVECTOR boundsMin = XMLoadFloat3(&m_boundsMin);
+    XMVECTOR boundsMax = XMLoadFloat3(&m_boundsMax);
+    XMFLOAT3 extent;
+    XMStoreFloat3(&extent, XMVectorSubtract(boundsMax, boundsMin));
+    float range = std::max(extent.x, std::max(extent.y, extent.z)) / 2.f;
+    if (range <= 0.f) range = 1.f;
+
+    XMVECTOR scale = XMVectorReplicate(1.f / range);
+    XMVECTOR offset = XMVectorNegate(XMVectorMultiply(XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f), scale));
+    boundsMin = XMVectorMultiplyAdd(boundsMin, scale, offset);
+    boundsMax = XMVectorMultiplyAdd(boundsMax, scale, offset);
+    XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+
+    XMVECTOR maxDistanceSq = XMVectorZero();
+    for (auto& vertex: m_vertices)
     {
-        if (m_vertices[i].position.x > maxX) maxX = m_vertices[i].position.x;
-        if (m_vertices[i].position.x < minX) minX = m_vertices[i].position.x;
-        if (m_vertices[i].position.y > maxY) maxY = m_vertices[i].position.y;
-        if (m_vertices[i].position.y < minY) minY = m_vertices[i].position.y;
-        if (m_vertices[i].position.z > maxZ) maxZ = m_vertices[i].position.z;
-        if (m_vertices[i].position.z < minZ) minZ = m_vertices[i].position.z;
+        XMVECTOR position = XMVectorMultiplyAdd(XMLoadFloat3(&vertex.position), scale, offset);
+        XMStoreFloat3(&vertex.position, position);
+        maxDistanceSq = XMVectorMax(maxDistanceSq, XMVector3LengthSq(XMVectorSubtract(position, center)));
     }
 
-    float offsetX = (maxX + minX) / 2.;
-    float offsetY = (maxY + minY) / 2.;
-    float offsetZ = (maxZ + minZ) / 2.;
-
-    float rangeX = maxX - minX;
-    float rangeY = maxY - minY;
-    float rangeZ = maxZ - minZ;
-    float range = std::max(rangeX, std::max(rangeY, rangeZ)) / 2.;
-
-    for (int i = 0; i < m_vertices.size(); ++i)
-    {
-        m_vertices[i].position.x = (m_vertices[i].position.x - offsetX) / range;
-        m_vertices[i].position.y = (m_vertices[i].position.y - offsetY) / range;
-        m_vertices[i].position.z = (m_vertices[i].position.z - offsetZ) / range;
-    }
+    XMStoreFloat3(&m_boundsMin, boundsMin);
+    XMStoreFloat3(&m_boundsMax, boundsMax);
+    XMStoreFloat4(&m_boundingSphere, XMVectorSetW(center, std::sqrt(XMVectorGetX(maxDistanceSq))));
 
     if (addFloor)
     {
-        minY = (minY - offsetY) / range;
+        float minY = m_boundsMin.y;
         m_vertices.push_back(Vertex{XMFLOAT3( 2.f, minY, -2.f), XMFLOAT3(0.f, 0.f, 0.f)});
         auto indexA = m_vertices.size() - 1;
         m_vertices.push_back(Vertex{XMFLOAT3( 2.f, minY,  2.f), XMFLOAT3(0.f, 0.f, 0.f)});
@@ -80,6 +78,8 @@ void Model::Reconstruct(bool addFloor)
 void Model::SetVertices(std::vector<std::array<double, 3>>& positions)
 {
     m_vertices.resize(positions.size());
+    XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+    XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
     for (int i = 0; i < m_vertices.size(); ++i)
     {
         m_vertices[i] = Vertex{
@@ -87,7 +87,13 @@ void Model::SetVertices(std::vector<std::array<double, 3>>& positions)
             XMFLOAT3(0.f, 0.f, 0.f),                                     // normal
             // XMFLOAT4(1.f, 1.f, 1.f, 1.f),                                // color
         };
+        // 转换的同时统计包围盒，Reconstruct 不必再扫一遍
+        XMVECTOR position = XMLoadFloat3(&m_vertices[i].position);
+        boundsMin = XMVectorMin(boundsMin, position);
+        boundsMax = XMVectorMax(boundsMax, position);
     }
+    XMStoreFloat3(&m_boundsMin, boundsMin);
+    XMStoreFloat3(&m_boundsMax, boundsMax);
 }
 
 // cut a polygon to several triangles
@@ -187,4 +193,14 @@ uint32_t Model::GetVerticesNum() const
 uint32_t Model::GetIndiciesNum() const
 {
     return m_indicies.size();
+}
+void Model::GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const
+{
+    boundsMin = m_boundsMin;
+    boundsMax = m_boundsMax;
+}
+void Model::GetBoundingSphere(XMFLOAT3& center, float& radius) const
+{
+    center = XMFLOAT3(m_boundingSphere.x, m_boundingSphere.y, m_boundingSphere.z);
+    radius = m_boundingSphere.w;
 }
\ No newline at end of file
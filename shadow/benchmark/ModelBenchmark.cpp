@@ -0,0 +1,1697 @@
+// Model loading benchmark.
+// cmake -S . -B build -DBUILD_BENCHMARK=ON && cmake --build build --target modelbenchmark
+// usage: modelbenchmark [model file (.obj/.ply)] [iterations]
+//        modelbenchmark --memory <model name in model_path>   (peak resident memory of one uncached Model load)
+//        modelbenchmark --simplify <n>                          (LOD chain of a generated n x n vertex height field)
+//        modelbenchmark --normals <copies>                      (vertex normals of bun_zipper repeated copies times)
+//        modelbenchmark --stream <model name in model_path>     (streamed upload through a small ring on the stand-in device)
+//        modelbenchmark --tangents <copies>                     (tangent frames of african_head repeated copies times)
+//        modelbenchmark --batch <copies>                        (every model in model_path loaded copies times as one batch)
+//        modelbenchmark --allocations <model file (.obj)>       (global heap allocations of the OBJ paths with and without the arenas)
+//        modelbenchmark --bvh <copies>                          (BVH build and ray queries on bun_zipper / african_head repeated copies times)
+//        modelbenchmark --codec <copies>                        (index / vertex buffer compression on bun_zipper / african_head repeated copies times)
+//        modelbenchmark --tga <size>                            (TGA decode of african_head_diffuse tiled to size x size, raw / RLE, 24 / 32 bpp)
+//        modelbenchmark --reconstruct <copies>                  (position bounds + scale-offset reconstruct on bun_zipper repeated copies times)
+#include "common/ObjHelper.h"
+#include "common/PlyHelper.h"
+#include "common/BinaryPly.h"
+#include "common/MappedFile.h"
+#include "common/MeshOptimizer.h"
+#include "common/VertexQuantizer.h"
+#include "common/MeshletBuilder.h"
+#include "common/MeshSimplifier.h"
+#include "common/MeshNormals.h"
+#include "common/MeshTangents.h"
+#include "common/MeshBounds.h"
+#include "common/UploadRing.h"
+#include "common/BatchLoader.h"
+#include "common/Hash.h"
+#include "common/Arena.h"
+#include "common/MeshBvh.h"
+#include "common/MeshCodec.h"
+#include "common/TgaDecoder.h"
+#include "Model.h"
+#include "StreamingMesh.h"
+#include "path.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Allocation tracking hook: the global operator new of the benchmark counts calls and bytes while
+// enabled, to see what the loaders still take from the global heap
+namespace AllocationTracking
+{
+    std::atomic<bool> g_enabled{false};
+    std::atomic<uint64_t> g_count{0};
+    std::atomic<uint64_t> g_bytes{0};
+}
+
+#if defined(_MSC_VER)
+#define ALLOCATION_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#endif
+
+// Every replaced operator new goes through Allocate and every operator delete through Free, plain
+// and aligned memory each with its matching release. They are not inlined, so the compiler does not
+// pair a malloc it sees in one operator with a free in another (GCC -Wmismatched-new-delete).
+namespace AllocationTracking
+{
+    inline void Count(size_t size)
+    {
+        if (!g_enabled.load(std::memory_order_relaxed)) return;
+        g_count.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    // alignment 0 = the default new alignment. nullptr when out of memory
+    ALLOCATION_NOINLINE void* Allocate(size_t size, size_t alignment) noexcept
+    {
+        Count(size);
+        size = std::max<size_t>(size, 1);
+        if (alignment == 0) return std::malloc(size);
+#ifdef _WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    ALLOCATION_NOINLINE void Free(void* p, bool aligned) noexcept
+    {
+#ifdef _WIN32
+        if (aligned)
+        {
+            _aligned_free(p);
+            return;
+        }
+#else
+        (void)aligned;
+#endif
+        std::free(p);
+    }
+
+    inline void* AllocateOrThrow(size_t size, size_t alignment)
+    {
+        void* p = Allocate(size, alignment);
+        if (p == nullptr) throw std::bad_alloc();
+        return p;
+    }
+}
+
+void* operator new(size_t size) { return AllocationTracking::AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocationTracking::AllocateOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return AllocationTracking::Allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return AllocationTracking::Allocate(size, 0); }
+
+void operator delete(void* p) noexcept { AllocationTracking::Free(p, false); }
+void operator delete[](void* p) noexcept { AllocationTracking::Free(p, false); }
+void operator delete(void* p, size_t) noexcept { AllocationTracking::Free(p, false); }
+void operator delete[](void* p, size_t) noexcept { AllocationTracking::Free(p, false); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { AllocationTracking::Free(p, false); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { AllocationTracking::Free(p, false); }
+
+// std::pmr::new_delete_resource allocates through the aligned forms
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return AllocationTracking::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return AllocationTracking::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocationTracking::Allocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocationTracking::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { AllocationTracking::Free(p, true); }
+void operator delete[](void* p, std::align_val_t) noexcept { AllocationTracking::Free(p, true); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { AllocationTracking::Free(p, true); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { AllocationTracking::Free(p, true); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { AllocationTracking::Free(p, true); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { AllocationTracking::Free(p, true); }
+
+namespace
+{
+    // 进程启动以来的峰值常驻内存
+    size_t PeakResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    double MeasureSeconds(int iterations, const std::function<void()>& func)
+    {
+        // warm up the file cache
+        func();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            func();
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(t1 - t0).count() / iterations;
+    }
+
+    using ObjLoader = ObjHelper::ObjLoader<>;
+
+    bool SameObjOutput(ObjLoader& a, ObjLoader& b)
+    {
+        if (a.GetverticesPosition() != b.GetverticesPosition()) return false;
+        if (a.GetVerticesNormal() != b.GetVerticesNormal()) return false;
+        if (a.GetVerticesUVW() != b.GetVerticesUVW()) return false;
+
+        auto& facesA = a.GetFaces();
+        auto& facesB = b.GetFaces();
+        if (facesA.size() != facesB.size()) return false;
+        for (size_t i = 0; i < facesA.size(); i++)
+        {
+            if (facesA[i].positionIndex != facesB[i].positionIndex ||
+                facesA[i].normalIndex != facesB[i].normalIndex ||
+                facesA[i].uvwIndex != facesB[i].uvwIndex)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BenchObjParse(std::string& filePath, int iterations)
+    {
+        using ObjHelper::ParseMode;
+
+        double megaBytes = Util::MappedFile(filePath).Size() / (1024. * 1024.);
+
+        std::printf("OBJ parse: %s (%.2f MB, %u threads)\n", filePath.c_str(), megaBytes, Util::WorkerCount());
+        const std::pair<const char*, ParseMode> modes[] = {
+            { "stream", ParseMode::Stream },
+            { "mapped", ParseMode::Mapped },
+            { "parallel", ParseMode::Parallel },
+        };
+        for (auto& mode: modes)
+        {
+            double seconds = MeasureSeconds(iterations, [&]() { ObjLoader loader(filePath, mode.second); });
+            std::printf("  %-8s %9.3f ms  %8.2f MB/s\n", mode.first, seconds * 1e3, megaBytes / seconds);
+        }
+
+        ObjLoader reference(filePath, ParseMode::Stream);
+        ObjLoader mapped(filePath, ParseMode::Mapped);
+        ObjLoader parallel(filePath, ParseMode::Parallel);
+        std::printf("  output %s\n",
+            SameObjOutput(reference, mapped) && SameObjOutput(reference, parallel) ? "identical" : "MISMATCH");
+
+        // 多余的分量（w、顶点颜色、第 4 个纹理坐标）在三种模式下都忽略
+        const char* extraPath = "extra_components.obj";
+        {
+            std::FILE* file = std::fopen(extraPath, "wb");
+            if (file == nullptr) throw std::runtime_error("cannot write extra_components.obj");
+            std::fputs("v 0 0 0 1 0 0\nv 1 0 0 0.5 0.5 0.5\nv 0 1 0 1\nv 1 1 0\n"
+                "vn 0 0 1 0\nvt 0 0\nvt 1 0 0 0\n"
+                "f 1/1/1 2/2/1 3/1/1\nf 2//1 4//1 3//1\n", file);
+            std::fclose(file);
+        }
+        ObjLoader extraReference(extraPath, ParseMode::Stream);
+        ObjLoader extraMapped(extraPath, ParseMode::Mapped);
+        ObjLoader extraParallel(extraPath, ParseMode::Parallel);
+        bool extraSame = extraReference.GetverticesPosition().size() == 4 &&
+            SameObjOutput(extraReference, extraMapped) && SameObjOutput(extraReference, extraParallel);
+        std::printf("  extra components (v x y z r g b) %s\n", extraSame ? "identical" : "MISMATCH");
+    }
+
+    // The repo only ships ascii PLY files, so binary copies are written next to the executable first.
+    void BenchPlyParse(std::string& filePath, int iterations)
+    {
+        happly::PLYData source(filePath);
+        auto referencePositions = source.getVertexPositions();
+        std::vector<uint32_t> referenceIndicies;
+        for (auto& face: source.getFaceIndices<uint32_t>())
+        {
+            for (size_t i2 = 2; i2 < face.size(); i2++)
+            {
+                referenceIndicies.insert(referenceIndicies.end(), {face[0], face[i2 - 1], face[i2]});
+            }
+        }
+
+        const std::pair<const char*, happly::DataFormat> formats[] = {
+            { "binary_little_endian.ply", happly::DataFormat::Binary },
+            { "binary_big_endian.ply", happly::DataFormat::BinaryBigEndian },
+        };
+        for (auto& format: formats)
+        {
+            std::string binaryPath = format.first;
+            source.write(binaryPath, format.second);
+            double megaBytes = Util::MappedFile(binaryPath).Size() / (1024. * 1024.);
+            std::printf("PLY parse: %s as %s (%.2f MB)\n", filePath.c_str(), format.first, megaBytes);
+
+            double happlySeconds = MeasureSeconds(iterations, [&]()
+            {
+                happly::PLYData plyIn(binaryPath);
+                plyIn.getVertexPositions();
+                plyIn.getFaceIndices<uint32_t>();
+            });
+            std::vector<std::array<double, 3>> positions;
+            std::vector<uint32_t> indicies;
+            double fastSeconds = MeasureSeconds(iterations, [&]() { BinaryPly::Load(binaryPath, positions, indicies); });
+            std::vector<std::array<float, 3>> floatPositions;
+            std::vector<uint32_t> floatIndicies;
+            double floatSeconds = MeasureSeconds(iterations, [&]() { BinaryPly::Load(binaryPath, floatPositions, floatIndicies); });
+
+            std::printf("  %-8s %9.3f ms  %8.2f MB/s\n", "happly", happlySeconds * 1e3, megaBytes / happlySeconds);
+            std::printf("  %-8s %9.3f ms  %8.2f MB/s\n", "binary", fastSeconds * 1e3, megaBytes / fastSeconds);
+            std::printf("  %-8s %9.3f ms  %8.2f MB/s\n", "binary32", floatSeconds * 1e3, megaBytes / floatSeconds);
+            std::printf("  output %s\n", positions == referencePositions && indicies == referenceIndicies ? "identical" : "MISMATCH");
+        }
+    }
+
+    // full Model construction: parse + reconstruct + normals, versus mapping the .meshcache
+    void BenchModelLoad(const std::wstring& modelName, ModelType type, bool reconstruct, int iterations)
+    {
+        // make sure the cache exists and is up to date
+        Model warmUp(modelName, type, reconstruct, true);
+
+        double coldSeconds = MeasureSeconds(iterations, [&]() { Model model(modelName, type, reconstruct, false); });
+        double cachedSeconds = MeasureSeconds(iterations, [&]() { Model model(modelName, type, reconstruct, true); });
+
+        std::printf("Model load: %s (%u vertices, %u indicies)\n",
+            Util::ToByteString(modelName).c_str(), warmUp.GetVerticesNum(), warmUp.GetIndiciesNum());
+        std::printf("  %-8s %9.3f ms\n", "parse", coldSeconds * 1e3);
+        std::printf("  %-8s %9.3f ms  (%.1fx)\n", "cached", cachedSeconds * 1e3, coldSeconds / cachedSeconds);
+        std::printf("  index buffer %u-bit, %zu submeshes, %.1f KB (32-bit %.1f KB)\n",
+            warmUp.GetIndexStride() * 8, warmUp.GetSubmeshes().size(),
+            warmUp.GetIndiciesNum() * warmUp.GetIndexStride() / 1024., warmUp.GetIndiciesNum() * sizeof(uint32_t) / 1024.);
+    }
+
+    // one vertex per face corner (the old OBJ path) versus one per unique v/vt/vn triple
+    void BenchObjWeld(const std::wstring& modelName)
+    {
+        std::wstring filePath = std::wstring(model_path) + modelName;
+        ObjLoader obj(Util::ToByteString(filePath));
+        size_t corners = 0;
+        for (auto& face: obj.GetFaces())
+        {
+            corners += face.positionIndex.size();
+        }
+
+        auto loader = ModelLoader<>::CreateModelLoader(ModelType::OBJ);
+        loader->LoadFromFile(filePath);
+        size_t welded = loader->GetPositions().size();
+
+        std::printf("OBJ weld: %s (%zu v, %zu vt, %zu vn)\n", Util::ToByteString(modelName).c_str(),
+            obj.GetverticesPosition().size(), obj.GetVerticesUVW().size(), obj.GetVerticesNormal().size());
+        std::printf("  %-8s %9zu vertices  %10.1f KB\n", "corners", corners, corners * sizeof(Vertex) / 1024.);
+        std::printf("  %-8s %9zu vertices  %10.1f KB  (%.2fx fewer)\n", "welded", welded, welded * sizeof(Vertex) / 1024.,
+            static_cast<double>(corners) / welded);
+    }
+
+    // ACMR/ATVR of the loader's triangle order versus the vertex cache optimized order
+    void BenchVertexCache(const std::wstring& modelName, ModelType type)
+    {
+        using namespace MeshOptimizer;
+
+        auto loader = ModelLoader<>::CreateModelLoader(type);
+        std::wstring filePath = std::wstring(model_path) + modelName;
+        loader->LoadFromFile(filePath);
+        size_t vertexCount = loader->GetPositions().size();
+        auto original = loader->TakeIndicies();
+
+        std::vector<uint32_t> optimized;
+        double seconds = MeasureSeconds(1, [&]()
+        {
+            optimized = original;
+            OptimizeVertexCache(optimized.data(), optimized.size(), vertexCount);
+        });
+
+        std::printf("Vertex cache: %s (%zu vertices, %zu triangles, optimized in %.3f ms)\n",
+            Util::ToByteString(modelName).c_str(), vertexCount, original.size() / 3, seconds * 1e3);
+        std::printf("  %-10s %14s %14s\n", "cache", "ACMR", "ATVR");
+        const std::pair<const char*, CacheType> types[] = { { "FIFO", CacheType::FIFO }, { "LRU", CacheType::LRU } };
+        for (auto& cacheType: types)
+        {
+            for (uint32_t cacheSize: {8u, 16u, 32u, 64u})
+            {
+                auto before = SimulateVertexCache(original.data(), original.size(), vertexCount, cacheType.second, cacheSize);
+                auto after = SimulateVertexCache(optimized.data(), optimized.size(), vertexCount, cacheType.second, cacheSize);
+                std::printf("  %-4s %-5u %6.3f->%6.3f %6.3f->%6.3f\n", cacheType.first, cacheSize,
+                    before.acmr, after.acmr, before.atvr, after.atvr);
+            }
+        }
+    }
+
+    // cache line bytes the vertex fetch touches, at the stride of the Model vertex buffer
+    void BenchVertexFetch(const std::wstring& modelName, ModelType type)
+    {
+        using namespace MeshOptimizer;
+
+        auto loader = ModelLoader<>::CreateModelLoader(type);
+        std::wstring filePath = std::wstring(model_path) + modelName;
+        loader->LoadFromFile(filePath);
+        auto positions = loader->GetPositions();
+        size_t vertexCount = positions.size();
+        const float* positionData = positions.data()->data();
+        const size_t positionStride = sizeof(positions[0]);
+        const size_t stride = sizeof(Vertex);
+
+        std::printf("Vertex fetch: %s (%zu vertices, %zu B stride)\n", Util::ToByteString(modelName).c_str(), vertexCount, stride);
+        std::printf("  %-22s %12s %10s %10s\n", "order", "B/triangle", "overfetch", "ACMR LRU32");
+        auto report = [&](const char* name, const std::vector<uint32_t>& indicies)
+        {
+            auto fetch = AnalyzeVertexFetch(indicies.data(), indicies.size(), vertexCount, stride);
+            auto cache = SimulateVertexCache(indicies.data(), indicies.size(), vertexCount, CacheType::LRU, 32);
+            std::printf("  %-22s %12.1f %10.2f %10.3f\n", name, fetch.bytesPerTriangle, fetch.overfetch, cache.acmr);
+        };
+
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint32_t> indicies(loader->GetIndicies().begin(), loader->GetIndicies().end());
+        report("file", indicies);
+
+        OptimizeVertexCache(indicies.data(), indicies.size(), vertexCount);
+        report("vertex cache", indicies);
+
+        OptimizeVertexFetchRemap(remap.data(), indicies.data(), indicies.size(), vertexCount);
+        RemapIndexBuffer(indicies.data(), indicies.size(), remap.data());
+        report("vertex cache + fetch", indicies);
+
+        // Morton pre-sort; positions stay in file order, so the triangle sort looks them up through the inverse map
+        std::vector<uint32_t> sorted(loader->GetIndicies().begin(), loader->GetIndicies().end());
+        std::vector<std::array<float, 3>> sortedPositions(vertexCount);
+        SpatialSortRemap(remap.data(), positionData, vertexCount, positionStride);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            sortedPositions[remap[v]] = positions[v];
+        }
+        RemapIndexBuffer(sorted.data(), sorted.size(), remap.data());
+        SpatialSortTriangles(sorted.data(), sorted.size(), sortedPositions.data()->data(), vertexCount, positionStride);
+        OptimizeVertexCache(sorted.data(), sorted.size(), vertexCount);
+        OptimizeVertexFetchRemap(remap.data(), sorted.data(), sorted.size(), vertexCount);
+        RemapIndexBuffer(sorted.data(), sorted.size(), remap.data());
+        report("morton + cache + fetch", sorted);
+    }
+
+    // estimated pixel shader invocations per covered pixel, and what the cluster sort costs the vertex cache
+    void BenchOverdraw(const std::wstring& modelName, ModelType type, bool reconstruct)
+    {
+        using namespace MeshOptimizer;
+
+        auto loader = ModelLoader<>::CreateModelLoader(type);
+        std::wstring filePath = std::wstring(model_path) + modelName;
+        loader->LoadFromFile(filePath);
+        if (reconstruct) loader->Reconstruct();
+        auto positions = loader->GetPositions();
+        size_t vertexCount = positions.size();
+        const float* positionData = positions.data()->data();
+        const size_t positionStride = sizeof(positions[0]);
+
+        std::printf("Overdraw: %s (%zu triangles)\n", Util::ToByteString(modelName).c_str(), loader->GetIndicies().size() / 3);
+        std::printf("  %-22s %10s %10s\n", "order", "overdraw", "ACMR FIFO16");
+        auto report = [&](const char* name, const std::vector<uint32_t>& indicies)
+        {
+            auto overdraw = AnalyzeOverdraw(indicies.data(), indicies.size(), positionData, vertexCount, positionStride);
+            auto cache = SimulateVertexCache(indicies.data(), indicies.size(), vertexCount, CacheType::FIFO, 16);
+            std::printf("  %-22s %10.3f %10.3f\n", name, overdraw.overdraw, cache.acmr);
+        };
+
+        std::vector<uint32_t> indicies(loader->GetIndicies().begin(), loader->GetIndicies().end());
+        report("file", indicies);
+        OptimizeVertexCache(indicies.data(), indicies.size(), vertexCount);
+        report("vertex cache", indicies);
+
+        for (float threshold: {1.05f, 1.2f})
+        {
+            auto sorted = indicies;
+            double seconds = MeasureSeconds(1, [&]()
+            {
+                sorted = indicies;
+                OptimizeOverdraw(sorted.data(), sorted.size(), positionData, vertexCount, positionStride, threshold);
+            });
+            char name[64];
+            std::snprintf(name, sizeof(name), "overdraw %.2f (%.1f ms)", threshold, seconds * 1e3);
+            report(name, sorted);
+        }
+    }
+
+    // GPU vertex size, encode/decode speed and round-trip error of the quantized vertex format
+    void BenchVertexQuantization(const std::wstring& modelName, ModelType type, bool reconstruct, int iterations)
+    {
+        using namespace VertexQuantizer;
+
+        Model model(modelName, type, reconstruct, false);
+        auto vertices = model.GetVertices();
+        size_t vertexCount = vertices.size();
+        const float* positions = &vertices[0].position.x;
+        const float* normals = &vertices[0].normal.x;
+        const float* uvs = &vertices[0].uv.x;
+
+        auto params = ComputeQuantization(positions, vertexCount, sizeof(Vertex));
+        std::vector<QuantizedVertex> quantized(vertexCount);
+        std::vector<Vertex> decoded(vertexCount);
+        double encodeSeconds = MeasureSeconds(iterations, [&]()
+        {
+            Encode(quantized.data(), positions, normals, uvs, vertexCount, sizeof(Vertex), params);
+        });
+        double decodeSeconds = MeasureSeconds(iterations, [&]()
+        {
+            Decode(&decoded[0].position.x, &decoded[0].normal.x, &decoded[0].uv.x, sizeof(Vertex), quantized.data(), vertexCount, params);
+        });
+        auto error = MeasureError(quantized.data(), positions, normals, uvs, vertexCount, sizeof(Vertex), params);
+        double extent = 2. * std::max(params.scale[0], std::max(params.scale[1], params.scale[2]));
+
+        std::printf("Vertex quantization: %s (%zu vertices)\n", Util::ToByteString(modelName).c_str(), vertexCount);
+        std::printf("  vertex size  %zu -> %zu B  (%.1f -> %.1f KB)\n", sizeof(Vertex), sizeof(QuantizedVertex),
+            vertexCount * sizeof(Vertex) / 1024., vertexCount * sizeof(QuantizedVertex) / 1024.);
+        std::printf("  encode   %8.3f ms  (%.0f M vertices/s)\n", encodeSeconds * 1e3, vertexCount / encodeSeconds * 1e-6);
+        std::printf("  decode   %8.3f ms  (%.0f M vertices/s)\n", decodeSeconds * 1e3, vertexCount / decodeSeconds * 1e-6);
+        std::printf("  position max %.3g rms %.3g  (max %.2g of the largest extent)\n",
+            error.positionMax, error.positionRms, error.positionMax / extent);
+        std::printf("  normal   max %.4f deg mean %.4f deg\n", error.normalMaxDegrees, error.normalMeanDegrees);
+        std::printf("  uv       max %.3g rms %.3g\n", error.uvMax, error.uvRms);
+    }
+
+    // meshlet build time, fill rate and normal cone spread on the final (cache optimized) index buffer
+    void BenchMeshlets(const std::wstring& modelName, ModelType type, bool reconstruct, int iterations)
+    {
+        using namespace MeshletBuilder;
+
+        Model model(modelName, type, reconstruct, false);
+        auto vertices = model.GetVertices();
+        auto indicies = model.GetIndicies();
+        // 去掉 AddFloor 加在最后的两个三角形
+        size_t indexCount = indicies.size() - 6;
+        const float* positions = &vertices[0].position.x;
+
+        MeshletData data;
+        double seconds = MeasureSeconds(iterations, [&]()
+        {
+            data = Build(indicies.data(), indexCount, positions, vertices.size(), sizeof(Vertex));
+        });
+        auto stats = Analyze(data);
+
+        // every triangle of the index buffer appears exactly once
+        std::vector<uint32_t> expected(indicies.begin(), indicies.begin() + indexCount);
+        std::vector<uint32_t> actual;
+        actual.reserve(indexCount);
+        for (auto& meshlet: data.meshlets)
+        {
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+            {
+                actual.push_back(data.vertices[meshlet.vertexOffset + data.triangles[meshlet.triangleOffset + i]]);
+            }
+        }
+        auto sortTriangles = [](std::vector<uint32_t>& list)
+        {
+            std::vector<std::array<uint32_t, 3>> triangles(list.size() / 3);
+            std::memcpy(triangles.data(), list.data(), triangles.size() * sizeof(triangles[0]));
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        };
+
+        std::printf("Meshlets: %s (%zu triangles)\n", Util::ToByteString(modelName).c_str(), indexCount / 3);
+        std::printf("  build    %8.3f ms  (%.1f ms per M triangles)  %s\n", seconds * 1e3, seconds * 1e3 / (indexCount / 3 * 1e-6),
+            sortTriangles(expected) == sortTriangles(actual) ? "ok" : "MISMATCH");
+        std::printf("  meshlets %zu, fill %.1f%% vertices %.1f%% triangles, average radius %.4g\n",
+            stats.meshletCount, stats.vertexFill * 100., stats.triangleFill * 100., stats.averageRadius);
+        std::printf("  cone half angle ");
+        for (int i = 0; i < 6; i++)
+        {
+            std::printf(" <%d: %u", (i + 1) * 15, stats.coneHistogram[i]);
+        }
+        std::printf("  none: %u\n", stats.coneHistogram[6]);
+        std::printf("  backface culled %.1f%% (average over axis / diagonal views)\n", stats.coneCulled * 100.);
+    }
+
+    const float S_LOD_RATIOS[] = {0.5f, 0.25f, 0.1f, 0.05f, 0.01f};
+
+    void ReportLods(Util::Span<const MeshSimplifier::LodLevel> lods, double extent)
+    {
+        std::printf("  %-8s %10s %12s %10s\n", "ratio", "triangles", "error", "of size");
+        for (size_t i = 0; i < lods.size(); i++)
+        {
+            std::printf("  %-8.2f %10zu %12.4g %9.3f%%\n", S_LOD_RATIOS[i], lods[i].indicies.size() / 3,
+                lods[i].error, lods[i].error / extent * 100.);
+        }
+    }
+
+    // LOD chain of the processed model, triangle count and estimated error per level
+    void BenchSimplify(const std::wstring& modelName, ModelType type, bool reconstruct)
+    {
+        Model model(modelName, type, reconstruct, false);
+        std::vector<float> ratios(std::begin(S_LOD_RATIOS), std::end(S_LOD_RATIOS));
+        auto t0 = std::chrono::high_resolution_clock::now();
+        model.GenerateLods(ratios);
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+
+        XMFLOAT3 boundsMin, boundsMax;
+        model.GetBounds(boundsMin, boundsMax);
+        double extent = std::max(boundsMax.x - boundsMin.x, std::max(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+        size_t triangleCount = (model.GetIndiciesNum() - 6) / 3;
+        std::printf("Simplify: %s (%zu triangles, %.1f ms)\n", Util::ToByteString(modelName).c_str(), triangleCount, seconds * 1e3);
+        ReportLods(model.GetLods(), extent);
+    }
+
+    // n x n vertex height field, for inputs larger than the bundled models
+    void BenchSimplifyGrid(size_t n)
+    {
+        std::vector<Vertex> vertices(n * n);
+        for (size_t y = 0; y < n; y++)
+        {
+            for (size_t x = 0; x < n; x++)
+            {
+                float u = static_cast<float>(x) / (n - 1), v = static_cast<float>(y) / (n - 1);
+                vertices[y * n + x] = Vertex{XMFLOAT3(u, 0.05f * std::sin(u * 40.f) * std::cos(v * 25.f), v), XMFLOAT3(0.f, 1.f, 0.f), XMFLOAT2(u, v)};
+            }
+        }
+        std::vector<uint32_t> indicies;
+        indicies.reserve((n - 1) * (n - 1) * 6);
+        for (size_t y = 0; y + 1 < n; y++)
+        {
+            for (size_t x = 0; x + 1 < n; x++)
+            {
+                auto a = static_cast<uint32_t>(y * n + x);
+                auto b = a + static_cast<uint32_t>(n);
+                indicies.insert(indicies.end(), {a, b, a + 1, a + 1, b, b + 1});
+            }
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        auto lods = MeshSimplifier::GenerateLods(indicies.data(), indicies.size(), &vertices[0].position.x, &vertices[0].normal.x,
+            &vertices[0].uv.x, vertices.size(), sizeof(Vertex), S_LOD_RATIOS, std::size(S_LOD_RATIOS));
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        std::printf("Simplify: %zux%zu grid (%zu triangles, %.1f ms, %.2f s per 10M triangles)\n", n, n, indicies.size() / 3,
+            seconds * 1e3, seconds / (indicies.size() / 3) * 1e7);
+        ReportLods(lods, 1.);
+    }
+
+    // Vertex normals of bun_zipper repeated side by side copies times: the serial scatter loop Model used
+    // before, against the adjacency gather with both weightings
+    void BenchNormals(int copies, int iterations)
+    {
+        using namespace MeshNormals;
+
+        auto loader = ModelLoader<>::CreateModelLoader(ModelType::PLY);
+        std::wstring filePath = std::wstring(model_path) + L"bun_zipper.ply";
+        loader->LoadFromFile(filePath);
+        loader->Reconstruct();
+        auto sourcePositions = loader->GetPositions();
+        auto sourceIndicies = loader->GetIndicies();
+
+        std::vector<Vertex> vertices(sourcePositions.size() * copies);
+        std::vector<uint32_t> indicies(sourceIndicies.size() * copies);
+        for (int c = 0; c < copies; c++)
+        {
+            size_t vertexBase = sourcePositions.size() * c;
+            for (size_t v = 0; v < sourcePositions.size(); v++)
+            {
+                auto& p = sourcePositions[v];
+                vertices[vertexBase + v].position = XMFLOAT3(p[0] + 2.f * c, p[1], p[2]);
+            }
+            for (size_t i = 0; i < sourceIndicies.size(); i++)
+            {
+                indicies[sourceIndicies.size() * c + i] = static_cast<uint32_t>(vertexBase + sourceIndicies[i]);
+            }
+        }
+        size_t triangleCount = indicies.size() / 3;
+
+        double scatterSeconds = MeasureSeconds(iterations, [&]()
+        {
+            for (auto& vertex: vertices) vertex.normal = XMFLOAT3(0.f, 0.f, 0.f);
+            for (size_t i = 0; i + 2 < indicies.size(); i += 3)
+            {
+                XMVECTOR a = XMLoadFloat3(&vertices[indicies[i]].position);
+                XMVECTOR normal = XMVector3Cross(XMLoadFloat3(&vertices[indicies[i + 1]].position) - a,
+                    XMLoadFloat3(&vertices[indicies[i + 2]].position) - a);
+                for (int k = 0; k < 3; k++)
+                {
+                    XMFLOAT3& n = vertices[indicies[i + k]].normal;
+                    XMStoreFloat3(&n, XMLoadFloat3(&n) + normal);
+                }
+            }
+            for (auto& vertex: vertices) XMStoreFloat3(&vertex.normal, XMVector3Normalize(XMLoadFloat3(&vertex.normal)));
+        });
+        std::vector<XMFLOAT3> reference(vertices.size());
+        for (size_t v = 0; v < vertices.size(); v++) reference[v] = vertices[v].normal;
+
+        Adjacency adjacency;
+        double adjacencySeconds = MeasureSeconds(iterations, [&]()
+        {
+            adjacency = BuildAdjacency(indicies.data(), indicies.size(), vertices.size());
+        });
+
+        std::printf("Vertex normals: bun_zipper.ply x%d (%zu vertices, %zu triangles, %u threads)\n",
+            copies, vertices.size(), triangleCount, Util::WorkerCount());
+        std::printf("  %-16s %10.2f ms  (%.0f M triangles/s)\n", "scatter (serial)", scatterSeconds * 1e3, triangleCount / scatterSeconds * 1e-6);
+        std::printf("  %-16s %10.2f ms\n", "adjacency", adjacencySeconds * 1e3);
+        for (auto weighting: {Weighting::Area, Weighting::Angle})
+        {
+            double seconds = MeasureSeconds(iterations, [&]()
+            {
+                ComputeNormals(&vertices[0].normal.x, &vertices[0].position.x, vertices.size(), sizeof(Vertex),
+                    indicies.data(), indicies.size(), adjacency, weighting);
+            });
+            double maxDegrees = 0.;
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                // unreferenced vertices keep a zero normal in both
+                if (reference[v].x == 0.f && reference[v].y == 0.f && reference[v].z == 0.f) continue;
+                float cosine = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&vertices[v].normal), XMLoadFloat3(&reference[v])));
+                maxDegrees = std::max(maxDegrees, std::acos(std::min(1.f, cosine)) * 180. / XM_PI);
+            }
+            std::printf("  %-16s %10.2f ms  (%.0f M triangles/s, %.1fx, max %.3g deg from scatter)\n",
+                weighting == Weighting::Area ? "gather area" : "gather angle", seconds * 1e3, triangleCount / seconds * 1e-6,
+                scatterSeconds / seconds, maxDegrees);
+        }
+    }
+
+    // Tangent frames of african_head repeated side by side copies times: the serial per triangle scatter
+    // (Lengyel) without any seam handling, against the mirrored split + parallel adjacency gather, and
+    // the scalar against the SIMD 10:10:10:2 packing
+    void BenchTangents(int copies, int iterations)
+    {
+        using namespace MeshTangents;
+
+        Model model(L"african_head.obj", ModelType::OBJ, false, false);
+        auto sourceVertices = model.GetVertices();
+        auto sourceIndicies = model.GetIndicies();
+        // 去掉 AddFloor 加在最后的两个三角形和四个顶点
+        size_t sourceVertexCount = sourceVertices.size() - 4;
+        size_t sourceIndexCount = sourceIndicies.size() - 6;
+
+        std::vector<Vertex> vertices(sourceVertexCount * copies);
+        std::vector<uint32_t> indicies(sourceIndexCount * copies);
+        for (int c = 0; c < copies; c++)
+        {
+            size_t vertexBase = sourceVertexCount * c;
+            for (size_t v = 0; v < sourceVertexCount; v++)
+            {
+                vertices[vertexBase + v] = sourceVertices[v];
+                vertices[vertexBase + v].position.x += 2.f * c;
+            }
+            for (size_t i = 0; i < sourceIndexCount; i++)
+            {
+                indicies[sourceIndexCount * c + i] = static_cast<uint32_t>(vertexBase + sourceIndicies[i]);
+            }
+        }
+        size_t triangleCount = indicies.size() / 3;
+
+        std::vector<XMFLOAT3> reference(vertices.size());
+        double scatterSeconds = MeasureSeconds(iterations, [&]()
+        {
+            std::fill(reference.begin(), reference.end(), XMFLOAT3(0.f, 0.f, 0.f));
+            for (size_t i = 0; i + 2 < indicies.size(); i += 3)
+            {
+                auto& v0 = vertices[indicies[i]];
+                auto& v1 = vertices[indicies[i + 1]];
+                auto& v2 = vertices[indicies[i + 2]];
+                XMVECTOR d1 = XMLoadFloat3(&v1.position) - XMLoadFloat3(&v0.position);
+                XMVECTOR d2 = XMLoadFloat3(&v2.position) - XMLoadFloat3(&v0.position);
+                float s1 = v1.uv.x - v0.uv.x, t1 = v1.uv.y - v0.uv.y;
+                float s2 = v2.uv.x - v0.uv.x, t2 = v2.uv.y - v0.uv.y;
+                float area = s1 * t2 - s2 * t1;
+                if (area == 0.f) continue;
+                XMVECTOR tangent = (d1 * t2 - d2 * t1) / area;
+                for (int k = 0; k < 3; k++)
+                {
+                    XMFLOAT3& t = reference[indicies[i + k]];
+                    XMStoreFloat3(&t, XMLoadFloat3(&t) + tangent);
+                }
+            }
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                XMVECTOR n = XMLoadFloat3(&vertices[v].normal);
+                XMVECTOR t = XMLoadFloat3(&reference[v]);
+                XMStoreFloat3(&reference[v], XMVector3Normalize(t - n * XMVector3Dot(n, t)));
+            }
+        });
+
+        size_t splitCount = 0;
+        double splitSeconds = MeasureSeconds(1, [&]()
+        {
+            auto adjacency = MeshNormals::BuildAdjacency(indicies.data(), indicies.size(), vertices.size());
+            auto sources = SplitMirrored(indicies.data(), indicies.size(), vertices.size(), &vertices[0].uv.x, sizeof(Vertex), adjacency);
+            splitCount = sources.size();
+            for (auto source: sources) vertices.push_back(vertices[source]);
+        });
+
+        MeshNormals::Adjacency adjacency;
+        std::vector<float> tangents(vertices.size() * 4);
+        double gatherSeconds = MeasureSeconds(iterations, [&]()
+        {
+            adjacency = MeshNormals::BuildAdjacency(indicies.data(), indicies.size(), vertices.size());
+            ComputeTangents(tangents.data(), &vertices[0].position.x, &vertices[0].normal.x, &vertices[0].uv.x,
+                vertices.size(), sizeof(Vertex), indicies.data(), indicies.size(), adjacency);
+        });
+
+        // 单位长度、和法线正交；没有镜像的顶点和 scatter 的方向比较
+        double maxLengthError = 0., maxDot = 0., maxDegrees = 0., sumDegrees = 0.;
+        size_t compared = 0;
+        size_t negative = 0;
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            XMVECTOR t = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&tangents[v * 4]));
+            XMVECTOR n = XMLoadFloat3(&vertices[v].normal);
+            maxLengthError = std::max(maxLengthError, std::abs(XMVectorGetX(XMVector3Length(t)) - 1.));
+            maxDot = std::max(maxDot, static_cast<double>(std::abs(XMVectorGetX(XMVector3Dot(t, n)))));
+            negative += tangents[v * 4 + 3] < 0.f;
+        }
+        std::vector<uint8_t> split(vertices.size());
+        for (size_t v = 0; v < splitCount; v++) split[vertices.size() - splitCount + v] = 1;
+        for (size_t v = 0; v < reference.size(); v++)
+        {
+            XMVECTOR r = XMLoadFloat3(&reference[v]);
+            if (split[v] || XMVectorGetX(XMVector3LengthSq(r)) == 0.f) continue;
+            float cosine = XMVectorGetX(XMVector3Dot(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&tangents[v * 4])), r));
+            double degrees = std::acos(std::min(1.f, cosine)) * 180. / XM_PI;
+            maxDegrees = std::max(maxDegrees, degrees);
+            sumDegrees += degrees;
+            compared++;
+        }
+
+        std::vector<uint32_t> scalar(vertices.size()), packed(vertices.size());
+        double scalarPackSeconds = MeasureSeconds(iterations, [&]()
+        {
+            for (size_t v = 0; v < vertices.size(); v++) scalar[v] = PackTangent(&tangents[v * 4]);
+        });
+        double packSeconds = MeasureSeconds(iterations, [&]()
+        {
+            PackTangents(packed.data(), tangents.data(), vertices.size());
+        });
+        double maxPackError = 0.;
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            float unpacked[4];
+            UnpackTangent(packed[v], unpacked);
+            for (int k = 0; k < 3; k++) maxPackError = std::max(maxPackError, static_cast<double>(std::abs(unpacked[k] - tangents[v * 4 + k])));
+            if (unpacked[3] != tangents[v * 4 + 3]) maxPackError = 2.;
+        }
+
+        double millions = triangleCount * 1e-6;
+        std::printf("Tangents: african_head.obj x%d (%zu vertices, %zu triangles, %u threads)\n",
+            copies, vertices.size(), triangleCount, Util::WorkerCount());
+        std::printf("  mirrored split   %zu vertices (%.2f ms), %zu with negative handedness\n", splitCount, splitSeconds * 1e3, negative);
+        std::printf("  %-16s %10.2f ms  (%.2f ms per M triangles)\n", "scatter (serial)", scatterSeconds * 1e3, scatterSeconds * 1e3 / millions);
+        // 权重不同（面积和角度），方向只在细长三角形附近差得多
+        std::printf("  %-16s %10.2f ms  (%.2f ms per M triangles, %.1fx, mean %.2g / max %.3g deg from scatter off the seams)\n", "gather",
+            gatherSeconds * 1e3, gatherSeconds * 1e3 / millions, scatterSeconds / gatherSeconds,
+            compared ? sumDegrees / compared : 0., maxDegrees);
+        std::printf("  %-16s max |length - 1| %.2g, max |dot(t, n)| %.2g\n", "frames", maxLengthError, maxDot);
+        std::printf("  %-16s %10.3f ms\n", "pack (scalar)", scalarPackSeconds * 1e3);
+        std::printf("  %-16s %10.3f ms  (%.1fx, %s, max unpack error %.2g)\n", "pack (simd)", packSeconds * 1e3,
+            scalarPackSeconds / packSeconds, scalar == packed ? "identical" : "MISMATCH", maxPackError);
+    }
+
+    // BVH over the model (without the floor) repeated side by side copies times: build time, the collapse to
+    // BVH4, and closest hit / any hit rays per second for rays from a sphere around the model towards
+    // random points inside its bounds. Checked against testing every triangle on a subset of the rays.
+    void BenchBvh(const std::wstring& modelName, ModelType type, bool reconstruct, int copies, int iterations)
+    {
+        using namespace MeshBvh;
+
+        Model model(modelName, type, reconstruct, false);
+        auto sourceVertices = model.GetVertices();
+        auto sourceIndicies = model.GetIndicies();
+        // 去掉 AddFloor 加在最后的两个三角形和四个顶点
+        size_t sourceVertexCount = sourceVertices.size() - 4;
+        size_t sourceIndexCount = sourceIndicies.size() - 6;
+        std::vector<Vertex> vertices(sourceVertexCount * copies);
+        std::vector<uint32_t> indicies(sourceIndexCount * copies);
+        for (int c = 0; c < copies; c++)
+        {
+            for (size_t v = 0; v < sourceVertexCount; v++)
+            {
+                vertices[sourceVertexCount * c + v] = sourceVertices[v];
+                vertices[sourceVertexCount * c + v].position.x += 2.f * c;
+            }
+            for (size_t i = 0; i < sourceIndexCount; i++)
+            {
+                indicies[sourceIndexCount * c + i] = static_cast<uint32_t>(sourceVertexCount * c + sourceIndicies[i]);
+            }
+        }
+        size_t triangleCount = indicies.size() / 3;
+        const float* positions = &vertices[0].position.x;
+
+        Bvh bvh;
+        double buildSeconds = MeasureSeconds(iterations, [&]()
+        {
+            bvh = Build(indicies.data(), indicies.size(), positions, vertices.size(), sizeof(Vertex));
+        });
+        Bvh4 bvh4;
+        double collapseSeconds = MeasureSeconds(iterations, [&]()
+        {
+            bvh4 = Collapse(bvh);
+        });
+        size_t leafCount = 0;
+        for (auto& node: bvh.nodes) leafCount += node.count > 0;
+
+        // 确定性的随机光线
+        uint32_t seed = 12345;
+        auto random = [&]()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) * (1.f / 16777216.f);
+        };
+        auto& root = bvh.nodes[0];
+        float center[3], radius = 0.f;
+        for (int k = 0; k < 3; k++)
+        {
+            center[k] = (root.boundsMin[k] + root.boundsMax[k]) * 0.5f;
+            radius = std::max(radius, root.boundsMax[k] - root.boundsMin[k]);
+        }
+        const size_t rayCount = 1 << 18;
+        std::vector<Ray> rays(rayCount);
+        for (auto& ray: rays)
+        {
+            float z = random() * 2.f - 1.f, phi = random() * 2.f * XM_PI;
+            float r = std::sqrt(std::max(0.f, 1.f - z * z));
+            float direction[3] = {r * std::cos(phi), r * std::sin(phi), z};
+            for (int k = 0; k < 3; k++)
+            {
+                ray.origin[k] = center[k] + direction[k] * radius * 2.f;
+                float target = root.boundsMin[k] + random() * (root.boundsMax[k] - root.boundsMin[k]);
+                ray.direction[k] = target - ray.origin[k];
+            }
+        }
+
+        std::vector<Hit> hits(rayCount), hits4(rayCount);
+        auto trace = [&](auto& tree, std::vector<Hit>& out)
+        {
+            Util::ParallelForRange(rayCount, 1024, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    out[i] = Hit();
+                    Intersect(tree, rays[i], out[i]);
+                }
+            });
+        };
+        double traceSeconds = MeasureSeconds(iterations, [&]() { trace(bvh, hits); });
+        double trace4Seconds = MeasureSeconds(iterations, [&]() { trace(bvh4, hits4); });
+        std::vector<char> occluded(rayCount);
+        double occludedSeconds = MeasureSeconds(iterations, [&]()
+        {
+            Util::ParallelForRange(rayCount, 1024, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++) occluded[i] = Occluded(bvh4, rays[i]);
+            });
+        });
+
+        // 每个三角形都测试一遍作为参考，只取一部分光线
+        auto sameHit = [](const Hit& a, const Hit& b)
+        {
+            if (a.triangle == S_NO_HIT || b.triangle == S_NO_HIT) return a.triangle == b.triangle;
+            // 共享边上的交点可能落在相邻的三角形上
+            return std::abs(a.t - b.t) <= 1e-5f * std::max(1.f, a.t);
+        };
+        Bvh flat;
+        flat.nodes.push_back(root);
+        flat.nodes[0].offset = 0;
+        flat.nodes[0].count = static_cast<uint32_t>(triangleCount);
+        flat.triangles = bvh.triangles;
+        flat.triangleData = bvh.triangleData;
+        size_t mismatches = 0, hitCount = 0;
+        const size_t referenceCount = std::min<size_t>(rayCount, std::max<size_t>(256, (size_t(1) << 26) / triangleCount));
+        for (size_t i = 0; i < rayCount; i++)
+        {
+            hitCount += hits[i].triangle != S_NO_HIT;
+            bool same = sameHit(hits[i], hits4[i]) && occluded[i] == (hits[i].triangle != S_NO_HIT);
+            if (i < referenceCount)
+            {
+                Hit reference;
+                Intersect(flat, rays[i], reference);
+                same = same && sameHit(reference, hits[i]);
+            }
+            mismatches += !same;
+        }
+
+        double mrays = rayCount * 1e-6;
+        std::printf("BVH: %s x%d (%zu triangles, %u threads)\n", Util::ToByteString(modelName).c_str(), copies, triangleCount,
+            Util::WorkerCount());
+        std::printf("  %-16s %10.2f ms  (%.1f M triangles/s, %zu nodes x %zu B, %zu leaves, depth %u, SAH cost %.1f)\n", "build",
+            buildSeconds * 1e3, triangleCount / buildSeconds * 1e-6, bvh.nodes.size(), sizeof(Node), leafCount, bvh.depth, SahCost(bvh));
+        std::printf("  %-16s %10.2f ms  (%zu nodes x %zu B)\n", "collapse bvh4", collapseSeconds * 1e3, bvh4.nodes.size(), sizeof(Node4));
+        std::printf("  %-16s %10.2f ms  (%.2f M rays/s, %.0f%% hit)\n", "closest bvh2", traceSeconds * 1e3, mrays / traceSeconds,
+            100. * hitCount / rayCount);
+        std::printf("  %-16s %10.2f ms  (%.2f M rays/s, %.2fx)\n", "closest bvh4", trace4Seconds * 1e3, mrays / trace4Seconds,
+            traceSeconds / trace4Seconds);
+        std::printf("  %-16s %10.2f ms  (%.2f M rays/s)\n", "any hit bvh4", occludedSeconds * 1e3, mrays / occludedSeconds);
+        std::printf("  %zu rays, %zu checked against every triangle, %s\n", rayCount, referenceCount,
+            mismatches == 0 ? "identical" : (std::to_string(mismatches) + " MISMATCHES").c_str());
+    }
+
+    // MeshCodec on the optimized buffers of the model (with the floor) repeated copies times: the index buffer,
+    // the float Vertex array and the 16 byte quantized vertices. Decode speed is in decoded bytes per second
+    void BenchCodec(const std::wstring& modelName, ModelType type, bool reconstruct, int copies, int iterations)
+    {
+        Model model(modelName, type, reconstruct, false, false, VertexFormat::Quantized);
+        auto sourceIndicies = model.GetIndicies();
+        size_t sourceVertexCount = model.GetVerticesNum();
+        std::vector<uint32_t> indicies;
+        for (int c = 0; c < copies; c++)
+        {
+            for (auto index: sourceIndicies) indicies.push_back(static_cast<uint32_t>(index + sourceVertexCount * c));
+        }
+        size_t vertexCount = sourceVertexCount * copies;
+        size_t triangleCount = indicies.size() / 3;
+
+        std::printf("Codec: %s x%d (%zu triangles, %zu vertices)\n", Util::ToByteString(modelName).c_str(), copies,
+            triangleCount, vertexCount);
+
+        auto report = [&](const char* label, size_t rawBytes, size_t encodedBytes, double encodeSeconds, double decodeSeconds, bool same,
+            const char* unit, double perUnit)
+        {
+            std::printf("  %-16s %9.2f KB -> %9.2f KB  %5.1f%%  (%.2f %s)  encode %7.2f ms  decode %7.3f ms  %6.2f GB/s  %s\n",
+                label, rawBytes / 1024., encodedBytes / 1024., 100. * encodedBytes / rawBytes, perUnit, unit,
+                encodeSeconds * 1e3, decodeSeconds * 1e3, rawBytes / decodeSeconds * 1e-9, same ? "lossless" : "MISMATCH");
+        };
+
+        {
+            std::vector<uint8_t> encoded;
+            double encodeSeconds = MeasureSeconds(iterations, [&]()
+            {
+                encoded = MeshCodec::EncodeIndexBuffer(indicies.data(), indicies.size());
+            });
+            std::vector<uint32_t> decoded(indicies.size());
+            bool valid = true;
+            double decodeSeconds = MeasureSeconds(iterations, [&]()
+            {
+                valid = MeshCodec::DecodeIndexBuffer(decoded.data(), decoded.size(), vertexCount, encoded.data(), encoded.size()) && valid;
+            });
+            report("indicies", indicies.size() * sizeof(uint32_t), encoded.size(), encodeSeconds, decodeSeconds,
+                valid && decoded == indicies, "bits/triangle", encoded.size() * 8. / triangleCount);
+        }
+
+        auto benchVertices = [&](const char* label, const void* source, size_t stride)
+        {
+            std::vector<uint8_t> vertices(vertexCount * stride);
+            for (int c = 0; c < copies; c++)
+            {
+                std::memcpy(vertices.data() + sourceVertexCount * stride * c, source, sourceVertexCount * stride);
+            }
+            std::vector<uint8_t> encoded;
+            double encodeSeconds = MeasureSeconds(iterations, [&]()
+            {
+                encoded = MeshCodec::EncodeVertexBuffer(vertices.data(), vertexCount, stride);
+            });
+            std::vector<uint8_t> decoded(vertices.size());
+            bool valid = true;
+            double decodeSeconds = MeasureSeconds(iterations, [&]()
+            {
+                valid = MeshCodec::DecodeVertexBuffer(decoded.data(), vertexCount, stride, encoded.data(), encoded.size()) && valid;
+            });
+            report(label, vertices.size(), encoded.size(), encodeSeconds, decodeSeconds, valid && decoded == vertices,
+                "bytes/vertex", static_cast<double>(encoded.size()) / vertexCount);
+        };
+        benchVertices("vertices", model.GetVertices().data(), sizeof(Vertex));
+        benchVertices("quantized", model.GetVertexData(), model.GetVertexStride());
+    }
+
+    // uncompressed or RLE true-color TGA of rgba, bottom-up like most tools write it
+    std::vector<uint8_t> WriteTga(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bitsPerPixel, bool rle)
+    {
+        std::vector<uint8_t> out(18, 0);
+        out[2] = rle ? 10 : 2;
+        out[12] = static_cast<uint8_t>(width);
+        out[13] = static_cast<uint8_t>(width >> 8);
+        out[14] = static_cast<uint8_t>(height);
+        out[15] = static_cast<uint8_t>(height >> 8);
+        out[16] = static_cast<uint8_t>(bitsPerPixel);
+        out[17] = bitsPerPixel == 32 ? 8 : 0;
+
+        size_t bytesPerPixel = bitsPerPixel / 8;
+        size_t pixelCount = static_cast<size_t>(width) * height;
+        std::vector<uint8_t> pixels(pixelCount * bytesPerPixel);
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            size_t row = i / width;
+            const uint8_t* source = rgba + ((height - 1 - row) * width + i % width) * 4;
+            uint8_t* pixel = pixels.data() + i * bytesPerPixel;
+            pixel[0] = source[2];
+            pixel[1] = source[1];
+            pixel[2] = source[0];
+            if (bytesPerPixel == 4) pixel[3] = source[3];
+        }
+        if (!rle)
+        {
+            out.insert(out.end(), pixels.begin(), pixels.end());
+            return out;
+        }
+
+        auto same = [&](size_t a, size_t b)
+        {
+            return std::memcmp(pixels.data() + a * bytesPerPixel, pixels.data() + b * bytesPerPixel, bytesPerPixel) == 0;
+        };
+        for (size_t i = 0; i < pixelCount;)
+        {
+            size_t run = 1;
+            while (i + run < pixelCount && run < 128 && same(i, i + run)) run++;
+            if (run > 1)
+            {
+                out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+                out.insert(out.end(), pixels.begin() + i * bytesPerPixel, pixels.begin() + (i + 1) * bytesPerPixel);
+                i += run;
+                continue;
+            }
+            size_t count = 1;
+            while (i + count < pixelCount && count < 128 && !(i + count + 1 < pixelCount && same(i + count, i + count + 1))) count++;
+            out.push_back(static_cast<uint8_t>(count - 1));
+            out.insert(out.end(), pixels.begin() + i * bytesPerPixel, pixels.begin() + (i + count) * bytesPerPixel);
+            i += count;
+        }
+        return out;
+    }
+
+    // african_head_diffuse.tga tiled to size x size and written raw / RLE at 24 / 32 bpp (alpha from the green
+    // channel so RLE runs stay realistic), decoded to RGBA8 with a per-pixel scalar loop like the usual
+    // loaders and with TgaDecoder
+    void BenchTga(uint32_t size, int iterations)
+    {
+        std::string filePath = Util::ToByteString(std::wstring(model_path) + L"african_head_diffuse.tga");
+        Util::MappedFile file(filePath);
+        auto data = reinterpret_cast<const uint8_t*>(file.Data());
+        TgaDecoder::Info info;
+        if (!file.IsOpen() || !TgaDecoder::ReadInfo(data, file.Size(), info)) throw std::runtime_error("BenchTga: cannot read african_head_diffuse.tga");
+
+        std::vector<uint8_t> tile(static_cast<size_t>(info.width) * info.height * 4);
+        double fileSeconds = MeasureSeconds(iterations, [&]()
+        {
+            if (!TgaDecoder::Decode(data, file.Size(), tile.data(), info.width * 4)) throw std::runtime_error("BenchTga: decode failed");
+        });
+        std::printf("TGA: african_head_diffuse.tga %ux%u %u bpp %s  decode %7.2f ms  %6.2f GB/s\n", info.width, info.height,
+            info.bitsPerPixel, info.rle ? "RLE" : "raw", fileSeconds * 1e3, tile.size() / fileSeconds * 1e-9);
+
+        std::vector<uint8_t> image(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                uint8_t* pixel = image.data() + (static_cast<size_t>(y) * size + x) * 4;
+                std::memcpy(pixel, tile.data() + (static_cast<size_t>(y % info.height) * info.width + x % info.width) * 4, 4);
+                pixel[3] = pixel[1];
+            }
+        }
+
+        // 逐像素解码，包跨行时按像素序号算行
+        auto scalarDecode = [](const std::vector<uint8_t>& tga, uint8_t* out)
+        {
+            uint32_t width = tga[12] | tga[13] << 8;
+            uint32_t height = tga[14] | tga[15] << 8;
+            size_t bytesPerPixel = tga[16] / 8;
+            bool rle = tga[2] == 10;
+            const uint8_t* input = tga.data() + 18 + tga[0];
+            size_t pixelCount = static_cast<size_t>(width) * height;
+            auto put = [&](size_t i, const uint8_t* source)
+            {
+                uint8_t* pixel = out + ((height - 1 - i / width) * width + i % width) * 4;
+                pixel[0] = source[2];
+                pixel[1] = source[1];
+                pixel[2] = source[0];
+                pixel[3] = bytesPerPixel == 4 ? source[3] : 255;
+            };
+            for (size_t i = 0; i < pixelCount;)
+            {
+                size_t count = 1;
+                bool run = false;
+                if (rle)
+                {
+                    count = (*input & 0x7f) + 1;
+                    run = (*input++ & 0x80) != 0;
+                }
+                for (size_t k = 0; k < count; k++)
+                {
+                    put(i + k, input);
+                    if (!run) input += bytesPerPixel;
+                }
+                if (run) input += bytesPerPixel;
+                i += count;
+            }
+        };
+
+        for (uint32_t bitsPerPixel: {24u, 32u})
+        {
+            for (bool rle: {false, true})
+            {
+                auto tga = WriteTga(image.data(), size, size, bitsPerPixel, rle);
+                std::vector<uint8_t> expected(image);
+                if (bitsPerPixel == 24)
+                {
+                    for (size_t i = 3; i < expected.size(); i += 4) expected[i] = 255;
+                }
+
+                std::vector<uint8_t> decoded(image.size());
+                double scalarSeconds = MeasureSeconds(iterations, [&]() { scalarDecode(tga, decoded.data()); });
+                bool scalarSame = decoded == expected;
+                bool valid = true;
+                double seconds = MeasureSeconds(iterations, [&]()
+                {
+                    valid = TgaDecoder::Decode(tga.data(), tga.size(), decoded.data(), size * 4) && valid;
+                });
+                std::printf("  %ux%u %u bpp %-3s %8.2f MB  scalar %7.2f ms %6.2f GB/s  TgaDecoder %7.2f ms %6.2f GB/s  x%.2f  %s\n",
+                    size, size, bitsPerPixel, rle ? "RLE" : "raw", tga.size() / (1024. * 1024.),
+                    scalarSeconds * 1e3, image.size() / scalarSeconds * 1e-9, seconds * 1e3, image.size() / seconds * 1e-9,
+                    scalarSeconds / seconds, scalarSame && valid && decoded == expected ? "same" : "MISMATCH");
+            }
+        }
+    }
+
+    // Reconstruct on bun_zipper positions repeated copies times: the branchy two pass scalar loop it used
+    // before, the SIMD min/max reduction + scale-offset, and the scale-offset alone with the bounds the
+    // loader tracked while parsing
+    void BenchReconstruct(int copies, int iterations)
+    {
+        using Vec3 = std::array<float, 3>;
+
+        auto loader = ModelLoader<>::CreateModelLoader(ModelType::PLY);
+        std::wstring filePath = std::wstring(model_path) + L"bun_zipper.ply";
+        loader->LoadFromFile(filePath);
+        auto sourcePositions = loader->GetPositions();
+
+        std::vector<Vec3> source(sourcePositions.size() * copies);
+        for (int c = 0; c < copies; c++)
+        {
+            for (size_t v = 0; v < sourcePositions.size(); v++)
+            {
+                auto& p = sourcePositions[v];
+                source[sourcePositions.size() * c + v] = {p[0] + 0.2f * c, p[1], p[2]};
+            }
+        }
+        std::vector<Vec3> positions;
+
+        auto scalarReconstruct = [&]()
+        {
+            float maxX, minX, maxY, minY, maxZ, minZ;
+            maxX = minX = positions[0][0];
+            maxY = minY = positions[0][1];
+            maxZ = minZ = positions[0][2];
+            for (size_t i = 1; i < positions.size(); ++i)
+            {
+                if (positions[i][0] > maxX) maxX = positions[i][0];
+                if (positions[i][0] < minX) minX = positions[i][0];
+                if (positions[i][1] > maxY) maxY = positions[i][1];
+                if (positions[i][1] < minY) minY = positions[i][1];
+                if (positions[i][2] > maxZ) maxZ = positions[i][2];
+                if (positions[i][2] < minZ) minZ = positions[i][2];
+            }
+            float offsetX = (maxX + minX) / 2, offsetY = (maxY + minY) / 2, offsetZ = (maxZ + minZ) / 2;
+            float range = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ)) / 2;
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                positions[i][0] = (positions[i][0] - offsetX) / range;
+                positions[i][1] = (positions[i][1] - offsetY) / range;
+                positions[i][2] = (positions[i][2] - offsetZ) / range;
+            }
+        };
+
+        // the transform is idempotent, repeated iterations run on already normalized data
+        positions = source;
+        double scalarSeconds = MeasureSeconds(iterations, scalarReconstruct);
+        positions = source;
+        scalarReconstruct();
+        std::vector<Vec3> reference = positions;
+
+        positions = source;
+        double simdSeconds = MeasureSeconds(iterations, [&]()
+        {
+            auto aabb = MeshBounds::ComputeAabb(positions[0].data(), positions.size(), sizeof(Vec3));
+            MeshBounds::NormalizeToUnitBox(positions[0].data(), positions.size(), sizeof(Vec3), aabb);
+        });
+
+        positions = source;
+        auto tracked = MeshBounds::ComputeAabb(positions[0].data(), positions.size(), sizeof(Vec3));
+        double fusedSeconds = MeasureSeconds(iterations, [&]()
+        {
+            tracked = MeshBounds::NormalizeToUnitBox(positions[0].data(), positions.size(), sizeof(Vec3), tracked);
+        });
+        positions = source;
+        tracked = MeshBounds::ComputeAabb(positions[0].data(), positions.size(), sizeof(Vec3));
+        tracked = MeshBounds::NormalizeToUnitBox(positions[0].data(), positions.size(), sizeof(Vec3), tracked);
+
+        float maxError = 0.f;
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            for (int k = 0; k < 3; k++) maxError = std::max(maxError, std::abs(positions[i][k] - reference[i][k]));
+        }
+        auto recomputed = MeshBounds::ComputeAabb(positions[0].data(), positions.size(), sizeof(Vec3));
+        bool boundsExact = true;
+        for (int k = 0; k < 3; k++)
+        {
+            boundsExact &= recomputed.min[k] == tracked.min[k] && recomputed.max[k] == tracked.max[k];
+        }
+        auto sphere = MeshBounds::ComputeSphere(positions[0].data(), positions.size(), sizeof(Vec3), tracked);
+
+        double bytes = static_cast<double>(positions.size() * sizeof(Vec3));
+        std::printf("Reconstruct: bun_zipper.ply x%d (%zu positions, %.1f MB, %u threads)\n",
+            copies, positions.size(), bytes / (1024. * 1024.), Util::WorkerCount());
+        std::printf("  %-24s %9.2f ms  (%.2f GB/s)\n", "two pass scalar", scalarSeconds * 1e3, bytes / scalarSeconds * 1e-9);
+        std::printf("  %-24s %9.2f ms  (%.2f GB/s, %.1fx)\n", "SIMD aabb + scale-offset", simdSeconds * 1e3,
+            bytes / simdSeconds * 1e-9, scalarSeconds / simdSeconds);
+        std::printf("  %-24s %9.2f ms  (%.2f GB/s, %.1fx)\n", "tracked bounds, one pass", fusedSeconds * 1e3,
+            bytes / fusedSeconds * 1e-9, scalarSeconds / fusedSeconds);
+        std::printf("  max diff from scalar %.3g, transformed bounds %s, sphere radius %.4f\n",
+            maxError, boundsExact ? "exact" : "NOT exact", sphere.radius);
+    }
+
+    bool EndsWith(const std::string& str, const char* suffix)
+    {
+        size_t length = std::strlen(suffix);
+        return str.size() >= length && str.compare(str.size() - length, length, suffix) == 0;
+    }
+
+    // 每个模型文件重复 copies 次：逐个串行加载（loader 内部仍然多线程），和批量加载在不限内存、
+    // 只够同时加载约两个大文件的预算下比较。检查批量的结果和串行完全一致
+    void BenchBatch(int copies)
+    {
+        const std::pair<const wchar_t*, ModelType> files[] =
+        {
+            {L"african_head.obj", ModelType::OBJ},
+            {L"box.obj", ModelType::OBJ},
+            {L"temp.obj", ModelType::OBJ},
+            {L"bun_zipper.ply", ModelType::PLY},
+            {L"box.ply", ModelType::PLY},
+            {L"platonic_shelf_ascii.ply", ModelType::PLY},
+        };
+        std::vector<BatchLoader::Request> requests;
+        for (int c = 0; c < copies; c++)
+        {
+            for (auto& file: files)
+            {
+                requests.push_back({std::wstring(model_path) + file.first, file.second, true});
+            }
+        }
+
+        auto hashLoader = [](const ModelLoader<>& loader)
+        {
+            auto positions = loader.GetPositions();
+            auto normals = loader.GetNormals();
+            auto uvws = loader.GetUVWs();
+            auto indicies = loader.GetIndicies();
+            uint64_t hash = Util::Hash64(positions.data(), positions.size() * sizeof(positions[0]));
+            hash = Util::Hash64(normals.data(), normals.size() * sizeof(normals[0]), hash);
+            hash = Util::Hash64(uvws.data(), uvws.size() * sizeof(uvws[0]), hash);
+            return Util::Hash64(indicies.data(), indicies.size() * sizeof(uint32_t), hash);
+        };
+
+        std::vector<uint64_t> expected(requests.size());
+        uint64_t totalBytes = 0;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            auto loader = ModelLoader<>::CreateModelLoader(requests[i].type);
+            loader->LoadFromFile(requests[i].filePath);
+            loader->Reconstruct();
+            expected[i] = hashLoader(*loader);
+        }
+        double serialSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+
+        uint64_t largest = 0;
+        for (auto& request: requests)
+        {
+            Util::MappedFile file(Util::ToByteString(request.filePath));
+            totalBytes += file.Size();
+            largest = std::max(largest, BatchLoader::EstimateBytes(request, file.Size()));
+        }
+        std::printf("Batch load: %zu files x%d (%zu loads, %.1f MB, %u threads)\n", std::size(files), copies,
+            requests.size(), totalBytes / (1024. * 1024.), Util::WorkerCount());
+        std::printf("  %-22s %10.2f ms  (%.0f MB/s)\n", "serial", serialSeconds * 1e3, totalBytes / serialSeconds / (1024. * 1024.));
+
+        const uint64_t budgets[] = {UINT64_MAX, largest * 2};
+        for (uint64_t memoryBudget: budgets)
+        {
+            BatchLoader::Options options;
+            options.memoryBudget = memoryBudget;
+            // 后处理里算哈希，结果按请求顺序写入，和完成顺序无关
+            std::vector<uint64_t> hashes(requests.size());
+            options.process = [&](size_t index, ModelLoader<>& loader) { hashes[index] = hashLoader(loader); };
+            BatchLoader::Stats stats;
+            auto results = BatchLoader::Load(requests, options, &stats);
+
+            bool identical = stats.failedCount == 0 && hashes == expected;
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                identical = identical && results[i].loader && hashLoader(*results[i].loader) == expected[i];
+            }
+            char label[64];
+            if (memoryBudget == UINT64_MAX) std::snprintf(label, sizeof(label), "batch (no budget)");
+            else std::snprintf(label, sizeof(label), "batch (%.1f MB budget)", memoryBudget / (1024. * 1024.));
+            std::printf("  %-22s %10.2f ms  (%.0f MB/s, %.1fx, parse %.1f + process %.1f ms cpu, peak in flight %.1f MB, %llu steals, %s)\n",
+                label, stats.wallSeconds * 1e3, totalBytes / stats.wallSeconds / (1024. * 1024.), serialSeconds / stats.wallSeconds,
+                stats.parseSeconds * 1e3, stats.processSeconds * 1e3, stats.peakInFlightBytes / (1024. * 1024.),
+                static_cast<unsigned long long>(stats.steals), identical ? "identical" : "MISMATCH");
+            if (memoryBudget != UINT64_MAX)
+            {
+                for (size_t i = 0; i < std::size(files); i++)
+                {
+                    auto& file = results[i].stats;
+                    std::printf("    %-26ls %8.1f KB  wait %7.2f  parse %7.2f  process %6.2f ms  (worker %d / %d)\n", files[i].first,
+                        file.fileBytes / 1024., file.waitSeconds * 1e3, file.parseSeconds * 1e3, file.processSeconds * 1e3,
+                        file.parseWorker, file.processWorker);
+                }
+            }
+        }
+    }
+
+    // heap allocations and bytes of one call of func, counted by the operator new hook
+    std::pair<uint64_t, uint64_t> CountAllocations(const std::function<void()>& func)
+    {
+        AllocationTracking::g_count = 0;
+        AllocationTracking::g_bytes = 0;
+        AllocationTracking::g_enabled = true;
+        func();
+        AllocationTracking::g_enabled = false;
+        return {AllocationTracking::g_count.load(), AllocationTracking::g_bytes.load()};
+    }
+
+    // OBJ 解析的三种模式和完整的 ModelLoader 加载：arena 关闭（全部走全局堆）和打开时的
+    // 全局堆分配次数、字节数和耗时
+    void BenchAllocations(const std::string& filePath, int iterations)
+    {
+        using ObjHelper::ParseMode;
+
+        std::wstring widePath = Util::ToWideString(filePath);
+        const std::pair<const char*, std::function<void()>> paths[] =
+        {
+            {"stream", [&]() { ObjLoader loader(filePath, ParseMode::Stream); }},
+            {"mapped", [&]() { ObjLoader loader(filePath, ParseMode::Mapped); }},
+            {"parallel", [&]() { ObjLoader loader(filePath, ParseMode::Parallel); }},
+            {"loader", [&]() { ModelLoader<>::CreateModelLoader(ModelType::OBJ)->LoadFromFile(widePath); }},
+        };
+
+        std::printf("Allocations: %s (%u threads, heap calls / MB / ms, arena off -> on)\n", filePath.c_str(), Util::WorkerCount());
+        for (auto& path: paths)
+        {
+            Util::Arena::SetBypass(true);
+            auto before = CountAllocations(path.second);
+            double beforeSeconds = MeasureSeconds(iterations, path.second);
+            Util::Arena::SetBypass(false);
+            auto after = CountAllocations(path.second);
+            double afterSeconds = MeasureSeconds(iterations, path.second);
+
+            std::printf("  %-8s %9llu -> %-7llu (%5.0fx)  %8.2f -> %-8.2f MB  %9.3f -> %-9.3f ms (%.2fx)\n", path.first,
+                static_cast<unsigned long long>(before.first), static_cast<unsigned long long>(after.first),
+                static_cast<double>(before.first) / std::max<uint64_t>(1, after.first),
+                before.second / (1024. * 1024.), after.second / (1024. * 1024.),
+                beforeSeconds * 1e3, afterSeconds * 1e3, beforeSeconds / afterSeconds);
+        }
+    }
+
+    // 流式上传到 MemoryDevice：每次拷贝带固定延迟，ring 比模型小得多，生产者必然要等 GPU。
+    // 检查最终缓冲和 loader 的结果一致、索引拷贝不早于它引用的顶点、staging 不超过 ring 的大小
+    void BenchStreaming(const std::wstring& modelName, ModelType type)
+    {
+        const uint32_t slotCount = 4;
+        const size_t slotSize = 256 * 1024;
+        const auto latency = std::chrono::microseconds(200);
+
+        auto loader = ModelLoader<float>::CreateModelLoader(type);
+        auto filePath = std::wstring(model_path) + modelName;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        loader->LoadFromFile(filePath);
+        double loadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        auto positions = loader->GetPositions();
+        auto indicies = loader->GetIndicies();
+
+        UploadRing::MemoryDevice device(latency);
+        double firstSeconds = 0.;
+        double streamSeconds = 0.;
+        UploadRing::Stats stats;
+        {
+            StreamingMesh mesh(device, slotCount, slotSize);
+            t0 = std::chrono::high_resolution_clock::now();
+            mesh.Start(modelName, type);
+            while (!mesh.IsFinished() && mesh.GetVisibleIndexCount() == 0) std::this_thread::yield();
+            firstSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+            mesh.Wait();
+            streamSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+            stats = mesh.GetStats();
+        }
+
+        // 数据一致
+        auto& vertexBuffer = device.GetBuffer(UploadRing::Target::Vertex);
+        auto& indexBuffer = device.GetBuffer(UploadRing::Target::Index);
+        bool same = stats.bytes[0] == positions.size() * sizeof(Vertex) && stats.bytes[1] == indicies.size() * sizeof(uint32_t);
+        for (size_t i = 0; same && i < positions.size(); i++)
+        {
+            Vertex vertex;
+            std::memcpy(&vertex, vertexBuffer.data() + i * sizeof(Vertex), sizeof(Vertex));
+            same = vertex.position.x == positions[i][0] && vertex.position.y == positions[i][1] && vertex.position.z == positions[i][2];
+        }
+        same = same && std::memcmp(indexBuffer.data(), indicies.data(), indicies.size() * sizeof(uint32_t)) == 0;
+
+        // 每个目标的拷贝首尾相接；索引拷贝完成时，它之前追加的顶点都已经拷贝完成
+        auto copies = device.GetCopies();
+        uint64_t end[UploadRing::S_TARGET_COUNT] = {};
+        bool ordered = true;
+        for (auto& copy: copies)
+        {
+            auto t = static_cast<uint32_t>(copy.target);
+            ordered &= copy.offset == end[t];
+            end[t] = copy.offset + copy.size;
+            if (copy.target == UploadRing::Target::Index)
+            {
+                size_t vertexCount = end[0] / sizeof(Vertex);
+                for (uint64_t k = copy.offset / sizeof(uint32_t); k < end[t] / sizeof(uint32_t); k++)
+                {
+                    ordered &= indicies[k] < vertexCount;
+                }
+            }
+        }
+
+        size_t modelBytes = positions.size() * sizeof(Vertex) + indicies.size() * sizeof(uint32_t);
+        std::printf("Streaming upload: %s (%zu vertices, %zu indicies, %.2f MB)\n",
+            Util::ToByteString(modelName).c_str(), positions.size(), indicies.size(), modelBytes / (1024. * 1024.));
+        std::printf("  ring %u x %zu KB, %lld us per copy\n", slotCount, slotSize / 1024, static_cast<long long>(latency.count()));
+        std::printf("  plain load     %9.2f ms\n", loadSeconds * 1e3);
+        std::printf("  first visible  %9.2f ms\n", firstSeconds * 1e3);
+        std::printf("  streamed       %9.2f ms  (%llu copies, %llu stalls %.2f ms, peak %u slots in flight)\n",
+            streamSeconds * 1e3, static_cast<unsigned long long>(stats.chunks), static_cast<unsigned long long>(stats.stalls),
+            stats.stallSeconds * 1e3, stats.peakSlotsInFlight);
+        std::printf("  staging peak %.2f MB of %.2f MB ring, %llu staging hazards\n",
+            device.GetPeakStagingInFlight() / (1024. * 1024.), slotCount * slotSize / (1024. * 1024.),
+            static_cast<unsigned long long>(device.GetStagingHazards()));
+        std::printf("  output %s, copy order %s\n", same ? "identical" : "MISMATCH", ordered ? "ok" : "BROKEN");
+    }
+
+    // The peak is per process, so this runs alone in its own invocation.
+    void BenchModelMemory(const std::string& modelName)
+    {
+        ModelType type = EndsWith(modelName, ".ply") ? ModelType::PLY : ModelType::OBJ;
+        size_t baseline = PeakResidentBytes();
+
+        Model model(Util::ToWideString(modelName), type, type == ModelType::PLY, false);
+        size_t modelBytes = model.GetVerticesNum() * sizeof(Vertex) + model.GetIndiciesNum() * sizeof(uint32_t);
+
+        size_t peak = PeakResidentBytes();
+        std::printf("Model memory: %s (%u vertices, %u indicies)\n", modelName.c_str(), model.GetVerticesNum(), model.GetIndiciesNum());
+        std::printf("  model data   %9.2f MB\n", modelBytes / (1024. * 1024.));
+        std::printf("  peak during  %9.2f MB  (%.2fx model data)\n",
+            (peak - baseline) / (1024. * 1024.), static_cast<double>(peak - baseline) / modelBytes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2 && std::strcmp(argv[1], "--memory") == 0)
+    {
+        try
+        {
+            BenchModelMemory(argv[2]);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--normals") == 0)
+    {
+        BenchNormals(std::max(1, std::atoi(argv[2])), 3);
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--tangents") == 0)
+    {
+        BenchTangents(std::max(1, std::atoi(argv[2])), 3);
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--batch") == 0)
+    {
+        try
+        {
+            BenchBatch(std::max(1, std::atoi(argv[2])));
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--allocations") == 0)
+    {
+        try
+        {
+            BenchAllocations(argv[2], 3);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--bvh") == 0)
+    {
+        try
+        {
+            BenchBvh(L"bun_zipper.ply", ModelType::PLY, true, std::max(1, std::atoi(argv[2])), 3);
+            BenchBvh(L"african_head.obj", ModelType::OBJ, false, std::max(1, std::atoi(argv[2])), 3);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--codec") == 0)
+    {
+        try
+        {
+            BenchCodec(L"bun_zipper.ply", ModelType::PLY, true, std::max(1, std::atoi(argv[2])), 10);
+            BenchCodec(L"african_head.obj", ModelType::OBJ, false, std::max(1, std::atoi(argv[2])), 10);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--tga") == 0)
+    {
+        try
+        {
+            BenchTga(static_cast<uint32_t>(std::min(65535, std::max(1, std::atoi(argv[2])))), 10);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--reconstruct") == 0)
+    {
+        BenchReconstruct(std::max(1, std::atoi(argv[2])), 3);
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--stream") == 0)
+    {
+        try
+        {
+            BenchStreaming(Util::ToWideString(argv[2]), EndsWith(argv[2], ".ply") ? ModelType::PLY : ModelType::OBJ);
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--simplify") == 0)
+    {
+        BenchSimplifyGrid(std::max(2, std::atoi(argv[2])));
+        return 0;
+    }
+
+    std::vector<std::string> files;
+    if (argc > 1)
+    {
+        files.push_back(argv[1]);
+    }
+    else
+    {
+        files.push_back(Util::ToByteString(std::wstring(model_path) + L"african_head.obj"));
+        files.push_back(Util::ToByteString(std::wstring(model_path) + L"bun_zipper.ply"));
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    try
+    {
+        for (auto& filePath: files)
+        {
+            if (EndsWith(filePath, ".ply")) BenchPlyParse(filePath, iterations);
+            else BenchObjParse(filePath, iterations);
+        }
+        if (argc <= 1)
+        {
+            BenchModelLoad(L"bun_zipper.ply", ModelType::PLY, true, iterations);
+            BenchModelLoad(L"african_head.obj", ModelType::OBJ, false, iterations);
+            BenchObjWeld(L"african_head.obj");
+            BenchVertexCache(L"bun_zipper.ply", ModelType::PLY);
+            BenchVertexCache(L"african_head.obj", ModelType::OBJ);
+            BenchVertexFetch(L"bun_zipper.ply", ModelType::PLY);
+            BenchVertexFetch(L"african_head.obj", ModelType::OBJ);
+            BenchOverdraw(L"bun_zipper.ply", ModelType::PLY, true);
+            BenchOverdraw(L"african_head.obj", ModelType::OBJ, false);
+            BenchVertexQuantization(L"bun_zipper.ply", ModelType::PLY, true, iterations);
+            BenchVertexQuantization(L"african_head.obj", ModelType::OBJ, false, iterations);
+            BenchMeshlets(L"bun_zipper.ply", ModelType::PLY, true, iterations);
+            BenchMeshlets(L"african_head.obj", ModelType::OBJ, false, iterations);
+            BenchSimplify(L"bun_zipper.ply", ModelType::PLY, true);
+            BenchSimplify(L"african_head.obj", ModelType::OBJ, false);
+            BenchNormals(1, iterations);
+            BenchTangents(1, iterations);
+            BenchReconstruct(16, iterations);
+            BenchStreaming(L"bun_zipper.ply", ModelType::PLY);
+            BenchStreaming(L"african_head.obj", ModelType::OBJ);
+            BenchBatch(8);
+            BenchAllocations(Util::ToByteString(std::wstring(model_path) + L"african_head.obj"), iterations);
+            BenchBvh(L"bun_zipper.ply", ModelType::PLY, true, 1, iterations);
+            BenchBvh(L"african_head.obj", ModelType::OBJ, false, 1, iterations);
+            BenchCodec(L"bun_zipper.ply", ModelType::PLY, true, 1, iterations);
+            BenchCodec(L"african_head.obj", ModelType::OBJ, false, 1, iterations);
+            BenchTga(4096, iterations);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
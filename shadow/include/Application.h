@@ -2,6 +2,7 @@
 #define __APPLICATION_H__
 
 #include "DXWindow.h"
+#include "ModelLoadQueue.h"
 
 class Application
 {
@@ -19,6 +20,14 @@ private:
     bool m_windowCreated = false;
 
     std::shared_ptr<Model> m_model;
+    // 异步加载，窗口在加载完成后换上这个模型
+    std::unique_ptr<ModelLoadQueue> m_loadQueue;
+    std::shared_ptr<ModelLoadHandle> m_pendingModel;
+    // 用于统计首帧时间
+    std::chrono::high_resolution_clock::time_point m_startTime;
+    // 不预先加载，由窗口流式加载的模型
+    std::wstring m_streamingModelName;
+    ModelType m_streamingModelType = ModelType::PLY;
 
 public:
     static void CreateInstance(HINSTANCE hInst);
@@ -32,6 +41,14 @@ public:
     void SetWARP(bool isUse);
     void SetModel(std::shared_ptr<Model>& m_model);
     std::shared_ptr<Model> GetModel() const;
+    // 在后台线程上加载，返回的 handle 可以等待、取消
+    std::shared_ptr<ModelLoadHandle> LoadModelAsync(ModelLoadDesc desc, LoadPriority priority = LoadPriority::Normal);
+    // 窗口先显示占位模型，handle 完成后换上加载的模型
+    void SetPendingModel(const std::shared_ptr<ModelLoadHandle>& handle);
+    std::shared_ptr<ModelLoadHandle> GetPendingModel() const;
+    std::chrono::high_resolution_clock::time_point GetStartTime() const;
+    void SetStreamingModel(std::wstring model_name, ModelType modelType);
+    bool GetStreamingModel(std::wstring& model_name, ModelType& modelType) const;
 
     ComPtr<ID3D12Device2> GetDevice();
 
@@ -7,9 +7,23 @@
 #include "DescriptorHeap.h"
 #include "Model.h"
 #include "Camera.h"
+#include "StreamingMesh.h"
+#include "UploadDevice.h"
+#include "ModelLoadQueue.h"
 
 using namespace DirectX;
 
+// 屏幕坐标拾取到的三角形
+struct PickResult
+{
+    // GetIndicies() 中的第几个三角形
+    uint32_t triangle;
+    XMFLOAT2 barycentrics;
+    XMFLOAT3 worldPosition;
+    // 拾取耗时
+    double seconds;
+};
+
 class DXWindow
 {
     const wchar_t* m_name;
@@ -17,6 +31,12 @@ class DXWindow
 
     std::shared_ptr<Model> m_model;
     std::shared_ptr<Camera> m_camera;
+    // 没有预先加载的模型时流式加载，边解析边显示
+    std::unique_ptr<D3D12UploadDevice> m_uploadDevice;
+    std::shared_ptr<StreamingMesh> m_streamingMesh;
+    // 异步加载中的模型，完成前 m_model 为占位模型
+    std::shared_ptr<ModelLoadHandle> m_pendingModel;
+    bool m_firstFramePresented = false;
 
     // Use WARP adapter
     bool m_useWarp = false;
@@ -82,6 +102,8 @@ class DXWindow
     // float m_FoV;
 
     DirectX::XMMATRIX m_ModelMatrix; // TODO
+    // 量化顶点的位置解码，左乘在模型矩阵前，法线矩阵不受影响
+    DirectX::XMMATRIX m_positionDecodeMatrix = DirectX::XMMatrixIdentity();
     // DirectX::XMMATRIX m_ViewMatrix;
     // DirectX::XMMATRIX m_ProjectionMatrix;
 
@@ -96,11 +118,17 @@ class DXWindow
         size_t numElements, size_t elementSize, const void* bufferData,
         D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
     void LoadAssets();
+    void CreateModelPipelineStates(VertexFormat vertexFormat, bool flatNormals);
+    void UploadModel(ComPtr<ID3D12GraphicsCommandList2> commandList,
+        ComPtr<ID3D12Resource>& intermediateVertexBuffer, ComPtr<ID3D12Resource>& intermediateIndexBuffer);
 
     void UpdateWindowRect(uint32_t width, uint32_t height);
 
     void UpdateShadowPassData(ComPtr<ID3D12GraphicsCommandList2>& commandList);
     void ShadowPass(ComPtr<ID3D12GraphicsCommandList2>& commandList);
+    void DrawModel(ComPtr<ID3D12GraphicsCommandList2>& commandList);
+    void SwapInPendingModel();
+    void UpdateStreamingMesh();
 public:
     DXWindow(const wchar_t* name, uint32_t w = 1280, uint32_t h = 720) noexcept;
     ~DXWindow() = default;
@@ -115,6 +143,10 @@ public:
 
     LRESULT OnWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+    // 客户区像素坐标处的射线和模型（不包括地板）的最近交点，没有模型或没有打到时返回 false。
+    // 模型没有 BVH 时第一次拾取会先建立
+    bool Pick(int x, int y, PickResult& result);
+
     void SetFullscreen(bool fullscreen);
     void SetVSync(bool VSync);
 
@@ -5,6 +5,11 @@
 #include <vector>
 #include <string>
 #include "common/ModelLoader.h"
+#include "common/Span.h"
+#include "common/VertexQuantizer.h"
+#include "common/MeshletBuilder.h"
+#include "common/MeshSimplifier.h"
+#include "common/MeshBvh.h"
 
 using namespace DirectX;
 
@@ -16,24 +21,142 @@ struct Vertex
     // XMFLOAT4 color;
 };
 
+enum class IndexFormat
+{
+    UInt16,
+    UInt32
+};
+
+// 一次 DrawIndexedInstanced 的范围，16 位索引相对于 baseVertex
+struct Submesh
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    int32_t baseVertex;
+};
+
+// GPU 顶点格式。Quantized 为 16 字节的 VertexQuantizer::QuantizedVertex，
+// 位置解码合并进模型矩阵（GetPositionDecode），法线在 shader 中解码（QUANTIZED_VERTEX）
+enum class VertexFormat
+{
+    Float32,
+    Quantized
+};
+
+// 模型空间的射线交点
+struct ModelHit
+{
+    // GetIndicies() 中的第几个三角形
+    uint32_t triangle;
+    // position = (1 - u - v) * v0 + u * v1 + v * v2
+    XMFLOAT2 barycentrics;
+    XMFLOAT3 position;
+    // 以射线方向的长度为单位
+    float t;
+};
+
+namespace MeshCache
+{
+    struct Key;
+}
+
 class Model
 {
 private:
     std::vector<Vertex> m_vertices;
     std::vector<uint32_t> m_indicies;
+    // GPU 索引缓冲：16 位时是每个子网格内相对 baseVertex 的索引，32 位时为空并直接使用 m_indicies
+    std::vector<uint16_t> m_indicies16;
+    std::vector<Submesh> m_submeshes;
+    // Optimize 切分的子网格（三角形分界，不包括地板），overdraw 在每段内部重排过，BuildIndexBuffer 按同样的分界切分
+    std::vector<uint32_t> m_submeshRanges;
+    IndexFormat m_indexFormat = IndexFormat::UInt32;
+    std::vector<VertexQuantizer::QuantizedVertex> m_quantizedVertices;
+    VertexQuantizer::QuantizationParams m_quantization;
+    VertexFormat m_vertexFormat = VertexFormat::Float32;
+    XMFLOAT3 m_boundsMin = XMFLOAT3(0.f, 0.f, 0.f);
+    XMFLOAT3 m_boundsMax = XMFLOAT3(0.f, 0.f, 0.f);
+    // xyz 为球心，w 为半径
+    XMFLOAT4 m_boundingSphere = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+    // 模型本身的 meshlet，不包括地板，顶点下标指向 m_vertices
+    MeshletBuilder::MeshletData m_meshlets;
+    std::vector<MeshSimplifier::LodLevel> m_lods;
+    // 和 m_vertices 一一对应的打包切线（MeshTangents::PackTangent），没有要求切线时为空
+    std::vector<uint32_t> m_tangents;
+    // 模型本身的 BVH，不包括地板，BuildBvh 之前为空
+    MeshBvh::Bvh4 m_bvh;
 
+    void LoadFromFile(std::wstring& filePath, ModelType modelType, bool reconstruct, bool spatialSort, bool tangents);
+    // 缓存不存在或已过期时返回 false
+    bool LoadFromCache(std::wstring& filePath, const MeshCache::Key& key);
+    void SaveToCache(std::wstring& filePath, const MeshCache::Key& key) const;
+
+    void Optimize(bool spatialSort);
     void CalculateVertexNormal();
+    void CalculateTangents();
+    // 包围盒由 loader 在解析时统计，这里只需再遍历一遍求包围球
+    void CalculateBounds(const MeshBounds::Aabb<float>& aabb);
+    void AddFloor();
+    void BuildIndexBuffer();
+    void BuildVertexBuffer(VertexFormat vertexFormat);
+
+    // 16 位索引的一个子网格最多引用的顶点数
+    static constexpr uint32_t S_SUBMESH_VERTICES = 1u << 16;
+    static std::vector<uint32_t> SplitSubmeshes(const std::vector<uint32_t>& indicies, size_t vertexCount);
 
     static std::wstring GetModelFullPath(std::wstring model_name);
+    static std::wstring GetCacheFullPath(std::wstring& filePath);
 
 public:
-    Model(std::wstring model_name, ModelType modelType, bool reconstruct = false) noexcept;
+    // useCache: load the processed mesh from <model>.meshcache when it matches the source file, write it otherwise
+    // spatialSort: Morton-order vertices and triangles before the cache/fetch optimization, for unordered scans
+    // vertexFormat: format of the GPU vertex buffer, the CPU side vertices stay Vertex
+    // tangents: generate a packed tangent stream (GetTangents), vertices on mirrored UV seams are split
+    // throws when the model cannot be loaded
+    Model(std::wstring model_name, ModelType modelType, bool reconstruct = false, bool useCache = true, bool spatialSort = false,
+        VertexFormat vertexFormat = VertexFormat::Float32, bool tangents = false);
     ~Model() = default;
 
-    std::vector<Vertex> GetVertices() const;
-    std::vector<uint32_t> GetIndicies() const;
+    // 只读视图，上传 GPU 时直接使用，不复制
+    Util::Span<const Vertex> GetVertices() const;
+    Util::Span<const uint32_t> GetIndicies() const;
+    // 移出数据，之后模型为空
+    std::vector<Vertex> TakeVertices();
+    std::vector<uint32_t> TakeIndicies();
     uint32_t GetVerticesNum() const;
     uint32_t GetIndiciesNum() const;
+
+    // 上传到 GPU 的索引数据，GetIndiciesNum() 个 GetIndexStride() 字节的索引，按子网格绘制
+    IndexFormat GetIndexFormat() const;
+    uint32_t GetIndexStride() const;
+    const void* GetIndexData() const;
+    Util::Span<const Submesh> GetSubmeshes() const;
+    // 上传到 GPU 的顶点数据，GetVerticesNum() 个 GetVertexStride() 字节的顶点
+    VertexFormat GetVertexFormat() const;
+    uint32_t GetVertexStride() const;
+    const void* GetVertexData() const;
+    // 第二个顶点流：每个 GPU 顶点一个 DXGI_FORMAT_R10G10B10A2_UNORM 的切线，
+    // xyz = rgb * 2 - 1，bitangent = (a * 2 - 1) * cross(normal, tangent)。构造时没有要求切线时为空
+    Util::Span<const uint32_t> GetTangents() const;
+    // 量化顶点的位置 = snorm * scale + offset，Float32 时为 (1, 1, 1) 和 (0, 0, 0)
+    void GetPositionDecode(XMFLOAT3& scale, XMFLOAT3& offset) const;
+    // 模型本身的包围盒，不包括地板
+    void GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const;
+    // 以包围盒中心为球心的包围球，不包括地板，用于剔除和阴影视锥拟合
+    void GetBoundingSphere(XMFLOAT3& center, float& radius) const;
+    // 按最终三角形顺序切分的 meshlet 及其包围球和法线锥，用于簇剔除
+    const MeshletBuilder::MeshletData& GetMeshlets() const;
+
+    // 按三角形比例（递减）生成 LOD 链，每一级都是 m_vertices 上的 32 位索引，不包括地板。
+    // 不随缓存保存，需要时调用
+    void GenerateLods(Util::Span<const float> ratios, const MeshSimplifier::Options& options = MeshSimplifier::Options());
+    Util::Span<const MeshSimplifier::LodLevel> GetLods() const;
+
+    // 为射线查询（拾取）建立 BVH，不随缓存保存，需要时调用。大模型上要几十到几百毫秒，最好在加载线程上调用
+    void BuildBvh();
+    bool HasBvh() const;
+    // 模型空间中 origin + t * direction，t 在 [0, tMax) 内最近的交点，没有 BVH 或没有交点时返回 false
+    bool Intersect(FXMVECTOR origin, FXMVECTOR direction, float tMax, ModelHit& hit) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef __MODELLOADQUEUE_H__
+#define __MODELLOADQUEUE_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Model.h"
+
+// 同优先级按提交顺序
+enum class LoadPriority : uint32_t
+{
+    Low,
+    Normal,
+    High
+};
+
+// Model 的构造参数
+struct ModelLoadDesc
+{
+    std::wstring model_name;
+    ModelType modelType = ModelType::OBJ;
+    bool reconstruct = false;
+    bool useCache = true;
+    bool spatialSort = false;
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    bool tangents = false;
+    // 加载后在加载线程上 BuildBvh，用于拾取
+    bool bvh = false;
+};
+
+// 一次异步加载。Get() 和 future 在加载失败或取消时抛出异常
+class ModelLoadHandle
+{
+    friend class ModelLoadQueue;
+public:
+    enum class State : uint32_t
+    {
+        Queued,
+        Loading,
+        Ready,
+        Failed,
+        Cancelled
+    };
+
+private:
+    ModelLoadDesc m_desc;
+    LoadPriority m_priority;
+    uint64_t m_sequence;
+    std::atomic<State> m_state{State::Queued};
+    std::promise<std::shared_ptr<Model>> m_promise;
+    std::shared_future<std::shared_ptr<Model>> m_future;
+    std::chrono::high_resolution_clock::time_point m_requestTime;
+    double m_waitSeconds = 0.;
+    double m_loadSeconds = 0.;
+
+    // 状态从 from 换到 to 成功的一方负责设置 promise，取消和加载完成不会重复设置
+    bool Transition(State from, State to);
+
+public:
+    ModelLoadHandle(ModelLoadDesc desc, LoadPriority priority, uint64_t sequence);
+    ModelLoadHandle(const ModelLoadHandle&) = delete;
+    ModelLoadHandle& operator=(const ModelLoadHandle&) = delete;
+
+    // 排队中的请求不会再加载；正在加载的 Model 构造无法中断，完成后丢弃
+    void Cancel();
+    State GetState() const;
+    // Ready、Failed 或 Cancelled
+    bool IsDone() const;
+    // 阻塞到完成
+    std::shared_ptr<Model> Get() const;
+    std::shared_future<std::shared_ptr<Model>> GetFuture() const;
+
+    const ModelLoadDesc& GetDesc() const;
+    LoadPriority GetPriority() const;
+    // 完成后有效：排队等待的时间和加载（解析、焊接、优化）的时间
+    double GetWaitSeconds() const;
+    double GetLoadSeconds() const;
+    std::chrono::high_resolution_clock::time_point GetRequestTime() const;
+};
+
+// 在一个后台线程上按优先级依次构造 Model。Model 内部的解析和优化已经是多线程的，
+// 同时只加载一个模型，避免多个加载争抢 worker 和内存
+class ModelLoadQueue
+{
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::vector<std::shared_ptr<ModelLoadHandle>> m_queue;
+    uint64_t m_sequence = 0;
+    bool m_quit = false;
+    std::thread m_worker;
+
+    void Run();
+
+public:
+    ModelLoadQueue();
+    // 取消排队中的请求，等待正在进行的加载结束
+    ~ModelLoadQueue();
+    ModelLoadQueue(const ModelLoadQueue&) = delete;
+    ModelLoadQueue& operator=(const ModelLoadQueue&) = delete;
+
+    std::shared_ptr<ModelLoadHandle> Push(ModelLoadDesc desc, LoadPriority priority = LoadPriority::Normal);
+};
+
+#endif
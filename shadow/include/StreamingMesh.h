@@ -0,0 +1,62 @@
+#ifndef __STREAMINGMESH_H__
+#define __STREAMINGMESH_H__
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Model.h"
+#include "common/MeshStream.h"
+#include "common/MeshBounds.h"
+#include "common/UploadRing.h"
+
+// 流式加载：后台线程解析模型文件，loader 边解析边输出的顶点和三角形经 UploadRing 追加到 GPU 缓冲，
+// 大模型在解析过程中逐步显示，staging 内存固定为 slotCount * slotSize。
+// 顶点为源文件坐标（显示时用 GetBounds 归一化），没有法线和 UV，shader 用 FLAT_NORMAL 求面法线
+class StreamingMesh : public MeshStream::Sink<float>
+{
+    UploadRing::Ring m_ring;
+    std::thread m_thread;
+    std::atomic<bool> m_finished{false};
+    std::atomic<bool> m_cancelled{false};
+    std::exception_ptr m_error;
+
+    mutable std::mutex m_boundsMutex;
+    MeshBounds::Aabb<float> m_bounds;
+    std::vector<Vertex> m_block;
+
+    void CheckCancelled() const;
+
+public:
+    // device 的生命周期需要长于 StreamingMesh
+    StreamingMesh(UploadRing::Device& device, uint32_t slotCount = 8, size_t slotSize = 1 << 20);
+    // 取消并等待后台线程结束
+    ~StreamingMesh();
+    StreamingMesh(const StreamingMesh&) = delete;
+    StreamingMesh& operator=(const StreamingMesh&) = delete;
+
+    // 开始在后台线程加载 model 目录下的文件，只能调用一次
+    void Start(std::wstring model_name, ModelType modelType);
+    // 之后的 sink 回调抛出异常，解析提前结束
+    void Cancel();
+    // 等待后台线程，转发加载中的异常
+    void Wait();
+    bool IsFinished() const;
+
+    // 渲染线程调用：已经拷贝完成、可以绘制的顶点数和索引数（整三角形）
+    uint32_t GetVisibleVertexCount();
+    uint32_t GetVisibleIndexCount();
+    // 目前为止收到的顶点的包围盒
+    MeshBounds::Aabb<float> GetBounds() const;
+    // Wait() 之后有效
+    const UploadRing::Stats& GetStats() const;
+
+    void OnBegin(size_t vertexCount, size_t indexCount) override;
+    void OnPositions(const std::array<float, 3>* positions, size_t count) override;
+    void OnIndicies(const uint32_t* indicies, size_t count) override;
+    void OnEnd() override;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __UPLOADDEVICE_H__
+#define __UPLOADDEVICE_H__
+
+#include "stdafx.h"
+#include "CommandQueue.h"
+#include "common/UploadRing.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// UploadRing::Device 的 D3D12 实现：独立的 copy queue，staging 为一个持久 Map 的 upload heap 缓冲，
+// 顶点和索引各一个 default heap 缓冲。缓冲是 simultaneous access 的，copy queue 写入新的区间时
+// direct queue 可以同时读取已经完成的区间
+class D3D12UploadDevice : public UploadRing::Device
+{
+    ComPtr<ID3D12Device2> m_device;
+    std::shared_ptr<CommandQueue> m_copyQueue;
+    ComPtr<ID3D12Resource> m_staging;
+    uint8_t* m_stagingData = nullptr;
+    size_t m_slotSize = 0;
+
+    // 渲染线程通过 GetBuffer 读取，扩容时替换
+    mutable std::mutex m_bufferMutex;
+    ComPtr<ID3D12Resource> m_buffers[UploadRing::S_TARGET_COUNT];
+    uint64_t m_capacity[UploadRing::S_TARGET_COUNT] = {};
+    // 扩容前的缓冲可能还在之前的帧中使用，保留到析构
+    std::vector<ComPtr<ID3D12Resource>> m_retired;
+
+public:
+    explicit D3D12UploadDevice(ComPtr<ID3D12Device2> device);
+    ~D3D12UploadDevice() override;
+
+    void CreateStaging(uint32_t slotCount, size_t slotSize) override;
+    uint8_t* GetStaging(uint32_t slot) override;
+    void Reserve(UploadRing::Target target, uint64_t bytes) override;
+    uint64_t Copy(uint32_t slot, UploadRing::Target target, uint64_t offset, uint64_t size) override;
+    bool IsFenceComplete(uint64_t fence) override;
+    void WaitForFence(uint64_t fence) override;
+
+    // 渲染线程调用，还没有数据时为 nullptr
+    ComPtr<ID3D12Resource> GetBuffer(UploadRing::Target target) const;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace
+{
+    // 单个块的上限，更大的请求单独成块
+    constexpr size_t S_MAX_BLOCK_SIZE = 16 << 20;
+}
+
+namespace Util
+{
+    std::atomic<bool> Arena::s_bypass{false};
+
+    Arena::Arena(size_t firstBlockSize)
+        : m_firstBlockSize(std::max<size_t>(firstBlockSize, 256))
+    {
+    }
+
+    Arena::~Arena()
+    {
+        Release();
+    }
+
+    void* Arena::do_allocate(size_t bytes, size_t alignment)
+    {
+        if (s_bypass)
+        {
+            void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            m_bypassed++;
+            return p;
+        }
+
+        m_allocations++;
+        while (m_current < m_blocks.size())
+        {
+            auto& block = m_blocks[m_current];
+            size_t start = (reinterpret_cast<uintptr_t>(block.data) + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+            start -= reinterpret_cast<uintptr_t>(block.data);
+            if (start + bytes <= block.size)
+            {
+                m_used += start + bytes - m_offset;
+                m_peak = std::max(m_peak, m_used);
+                m_offset = start + bytes;
+                return block.data + start;
+            }
+            // 剩下的部分放弃，Reset 之后再用
+            m_used += block.size - m_offset;
+            m_current++;
+            m_offset = 0;
+        }
+
+        // 块按大小翻倍增长，Reset 后重复的解析不再需要新块
+        size_t size = m_blocks.empty() ? m_firstBlockSize : std::min(m_blocks.back().size * 2, S_MAX_BLOCK_SIZE);
+        size = std::max(size, bytes + alignment);
+        char* data = static_cast<char*>(::operator new(size));
+        m_blocks.push_back(Block{data, size});
+        m_current = m_blocks.size() - 1;
+        m_offset = 0;
+        return do_allocate(bytes, alignment);
+    }
+
+    void Arena::do_deallocate(void* p, size_t bytes, size_t alignment)
+    {
+        // 没有 bypass 期间分配、还没释放的内存时什么都不做
+        if (m_bypassed == 0) return;
+        auto address = static_cast<char*>(p);
+        for (auto& block: m_blocks)
+        {
+            if (address >= block.data && address < block.data + block.size) return;
+        }
+        // 在 bypass 期间分配的
+        m_bypassed--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    Arena::Mark Arena::GetMark() const
+    {
+        return Mark{m_current, m_offset, m_used};
+    }
+
+    void Arena::Rewind(const Mark& mark)
+    {
+        m_current = mark.block;
+        m_offset = mark.offset;
+        m_used = mark.used;
+    }
+
+    void Arena::Reset()
+    {
+        Rewind(Mark{0, 0, 0});
+    }
+
+    void Arena::Release()
+    {
+        for (auto& block: m_blocks)
+        {
+            ::operator delete(block.data);
+        }
+        m_blocks.clear();
+        Reset();
+    }
+
+    size_t Arena::GetReservedBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& block: m_blocks) bytes += block.size;
+        return bytes;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Util
+{
+    // Monotonic pmr memory resource for parse temporaries: allocations bump a pointer through a list of
+    // blocks, deallocate does nothing, Reset / Rewind make the blocks reusable without returning them to
+    // the heap. One arena is used by one thread at a time.
+    class Arena : public std::pmr::memory_resource
+    {
+        struct Block
+        {
+            char* data;
+            size_t size;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_current = 0;       // block that is bumped
+        size_t m_offset = 0;        // used bytes of it
+        size_t m_firstBlockSize;
+        uint64_t m_allocations = 0;
+        size_t m_used = 0;
+        size_t m_peak = 0;
+        size_t m_bypassed = 0;      // heap allocations made during a bypass and not freed yet
+
+        static std::atomic<bool> s_bypass;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    public:
+        struct Mark
+        {
+            size_t block;
+            size_t offset;
+            size_t used;
+        };
+
+        explicit Arena(size_t firstBlockSize = 64 * 1024);
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        Mark GetMark() const;
+        // frees everything allocated after mark
+        void Rewind(const Mark& mark);
+        // frees everything, keeps the blocks
+        void Reset();
+        // frees everything and returns the blocks to the heap
+        void Release();
+
+        uint64_t GetAllocationCount() const { return m_allocations; }
+        // bytes handed out since the last Reset, including the alignment padding
+        size_t GetUsedBytes() const { return m_used; }
+        size_t GetPeakBytes() const { return m_peak; }
+        size_t GetReservedBytes() const;
+
+        // Every arena forwards to the global heap while set, to measure what the arenas save.
+        // Memory allocated before a switch is still released correctly; deallocate only looks up which
+        // blocks own a pointer while heap allocations from a bypass are alive.
+        static void SetBypass(bool bypass) { s_bypass = bypass; }
+        static bool GetBypass() { return s_bypass; }
+    };
+
+    // scratch arena of the calling thread, for temporaries that do not outlive an ArenaScope
+    inline Arena& ThreadArena()
+    {
+        thread_local Arena arena;
+        return arena;
+    }
+
+    // everything allocated from the arena during the scope is freed at its end
+    class ArenaScope
+    {
+        Arena& m_arena;
+        Arena::Mark m_mark;
+
+    public:
+        explicit ArenaScope(Arena& arena = ThreadArena()) : m_arena(arena), m_mark(arena.GetMark()) {}
+        ~ArenaScope() { m_arena.Rewind(m_mark); }
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+    };
+}
+#endif
@@ -0,0 +1,167 @@
+#include "BatchLoader.h"
+#include "MappedFile.h"
+#include "TaskPool.h"
+#include "Utility.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+
+namespace
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    double Seconds(Clock::time_point begin, Clock::time_point end)
+    {
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    uint64_t LoadedBytes(const ModelLoader<>& loader)
+    {
+        using Vec3 = ModelLoader<>::Vec3;
+        return (loader.GetPositions().size() + loader.GetNormals().size() + loader.GetUVWs().size()) * sizeof(Vec3) +
+            loader.GetIndicies().size() * sizeof(uint32_t);
+    }
+
+    // 正在解析或后处理的文件的估计内存之和
+    class Budget
+    {
+        std::mutex m_mutex;
+        std::condition_variable m_released;
+        uint64_t m_limit;
+        uint64_t m_inFlight = 0;
+        uint64_t m_peak = 0;
+
+    public:
+        explicit Budget(uint64_t limit) : m_limit(limit) {}
+
+        // 超出预算的文件等到没有其它文件在处理时单独加载
+        void Acquire(uint64_t bytes)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_released.wait(lock, [&]() { return m_inFlight == 0 || m_inFlight + bytes <= m_limit; });
+            m_inFlight += bytes;
+            m_peak = std::max(m_peak, m_inFlight);
+        }
+
+        void Release(uint64_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_inFlight -= bytes;
+            }
+            m_released.notify_all();
+        }
+
+        uint64_t GetPeak()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_peak;
+        }
+    };
+}
+
+namespace BatchLoader
+{
+    uint64_t EstimateBytes(const Request& request, uint64_t fileBytes)
+    {
+        // 文本 OBJ 的面在解析时先存成每面一个 vector，之后再展开、焊接；PLY 基本按文件大小读入
+        uint64_t factor = request.type == ModelType::OBJ ? 4 : 2;
+        return std::max<uint64_t>(fileBytes * factor, 64 * 1024);
+    }
+
+    std::vector<Result> Load(const std::vector<Request>& requests, const Options& options, Stats* stats)
+    {
+        auto start = Clock::now();
+        std::vector<Result> results(requests.size());
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            Util::MappedFile file;
+            if (file.Open(Util::ToByteString(requests[i].filePath))) results[i].stats.fileBytes = file.Size();
+            results[i].stats.estimatedBytes = EstimateBytes(requests[i], results[i].stats.fileBytes);
+        }
+
+        // 大文件先开始，大小相同时按请求顺序
+        std::vector<size_t> order(requests.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return results[a].stats.fileBytes > results[b].stats.fileBytes;
+        });
+
+        Budget budget(options.memoryBudget);
+        Util::TaskPool pool(options.threadCount ? options.threadCount : Util::WorkerCount());
+        for (size_t index: order)
+        {
+            budget.Acquire(results[index].stats.estimatedBytes);
+            // 每个任务只写自己的 results[index]
+            pool.Submit([&, index]()
+            {
+                auto& result = results[index];
+                auto& request = requests[index];
+                auto parseStart = Clock::now();
+                result.stats.waitSeconds = Seconds(start, parseStart);
+                result.stats.parseWorker = Util::TaskPool::CurrentWorker();
+                try
+                {
+                    auto loader = ModelLoader<>::CreateModelLoader(request.type);
+                    std::wstring filePath = request.filePath;
+                    loader->LoadFromFile(filePath);
+                    result.loader = std::move(loader);
+                }
+                catch (...)
+                {
+                    result.error = std::current_exception();
+                }
+                result.stats.parseSeconds = Seconds(parseStart, Clock::now());
+                if (result.error)
+                {
+                    budget.Release(result.stats.estimatedBytes);
+                    return;
+                }
+
+                pool.Submit([&, index]()
+                {
+                    auto& result = results[index];
+                    auto processStart = Clock::now();
+                    result.stats.processWorker = Util::TaskPool::CurrentWorker();
+                    try
+                    {
+                        if (requests[index].reconstruct) result.loader->Reconstruct();
+                        if (options.process) options.process(index, *result.loader);
+                        result.stats.loadedBytes = LoadedBytes(*result.loader);
+                    }
+                    catch (...)
+                    {
+                        result.error = std::current_exception();
+                        result.loader.reset();
+                    }
+                    result.stats.processSeconds = Seconds(processStart, Clock::now());
+                    budget.Release(result.stats.estimatedBytes);
+                });
+            });
+        }
+        pool.Wait();
+
+        if (stats)
+        {
+            *stats = Stats();
+            stats->fileCount = requests.size();
+            stats->threadCount = pool.GetThreadCount();
+            for (auto& result: results)
+            {
+                stats->failedCount += result.error ? 1 : 0;
+                stats->fileBytes += result.stats.fileBytes;
+                stats->loadedBytes += result.stats.loadedBytes;
+                stats->parseSeconds += result.stats.parseSeconds;
+                stats->processSeconds += result.stats.processSeconds;
+            }
+            stats->peakInFlightBytes = budget.GetPeak();
+            stats->steals = pool.GetStealCount();
+            stats->wallSeconds = Seconds(start, Clock::now());
+        }
+        return results;
+    }
+}
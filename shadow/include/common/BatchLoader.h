@@ -0,0 +1,78 @@
+#ifndef __BATCHLOADER_H__
+#define __BATCHLOADER_H__
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+// Loads many model files at once on a Util::TaskPool: every file is parsed as one task, and its
+// post-processing (Reconstruct, then the caller's Process) is submitted from that task so it usually
+// runs on the same worker while the data is still hot, or gets stolen by an idle one. Files start
+// largest first for a shorter tail, and only while the estimated memory of the files being parsed
+// or processed fits the budget. Results are in request order and do not depend on which worker
+// finished first.
+namespace BatchLoader
+{
+    struct Request
+    {
+        std::wstring filePath;
+        ModelType type = ModelType::OBJ;
+        bool reconstruct = false;
+    };
+
+    struct FileStats
+    {
+        uint64_t fileBytes = 0;
+        uint64_t estimatedBytes = 0;    // charged against the budget while the file is in flight
+        uint64_t loadedBytes = 0;       // arrays held by the loader after post-processing
+        double waitSeconds = 0.;        // from Load() until the parse started
+        double parseSeconds = 0.;
+        double processSeconds = 0.;
+        int32_t parseWorker = -1;
+        int32_t processWorker = -1;
+    };
+
+    struct Result
+    {
+        // nullptr when the file failed, error holds why
+        std::unique_ptr<ModelLoader<>> loader;
+        std::exception_ptr error;
+        FileStats stats;
+    };
+
+    struct Stats
+    {
+        size_t fileCount = 0;
+        size_t failedCount = 0;
+        uint32_t threadCount = 0;
+        uint64_t fileBytes = 0;
+        uint64_t loadedBytes = 0;
+        uint64_t peakInFlightBytes = 0;     // estimated
+        uint64_t steals = 0;
+        double wallSeconds = 0.;
+        // summed over the files, CPU time spent in each stage
+        double parseSeconds = 0.;
+        double processSeconds = 0.;
+    };
+
+    struct Options
+    {
+        uint32_t threadCount = 0;           // 0: Util::WorkerCount()
+        // a file larger than the budget still loads, alone
+        uint64_t memoryBudget = 1ull << 30;
+        // runs on a pool worker after Reconstruct, with the index of the request. It may Take*() the
+        // arrays to convert them into its own format; exceptions fail that file only
+        std::function<void(size_t index, ModelLoader<>& loader)> process;
+    };
+
+    // peak memory of loading a file of fileBytes bytes, parse temporaries included
+    uint64_t EstimateBytes(const Request& request, uint64_t fileBytes);
+
+    // blocks until every file is loaded or failed, never throws for a single file
+    std::vector<Result> Load(const std::vector<Request>& requests, const Options& options = Options(), Stats* stats = nullptr);
+}
+#endif
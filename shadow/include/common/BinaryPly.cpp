@@ -0,0 +1,342 @@
+#include "BinaryPly.h"
+#include "ByteSwap.h"
+#include "MappedFile.h"
+#include "TextParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+    enum class Scalar
+    {
+        Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Unknown
+    };
+
+    size_t ScalarSize(Scalar type)
+    {
+        switch (type)
+        {
+        case Scalar::Int8:
+        case Scalar::UInt8:   return 1;
+        case Scalar::Int16:
+        case Scalar::UInt16:  return 2;
+        case Scalar::Int32:
+        case Scalar::UInt32:
+        case Scalar::Float32: return 4;
+        case Scalar::Float64: return 8;
+        default:              return 0;
+        }
+    }
+
+    // same type names as happly accepts
+    Scalar ToScalar(std::string_view name)
+    {
+        if (name == "char"   || name == "int8")    return Scalar::Int8;
+        if (name == "uchar"  || name == "uint8")   return Scalar::UInt8;
+        if (name == "short"  || name == "int16")   return Scalar::Int16;
+        if (name == "ushort" || name == "uint16")  return Scalar::UInt16;
+        if (name == "int"    || name == "int32")   return Scalar::Int32;
+        if (name == "uint"   || name == "uint32")  return Scalar::UInt32;
+        if (name == "float"  || name == "float32") return Scalar::Float32;
+        if (name == "double" || name == "float64") return Scalar::Float64;
+        return Scalar::Unknown;
+    }
+
+    struct Property
+    {
+        std::string_view name;
+        Scalar type;
+        bool isList;
+        Scalar countType;
+    };
+
+    struct Element
+    {
+        std::string_view name;
+        size_t count;
+        std::vector<Property> properties;
+    };
+
+    struct Header
+    {
+        bool binary = false;
+        bool bigEndian = false;
+        std::vector<Element> elements;
+        size_t dataOffset = 0;
+    };
+
+    std::vector<std::string_view> SplitLine(const char*& p, const char* end)
+    {
+        std::vector<std::string_view> tokens;
+        while (true)
+        {
+            Util::SkipBlanks(p, end);
+            if (p == end || *p == '\n') break;
+            const char* tokenEnd = Util::TokenEnd(p, end);
+            tokens.emplace_back(p, tokenEnd - p);
+            p = tokenEnd;
+        }
+        if (p < end) ++p;
+        return tokens;
+    }
+
+    bool ParseHeader(const char* data, size_t size, Header& header)
+    {
+        const char* p = data;
+        const char* end = data + size;
+
+        auto magic = SplitLine(p, end);
+        if (magic.size() != 1 || magic[0] != "ply") return false;
+
+        while (p < end)
+        {
+            auto tokens = SplitLine(p, end);
+            if (tokens.empty()) continue;
+
+            if (tokens[0] == "end_header")
+            {
+                header.dataOffset = p - data;
+                return true;
+            }
+            else if (tokens[0] == "format")
+            {
+                if (tokens.size() != 3) return false;
+                header.binary = tokens[1] != "ascii";
+                header.bigEndian = tokens[1] == "binary_big_endian";
+            }
+            else if (tokens[0] == "element")
+            {
+                if (tokens.size() != 3) return false;
+                const char* countBegin = tokens[2].data();
+                int64_t count;
+                if (!Util::ParseInt(countBegin, countBegin + tokens[2].size(), count) || count < 0) return false;
+                header.elements.push_back(Element{tokens[1], static_cast<size_t>(count), {}});
+            }
+            else if (tokens[0] == "property")
+            {
+                if (header.elements.empty()) return false;
+                if (tokens.size() == 3)
+                {
+                    header.elements.back().properties.push_back(Property{tokens[2], ToScalar(tokens[1]), false, Scalar::Unknown});
+                }
+                else if (tokens.size() == 5 && tokens[1] == "list")
+                {
+                    header.elements.back().properties.push_back(Property{tokens[4], ToScalar(tokens[3]), true, ToScalar(tokens[2])});
+                }
+                else return false;
+            }
+            // comment, obj_info
+        }
+        return false;
+    }
+
+    // Vertices are gathered in blocks so the big endian swap runs over a small,
+    // cache resident buffer with SIMD instead of per component. The bounds are
+    // accumulated in the same pass, every finished block goes to the sink.
+    template<typename Raw, typename Value, typename T>
+    void ReadPositions(const char* vertexData, size_t count, size_t stride, const size_t (&offsets)[3],
+        bool bigEndian, std::vector<std::array<T, 3>>& positions, MeshBounds::Aabb<T>& bounds, MeshStream::Sink<T>* sink)
+    {
+        static_assert(sizeof(Raw) == sizeof(Value), "raw word must match the component size");
+        constexpr size_t BLOCK = 1024;
+        Raw raw[BLOCK * 3];
+
+        positions.resize(count);
+        for (size_t first = 0; first < count; first += BLOCK)
+        {
+            size_t blockCount = std::min(BLOCK, count - first);
+            const char* vertex = vertexData + first * stride;
+            for (size_t i = 0; i < blockCount; i++, vertex += stride)
+            {
+                std::memcpy(&raw[i * 3    ], vertex + offsets[0], sizeof(Raw));
+                std::memcpy(&raw[i * 3 + 1], vertex + offsets[1], sizeof(Raw));
+                std::memcpy(&raw[i * 3 + 2], vertex + offsets[2], sizeof(Raw));
+            }
+            if (bigEndian)
+            {
+                Util::ByteSwap(raw, blockCount * 3);
+            }
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                Value value[3];
+                std::memcpy(value, &raw[i * 3], sizeof(value));
+                positions[first + i] = {static_cast<T>(value[0]), static_cast<T>(value[1]), static_cast<T>(value[2])};
+                bounds.Extend(positions[first + i].data());
+            }
+            if (sink != nullptr) sink->OnPositions(&positions[first], blockCount);
+        }
+    }
+
+    // faces: <count> <i0> <i1> ... cut into a triangle fan, the raw words are endian-swapped later in bulk
+    void ReadFaces(const char*& p, const char* end, size_t faceCount, bool signedCount, std::vector<uint32_t>& result)
+    {
+        // 每个面至少 1 个计数字节加 3 个索引，先用剩下的字节检查头里的面数再分配
+        constexpr size_t MIN_FACE_BYTES = 1 + 3 * sizeof(uint32_t);
+        if (faceCount > static_cast<size_t>(end - p) / MIN_FACE_BYTES) throw std::runtime_error("ply format error.");
+        result.resize(faceCount * 3);
+        size_t written = 0;
+        for (size_t f = 0; f < faceCount; f++)
+        {
+            if (p >= end) throw std::runtime_error("ply format error.");
+            uint8_t n = static_cast<uint8_t>(*p++);
+            if (n < 3 || (signedCount && n > 127) || static_cast<size_t>(end - p) < n * sizeof(uint32_t))
+            {
+                throw std::runtime_error("ply format error.");
+            }
+
+            size_t triangles = n - 2;
+            if (written + triangles * 3 > result.size())
+            {
+                result.resize(std::max(result.size() * 2, written + triangles * 3));
+            }
+            if (n == 3)
+            {
+                std::memcpy(&result[written], p, 3 * sizeof(uint32_t));
+                written += 3;
+            }
+            else
+            {
+                uint32_t polygon[255];
+                std::memcpy(polygon, p, n * sizeof(uint32_t));
+                for (uint32_t i2 = 2; i2 < n; i2++)
+                {
+                    result[written++] = polygon[0];
+                    result[written++] = polygon[i2 - 1];
+                    result[written++] = polygon[i2];
+                }
+            }
+            p += n * sizeof(uint32_t);
+        }
+        result.resize(written);
+    }
+}
+
+namespace BinaryPly
+{
+    template<typename T>
+    bool Load(const std::string& filePath, std::vector<std::array<T, 3>>& positions, std::vector<uint32_t>& indicies,
+        MeshBounds::Aabb<T>* bounds, MeshStream::Sink<T>* sink)
+    {
+        Util::MappedFile file(filePath);
+        if (!file.IsOpen() || file.Size() == 0) return false;
+
+        Header header;
+        if (!ParseHeader(file.Data(), file.Size(), header) || !header.binary) return false;
+
+        const char* data = file.Data();
+        const char* end = data + file.Size();
+        const char* cursor = data + header.dataOffset;
+
+        const char* vertexData = nullptr;
+        size_t vertexCount = 0;
+        size_t vertexStride = 0;
+        size_t positionOffsets[3] = {};
+        Scalar positionType = Scalar::Unknown;
+
+        std::vector<uint32_t> result;
+        bool facesFound = false;
+
+        for (auto& element: header.elements)
+        {
+            bool hasList = false;
+            size_t stride = 0;
+            for (auto& property: element.properties)
+            {
+                if (property.type == Scalar::Unknown) return false;
+                hasList |= property.isList;
+                stride += ScalarSize(property.type);
+            }
+
+            if (!hasList)
+            {
+                if (element.name == "vertex")
+                {
+                    const char* names[3] = {"x", "y", "z"};
+                    for (int k = 0; k < 3; k++)
+                    {
+                        size_t offset = 0;
+                        bool found = false;
+                        for (auto& property: element.properties)
+                        {
+                            if (property.name == names[k])
+                            {
+                                if (k > 0 && property.type != positionType) return false;
+                                positionType = property.type;
+                                positionOffsets[k] = offset;
+                                found = true;
+                                break;
+                            }
+                            offset += ScalarSize(property.type);
+                        }
+                        if (!found) return false;
+                    }
+                    if (positionType != Scalar::Float32 && positionType != Scalar::Float64) return false;
+
+                    vertexData = cursor;
+                    vertexCount = element.count;
+                    vertexStride = stride;
+                }
+                if (stride == 0 || static_cast<size_t>(end - cursor) / stride < element.count) return false;
+                cursor += element.count * stride;
+            }
+            else if (element.name == "face" && element.properties.size() == 1 && !facesFound)
+            {
+                auto& property = element.properties[0];
+                if (property.countType != Scalar::UInt8 && property.countType != Scalar::Int8) return false;
+                if (property.type != Scalar::Int32 && property.type != Scalar::UInt32) return false;
+
+                ReadFaces(cursor, end, element.count, property.countType == Scalar::Int8, result);
+                facesFound = true;
+            }
+            else
+            {
+                return false;
+            }
+
+            // the rest of the file is not needed
+            if (vertexData != nullptr && facesFound) break;
+        }
+        if (vertexData == nullptr || !facesFound) return false;
+
+        if (sink != nullptr) sink->OnBegin(vertexCount, result.size());
+        MeshBounds::Aabb<T> positionBounds;
+        if (positionType == Scalar::Float32)
+        {
+            ReadPositions<uint32_t, float>(vertexData, vertexCount, vertexStride, positionOffsets, header.bigEndian, positions, positionBounds, sink);
+        }
+        else
+        {
+            ReadPositions<uint64_t, double>(vertexData, vertexCount, vertexStride, positionOffsets, header.bigEndian, positions, positionBounds, sink);
+        }
+
+        // swapped, checked and streamed block by block while the block is in cache
+        constexpr size_t INDEX_BLOCK = 3 * 4096;
+        for (size_t first = 0; first < result.size(); first += INDEX_BLOCK)
+        {
+            size_t blockCount = std::min(INDEX_BLOCK, result.size() - first);
+            uint32_t* block = result.data() + first;
+            if (header.bigEndian)
+            {
+                Util::ByteSwap32(block, blockCount);
+            }
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                // also rejects negative int indices
+                if (block[i] >= vertexCount) throw std::runtime_error("ply format error.");
+            }
+            if (sink != nullptr) sink->OnIndicies(block, blockCount);
+        }
+
+        indicies.swap(result);
+        if (bounds != nullptr) *bounds = positionBounds;
+        return true;
+    }
+
+    template bool Load<float>(const std::string&, std::vector<std::array<float, 3>>&, std::vector<uint32_t>&,
+        MeshBounds::Aabb<float>*, MeshStream::Sink<float>*);
+    template bool Load<double>(const std::string&, std::vector<std::array<double, 3>>&, std::vector<uint32_t>&,
+        MeshBounds::Aabb<double>*, MeshStream::Sink<double>*);
+}
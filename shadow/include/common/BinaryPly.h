@@ -0,0 +1,23 @@
+#ifndef __BINARYPLY_H__
+#define __BINARYPLY_H__
+
+#include <array>
+#include <string>
+#include <vector>
+#include "MeshBounds.h"
+#include "MeshStream.h"
+
+namespace BinaryPly
+{
+    // Fast path for binary (little or big endian) PLY files: the vertex element must have a fixed
+    // stride with float or double x/y/z, the face element a single "list uchar int/uint" property.
+    // Positions and (fan-triangulated) indices are read straight from the mapped file.
+    // Returns false if the file does not qualify, the caller should fall back to happly.
+    // bounds (optional) receives the box of all positions, tracked while they are converted.
+    // sink (optional) gets the positions block by block as they are converted, then the triangles.
+    // Instantiated for float and double positions.
+    template<typename T>
+    bool Load(const std::string& filePath, std::vector<std::array<T, 3>>& positions, std::vector<uint32_t>& indicies,
+        MeshBounds::Aabb<T>* bounds = nullptr, MeshStream::Sink<T>* sink = nullptr);
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef __BYTESWAP_H__
+#define __BYTESWAP_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UTIL_BYTESWAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTIL_BYTESWAP_NEON
+#endif
+
+namespace Util
+{
+    inline uint32_t ByteSwap32(uint32_t v)
+    {
+        return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+    }
+
+    inline uint64_t ByteSwap64(uint64_t v)
+    {
+        return (static_cast<uint64_t>(ByteSwap32(static_cast<uint32_t>(v))) << 32) | ByteSwap32(static_cast<uint32_t>(v >> 32));
+    }
+
+    // in-place endian swap of count 32-bit words
+    inline void ByteSwap32(uint32_t* data, size_t count)
+    {
+        size_t i = 0;
+#if defined(UTIL_BYTESWAP_SSE2)
+        const __m128i lowMask = _mm_set1_epi32(0x00ff00ff);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            // swap bytes inside each 16-bit half, then swap the halves
+            v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 8), lowMask), _mm_slli_epi16(_mm_and_si128(v, lowMask), 8));
+            v = _mm_shufflelo_epi16(_mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), v);
+        }
+#elif defined(UTIL_BYTESWAP_NEON)
+        for (; i + 4 <= count; i += 4)
+        {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+            vst1q_u8(reinterpret_cast<uint8_t*>(data + i), vrev32q_u8(v));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            data[i] = ByteSwap32(data[i]);
+        }
+    }
+
+    // in-place endian swap of count 64-bit words
+    inline void ByteSwap64(uint64_t* data, size_t count)
+    {
+        size_t i = 0;
+#if defined(UTIL_BYTESWAP_SSE2)
+        const __m128i lowMask = _mm_set1_epi32(0x00ff00ff);
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 8), lowMask), _mm_slli_epi16(_mm_and_si128(v, lowMask), 8));
+            v = _mm_shufflelo_epi16(_mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), v);
+        }
+#elif defined(UTIL_BYTESWAP_NEON)
+        for (; i + 2 <= count; i += 2)
+        {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+            vst1q_u8(reinterpret_cast<uint8_t*>(data + i), vrev64q_u8(v));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            data[i] = ByteSwap64(data[i]);
+        }
+    }
+
+    inline void ByteSwap(uint32_t* data, size_t count) { ByteSwap32(data, count); }
+    inline void ByteSwap(uint64_t* data, size_t count) { ByteSwap64(data, count); }
+}
+#endif
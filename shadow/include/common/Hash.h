@@ -0,0 +1,76 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace Util
+{
+    // 64-bit content hash (xxHash64 construction), runs at memory bandwidth on large buffers
+    inline uint64_t Hash64(const void* input, size_t length, uint64_t seed = 0)
+    {
+        constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+        constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+        constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+        auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+        auto read64 = [](const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; };
+        auto read32 = [](const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; };
+        auto round = [&](uint64_t acc, uint64_t value) { return rotl(acc + value * P2, 31) * P1; };
+        auto merge = [&](uint64_t acc, uint64_t value) { return (acc ^ round(0, value)) * P1 + P4; };
+
+        auto p = static_cast<const uint8_t*>(input);
+        const uint8_t* end = p + length;
+        uint64_t h;
+
+        if (length >= 32)
+        {
+            uint64_t v1 = seed + P1 + P2;
+            uint64_t v2 = seed + P2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - P1;
+            for (; p + 32 <= end; p += 32)
+            {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = merge(h, v1);
+            h = merge(h, v2);
+            h = merge(h, v3);
+            h = merge(h, v4);
+        }
+        else
+        {
+            h = seed + P5;
+        }
+
+        h += length;
+        for (; p + 8 <= end; p += 8)
+        {
+            h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+        }
+        if (p + 4 <= end)
+        {
+            h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+            p += 4;
+        }
+        for (; p < end; p++)
+        {
+            h = rotl(h ^ (*p * P5), 11) * P1;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+}
+#endif
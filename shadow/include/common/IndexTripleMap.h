@@ -0,0 +1,83 @@
+#ifndef __INDEXTRIPLEMAP_H__
+#define __INDEXTRIPLEMAP_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Util
+{
+    // Open addressing (linear probing) map from an index triple, e.g. OBJ "v/vt/vn",
+    // to a uint32 value. Keys and values live in one flat array, no per-entry allocation.
+    class IndexTripleMap
+    {
+        struct Slot
+        {
+            uint32_t key[3];
+            uint32_t value;
+        };
+        static constexpr uint32_t S_EMPTY = 0xffffffffu;
+
+        std::vector<Slot> m_slots;
+        size_t m_mask = 0;
+        size_t m_size = 0;
+
+        static size_t Hash(uint32_t a, uint32_t b, uint32_t c)
+        {
+            uint64_t h = (static_cast<uint64_t>(a) << 32 | b) * 0x9E3779B97F4A7C15ull;
+            h ^= (h >> 32) ^ (static_cast<uint64_t>(c) * 0xC2B2AE3D27D4EB4Full);
+            h ^= h >> 29;
+            h *= 0xBF58476D1CE4E5B9ull;
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::vector<Slot> old;
+            old.swap(m_slots);
+            m_slots.assign(capacity, Slot{{0, 0, 0}, S_EMPTY});
+            m_mask = capacity - 1;
+            for (auto& slot: old)
+            {
+                if (slot.value == S_EMPTY) continue;
+                size_t i = Hash(slot.key[0], slot.key[1], slot.key[2]) & m_mask;
+                while (m_slots[i].value != S_EMPTY) i = (i + 1) & m_mask;
+                m_slots[i] = slot;
+            }
+        }
+
+    public:
+        // expected: number of distinct keys, the table grows past it when needed
+        explicit IndexTripleMap(size_t expected = 0)
+        {
+            size_t capacity = 16;
+            while (capacity < expected + expected / 2) capacity <<= 1;
+            Rehash(capacity);
+        }
+
+        size_t Size() const { return m_size; }
+
+        // Returns the value stored for (a, b, c); if the key is new, stores value and returns it.
+        // value must not be 0xffffffff.
+        uint32_t FindOrInsert(uint32_t a, uint32_t b, uint32_t c, uint32_t value)
+        {
+            // keep the load factor under 0.7
+            if ((m_size + 1) * 10 > m_slots.size() * 7) Rehash(m_slots.size() * 2);
+
+            size_t i = Hash(a, b, c) & m_mask;
+            while (true)
+            {
+                Slot& slot = m_slots[i];
+                if (slot.value == S_EMPTY)
+                {
+                    slot = Slot{{a, b, c}, value};
+                    m_size++;
+                    return value;
+                }
+                if (slot.key[0] == a && slot.key[1] == b && slot.key[2] == c) return slot.value;
+                i = (i + 1) & m_mask;
+            }
+        }
+    };
+}
+#endif
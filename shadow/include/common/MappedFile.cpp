@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+    MappedFile::MappedFile(const std::string& filePath)
+    {
+        Open(filePath);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_opened, other.m_opened);
+#ifdef _WIN32
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#else
+            std::swap(m_fd, other.m_fd);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& filePath)
+    {
+        Close();
+
+        HANDLE file = ::CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size = {};
+        if (!::GetFileSizeEx(file, &size))
+        {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_size = static_cast<size_t>(size.QuadPart);
+        m_opened = true;
+        // 不能为空文件创建 file mapping
+        if (m_size == 0) return true;
+
+        HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            Close();
+            return false;
+        }
+        m_mapping = mapping;
+
+        m_data = static_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data) ::UnmapViewOfFile(m_data);
+        if (m_mapping) ::CloseHandle(static_cast<HANDLE>(m_mapping));
+        if (m_file) ::CloseHandle(static_cast<HANDLE>(m_file));
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = nullptr;
+        m_size = 0;
+        m_opened = false;
+    }
+#else
+    bool MappedFile::Open(const std::string& filePath)
+    {
+        Close();
+
+        int fd = ::open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st = {};
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        m_fd = fd;
+        m_size = static_cast<size_t>(st.st_size);
+        m_opened = true;
+        if (m_size == 0) return true;
+
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        ::madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_data = nullptr;
+        m_fd = -1;
+        m_size = 0;
+        m_opened = false;
+    }
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <string>
+#include <cstddef>
+
+namespace Util
+{
+    // read-only memory mapping of a whole file
+    class MappedFile
+    {
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_opened = false;
+
+#ifdef _WIN32
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_fd = -1;
+#endif
+
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool Open(const std::string& filePath);
+        void Close();
+
+        bool IsOpen() const { return m_opened; }
+        // 空文件时返回 nullptr
+        const char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+    };
+}
+#endif
@@ -0,0 +1,268 @@
+#include "MeshBounds.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHBOUNDS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MESHBOUNDS_NEON
+#endif
+
+namespace
+{
+#if defined(MESHBOUNDS_SSE2)
+    using Float4 = __m128;
+    inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+    inline void Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+    inline Float4 Set1(float v) { return _mm_set1_ps(v); }
+    inline Float4 Set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+    inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+    inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+    inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+    inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+    // lanes 0-2 from a, lane 3 from b
+    inline Float4 SelectXyz(Float4 a, Float4 b)
+    {
+        const Float4 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+#elif defined(MESHBOUNDS_NEON)
+    using Float4 = float32x4_t;
+    inline Float4 Load(const float* p) { return vld1q_f32(p); }
+    inline void Store(float* p, Float4 v) { vst1q_f32(p, v); }
+    inline Float4 Set1(float v) { return vdupq_n_f32(v); }
+    inline Float4 Set(float a, float b, float c, float d)
+    {
+        const float lanes[4] = {a, b, c, d};
+        return vld1q_f32(lanes);
+    }
+    inline Float4 Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+    inline Float4 Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+    inline Float4 Min(Float4 a, Float4 b) { return vminq_f32(a, b); }
+    inline Float4 Max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+    inline Float4 SelectXyz(Float4 a, Float4 b) { return vsetq_lane_f32(vgetq_lane_f32(b, 3), a, 3); }
+#else
+    struct Float4
+    {
+        float v[4];
+    };
+    template<typename Op>
+    inline Float4 Map(Float4 a, Float4 b, Op op)
+    {
+        Float4 r;
+        for (int i = 0; i < 4; i++) r.v[i] = op(a.v[i], b.v[i]);
+        return r;
+    }
+    inline Float4 Load(const float* p) { return Float4{{p[0], p[1], p[2], p[3]}}; }
+    inline void Store(float* p, Float4 v) { std::copy(v.v, v.v + 4, p); }
+    inline Float4 Set1(float v) { return Float4{{v, v, v, v}}; }
+    inline Float4 Set(float a, float b, float c, float d) { return Float4{{a, b, c, d}}; }
+    inline Float4 Add(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    inline Float4 Mul(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    inline Float4 Min(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return std::min(x, y); }); }
+    inline Float4 Max(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return std::max(x, y); }); }
+    inline Float4 SelectXyz(Float4 a, Float4 b) { return Float4{{a.v[0], a.v[1], a.v[2], b.v[3]}}; }
+#endif
+
+    // 每个任务至少处理这么多个点，太小时线程开销比内存带宽更贵
+    constexpr size_t S_GRAIN = 1 << 16;
+
+    template<typename T>
+    const T* At(const T* positions, size_t stride, size_t i)
+    {
+        return reinterpret_cast<const T*>(reinterpret_cast<const char*>(positions) + i * stride);
+    }
+    template<typename T>
+    T* At(T* positions, size_t stride, size_t i)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(positions) + i * stride);
+    }
+
+    template<typename T>
+    MeshBounds::Aabb<T> ScalarAabb(const T* positions, size_t begin, size_t end, size_t stride)
+    {
+        MeshBounds::Aabb<T> aabb;
+        for (size_t i = begin; i < end; i++)
+        {
+            aabb.Extend(At(positions, stride, i));
+        }
+        return aabb;
+    }
+
+    MeshBounds::Aabb<float> RangeAabb(const float* positions, size_t begin, size_t end, size_t stride)
+    {
+        MeshBounds::Aabb<float> aabb;
+        size_t i = begin;
+        if (stride == 3 * sizeof(float))
+        {
+            // 4 packed positions are 3 registers: xyzx yzxy zxyz. Per-lane min/max over them,
+            // the stored registers are then 4 xyz triples to fold into the box
+            const float* p = positions + begin * 3;
+            Float4 lo[3] = {Set1(aabb.min[0]), Set1(aabb.min[0]), Set1(aabb.min[0])};
+            Float4 hi[3] = {Set1(aabb.max[0]), Set1(aabb.max[0]), Set1(aabb.max[0])};
+            for (; i + 4 <= end; i += 4, p += 12)
+            {
+                for (int r = 0; r < 3; r++)
+                {
+                    Float4 v = Load(p + r * 4);
+                    lo[r] = Min(lo[r], v);
+                    hi[r] = Max(hi[r], v);
+                }
+            }
+            float triples[2][12];
+            for (int r = 0; r < 3; r++)
+            {
+                Store(triples[0] + r * 4, lo[r]);
+                Store(triples[1] + r * 4, hi[r]);
+            }
+            for (int j = 0; j < 4; j++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    aabb.min[k] = std::min(aabb.min[k], triples[0][j * 3 + k]);
+                    aabb.max[k] = std::max(aabb.max[k], triples[1][j * 3 + k]);
+                }
+            }
+        }
+        else if (stride >= 4 * sizeof(float))
+        {
+            // interleaved vertex: one load per position, lane 3 is the next attribute and ignored.
+            // The last position may end the buffer, the scalar tail reads it
+            Float4 lo = Set1(aabb.min[0]);
+            Float4 hi = Set1(aabb.max[0]);
+            for (; i + 1 < end; i++)
+            {
+                Float4 v = Load(At(positions, stride, i));
+                lo = Min(lo, v);
+                hi = Max(hi, v);
+            }
+            float lanes[2][4];
+            Store(lanes[0], lo);
+            Store(lanes[1], hi);
+            for (int k = 0; k < 3; k++)
+            {
+                aabb.min[k] = lanes[0][k];
+                aabb.max[k] = lanes[1][k];
+            }
+        }
+        aabb.Merge(ScalarAabb(positions, i, end, stride));
+        return aabb;
+    }
+
+    void RangeScaleOffset(float* positions, size_t begin, size_t end, size_t stride, float scale, const float offset[3])
+    {
+        size_t i = begin;
+        Float4 s = Set1(scale);
+        if (stride == 3 * sizeof(float))
+        {
+            const Float4 o0 = Set(offset[0], offset[1], offset[2], offset[0]);
+            const Float4 o1 = Set(offset[1], offset[2], offset[0], offset[1]);
+            const Float4 o2 = Set(offset[2], offset[0], offset[1], offset[2]);
+            float* p = positions + begin * 3;
+            for (; i + 4 <= end; i += 4, p += 12)
+            {
+                Store(p,     Add(Mul(Load(p),     s), o0));
+                Store(p + 4, Add(Mul(Load(p + 4), s), o1));
+                Store(p + 8, Add(Mul(Load(p + 8), s), o2));
+            }
+        }
+        else if (stride >= 4 * sizeof(float))
+        {
+            const Float4 o = Set(offset[0], offset[1], offset[2], 0.f);
+            // lane 3 is written back unchanged; the last position goes to the scalar tail like in RangeAabb
+            for (; i + 1 < end; i++)
+            {
+                float* p = At(positions, stride, i);
+                Float4 v = Load(p);
+                Store(p, SelectXyz(Add(Mul(v, s), o), v));
+            }
+        }
+        for (; i < end; i++)
+        {
+            float* p = At(positions, stride, i);
+            for (int k = 0; k < 3; k++) p[k] = p[k] * scale + offset[k];
+        }
+    }
+
+    template<typename T, typename Range>
+    MeshBounds::Aabb<T> ParallelAabb(const T* positions, size_t count, size_t stride, Range range)
+    {
+        MeshBounds::Aabb<T> aabb;
+        std::mutex mutex;
+        // min/max 与合并顺序无关，结果是确定的
+        Util::ParallelForRange(count, S_GRAIN, [&](size_t begin, size_t end)
+        {
+            auto partial = range(positions, begin, end, stride);
+            std::lock_guard<std::mutex> lock(mutex);
+            aabb.Merge(partial);
+        });
+        return aabb;
+    }
+}
+
+namespace MeshBounds
+{
+    Aabb<float> ComputeAabb(const float* positions, size_t count, size_t stride)
+    {
+        return ParallelAabb(positions, count, stride, RangeAabb);
+    }
+
+    Aabb<double> ComputeAabb(const double* positions, size_t count, size_t stride)
+    {
+        return ParallelAabb(positions, count, stride, ScalarAabb<double>);
+    }
+
+    Sphere ComputeSphere(const float* positions, size_t count, size_t stride, const Aabb<float>& aabb)
+    {
+        Sphere sphere;
+        if (aabb.IsEmpty()) return sphere;
+        for (int k = 0; k < 3; k++)
+        {
+            sphere.center[k] = (aabb.min[k] + aabb.max[k]) / 2;
+        }
+
+        float maxDistance = 0.f;
+        std::mutex mutex;
+        Util::ParallelForRange(count, S_GRAIN, [&](size_t begin, size_t end)
+        {
+            float partial = 0.f;
+            for (size_t i = begin; i < end; i++)
+            {
+                const float* p = At(positions, stride, i);
+                float dx = p[0] - sphere.center[0];
+                float dy = p[1] - sphere.center[1];
+                float dz = p[2] - sphere.center[2];
+                partial = std::max(partial, dx * dx + dy * dy + dz * dz);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            maxDistance = std::max(maxDistance, partial);
+        });
+        sphere.radius = std::sqrt(maxDistance);
+        return sphere;
+    }
+
+    void ScaleOffset(float* positions, size_t count, size_t stride, float scale, const float offset[3])
+    {
+        Util::ParallelForRange(count, S_GRAIN, [&](size_t begin, size_t end)
+        {
+            RangeScaleOffset(positions, begin, end, stride, scale, offset);
+        });
+    }
+
+    void ScaleOffset(double* positions, size_t count, size_t stride, double scale, const double offset[3])
+    {
+        Util::ParallelForRange(count, S_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                double* p = At(positions, stride, i);
+                for (int k = 0; k < 3; k++) p[k] = p[k] * scale + offset[k];
+            }
+        });
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef __MESHBOUNDS_H__
+#define __MESHBOUNDS_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+// Position stream bounds for the loaders and Model: a multi-threaded 4 lane (SSE2/NEON) min/max
+// reduction, the bounding sphere around it and the scale-offset kernel used by Reconstruct,
+// which rewrites the positions in a single streaming pass once the bounds are known.
+namespace MeshBounds
+{
+    // empty box: min = +max, max = -max, so the first Extend sets both
+    template<typename T>
+    struct Aabb
+    {
+        T min[3] = {std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max()};
+        T max[3] = {std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest()};
+
+        bool IsEmpty() const { return min[0] > max[0]; }
+
+        void Extend(const T* p)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                min[k] = p[k] < min[k] ? p[k] : min[k];
+                max[k] = p[k] > max[k] ? p[k] : max[k];
+            }
+        }
+        void Merge(const Aabb& other)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                min[k] = other.min[k] < min[k] ? other.min[k] : min[k];
+                max[k] = other.max[k] > max[k] ? other.max[k] : max[k];
+            }
+        }
+    };
+
+    struct Sphere
+    {
+        float center[3] = {0.f, 0.f, 0.f};
+        float radius = 0.f;
+    };
+
+    // positions: xyz every stride bytes
+    Aabb<float> ComputeAabb(const float* positions, size_t count, size_t stride);
+    Aabb<double> ComputeAabb(const double* positions, size_t count, size_t stride);
+
+    // centered on the box, radius = distance to the farthest position (not the box corner)
+    Sphere ComputeSphere(const float* positions, size_t count, size_t stride, const Aabb<float>& aabb);
+
+    // p = p * scale + offset for every position, in place
+    void ScaleOffset(float* positions, size_t count, size_t stride, float scale, const float offset[3]);
+    void ScaleOffset(double* positions, size_t count, size_t stride, double scale, const double offset[3]);
+
+    // Reconstruct 的变换：盒子中心移到原点，最长边缩放到 [-1,1]，返回变换后的盒子。
+    // 变换单调，直接变换原盒子的两个角，不需要再统计一遍。空盒子或所有点重合时不修改
+    template<typename T>
+    Aabb<T> NormalizeToUnitBox(T* positions, size_t count, size_t stride, const Aabb<T>& aabb)
+    {
+        if (aabb.IsEmpty()) return aabb;
+        T range = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            T extent = aabb.max[k] - aabb.min[k];
+            range = extent > range ? extent : range;
+        }
+        range /= 2;
+        if (!(range > 0)) return aabb;
+
+        T scale = 1 / range;
+        T offset[3];
+        for (int k = 0; k < 3; k++)
+        {
+            offset[k] = -(aabb.max[k] + aabb.min[k]) / 2 * scale;
+        }
+        ScaleOffset(positions, count, stride, scale, offset);
+
+        Aabb<T> result;
+        for (int k = 0; k < 3; k++)
+        {
+            result.min[k] = aabb.min[k] * scale + offset[k];
+            result.max[k] = aabb.max[k] * scale + offset[k];
+        }
+        return result;
+    }
+}
+#endif
@@ -0,0 +1,754 @@
+#include "MeshBvh.h"
+#include "MeshBounds.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHBVH_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MESHBVH_NEON
+#endif
+
+namespace
+{
+    using MeshBvh::Node;
+    using MeshBvh::Node4;
+    using Aabb = MeshBounds::Aabb<float>;
+
+    constexpr uint32_t S_BIN_COUNT = 16;
+    constexpr uint32_t S_MAX_LEAF_SIZE = 8;
+    // 超过这个深度改用中位数划分，每层减半，树的层数到不了 S_MAX_DEPTH；Split 仍然在 S_MAX_DEPTH 处强制叶子，
+    // 遍历栈按它分配：二叉树每层最多压入 1 个，4 叉树每层最多净增 3 个
+    constexpr uint32_t S_MEDIAN_DEPTH = 32;
+    constexpr uint32_t S_MAX_DEPTH = 64;
+    constexpr uint32_t S_STACK_SIZE = S_MAX_DEPTH;
+    constexpr uint32_t S_STACK_SIZE4 = 3 * S_MAX_DEPTH + 1;
+    // 并行统计时每个任务至少处理的三角形数
+    constexpr uint32_t S_PARALLEL_BINNING = 1 << 16;
+    constexpr float S_TRAVERSAL_COST = 1.f;
+    constexpr float S_TRIANGLE_COST = 1.f;
+
+    inline float HalfArea(const Aabb& box)
+    {
+        if (box.IsEmpty()) return 0.f;
+        float dx = box.max[0] - box.min[0], dy = box.max[1] - box.min[1], dz = box.max[2] - box.min[2];
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    struct Bin
+    {
+        Aabb bounds;
+        uint32_t count = 0;
+    };
+
+    struct Bins
+    {
+        Bin bins[3][S_BIN_COUNT];
+
+        void Merge(const Bins& other)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                for (uint32_t b = 0; b < S_BIN_COUNT; b++)
+                {
+                    bins[axis][b].bounds.Merge(other.bins[axis][b].bounds);
+                    bins[axis][b].count += other.bins[axis][b].count;
+                }
+            }
+        }
+    };
+
+    struct Context
+    {
+        std::vector<Aabb> triangleBounds;
+        std::vector<float> centroids;   // 3 per triangle
+        std::vector<uint32_t> ids;      // 构建时原地划分
+    };
+
+    // 节点的包围盒和中心点的包围盒
+    struct RangeBounds
+    {
+        Aabb bounds;
+        Aabb centroidBounds;
+
+        void Merge(const RangeBounds& other)
+        {
+            bounds.Merge(other.bounds);
+            centroidBounds.Merge(other.centroidBounds);
+        }
+    };
+
+    // 区间较大时拆成多个任务，每个任务写自己的部分结果再合并。ParallelFor 每次都要创建线程，
+    // 每个任务至少分到 S_PARALLEL_BINNING 个三角形，BuildTop 的每个节点才划得来
+    template<typename Result, typename Func>
+    Result Reduce(uint32_t begin, uint32_t end, Func&& func)
+    {
+        uint32_t count = end - begin;
+        size_t taskCount = std::min<size_t>(Util::WorkerCount() * 2, count / S_PARALLEL_BINNING);
+        if (taskCount <= 1)
+        {
+            Result result;
+            func(begin, end, result);
+            return result;
+        }
+        std::vector<Result> partial(taskCount);
+        Util::ParallelFor(taskCount, [&](size_t task)
+        {
+            func(static_cast<uint32_t>(begin + count * task / taskCount),
+                static_cast<uint32_t>(begin + count * (task + 1) / taskCount), partial[task]);
+        });
+        for (size_t task = 1; task < taskCount; task++) partial[0].Merge(partial[task]);
+        return partial[0];
+    }
+
+    RangeBounds ComputeRangeBounds(const Context& context, uint32_t begin, uint32_t end)
+    {
+        return Reduce<RangeBounds>(begin, end, [&](uint32_t b, uint32_t e, RangeBounds& result)
+        {
+            for (uint32_t i = b; i < e; i++)
+            {
+                uint32_t id = context.ids[i];
+                result.bounds.Merge(context.triangleBounds[id]);
+                result.centroidBounds.Extend(&context.centroids[id * 3]);
+            }
+        });
+    }
+
+    inline uint32_t BinIndex(float centroid, float minimum, float scale)
+    {
+        auto bin = static_cast<int32_t>((centroid - minimum) * scale);
+        return static_cast<uint32_t>(std::min<int32_t>(std::max<int32_t>(bin, 0), S_BIN_COUNT - 1));
+    }
+
+    // 返回划分位置，叶子更便宜时返回 end
+    uint32_t Split(Context& context, uint32_t begin, uint32_t end, const RangeBounds& range, uint32_t depth)
+    {
+        uint32_t count = end - begin;
+        if (count <= 1 || depth + 1 >= S_MAX_DEPTH) return end;
+
+        float scale[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = range.centroidBounds.max[axis] - range.centroidBounds.min[axis];
+            scale[axis] = extent > 0.f ? S_BIN_COUNT / extent : 0.f;
+        }
+
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        if (depth < S_MEDIAN_DEPTH)
+        {
+            Bins bins = Reduce<Bins>(begin, end, [&](uint32_t b, uint32_t e, Bins& result)
+            {
+                for (uint32_t i = b; i < e; i++)
+                {
+                    uint32_t id = context.ids[i];
+                    const float* centroid = &context.centroids[id * 3];
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        if (scale[axis] == 0.f) continue;
+                        auto& bin = result.bins[axis][BinIndex(centroid[axis], range.centroidBounds.min[axis], scale[axis])];
+                        bin.bounds.Merge(context.triangleBounds[id]);
+                        bin.count++;
+                    }
+                }
+            });
+
+            // 从右往左累积右半部分的面积，再从左往右扫描
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (scale[axis] == 0.f) continue;
+                float rightArea[S_BIN_COUNT];
+                uint32_t rightCount[S_BIN_COUNT];
+                Aabb right;
+                uint32_t rightSum = 0;
+                for (uint32_t b = S_BIN_COUNT - 1; b > 0; b--)
+                {
+                    right.Merge(bins.bins[axis][b].bounds);
+                    rightSum += bins.bins[axis][b].count;
+                    rightArea[b] = HalfArea(right);
+                    rightCount[b] = rightSum;
+                }
+                Aabb left;
+                uint32_t leftSum = 0;
+                for (uint32_t b = 1; b < S_BIN_COUNT; b++)
+                {
+                    left.Merge(bins.bins[axis][b - 1].bounds);
+                    leftSum += bins.bins[axis][b - 1].count;
+                    if (leftSum == 0 || rightCount[b] == 0) continue;
+                    float cost = HalfArea(left) * leftSum + rightArea[b] * rightCount[b];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = b;
+                    }
+                }
+            }
+        }
+
+        float area = HalfArea(range.bounds);
+        float leafCost = count * S_TRIANGLE_COST;
+        float splitCost = area > 0.f ? S_TRAVERSAL_COST + bestCost / area * S_TRIANGLE_COST : leafCost;
+        if (count <= S_MAX_LEAF_SIZE && (bestAxis < 0 || leafCost <= splitCost)) return end;
+
+        uint32_t* first = context.ids.data() + begin;
+        uint32_t* last = context.ids.data() + end;
+        uint32_t* middle = first;
+        if (bestAxis >= 0)
+        {
+            middle = std::partition(first, last, [&](uint32_t id)
+            {
+                return BinIndex(context.centroids[id * 3 + bestAxis], range.centroidBounds.min[bestAxis], scale[bestAxis]) < bestBin;
+            });
+        }
+        // 中心点全部重合或深度太大：按最长轴的中位数划分
+        if (middle == first || middle == last)
+        {
+            int axis = 0;
+            for (int k = 1; k < 3; k++)
+            {
+                if (range.bounds.max[k] - range.bounds.min[k] > range.bounds.max[axis] - range.bounds.min[axis]) axis = k;
+            }
+            middle = first + count / 2;
+            std::nth_element(first, middle, last, [&](uint32_t a, uint32_t b)
+            {
+                float ca = context.centroids[a * 3 + axis], cb = context.centroids[b * 3 + axis];
+                return ca < cb || (ca == cb && a < b);
+            });
+        }
+        return static_cast<uint32_t>(middle - context.ids.data());
+    }
+
+    inline Node MakeNode(const Aabb& bounds, uint32_t offset, uint32_t count)
+    {
+        Node node;
+        for (int k = 0; k < 3; k++)
+        {
+            node.boundsMin[k] = bounds.min[k];
+            node.boundsMax[k] = bounds.max[k];
+        }
+        node.offset = offset;
+        node.count = count;
+        return node;
+    }
+
+    // 深度优先：左子树紧跟父节点，父节点的 offset 指向右子树
+    uint32_t BuildSubtree(Context& context, uint32_t begin, uint32_t end, uint32_t depth, std::vector<Node>& nodes)
+    {
+        RangeBounds range = ComputeRangeBounds(context, begin, end);
+        uint32_t middle = Split(context, begin, end, range, depth);
+        auto index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(MakeNode(range.bounds, begin, end - begin));
+        if (middle == end) return depth + 1;
+
+        uint32_t leftDepth = BuildSubtree(context, begin, middle, depth + 1, nodes);
+        nodes[index].offset = static_cast<uint32_t>(nodes.size());
+        nodes[index].count = 0;
+        uint32_t rightDepth = BuildSubtree(context, middle, end, depth + 1, nodes);
+        return std::max(leftDepth, rightDepth);
+    }
+
+    // 上层节点：大区间在这里划分（统计本身是并行的），划分到足够小的区间作为独立的子树任务
+    struct TopNode
+    {
+        Aabb bounds;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t depth;
+        int32_t left = -1;
+        int32_t right = -1;
+        int32_t job = -1;
+    };
+
+    int32_t BuildTop(Context& context, uint32_t begin, uint32_t end, uint32_t depth, uint32_t jobSize,
+        std::vector<TopNode>& top, std::vector<int32_t>& jobs)
+    {
+        auto index = static_cast<int32_t>(top.size());
+        top.push_back(TopNode{Aabb(), begin, end, depth});
+        if (end - begin <= jobSize)
+        {
+            top[index].job = static_cast<int32_t>(jobs.size());
+            jobs.push_back(index);
+            return index;
+        }
+
+        RangeBounds range = ComputeRangeBounds(context, begin, end);
+        top[index].bounds = range.bounds;
+        uint32_t middle = Split(context, begin, end, range, depth);
+        if (middle == end)
+        {
+            top[index].job = static_cast<int32_t>(jobs.size());
+            jobs.push_back(index);
+            return index;
+        }
+        int32_t left = BuildTop(context, begin, middle, depth + 1, jobSize, top, jobs);
+        int32_t right = BuildTop(context, middle, end, depth + 1, jobSize, top, jobs);
+        top[index].left = left;
+        top[index].right = right;
+        return index;
+    }
+
+    void Emit(const std::vector<TopNode>& top, int32_t index, const std::vector<std::vector<Node>>& subtrees, std::vector<Node>& nodes)
+    {
+        auto& node = top[index];
+        if (node.job >= 0)
+        {
+            auto base = static_cast<uint32_t>(nodes.size());
+            for (Node subtreeNode: subtrees[node.job])
+            {
+                if (subtreeNode.count == 0) subtreeNode.offset += base;
+                nodes.push_back(subtreeNode);
+            }
+            return;
+        }
+        auto position = nodes.size();
+        nodes.push_back(MakeNode(node.bounds, 0, 0));
+        Emit(top, node.left, subtrees, nodes);
+        nodes[position].offset = static_cast<uint32_t>(nodes.size());
+        Emit(top, node.right, subtrees, nodes);
+    }
+
+    struct PreparedRay
+    {
+        float origin[3];
+        float direction[3];
+        float inverse[3];
+        float tMax;
+    };
+
+    PreparedRay Prepare(const MeshBvh::Ray& ray)
+    {
+        PreparedRay prepared;
+        for (int k = 0; k < 3; k++)
+        {
+            prepared.origin[k] = ray.origin[k];
+            prepared.direction[k] = ray.direction[k];
+            // 0 的倒数为 inf，slab 测试里得到 +-inf 仍然正确
+            prepared.inverse[k] = 1.f / ray.direction[k];
+        }
+        prepared.tMax = ray.tMax;
+        return prepared;
+    }
+
+    inline bool HitBox(const float boundsMin[3], const float boundsMax[3], const PreparedRay& ray, float& tNear)
+    {
+        float t0 = 0.f, t1 = ray.tMax;
+        for (int k = 0; k < 3; k++)
+        {
+            float a = (boundsMin[k] - ray.origin[k]) * ray.inverse[k];
+            float b = (boundsMax[k] - ray.origin[k]) * ray.inverse[k];
+            t0 = std::max(t0, std::min(a, b));
+            t1 = std::min(t1, std::max(a, b));
+        }
+        tNear = t0;
+        return t0 <= t1;
+    }
+
+    // Möller-Trumbore，data: v0, e1, e2
+    inline bool HitTriangle(const float* data, const PreparedRay& ray, float& t, float& u, float& v)
+    {
+        const float* v0 = data;
+        const float* e1 = data + 3;
+        const float* e2 = data + 6;
+        const float* d = ray.direction;
+        float p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+        float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (det == 0.f) return false;
+        float inverse = 1.f / det;
+        float s[3] = {ray.origin[0] - v0[0], ray.origin[1] - v0[1], ray.origin[2] - v0[2]};
+        u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+        if (u < 0.f || u > 1.f) return false;
+        float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+        v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverse;
+        if (v < 0.f || u + v > 1.f) return false;
+        t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+        return t >= 0.f && t < ray.tMax;
+    }
+
+    // 叶子里的三角形，找到更近的交点时缩短 ray.tMax
+    template<bool AnyHit>
+    bool IntersectLeaf(const std::vector<float>& triangleData, uint32_t first, uint32_t count, PreparedRay& ray, uint32_t& slot,
+        float& u, float& v)
+    {
+        bool found = false;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            float t, hitU, hitV;
+            if (!HitTriangle(&triangleData[i * 9], ray, t, hitU, hitV)) continue;
+            ray.tMax = t;
+            slot = i;
+            u = hitU;
+            v = hitV;
+            found = true;
+            if (AnyHit) break;
+        }
+        return found;
+    }
+
+    template<bool AnyHit>
+    bool Traverse(const MeshBvh::Bvh& bvh, const MeshBvh::Ray& sourceRay, MeshBvh::Hit* hit)
+    {
+        if (bvh.nodes.empty()) return false;
+        PreparedRay ray = Prepare(sourceRay);
+        float tNear;
+        if (!HitBox(bvh.nodes[0].boundsMin, bvh.nodes[0].boundsMax, ray, tNear)) return false;
+
+        uint32_t stack[S_STACK_SIZE];
+        uint32_t stackSize = 0;
+        uint32_t slot = MeshBvh::S_NO_HIT;
+        float u = 0.f, v = 0.f;
+        uint32_t index = 0;
+        while (true)
+        {
+            const Node& node = bvh.nodes[index];
+            if (node.count > 0)
+            {
+                if (IntersectLeaf<AnyHit>(bvh.triangleData, node.offset, node.count, ray, slot, u, v) && AnyHit) return true;
+            }
+            else
+            {
+                // 先走近的子节点，远的入栈
+                uint32_t left = index + 1, right = node.offset;
+                float tLeft, tRight;
+                bool hitLeft = HitBox(bvh.nodes[left].boundsMin, bvh.nodes[left].boundsMax, ray, tLeft);
+                bool hitRight = HitBox(bvh.nodes[right].boundsMin, bvh.nodes[right].boundsMax, ray, tRight);
+                if (hitLeft && hitRight)
+                {
+                    if (tRight < tLeft) std::swap(left, right);
+                    stack[stackSize++] = right;
+                    index = left;
+                    continue;
+                }
+                if (hitLeft || hitRight)
+                {
+                    index = hitLeft ? left : right;
+                    continue;
+                }
+            }
+            if (stackSize == 0) break;
+            index = stack[--stackSize];
+        }
+
+        if (slot == MeshBvh::S_NO_HIT) return false;
+        if (hit != nullptr)
+        {
+            hit->t = ray.tMax;
+            hit->triangle = bvh.triangles[slot];
+            hit->u = u;
+            hit->v = v;
+        }
+        return true;
+    }
+
+    // 四个子节点的包围盒一次测试，返回命中的掩码，tNear 为各自的进入距离
+    inline uint32_t HitBoxes(const Node4& node, const PreparedRay& ray, float tNear[4])
+    {
+#if defined(MESHBVH_SSE2)
+        __m128 t0 = _mm_setzero_ps(), t1 = _mm_set1_ps(ray.tMax);
+        for (int k = 0; k < 3; k++)
+        {
+            __m128 origin = _mm_set1_ps(ray.origin[k]), inverse = _mm_set1_ps(ray.inverse[k]);
+            __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.boundsMin[k]), origin), inverse);
+            __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.boundsMax[k]), origin), inverse);
+            t0 = _mm_max_ps(t0, _mm_min_ps(a, b));
+            t1 = _mm_min_ps(t1, _mm_max_ps(a, b));
+        }
+        _mm_storeu_ps(tNear, t0);
+        __m128i empty = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(node.child)), _mm_set1_epi32(-1));
+        __m128 mask = _mm_andnot_ps(_mm_castsi128_ps(empty), _mm_cmple_ps(t0, t1));
+        return static_cast<uint32_t>(_mm_movemask_ps(mask));
+#elif defined(MESHBVH_NEON)
+        float32x4_t t0 = vdupq_n_f32(0.f), t1 = vdupq_n_f32(ray.tMax);
+        for (int k = 0; k < 3; k++)
+        {
+            float32x4_t origin = vdupq_n_f32(ray.origin[k]), inverse = vdupq_n_f32(ray.inverse[k]);
+            float32x4_t a = vmulq_f32(vsubq_f32(vld1q_f32(node.boundsMin[k]), origin), inverse);
+            float32x4_t b = vmulq_f32(vsubq_f32(vld1q_f32(node.boundsMax[k]), origin), inverse);
+            t0 = vmaxq_f32(t0, vminq_f32(a, b));
+            t1 = vminq_f32(t1, vmaxq_f32(a, b));
+        }
+        vst1q_f32(tNear, t0);
+        uint32x4_t hit = vbicq_u32(vcleq_f32(t0, t1), vceqq_u32(vld1q_u32(node.child), vdupq_n_u32(MeshBvh::S_NO_HIT)));
+        uint32_t lanes[4];
+        vst1q_u32(lanes, hit);
+        return (lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8);
+#else
+        uint32_t mask = 0;
+        for (int c = 0; c < 4; c++)
+        {
+            if (node.child[c] == MeshBvh::S_NO_HIT) continue;
+            float boundsMin[3] = {node.boundsMin[0][c], node.boundsMin[1][c], node.boundsMin[2][c]};
+            float boundsMax[3] = {node.boundsMax[0][c], node.boundsMax[1][c], node.boundsMax[2][c]};
+            if (HitBox(boundsMin, boundsMax, ray, tNear[c])) mask |= 1u << c;
+        }
+        return mask;
+#endif
+    }
+
+    template<bool AnyHit>
+    bool Traverse(const MeshBvh::Bvh4& bvh, const MeshBvh::Ray& sourceRay, MeshBvh::Hit* hit)
+    {
+        if (bvh.nodes.empty()) return false;
+        PreparedRay ray = Prepare(sourceRay);
+
+        // 弹出 1 个、最多压入 4 个
+        struct Entry
+        {
+            uint32_t node;
+            float tNear;
+        };
+        Entry stack[S_STACK_SIZE4];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = Entry{0, 0.f};
+        uint32_t slot = MeshBvh::S_NO_HIT;
+        float u = 0.f, v = 0.f;
+        while (stackSize > 0)
+        {
+            Entry entry = stack[--stackSize];
+            // 入栈之后找到了更近的交点
+            if (entry.tNear > ray.tMax) continue;
+
+            const Node4& node = bvh.nodes[entry.node];
+            float tNear[4];
+            uint32_t mask = HitBoxes(node, ray, tNear);
+            Entry children[4];
+            uint32_t childCount = 0;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if ((mask & (1u << c)) == 0) continue;
+                if (node.count[c] > 0)
+                {
+                    if (IntersectLeaf<AnyHit>(bvh.triangleData, node.child[c], node.count[c], ray, slot, u, v) && AnyHit) return true;
+                    continue;
+                }
+                // 按距离插入排序，远的先入栈
+                uint32_t i = childCount++;
+                for (; i > 0 && children[i - 1].tNear < tNear[c]; i--) children[i] = children[i - 1];
+                children[i] = Entry{node.child[c], tNear[c]};
+            }
+            for (uint32_t i = 0; i < childCount; i++) stack[stackSize++] = children[i];
+        }
+
+        if (slot == MeshBvh::S_NO_HIT) return false;
+        if (hit != nullptr)
+        {
+            hit->t = ray.tMax;
+            hit->triangle = bvh.triangles[slot];
+            hit->u = u;
+            hit->v = v;
+        }
+        return true;
+    }
+
+    // 二叉节点 index 折叠成一个 4 叉节点：反复展开面积最大的内部子节点，直到有 4 个子节点
+    uint32_t CollapseNode(const MeshBvh::Bvh& bvh, uint32_t index, std::vector<Node4>& nodes)
+    {
+        uint32_t children[4];
+        uint32_t childCount = 0;
+        const Node& node = bvh.nodes[index];
+        if (node.count > 0)
+        {
+            children[childCount++] = index;
+        }
+        else
+        {
+            children[childCount++] = index + 1;
+            children[childCount++] = node.offset;
+            while (childCount < 4)
+            {
+                int best = -1;
+                float bestArea = -1.f;
+                for (uint32_t c = 0; c < childCount; c++)
+                {
+                    const Node& child = bvh.nodes[children[c]];
+                    if (child.count > 0) continue;
+                    Aabb box;
+                    box.Extend(child.boundsMin);
+                    box.Extend(child.boundsMax);
+                    float area = HalfArea(box);
+                    if (area > bestArea)
+                    {
+                        bestArea = area;
+                        best = static_cast<int>(c);
+                    }
+                }
+                if (best < 0) break;
+                uint32_t expanded = children[best];
+                children[best] = expanded + 1;
+                children[childCount++] = bvh.nodes[expanded].offset;
+            }
+        }
+
+        auto result = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            // 空位：包围盒为空，child 标记为无效
+            float boundsMin[3] = {0.f, 0.f, 0.f}, boundsMax[3] = {0.f, 0.f, 0.f};
+            uint32_t child = MeshBvh::S_NO_HIT, count = 0;
+            if (c < childCount)
+            {
+                const Node& source = bvh.nodes[children[c]];
+                std::copy(source.boundsMin, source.boundsMin + 3, boundsMin);
+                std::copy(source.boundsMax, source.boundsMax + 3, boundsMax);
+                if (source.count > 0)
+                {
+                    child = source.offset;
+                    count = source.count;
+                }
+                else
+                {
+                    child = CollapseNode(bvh, children[c], nodes);
+                }
+            }
+            // 递归可能让 nodes 重新分配，最后再写
+            auto& target = nodes[result];
+            for (int k = 0; k < 3; k++)
+            {
+                target.boundsMin[k][c] = boundsMin[k];
+                target.boundsMax[k][c] = boundsMax[k];
+            }
+            target.child[c] = child;
+            target.count[c] = count;
+        }
+        return result;
+    }
+}
+
+namespace MeshBvh
+{
+    Bvh Build(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+    {
+        Bvh bvh;
+        auto triangleCount = static_cast<uint32_t>(indexCount / 3);
+        if (triangleCount == 0) return bvh;
+
+        auto position = [&](uint32_t vertex)
+        {
+            return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+        };
+
+        // 越界的索引在任务里抛出，ParallelFor 转到调用线程
+        Context context;
+        context.triangleBounds.resize(triangleCount);
+        context.centroids.resize(triangleCount * 3);
+        context.ids.resize(triangleCount);
+        Util::ParallelForRange(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+            {
+                Aabb box;
+                for (int k = 0; k < 3; k++)
+                {
+                    if (indicies[t * 3 + k] >= vertexCount) throw std::runtime_error("MeshBvh: index out of range");
+                    box.Extend(position(indicies[t * 3 + k]));
+                }
+                context.triangleBounds[t] = box;
+                for (int k = 0; k < 3; k++) context.centroids[t * 3 + k] = (box.min[k] + box.max[k]) * 0.5f;
+                context.ids[t] = static_cast<uint32_t>(t);
+            }
+        });
+
+        // 子树数量是线程数的几倍，子树之间负载不均时也能分摊
+        uint32_t jobSize = std::max<uint32_t>(4096, triangleCount / (Util::WorkerCount() * 8));
+        std::vector<TopNode> top;
+        std::vector<int32_t> jobs;
+        BuildTop(context, 0, triangleCount, 0, jobSize, top, jobs);
+
+        std::vector<std::vector<Node>> subtrees(jobs.size());
+        std::vector<uint32_t> depths(jobs.size());
+        // 子树里的 Reduce 在任务线程上就地执行，不会再开线程
+        Util::ParallelFor(jobs.size(), [&](size_t job)
+        {
+            auto& node = top[jobs[job]];
+            subtrees[job].reserve((node.end - node.begin) / 2);
+            depths[job] = BuildSubtree(context, node.begin, node.end, node.depth, subtrees[job]);
+        });
+
+        size_t nodeCount = top.size() - jobs.size();
+        for (auto& subtree: subtrees) nodeCount += subtree.size();
+        bvh.nodes.reserve(nodeCount);
+        Emit(top, 0, subtrees, bvh.nodes);
+        bvh.depth = *std::max_element(depths.begin(), depths.end());
+
+        // 三角形按叶子顺序排列，预先算好 v0 和两条边
+        bvh.triangles = std::move(context.ids);
+        bvh.triangleData.resize(size_t(triangleCount) * 9);
+        Util::ParallelForRange(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                uint32_t t = bvh.triangles[i];
+                const float* v0 = position(indicies[t * 3]);
+                const float* v1 = position(indicies[t * 3 + 1]);
+                const float* v2 = position(indicies[t * 3 + 2]);
+                float* data = &bvh.triangleData[i * 9];
+                for (int k = 0; k < 3; k++)
+                {
+                    data[k] = v0[k];
+                    data[3 + k] = v1[k] - v0[k];
+                    data[6 + k] = v2[k] - v0[k];
+                }
+            }
+        });
+        return bvh;
+    }
+
+    Bvh4 Collapse(const Bvh& bvh)
+    {
+        Bvh4 result;
+        if (bvh.nodes.empty()) return result;
+        result.nodes.reserve(bvh.nodes.size() / 2 + 1);
+        CollapseNode(bvh, 0, result.nodes);
+        result.triangles = bvh.triangles;
+        result.triangleData = bvh.triangleData;
+        return result;
+    }
+
+    bool Intersect(const Bvh& bvh, const Ray& ray, Hit& hit)
+    {
+        return Traverse<false>(bvh, ray, &hit);
+    }
+
+    bool Intersect(const Bvh4& bvh, const Ray& ray, Hit& hit)
+    {
+        return Traverse<false>(bvh, ray, &hit);
+    }
+
+    bool Occluded(const Bvh& bvh, const Ray& ray)
+    {
+        return Traverse<true>(bvh, ray, nullptr);
+    }
+
+    bool Occluded(const Bvh4& bvh, const Ray& ray)
+    {
+        return Traverse<true>(bvh, ray, nullptr);
+    }
+
+    float SahCost(const Bvh& bvh)
+    {
+        if (bvh.nodes.empty()) return 0.f;
+        auto area = [](const Node& node)
+        {
+            Aabb box;
+            box.Extend(node.boundsMin);
+            box.Extend(node.boundsMax);
+            return HalfArea(box);
+        };
+        float rootArea = area(bvh.nodes[0]);
+        if (!(rootArea > 0.f)) return static_cast<float>(bvh.triangles.size());
+        double cost = 0.;
+        for (auto& node: bvh.nodes)
+        {
+            cost += area(node) / rootArea * (node.count > 0 ? node.count * S_TRIANGLE_COST : S_TRAVERSAL_COST);
+        }
+        return static_cast<float>(cost);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __MESHBVH_H__
+#define __MESHBVH_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Bounding volume hierarchy over a triangle list for CPU ray queries (picking, baking, shadow checks).
+// Built top-down with binned SAH: the upper levels bin in parallel, below that independent subtrees
+// are built in parallel and stitched together. Nodes are 32 bytes in depth-first order (the left child
+// follows its parent), and the binary tree can be collapsed into a 4-wide one whose four child boxes
+// are tested at once with SSE2 / NEON.
+namespace MeshBvh
+{
+    constexpr uint32_t S_NO_HIT = 0xffffffffu;
+
+    // interior: count == 0, left child = this + 1, right child = offset
+    // leaf: triangles [offset, offset + count) of Bvh::triangles
+    struct Node
+    {
+        float boundsMin[3];
+        uint32_t offset;
+        float boundsMax[3];
+        uint32_t count;
+    };
+    static_assert(sizeof(Node) == 32, "MeshBvh::Node is expected to be 32 bytes");
+
+    // SoA child boxes. Per slot: count > 0 is a leaf like Node's, count == 0 an interior node index,
+    // child == S_NO_HIT an empty slot
+    struct Node4
+    {
+        float boundsMin[3][4];
+        float boundsMax[3][4];
+        uint32_t child[4];
+        uint32_t count[4];
+    };
+    static_assert(sizeof(Node4) == 128, "MeshBvh::Node4 is expected to be 128 bytes");
+
+    struct Bvh
+    {
+        std::vector<Node> nodes;
+        // source triangle (index / 3 into the index buffer) of every leaf slot
+        std::vector<uint32_t> triangles;
+        // per leaf slot: v0, v1 - v0, v2 - v0, copied from the positions so traversal does not gather
+        std::vector<float> triangleData;
+        uint32_t depth = 0;
+    };
+
+    struct Bvh4
+    {
+        std::vector<Node4> nodes;
+        std::vector<uint32_t> triangles;
+        std::vector<float> triangleData;
+    };
+
+    // direction does not need to be normalized, t is in units of it
+    struct Ray
+    {
+        float origin[3];
+        float direction[3];
+        float tMax = std::numeric_limits<float>::max();
+    };
+
+    // p = (1 - u - v) * v0 + u * v1 + v * v2 of the source triangle
+    struct Hit
+    {
+        float t = std::numeric_limits<float>::max();
+        uint32_t triangle = S_NO_HIT;
+        float u = 0.f;
+        float v = 0.f;
+    };
+
+    // positions: xyz every positionStride bytes. Throws std::runtime_error for indices >= vertexCount
+    Bvh Build(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+    Bvh4 Collapse(const Bvh& bvh);
+
+    // closest hit with t in [0, ray.tMax), hit is untouched when there is none
+    bool Intersect(const Bvh& bvh, const Ray& ray, Hit& hit);
+    bool Intersect(const Bvh4& bvh, const Ray& ray, Hit& hit);
+    // any hit in [0, ray.tMax)
+    bool Occluded(const Bvh& bvh, const Ray& ray);
+    bool Occluded(const Bvh4& bvh, const Ray& ray);
+
+    // expected cost relative to testing every triangle (traversal step 1, triangle test 1)
+    float SahCost(const Bvh& bvh);
+}
+#endif
@@ -0,0 +1,171 @@
+#include "MeshCache.h"
+#include "Hash.h"
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    const char S_MAGIC[4] = {'M', 'S', 'H', 'C'};
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // count elements of elementSize bytes at offset lie inside a file of size bytes, without overflowing on garbage headers
+    bool FitsIn(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size)
+    {
+        return offset <= size && count <= (size - offset) / elementSize;
+    }
+
+    bool SameKey(const MeshCache::Key& a, const MeshCache::Key& b)
+    {
+        return a.sourceHash == b.sourceHash && a.sourceSize == b.sourceSize &&
+            a.options == b.options && a.vertexStride == b.vertexStride;
+    }
+}
+
+namespace MeshCache
+{
+    bool MakeKey(const std::string& sourcePath, uint32_t options, uint32_t vertexStride, Key& key)
+    {
+        Util::MappedFile source(sourcePath);
+        if (!source.IsOpen()) return false;
+
+        key.sourceHash = Util::Hash64(source.Data(), source.Size());
+        key.sourceSize = source.Size();
+        key.options = options;
+        key.vertexStride = vertexStride;
+        return true;
+    }
+
+    bool Write(const std::string& cachePath, const Key& key,
+        const void* vertices, uint64_t vertexCount,
+        const uint32_t* indicies, uint64_t indexCount,
+        const uint32_t* tangents, uint64_t tangentCount,
+        const uint32_t* submeshRanges, uint64_t submeshRangeCount,
+        const float boundsMin[3], const float boundsMax[3], const float boundingSphere[4],
+        const MeshletBuilder::MeshletData& meshlets)
+    {
+        auto encodedVertices = MeshCodec::EncodeVertexBuffer(vertices, vertexCount, key.vertexStride);
+        auto encodedIndicies = MeshCodec::EncodeIndexBuffer(indicies, indexCount);
+        auto encodedTangents = MeshCodec::EncodeVertexBuffer(tangents, tangentCount, sizeof(uint32_t));
+
+        Header header = {};
+        std::copy(S_MAGIC, S_MAGIC + 4, header.magic);
+        header.version = S_VERSION;
+        header.key = key;
+        header.vertexCount = vertexCount;
+        header.indexCount = indexCount;
+        header.vertexBytes = encodedVertices.size();
+        header.indexBytes = encodedIndicies.size();
+        header.tangentBytes = encodedTangents.size();
+        header.vertexOffset = AlignUp(sizeof(Header), 16);
+        header.indexOffset = AlignUp(header.vertexOffset + header.vertexBytes, 16);
+        header.meshletCount = meshlets.meshlets.size();
+        header.meshletVertexCount = meshlets.vertices.size();
+        header.meshletTriangleCount = meshlets.triangles.size();
+        header.meshletOffset = AlignUp(header.indexOffset + header.indexBytes, 16);
+        header.meshletVertexOffset = AlignUp(header.meshletOffset +
+            header.meshletCount * (sizeof(MeshletBuilder::Meshlet) + sizeof(MeshletBuilder::MeshletBounds)), 16);
+        header.meshletTriangleOffset = AlignUp(header.meshletVertexOffset + header.meshletVertexCount * sizeof(uint32_t), 16);
+        header.tangentCount = tangentCount;
+        header.tangentOffset = AlignUp(header.meshletTriangleOffset + header.meshletTriangleCount, 16);
+        header.submeshRangeCount = submeshRangeCount;
+        header.submeshRangeOffset = AlignUp(header.tangentOffset + header.tangentBytes, 16);
+        for (int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = boundsMin[i];
+            header.boundsMax[i] = boundsMax[i];
+        }
+        std::copy(boundingSphere, boundingSphere + 4, header.boundingSphere);
+
+        // write to a temporary file first so a crash never leaves a half written cache behind
+        std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ofstream::binary | std::ofstream::trunc);
+            if (out.fail()) return false;
+
+            const char zeros[16] = {};
+            uint64_t position = 0;
+            auto writeAt = [&](uint64_t offset, const void* data, uint64_t size)
+            {
+                out.write(zeros, offset - position);
+                out.write(static_cast<const char*>(data), size);
+                position = offset + size;
+            };
+            writeAt(0, &header, sizeof(header));
+            writeAt(header.vertexOffset, encodedVertices.data(), header.vertexBytes);
+            writeAt(header.indexOffset, encodedIndicies.data(), header.indexBytes);
+            writeAt(header.meshletOffset, meshlets.meshlets.data(), header.meshletCount * sizeof(MeshletBuilder::Meshlet));
+            writeAt(position, meshlets.bounds.data(), header.meshletCount * sizeof(MeshletBuilder::MeshletBounds));
+            writeAt(header.meshletVertexOffset, meshlets.vertices.data(), header.meshletVertexCount * sizeof(uint32_t));
+            writeAt(header.meshletTriangleOffset, meshlets.triangles.data(), header.meshletTriangleCount);
+            writeAt(header.tangentOffset, encodedTangents.data(), header.tangentBytes);
+            writeAt(header.submeshRangeOffset, submeshRanges, header.submeshRangeCount * sizeof(uint32_t));
+            if (out.fail()) return false;
+        }
+
+        std::remove(cachePath.c_str());
+        return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+    }
+
+    bool CacheFile::Open(const std::string& cachePath, const Key& key)
+    {
+        m_header = nullptr;
+        if (!m_file.Open(cachePath)) return false;
+
+        auto header = reinterpret_cast<const Header*>(m_file.Data());
+        uint64_t size = m_file.Size();
+        bool valid = size >= sizeof(Header) &&
+            std::equal(S_MAGIC, S_MAGIC + 4, header->magic) &&
+            header->version == S_VERSION &&
+            SameKey(header->key, key) &&
+            FitsIn(header->vertexOffset, header->vertexBytes, 1, size) &&
+            FitsIn(header->indexOffset, header->indexBytes, 1, size) &&
+            FitsIn(header->meshletOffset, header->meshletCount,
+                sizeof(MeshletBuilder::Meshlet) + sizeof(MeshletBuilder::MeshletBounds), size) &&
+            FitsIn(header->meshletVertexOffset, header->meshletVertexCount, sizeof(uint32_t), size) &&
+            FitsIn(header->meshletTriangleOffset, header->meshletTriangleCount, 1, size) &&
+            FitsIn(header->tangentOffset, header->tangentBytes, 1, size) &&
+            FitsIn(header->submeshRangeOffset, header->submeshRangeCount, sizeof(uint32_t), size);
+        // 解码前调用方按这些数分配内存，先和编码后的大小对照，坏的头不会分配出巨大的数组
+        valid = valid &&
+            header->vertexCount <= MeshCodec::MaxVertexCount(header->vertexBytes, key.vertexStride) &&
+            header->indexCount <= MeshCodec::MaxIndexCount(header->indexBytes) &&
+            (header->tangentCount == 0 || header->tangentCount == header->vertexCount) &&
+            header->tangentCount <= MeshCodec::MaxVertexCount(header->tangentBytes, sizeof(uint32_t));
+
+        // a stale cache is going to be overwritten, don't keep it mapped
+        if (!valid)
+        {
+            m_file.Close();
+            return false;
+        }
+
+        m_header = header;
+        return true;
+    }
+
+    bool CacheFile::DecodeVertices(void* destination) const
+    {
+        return MeshCodec::DecodeVertexBuffer(destination, m_header->vertexCount, m_header->key.vertexStride,
+            reinterpret_cast<const uint8_t*>(m_file.Data()) + m_header->vertexOffset, m_header->vertexBytes);
+    }
+
+    bool CacheFile::DecodeIndicies(uint32_t* destination) const
+    {
+        return MeshCodec::DecodeIndexBuffer(destination, m_header->indexCount, m_header->vertexCount,
+            reinterpret_cast<const uint8_t*>(m_file.Data()) + m_header->indexOffset, m_header->indexBytes);
+    }
+
+    bool CacheFile::DecodeTangents(uint32_t* destination) const
+    {
+        return MeshCodec::DecodeVertexBuffer(destination, m_header->tangentCount, sizeof(uint32_t),
+            reinterpret_cast<const uint8_t*>(m_file.Data()) + m_header->tangentOffset, m_header->tangentBytes);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef __MESHCACHE_H__
+#define __MESHCACHE_H__
+
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "MeshletBuilder.h"
+
+// Binary cache of an already processed mesh (vertex array + uint32 index buffer + meshlets + optional packed tangents),
+// stored next to the source model and memory-mapped on later loads. Vertices, indices and tangents are
+// stored MeshCodec encoded and decoded straight into the caller's memory.
+namespace MeshCache
+{
+    constexpr uint32_t S_VERSION = 12;
+
+    // everything the cached data depends on
+    struct Key
+    {
+        uint64_t sourceHash = 0;
+        uint64_t sourceSize = 0;
+        uint32_t options = 0;       // loader type and processing flags
+        uint32_t vertexStride = 0;  // sizeof(Vertex)
+    };
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        Key key;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t vertexBytes;           // encoded sizes
+        uint64_t indexBytes;
+        float boundsMin[3];
+        float boundsMax[3];
+        float boundingSphere[4];        // center xyz, radius
+        uint64_t meshletCount;
+        uint64_t meshletVertexCount;
+        uint64_t meshletTriangleCount;  // uint8 entries, 3 per triangle
+        uint64_t meshletOffset;         // Meshlet array, followed by the MeshletBounds array
+        uint64_t meshletVertexOffset;
+        uint64_t meshletTriangleOffset;
+        uint64_t tangentCount;          // packed tangents, 0 or vertexCount
+        uint64_t tangentOffset;
+        uint64_t tangentBytes;
+        uint64_t submeshRangeCount;     // uint32 triangle boundaries of the 16-bit index submeshes
+        uint64_t submeshRangeOffset;
+    };
+
+    // hashes the whole source file, returns false if it cannot be read
+    bool MakeKey(const std::string& sourcePath, uint32_t options, uint32_t vertexStride, Key& key);
+
+    bool Write(const std::string& cachePath, const Key& key,
+        const void* vertices, uint64_t vertexCount,
+        const uint32_t* indicies, uint64_t indexCount,
+        const uint32_t* tangents, uint64_t tangentCount,
+        const uint32_t* submeshRanges, uint64_t submeshRangeCount,
+        const float boundsMin[3], const float boundsMax[3], const float boundingSphere[4],
+        const MeshletBuilder::MeshletData& meshlets);
+
+    class CacheFile
+    {
+        Util::MappedFile m_file;
+        const Header* m_header = nullptr;
+
+    public:
+        CacheFile() = default;
+        ~CacheFile() = default;
+
+        // 版本、源文件或处理选项不一致，或者头里的区域、数量和文件对不上时返回 false，缓存需要重建
+        bool Open(const std::string& cachePath, const Key& key);
+
+        const Header& GetHeader() const { return *m_header; }
+        // 解码到 vertexCount * vertexStride 字节 / indexCount 个索引 / tangentCount 个切线的内存里。
+        // Model 解码到自己的数组（BVH、meshlet 和 16 位索引拆分还要在 CPU 上读），不直接解码到上传缓冲。数据损坏时返回 false
+        bool DecodeVertices(void* destination) const;
+        bool DecodeIndicies(uint32_t* destination) const;
+        bool DecodeTangents(uint32_t* destination) const;
+        const MeshletBuilder::Meshlet* GetMeshlets() const { return reinterpret_cast<const MeshletBuilder::Meshlet*>(m_file.Data() + m_header->meshletOffset); }
+        const MeshletBuilder::MeshletBounds* GetMeshletBounds() const
+        {
+            return reinterpret_cast<const MeshletBuilder::MeshletBounds*>(GetMeshlets() + m_header->meshletCount);
+        }
+        const uint32_t* GetMeshletVertices() const { return reinterpret_cast<const uint32_t*>(m_file.Data() + m_header->meshletVertexOffset); }
+        const uint8_t* GetMeshletTriangles() const { return reinterpret_cast<const uint8_t*>(m_file.Data() + m_header->meshletTriangleOffset); }
+        const uint32_t* GetSubmeshRanges() const { return reinterpret_cast<const uint32_t*>(m_file.Data() + m_header->submeshRangeOffset); }
+    };
+}
+#endif
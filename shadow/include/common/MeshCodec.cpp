@@ -0,0 +1,900 @@
+#include "MeshCodec.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHCODEC_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MESHCODEC_NEON
+#endif
+
+namespace
+{
+    // 格式的第一个字节，格式变化时修改
+    constexpr uint8_t S_INDEX_HEADER = 0xe1;
+    constexpr uint8_t S_VERTEX_HEADER = 0xe2;
+
+    constexpr uint32_t S_FIFO_SIZE = 16;
+    // 三角形的代码字节：最高位为 1 时三个顶点都是引用；否则低 4 位是边 FIFO 的槽位，
+    // bit 4-5 是旋转，bit 6 表示第三个顶点是 next
+    constexpr uint8_t S_CODE_NO_EDGE = 0x80;
+    constexpr uint8_t S_CODE_NEXT = 0x40;
+    // 顶点引用：0 为 next，1..16 为顶点 FIFO 的槽位，之后是和上一个引用的 zigzag 差
+    constexpr uint64_t S_REF_DELTA = 1 + S_FIFO_SIZE;
+    // 一个三角形的数据最多 3 个 5 字节的 varint，末尾补这么多 0，解码时每个三角形只检查一次越界
+    constexpr size_t S_INDEX_PADDING = 16;
+
+    constexpr size_t S_GROUP = 16;
+    constexpr size_t S_MAX_STRIDE = 256;
+    // 块内的字节平面一共不超过 8 KB，解码时留在 L1 里
+    constexpr size_t S_BLOCK_BYTES = 8192;
+    constexpr size_t S_MAX_BLOCK = 256;
+
+    // 最近的在 (head - 1) & 15
+    struct EdgeFifo
+    {
+        uint32_t a[S_FIFO_SIZE];
+        uint32_t b[S_FIFO_SIZE];
+        uint32_t head = 0;
+
+        EdgeFifo()
+        {
+            std::fill(a, a + S_FIFO_SIZE, ~0u);
+            std::fill(b, b + S_FIFO_SIZE, ~0u);
+        }
+        void Push(uint32_t x, uint32_t y)
+        {
+            a[head & (S_FIFO_SIZE - 1)] = x;
+            b[head & (S_FIFO_SIZE - 1)] = y;
+            head++;
+        }
+        uint32_t Slot(uint32_t i) const
+        {
+            return (head - 1 - i) & (S_FIFO_SIZE - 1);
+        }
+    };
+
+    struct VertexFifo
+    {
+        // 最后一个是解码时不需要放入的顶点的写入位置
+        uint32_t v[S_FIFO_SIZE + 1];
+        uint32_t head = 0;
+
+        VertexFifo()
+        {
+            std::fill(v, v + S_FIFO_SIZE + 1, ~0u);
+        }
+        void Push(uint32_t x)
+        {
+            v[head & (S_FIFO_SIZE - 1)] = x;
+            head++;
+        }
+        uint32_t Get(uint32_t i) const
+        {
+            return v[(head - 1 - i) & (S_FIFO_SIZE - 1)];
+        }
+        int Find(uint32_t x) const
+        {
+            for (uint32_t i = 0; i < S_FIFO_SIZE; i++)
+            {
+                if (Get(i) == x) return static_cast<int>(i);
+            }
+            return -1;
+        }
+    };
+
+    inline void WriteVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // 调用方保证至少还有 5 个字节，超过 5 个字节的值不会由编码器产生
+    inline bool ReadVarint(const uint8_t*& data, uint64_t& value)
+    {
+        // 大多数引用是 1 个字节
+        if (*data < 0x80)
+        {
+            value = *data++;
+            return true;
+        }
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) return true;
+        }
+        return false;
+    }
+
+    // 旋转后的第 i 个顶点在原三角形中的位置
+    constexpr uint8_t S_ROTATE[3][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}};
+
+    // 编码和解码对顶点引用维护同样的状态
+    struct IndexState
+    {
+        EdgeFifo edges;
+        VertexFifo vertices;
+        uint32_t next = 0;
+        uint32_t last = 0;
+    };
+
+    void WriteReference(std::vector<uint8_t>& data, IndexState& state, uint32_t v)
+    {
+        if (v == state.next)
+        {
+            data.push_back(0);
+            state.next++;
+            state.vertices.Push(v);
+        }
+        else
+        {
+            int slot = state.vertices.Find(v);
+            if (slot >= 0)
+            {
+                data.push_back(static_cast<uint8_t>(1 + slot));
+            }
+            else
+            {
+                int32_t delta = static_cast<int32_t>(v - state.last);
+                uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+                WriteVarint(data, zigzag + S_REF_DELTA);
+                state.vertices.Push(v);
+            }
+        }
+        state.last = v;
+    }
+
+    // 三种引用各占一部分，分支预测不了：三个候选都算出来再选择，FIFO 无条件写入
+    inline uint32_t ResolveReference(IndexState& state, uint64_t value)
+    {
+        uint32_t z = static_cast<uint32_t>(value - S_REF_DELTA);
+        uint32_t delta = state.last + ((z >> 1) ^ (0u - (z & 1)));
+        uint32_t slot = static_cast<uint32_t>(value - 1);
+        uint32_t fifo = state.vertices.Get(slot);
+        bool isNext = value == 0;
+        bool isFifo = slot < S_FIFO_SIZE;
+        uint32_t v = isNext ? state.next : isFifo ? fifo : delta;
+        state.next += isNext;
+        state.vertices.v[isFifo ? S_FIFO_SIZE : state.vertices.head & (S_FIFO_SIZE - 1)] = v;
+        state.vertices.head += !isFifo;
+        state.last = v;
+        return v;
+    }
+
+    inline bool ReadReference(const uint8_t*& data, IndexState& state, uint32_t& v)
+    {
+        uint64_t value;
+        if (!ReadVarint(data, value) || value > S_REF_DELTA + 0xffffffffull) return false;
+        v = ResolveReference(state, value);
+        return true;
+    }
+
+    inline size_t BlockSize(size_t stride)
+    {
+        return std::min(S_MAX_BLOCK, std::max(S_GROUP, (S_BLOCK_BYTES / stride) & ~(S_GROUP - 1)));
+    }
+
+    // 每组 16 个值的位宽 0 / 2 / 4 / 8 对应的字节数
+    constexpr size_t S_GROUP_BYTES[4] = {0, 4, 8, 16};
+    // 顶点数据末尾补 0，解码时每组都可以直接读 16 个字节
+    constexpr size_t S_VERTEX_PADDING = 16;
+
+    void EncodeGroup(std::vector<uint8_t>& out, const uint8_t* z, int width)
+    {
+        switch (width)
+        {
+        case 1:
+            for (size_t j = 0; j < 4; j++)
+            {
+                out.push_back(static_cast<uint8_t>(z[4 * j] << 6 | z[4 * j + 1] << 4 | z[4 * j + 2] << 2 | z[4 * j + 3]));
+            }
+            break;
+        case 2:
+            for (size_t j = 0; j < 8; j++)
+            {
+                out.push_back(static_cast<uint8_t>(z[2 * j] << 4 | z[2 * j + 1]));
+            }
+            break;
+        case 3:
+            out.insert(out.end(), z, z + S_GROUP);
+            break;
+        }
+    }
+
+#if defined(MESHCODEC_SSE2)
+    inline __m128i Unzigzag(__m128i z)
+    {
+        // (z >> 1) ^ -(z & 1)
+        return _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z, 1), _mm_set1_epi8(0x7f)),
+            _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi8(1))));
+    }
+
+    // 位宽随数据变化，分支预测不了，三种解包都算出来再按位宽选择。data 之后至少有 16 个字节
+    inline __m128i UnpackGroup(const uint8_t* data, int width)
+    {
+        const __m128i low4 = _mm_set1_epi8(0x0f);
+        const __m128i low2 = _mm_set1_epi8(0x03);
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i z4 = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(raw, 4), low4), _mm_and_si128(raw, low4));
+        __m128i z2 = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(z4, 2), low2), _mm_and_si128(z4, low2));
+        __m128i w = _mm_set1_epi8(static_cast<char>(width));
+        return _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(w, _mm_set1_epi8(1)), z2),
+            _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(w, _mm_set1_epi8(2)), z4),
+                _mm_and_si128(_mm_cmpeq_epi8(w, _mm_set1_epi8(3)), raw)));
+    }
+
+    // 一个平面的 zigzag 差
+    void UnpackPlane(const uint8_t* data, const uint8_t* widths, const uint16_t* offsets, size_t groupCount, uint8_t* plane)
+    {
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            _mm_store_si128(reinterpret_cast<__m128i*>(plane + g * S_GROUP), UnpackGroup(data + offsets[g], widths[g]));
+        }
+    }
+
+    // 平面内沿顶点求前缀和，last 是上一个块的最后一个值，返回后更新
+    void SumPlane(uint8_t* plane, size_t groupCount, uint8_t& last)
+    {
+        __m128i prev = _mm_set1_epi8(static_cast<char>(last));
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(plane + g * S_GROUP);
+            __m128i x = Unzigzag(_mm_load_si128(p));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi8(x, prev);
+            _mm_store_si128(p, x);
+            __m128i high = _mm_unpackhi_epi8(x, x);
+            high = _mm_unpackhi_epi16(high, high);
+            prev = _mm_shuffle_epi32(high, 0xff);
+        }
+        last = static_cast<uint8_t>(_mm_cvtsi128_si32(prev));
+    }
+
+    // 转置后的 16 个顶点各 16 个字节依次累加，一个顶点一次加法
+    void SumRows(uint8_t rows[256], uint8_t last[16])
+    {
+        __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last));
+        for (size_t i = 0; i < S_GROUP; i++)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(rows + i * 16);
+            prev = _mm_add_epi8(prev, Unzigzag(_mm_load_si128(p)));
+            _mm_store_si128(p, prev);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(last), prev);
+    }
+
+    // 4 个字节平面的 16 个值交错成 16 个顶点的 4 个字节
+    inline void Transpose4(const uint8_t* p0, const uint8_t* p1, const uint8_t* p2, const uint8_t* p3, uint8_t out[64])
+    {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(p0));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(p1));
+        __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(p2));
+        __m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(p3));
+        __m128i ab0 = _mm_unpacklo_epi8(a, b);
+        __m128i ab1 = _mm_unpackhi_epi8(a, b);
+        __m128i cd0 = _mm_unpacklo_epi8(c, d);
+        __m128i cd1 = _mm_unpackhi_epi8(c, d);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(ab0, cd0));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi16(ab0, cd0));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 32), _mm_unpacklo_epi16(ab1, cd1));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 48), _mm_unpackhi_epi16(ab1, cd1));
+    }
+
+    // 16 个平面（间隔 planeStride）的 16 个值转置成 16 个顶点的 16 个字节
+    inline void Transpose16(const uint8_t* plane, size_t planeStride, uint8_t out[256])
+    {
+        __m128i rows[4][4];
+        for (int j = 0; j < 4; j++)
+        {
+            const uint8_t* p = plane + 4 * j * planeStride;
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(p + planeStride));
+            __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(p + 2 * planeStride));
+            __m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(p + 3 * planeStride));
+            __m128i ab0 = _mm_unpacklo_epi8(a, b);
+            __m128i ab1 = _mm_unpackhi_epi8(a, b);
+            __m128i cd0 = _mm_unpacklo_epi8(c, d);
+            __m128i cd1 = _mm_unpackhi_epi8(c, d);
+            rows[0][j] = _mm_unpacklo_epi16(ab0, cd0);
+            rows[1][j] = _mm_unpackhi_epi16(ab0, cd0);
+            rows[2][j] = _mm_unpacklo_epi16(ab1, cd1);
+            rows[3][j] = _mm_unpackhi_epi16(ab1, cd1);
+        }
+        // rows[q][j] 是顶点 4q..4q+3 的第 4j..4j+3 个字节，再做一次 4x4 的 32 位转置
+        for (int q = 0; q < 4; q++)
+        {
+            __m128i t0 = _mm_unpacklo_epi32(rows[q][0], rows[q][1]);
+            __m128i t1 = _mm_unpacklo_epi32(rows[q][2], rows[q][3]);
+            __m128i t2 = _mm_unpackhi_epi32(rows[q][0], rows[q][1]);
+            __m128i t3 = _mm_unpackhi_epi32(rows[q][2], rows[q][3]);
+            __m128i* o = reinterpret_cast<__m128i*>(out + q * 64);
+            _mm_store_si128(o + 0, _mm_unpacklo_epi64(t0, t1));
+            _mm_store_si128(o + 1, _mm_unpackhi_epi64(t0, t1));
+            _mm_store_si128(o + 2, _mm_unpacklo_epi64(t2, t3));
+            _mm_store_si128(o + 3, _mm_unpackhi_epi64(t2, t3));
+        }
+    }
+#elif defined(MESHCODEC_NEON)
+    inline uint8x16_t Unzigzag(uint8x16_t z)
+    {
+        uint8x16_t sign = vreinterpretq_u8_s8(vnegq_s8(vreinterpretq_s8_u8(vandq_u8(z, vdupq_n_u8(1)))));
+        return veorq_u8(vshrq_n_u8(z, 1), sign);
+    }
+
+    inline uint8x16_t UnpackGroup(const uint8_t* data, int width)
+    {
+        const uint8x8_t low4 = vdup_n_u8(0x0f);
+        const uint8x8_t low2 = vdup_n_u8(0x03);
+        uint8x16_t raw = vld1q_u8(data);
+        uint8x8x2_t n4 = vzip_u8(vshr_n_u8(vget_low_u8(raw), 4), vand_u8(vget_low_u8(raw), low4));
+        uint8x8x2_t n2 = vzip_u8(vshr_n_u8(n4.val[0], 2), vand_u8(n4.val[0], low2));
+        uint8x16_t z4 = vcombine_u8(n4.val[0], n4.val[1]);
+        uint8x16_t z2 = vcombine_u8(n2.val[0], n2.val[1]);
+        uint8x16_t w = vdupq_n_u8(static_cast<uint8_t>(width));
+        return vorrq_u8(vandq_u8(vceqq_u8(w, vdupq_n_u8(1)), z2),
+            vorrq_u8(vandq_u8(vceqq_u8(w, vdupq_n_u8(2)), z4), vandq_u8(vceqq_u8(w, vdupq_n_u8(3)), raw)));
+    }
+
+    void UnpackPlane(const uint8_t* data, const uint8_t* widths, const uint16_t* offsets, size_t groupCount, uint8_t* plane)
+    {
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            vst1q_u8(plane + g * S_GROUP, UnpackGroup(data + offsets[g], widths[g]));
+        }
+    }
+
+    void SumPlane(uint8_t* plane, size_t groupCount, uint8_t& last)
+    {
+        const uint8x16_t zero = vdupq_n_u8(0);
+        uint8x16_t prev = vdupq_n_u8(last);
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            uint8_t* p = plane + g * S_GROUP;
+            uint8x16_t x = Unzigzag(vld1q_u8(p));
+            x = vaddq_u8(x, vextq_u8(zero, x, 15));
+            x = vaddq_u8(x, vextq_u8(zero, x, 14));
+            x = vaddq_u8(x, vextq_u8(zero, x, 12));
+            x = vaddq_u8(x, vextq_u8(zero, x, 8));
+            x = vaddq_u8(x, prev);
+            vst1q_u8(p, x);
+            prev = vdupq_n_u8(vgetq_lane_u8(x, 15));
+        }
+        last = vgetq_lane_u8(prev, 0);
+    }
+
+    void SumRows(uint8_t rows[256], uint8_t last[16])
+    {
+        uint8x16_t prev = vld1q_u8(last);
+        for (size_t i = 0; i < S_GROUP; i++)
+        {
+            prev = vaddq_u8(prev, Unzigzag(vld1q_u8(rows + i * 16)));
+            vst1q_u8(rows + i * 16, prev);
+        }
+        vst1q_u8(last, prev);
+    }
+
+    inline void Transpose4(const uint8_t* p0, const uint8_t* p1, const uint8_t* p2, const uint8_t* p3, uint8_t out[64])
+    {
+        uint8x16x4_t planes = {{vld1q_u8(p0), vld1q_u8(p1), vld1q_u8(p2), vld1q_u8(p3)}};
+        vst4q_u8(out, planes);
+    }
+
+    inline void Transpose16(const uint8_t* plane, size_t planeStride, uint8_t out[256])
+    {
+        alignas(16) uint8_t rows[4][64];
+        for (int j = 0; j < 4; j++)
+        {
+            const uint8_t* p = plane + 4 * j * planeStride;
+            Transpose4(p, p + planeStride, p + 2 * planeStride, p + 3 * planeStride, rows[j]);
+        }
+        for (int q = 0; q < 4; q++)
+        {
+            uint32x4x4_t dwords = {{
+                vld1q_u32(reinterpret_cast<const uint32_t*>(rows[0] + q * 16)),
+                vld1q_u32(reinterpret_cast<const uint32_t*>(rows[1] + q * 16)),
+                vld1q_u32(reinterpret_cast<const uint32_t*>(rows[2] + q * 16)),
+                vld1q_u32(reinterpret_cast<const uint32_t*>(rows[3] + q * 16))}};
+            vst4q_u32(reinterpret_cast<uint32_t*>(out + q * 64), dwords);
+        }
+    }
+#else
+    inline uint8_t Unzigzag(uint8_t z)
+    {
+        return static_cast<uint8_t>((z >> 1) ^ (0u - (z & 1)));
+    }
+
+    void UnpackPlane(const uint8_t* data, const uint8_t* widths, const uint16_t* offsets, size_t groupCount, uint8_t* plane)
+    {
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            int width = widths[g];
+            const uint8_t* group = data + offsets[g];
+            uint8_t* out = plane + g * S_GROUP;
+            for (size_t i = 0; i < S_GROUP; i++)
+            {
+                switch (width)
+                {
+                case 0: out[i] = 0; break;
+                case 1: out[i] = (group[i >> 2] >> (6 - (i & 3) * 2)) & 3; break;
+                case 2: out[i] = (group[i >> 1] >> (4 - (i & 1) * 4)) & 15; break;
+                default: out[i] = group[i]; break;
+                }
+            }
+        }
+    }
+
+    void SumPlane(uint8_t* plane, size_t groupCount, uint8_t& last)
+    {
+        for (size_t i = 0; i < groupCount * S_GROUP; i++)
+        {
+            last = static_cast<uint8_t>(last + Unzigzag(plane[i]));
+            plane[i] = last;
+        }
+    }
+
+    void SumRows(uint8_t rows[256], uint8_t last[16])
+    {
+        for (size_t i = 0; i < S_GROUP; i++)
+        {
+            for (size_t k = 0; k < 16; k++)
+            {
+                last[k] = static_cast<uint8_t>(last[k] + Unzigzag(rows[i * 16 + k]));
+                rows[i * 16 + k] = last[k];
+            }
+        }
+    }
+
+    inline void Transpose4(const uint8_t* p0, const uint8_t* p1, const uint8_t* p2, const uint8_t* p3, uint8_t out[64])
+    {
+        for (size_t i = 0; i < S_GROUP; i++)
+        {
+            out[i * 4 + 0] = p0[i];
+            out[i * 4 + 1] = p1[i];
+            out[i * 4 + 2] = p2[i];
+            out[i * 4 + 3] = p3[i];
+        }
+    }
+
+    inline void Transpose16(const uint8_t* plane, size_t planeStride, uint8_t out[256])
+    {
+        for (size_t i = 0; i < S_GROUP; i++)
+        {
+            for (size_t k = 0; k < 16; k++) out[i * 16 + k] = plane[k * planeStride + i];
+        }
+    }
+#endif
+    // 按块独立编码，块之间不共享状态，解码时并行
+    constexpr size_t S_INDEX_CHUNK = 16384;         // 三角形
+    constexpr size_t S_SEGMENT_BLOCKS = 16;         // 顶点块
+
+    inline uint64_t ReadOffset(const uint8_t* table, size_t i)
+    {
+        uint64_t offset;
+        std::memcpy(&offset, table + i * sizeof(uint64_t), sizeof(uint64_t));
+        return offset;
+    }
+
+    inline uint32_t ReadNext(const uint8_t* table, size_t i)
+    {
+        uint32_t next;
+        std::memcpy(&next, table + i * sizeof(uint32_t), sizeof(uint32_t));
+        return next;
+    }
+
+    // 每个三角形的代码写到 codes，引用写到 data
+    // next 从之前所有块里最大的索引 + 1 开始，优化过的索引缓冲里新顶点仍然按顺序出现
+    void EncodeIndexChunk(const uint32_t* indicies, size_t triangleCount, uint32_t next, uint8_t* codes, std::vector<uint8_t>& data)
+    {
+        IndexState state;
+        state.next = next;
+        state.last = next;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            uint32_t a = indicies[t * 3 + 0];
+            uint32_t b = indicies[t * 3 + 1];
+            uint32_t c = indicies[t * 3 + 2];
+
+            // 找一条和最近的三角形共享的边，旋转到 (a, b) 的位置
+            int slot = -1;
+            int rotation = 0;
+            for (uint32_t i = 0; i < S_FIFO_SIZE && slot < 0; i++)
+            {
+                uint32_t s = state.edges.Slot(i);
+                uint32_t x = state.edges.a[s];
+                uint32_t y = state.edges.b[s];
+                if (x == a && y == b) rotation = 0;
+                else if (x == b && y == c) rotation = 1;
+                else if (x == c && y == a) rotation = 2;
+                else continue;
+                slot = static_cast<int>(i);
+            }
+
+            if (slot >= 0)
+            {
+                uint32_t r[3] = {a, b, c};
+                std::rotate(r, r + rotation, r + 3);
+                uint8_t code = static_cast<uint8_t>(slot | rotation << 4);
+                if (r[2] == state.next)
+                {
+                    code |= S_CODE_NEXT;
+                    state.next++;
+                    state.vertices.Push(r[2]);
+                    state.last = r[2];
+                }
+                else
+                {
+                    WriteReference(data, state, r[2]);
+                }
+                codes[t] = code;
+                // 共享的边已经用过，另外两条边反向放入，相邻三角形按同样的方向引用它们
+                state.edges.Push(r[2], r[1]);
+                state.edges.Push(r[0], r[2]);
+            }
+            else
+            {
+                codes[t] = S_CODE_NO_EDGE;
+                WriteReference(data, state, a);
+                WriteReference(data, state, b);
+                WriteReference(data, state, c);
+                state.edges.Push(b, a);
+                state.edges.Push(c, b);
+                state.edges.Push(a, c);
+            }
+        }
+    }
+
+    // input 到 chunkEnd 是这一块的数据，之后到 end 至少还有 S_INDEX_PADDING 个字节可以读
+    bool DecodeIndexChunk(uint32_t* destination, size_t triangleCount, size_t vertexCount, uint32_t next, const uint8_t* codes,
+        const uint8_t* input, const uint8_t* chunkEnd, const uint8_t* end)
+    {
+        IndexState state;
+        state.next = next;
+        state.last = next;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (input > chunkEnd || static_cast<size_t>(end - input) < S_INDEX_PADDING) return false;
+
+            uint8_t code = codes[t];
+            uint32_t a, b, c;
+            if ((code & S_CODE_NO_EDGE) == 0)
+            {
+                uint32_t s = state.edges.Slot(code & (S_FIFO_SIZE - 1));
+                a = state.edges.a[s];
+                b = state.edges.b[s];
+                // 第三个顶点是 next 时当作读到了引用 0，不消耗数据
+                uint64_t value;
+                bool next = (code & S_CODE_NEXT) != 0;
+                uint8_t byte = next ? 0 : *input;
+                input += !next;
+                if (byte < 0x80)
+                {
+                    value = byte;
+                }
+                else
+                {
+                    input--;
+                    if (!ReadVarint(input, value) || value > S_REF_DELTA + 0xffffffffull) return false;
+                }
+                c = ResolveReference(state, value);
+                state.edges.Push(c, b);
+                state.edges.Push(a, c);
+
+                // 转回原来的旋转
+                uint32_t rotation = (code >> 4) & 3;
+                if (rotation == 3) return false;
+                uint32_t* out = destination + t * 3;
+                out[S_ROTATE[rotation][0]] = a;
+                out[S_ROTATE[rotation][1]] = b;
+                out[S_ROTATE[rotation][2]] = c;
+            }
+            else
+            {
+                if (code != S_CODE_NO_EDGE) return false;
+                if (!ReadReference(input, state, a) || !ReadReference(input, state, b) || !ReadReference(input, state, c)) return false;
+                state.edges.Push(b, a);
+                state.edges.Push(c, b);
+                state.edges.Push(a, c);
+                destination[t * 3 + 0] = a;
+                destination[t * 3 + 1] = b;
+                destination[t * 3 + 2] = c;
+            }
+            if (a >= vertexCount || b >= vertexCount || c >= vertexCount) return false;
+        }
+        return input == chunkEnd;
+    }
+
+    void EncodeVertexSegment(const uint8_t* source, size_t vertexCount, size_t stride, std::vector<uint8_t>& out)
+    {
+        size_t blockSize = BlockSize(stride);
+        std::vector<uint8_t> last(stride, 0);
+        uint8_t z[S_MAX_BLOCK];
+        for (size_t base = 0; base < vertexCount; base += blockSize)
+        {
+            size_t count = std::min(blockSize, vertexCount - base);
+            size_t groupCount = (count + S_GROUP - 1) / S_GROUP;
+            for (size_t k = 0; k < stride; k++)
+            {
+                // 最后一组不满时补 0 差，解码出来的多余值和最后一个顶点相同
+                std::fill(z, z + groupCount * S_GROUP, 0);
+                for (size_t i = 0; i < count; i++)
+                {
+                    uint8_t value = source[(base + i) * stride + k];
+                    int8_t delta = static_cast<int8_t>(value - last[k]);
+                    z[i] = static_cast<uint8_t>((static_cast<uint8_t>(delta) << 1) ^ (delta >> 7));
+                    last[k] = value;
+                }
+
+                size_t headerOffset = out.size();
+                out.resize(out.size() + (groupCount + 3) / 4, 0);
+                for (size_t g = 0; g < groupCount; g++)
+                {
+                    const uint8_t* group = z + g * S_GROUP;
+                    uint8_t largest = *std::max_element(group, group + S_GROUP);
+                    int width = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+                    out[headerOffset + (g >> 2)] |= static_cast<uint8_t>(width << ((g & 3) * 2));
+                    EncodeGroup(out, group, width);
+                }
+            }
+        }
+    }
+
+    // input 到 end 是这一段的数据，之后至少还有 S_VERTEX_PADDING 个字节可以读
+    bool DecodeVertexSegment(uint8_t* target, size_t vertexCount, size_t stride, const uint8_t* input, const uint8_t* end)
+    {
+        size_t blockSize = BlockSize(stride);
+        // 前面每 16 个平面转置后按顶点累加，剩下的平面在平面内累加
+        size_t rowBytes = stride & ~size_t(15);
+
+        uint8_t last[S_MAX_STRIDE] = {};
+        alignas(16) uint8_t planes[S_BLOCK_BYTES];
+        alignas(16) uint8_t transposed[256];
+        uint8_t widths[S_MAX_BLOCK / S_GROUP];
+        uint16_t offsets[S_MAX_BLOCK / S_GROUP];
+        for (size_t base = 0; base < vertexCount; base += blockSize)
+        {
+            size_t count = std::min(blockSize, vertexCount - base);
+            size_t groupCount = (count + S_GROUP - 1) / S_GROUP;
+            size_t headerSize = (groupCount + 3) / 4;
+            for (size_t k = 0; k < stride; k++)
+            {
+                if (static_cast<size_t>(end - input) < headerSize) return false;
+                const uint8_t* header = input;
+                // 先算出每组的偏移，解码时各组的读取互不依赖
+                size_t planeSize = headerSize;
+                for (size_t g = 0; g < groupCount; g++)
+                {
+                    widths[g] = (header[g >> 2] >> ((g & 3) * 2)) & 3;
+                    offsets[g] = static_cast<uint16_t>(planeSize);
+                    planeSize += S_GROUP_BYTES[widths[g]];
+                }
+                if (static_cast<size_t>(end - input) < planeSize) return false;
+
+                UnpackPlane(input, widths, offsets, groupCount, planes + k * blockSize);
+                if (k >= rowBytes) SumPlane(planes + k * blockSize, groupCount, last[k]);
+                input += planeSize;
+            }
+
+            // 每次转置 16 个（或 4 个）平面的 16 个顶点，写回顶点里连续的 16（4）个字节
+            size_t k = 0;
+            for (; k < rowBytes; k += 16)
+            {
+                const uint8_t* plane = planes + k * blockSize;
+                for (size_t g = 0; g < groupCount; g++)
+                {
+                    size_t first = g * S_GROUP;
+                    // 最后一组不满时多出来的差为 0，last 停在最后一个顶点
+                    Transpose16(plane + first, blockSize, transposed);
+                    SumRows(transposed, last + k);
+                    size_t n = std::min(S_GROUP, count - first);
+                    uint8_t* out = target + (base + first) * stride + k;
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        std::memcpy(out + i * stride, transposed + i * 16, 16);
+                    }
+                }
+            }
+            for (; k + 4 <= stride; k += 4)
+            {
+                const uint8_t* plane = planes + k * blockSize;
+                for (size_t g = 0; g < groupCount; g++)
+                {
+                    size_t first = g * S_GROUP;
+                    Transpose4(plane + first, plane + blockSize + first, plane + 2 * blockSize + first, plane + 3 * blockSize + first,
+                        transposed);
+                    size_t n = std::min(S_GROUP, count - first);
+                    uint8_t* out = target + (base + first) * stride + k;
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        std::memcpy(out + i * stride, transposed + i * 4, 4);
+                    }
+                }
+            }
+            for (; k < stride; k++)
+            {
+                const uint8_t* plane = planes + k * blockSize;
+                for (size_t i = 0; i < count; i++)
+                {
+                    target[(base + i) * stride + k] = plane[i];
+                }
+            }
+        }
+        return input == end;
+    }
+}
+
+namespace MeshCodec
+{
+    std::vector<uint8_t> EncodeIndexBuffer(const uint32_t* indicies, size_t indexCount)
+    {
+        if (indexCount % 3 != 0) throw std::runtime_error("MeshCodec: index count is not a multiple of 3");
+
+        // 头，每块数据的结束偏移，每块开始的 next，所有三角形的代码，各块的数据
+        size_t triangleCount = indexCount / 3;
+        size_t chunkCount = (triangleCount + S_INDEX_CHUNK - 1) / S_INDEX_CHUNK;
+        size_t nextOffset = 1 + chunkCount * sizeof(uint64_t);
+        size_t codesOffset = nextOffset + chunkCount * sizeof(uint32_t);
+        std::vector<uint8_t> out(codesOffset + triangleCount);
+        out[0] = S_INDEX_HEADER;
+
+        uint32_t next = 0;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            std::memcpy(out.data() + nextOffset + chunk * sizeof(uint32_t), &next, sizeof(uint32_t));
+            size_t first = chunk * S_INDEX_CHUNK * 3;
+            size_t last = std::min(first + S_INDEX_CHUNK * 3, indexCount);
+            uint32_t largest = *std::max_element(indicies + first, indicies + last);
+            next = std::max(next, largest + 1);
+        }
+
+        std::vector<std::vector<uint8_t>> chunks(chunkCount);
+        Util::ParallelFor(chunkCount, [&](size_t chunk)
+        {
+            size_t first = chunk * S_INDEX_CHUNK;
+            size_t count = std::min(S_INDEX_CHUNK, triangleCount - first);
+            uint32_t chunkNext = ReadNext(out.data() + nextOffset, chunk);
+            chunks[chunk].reserve(count * 2);
+            EncodeIndexChunk(indicies + first * 3, count, chunkNext, out.data() + codesOffset + first, chunks[chunk]);
+        });
+
+        uint64_t offset = 0;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            offset += chunks[chunk].size();
+            std::memcpy(out.data() + 1 + chunk * sizeof(uint64_t), &offset, sizeof(uint64_t));
+        }
+        out.reserve(out.size() + offset + S_INDEX_PADDING);
+        for (auto& chunk: chunks) out.insert(out.end(), chunk.begin(), chunk.end());
+        out.resize(out.size() + S_INDEX_PADDING, 0);
+        return out;
+    }
+
+    bool DecodeIndexBuffer(uint32_t* destination, size_t indexCount, size_t vertexCount, const uint8_t* data, size_t size)
+    {
+        if (indexCount % 3 != 0) return false;
+        size_t triangleCount = indexCount / 3;
+        size_t chunkCount = (triangleCount + S_INDEX_CHUNK - 1) / S_INDEX_CHUNK;
+        size_t nextOffset = 1 + chunkCount * sizeof(uint64_t);
+        size_t codesOffset = nextOffset + chunkCount * sizeof(uint32_t);
+        if (size < codesOffset + triangleCount + S_INDEX_PADDING || data[0] != S_INDEX_HEADER) return false;
+
+        // 编码器只在末尾补 0
+        const uint8_t* table = data + 1;
+        const uint8_t* nextTable = data + nextOffset;
+        const uint8_t* codes = data + codesOffset;
+        const uint8_t* chunkData = codes + triangleCount;
+        const uint8_t* end = data + size;
+        uint64_t dataSize = static_cast<uint64_t>(end - chunkData) - S_INDEX_PADDING;
+        if (chunkCount > 0 && ReadOffset(table, chunkCount - 1) != dataSize) return false;
+        for (size_t chunk = 1; chunk < chunkCount; chunk++)
+        {
+            if (ReadOffset(table, chunk - 1) > ReadOffset(table, chunk)) return false;
+        }
+
+        std::atomic<bool> valid{true};
+        Util::ParallelFor(chunkCount, [&](size_t chunk)
+        {
+            size_t first = chunk * S_INDEX_CHUNK;
+            size_t count = std::min(S_INDEX_CHUNK, triangleCount - first);
+            uint64_t begin = chunk == 0 ? 0 : ReadOffset(table, chunk - 1);
+            uint64_t chunkEnd = ReadOffset(table, chunk);
+            uint32_t next = ReadNext(nextTable, chunk);
+            if (!DecodeIndexChunk(destination + first * 3, count, vertexCount, next, codes + first, chunkData + begin, chunkData + chunkEnd,
+                end))
+            {
+                valid = false;
+            }
+        });
+        return valid;
+    }
+
+    std::vector<uint8_t> EncodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride)
+    {
+        if (stride == 0 || stride > S_MAX_STRIDE) throw std::runtime_error("MeshCodec: vertex stride must be in [1, 256]");
+
+        // 头，每段的结束偏移，各段的数据
+        auto source = static_cast<const uint8_t*>(vertices);
+        size_t segmentSize = BlockSize(stride) * S_SEGMENT_BLOCKS;
+        size_t segmentCount = (vertexCount + segmentSize - 1) / segmentSize;
+        std::vector<uint8_t> out(1 + segmentCount * sizeof(uint64_t));
+        out[0] = S_VERTEX_HEADER;
+
+        std::vector<std::vector<uint8_t>> segments(segmentCount);
+        Util::ParallelFor(segmentCount, [&](size_t segment)
+        {
+            size_t first = segment * segmentSize;
+            size_t count = std::min(segmentSize, vertexCount - first);
+            segments[segment].reserve(count * stride / 2);
+            EncodeVertexSegment(source + first * stride, count, stride, segments[segment]);
+        });
+
+        uint64_t offset = 0;
+        for (size_t segment = 0; segment < segmentCount; segment++)
+        {
+            offset += segments[segment].size();
+            std::memcpy(out.data() + 1 + segment * sizeof(uint64_t), &offset, sizeof(uint64_t));
+        }
+        out.reserve(out.size() + offset + S_VERTEX_PADDING);
+        for (auto& segment: segments) out.insert(out.end(), segment.begin(), segment.end());
+        out.resize(out.size() + S_VERTEX_PADDING, 0);
+        return out;
+    }
+
+    bool DecodeVertexBuffer(void* destination, size_t vertexCount, size_t stride, const uint8_t* data, size_t size)
+    {
+        if (stride == 0 || stride > S_MAX_STRIDE) return false;
+        size_t segmentSize = BlockSize(stride) * S_SEGMENT_BLOCKS;
+        size_t segmentCount = (vertexCount + segmentSize - 1) / segmentSize;
+        size_t segmentsOffset = 1 + segmentCount * sizeof(uint64_t);
+        if (size < segmentsOffset + S_VERTEX_PADDING || data[0] != S_VERTEX_HEADER) return false;
+
+        const uint8_t* table = data + 1;
+        const uint8_t* segmentData = data + segmentsOffset;
+        uint64_t dataSize = size - segmentsOffset - S_VERTEX_PADDING;
+        if (segmentCount > 0 && ReadOffset(table, segmentCount - 1) != dataSize) return false;
+        for (size_t segment = 1; segment < segmentCount; segment++)
+        {
+            if (ReadOffset(table, segment - 1) > ReadOffset(table, segment)) return false;
+        }
+
+        auto target = static_cast<uint8_t*>(destination);
+        std::atomic<bool> valid{true};
+        Util::ParallelFor(segmentCount, [&](size_t segment)
+        {
+            size_t first = segment * segmentSize;
+            size_t count = std::min(segmentSize, vertexCount - first);
+            uint64_t begin = segment == 0 ? 0 : ReadOffset(table, segment - 1);
+            uint64_t segmentEnd = ReadOffset(table, segment);
+            if (!DecodeVertexSegment(target + first * stride, count, stride, segmentData + begin, segmentData + segmentEnd))
+            {
+                valid = false;
+            }
+        });
+        return valid;
+    }
+
+    size_t MaxIndexCount(size_t size)
+    {
+        return size * 3;
+    }
+
+    size_t MaxVertexCount(size_t size, size_t stride)
+    {
+        if (stride == 0 || stride > S_MAX_STRIDE) return 0;
+        return size / stride * BlockSize(stride);
+    }
+}
@@ -0,0 +1,279 @@
+#include "MeshNormals.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHNORMALS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MESHNORMALS_NEON
+#endif
+
+namespace
+{
+    // 4 lane float vector, the kernels below are written once against it
+#if defined(MESHNORMALS_SSE2)
+    using Float4 = __m128;
+    inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+    inline void Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+    inline Float4 Set1(float v) { return _mm_set1_ps(v); }
+    inline Float4 Set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+    inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+    inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+    inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+    inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+    inline Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a); }
+    inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+    inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+    inline Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    inline Float4 Greater(Float4 a, Float4 b) { return _mm_cmpgt_ps(a, b); }
+    inline Float4 Select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#elif defined(MESHNORMALS_NEON)
+    using Float4 = float32x4_t;
+    inline Float4 Load(const float* p) { return vld1q_f32(p); }
+    inline void Store(float* p, Float4 v) { vst1q_f32(p, v); }
+    inline Float4 Set1(float v) { return vdupq_n_f32(v); }
+    inline Float4 Set(float a, float b, float c, float d)
+    {
+        const float lanes[4] = {a, b, c, d};
+        return vld1q_f32(lanes);
+    }
+    inline Float4 Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+    inline Float4 Sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+    inline Float4 Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+    inline Float4 Div(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+    inline Float4 Sqrt(Float4 a) { return vsqrtq_f32(a); }
+    inline Float4 Min(Float4 a, Float4 b) { return vminq_f32(a, b); }
+    inline Float4 Max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+    inline Float4 Abs(Float4 a) { return vabsq_f32(a); }
+    inline Float4 Greater(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+    inline Float4 Select(Float4 mask, Float4 a, Float4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+#else
+    struct Float4
+    {
+        float v[4];
+    };
+    template<typename Op>
+    inline Float4 Map(Float4 a, Float4 b, Op op)
+    {
+        Float4 r;
+        for (int i = 0; i < 4; i++) r.v[i] = op(a.v[i], b.v[i]);
+        return r;
+    }
+    inline Float4 Load(const float* p) { return Float4{{p[0], p[1], p[2], p[3]}}; }
+    inline void Store(float* p, Float4 v) { std::copy(v.v, v.v + 4, p); }
+    inline Float4 Set1(float v) { return Float4{{v, v, v, v}}; }
+    inline Float4 Set(float a, float b, float c, float d) { return Float4{{a, b, c, d}}; }
+    inline Float4 Add(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    inline Float4 Sub(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    inline Float4 Mul(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    inline Float4 Div(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    inline Float4 Sqrt(Float4 a) { return Map(a, a, [](float x, float) { return std::sqrt(x); }); }
+    inline Float4 Min(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return std::min(x, y); }); }
+    inline Float4 Max(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return std::max(x, y); }); }
+    inline Float4 Abs(Float4 a) { return Map(a, a, [](float x, float) { return std::abs(x); }); }
+    // masks are 1 / 0 here instead of all bits
+    inline Float4 Greater(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x > y ? 1.f : 0.f; }); }
+    inline Float4 Select(Float4 mask, Float4 a, Float4 b)
+    {
+        Float4 r;
+        for (int i = 0; i < 4; i++) r.v[i] = mask.v[i] != 0.f ? a.v[i] : b.v[i];
+        return r;
+    }
+#endif
+
+    inline Float4 Dot(const Float4 a[3], const Float4 b[3])
+    {
+        return Add(Add(Mul(a[0], b[0]), Mul(a[1], b[1])), Mul(a[2], b[2]));
+    }
+
+    // 1 / sqrt(lengthSquared), 0 for zero vectors
+    inline Float4 InverseLength(Float4 lengthSquared)
+    {
+        Float4 zero = Set1(0.f);
+        return Select(Greater(lengthSquared, zero), Div(Set1(1.f), Sqrt(lengthSquared)), zero);
+    }
+
+    // Abramowitz & Stegun 4.4.45, |error| < 7e-5 rad
+    inline Float4 Acos(Float4 x)
+    {
+        Float4 a = Abs(x);
+        Float4 poly = Add(Mul(Add(Mul(Add(Mul(Set1(-0.0187293f), a), Set1(0.0742610f)), a), Set1(-0.2121144f)), a), Set1(1.5707288f));
+        Float4 r = Mul(Sqrt(Sub(Set1(1.f), a)), poly);
+        return Select(Greater(Set1(0.f), x), Sub(Set1(3.14159265f), r), r);
+    }
+
+    // angle between a and b, 0 when either is degenerate
+    inline Float4 Angle(const Float4 a[3], const Float4 b[3])
+    {
+        Float4 cosine = Mul(Dot(a, b), InverseLength(Mul(Dot(a, a), Dot(b, b))));
+        return Acos(Min(Max(cosine, Set1(-1.f)), Set1(1.f)));
+    }
+
+    inline const float* At(const float* base, size_t i, size_t stride)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(base) + i * stride);
+    }
+    inline float* At(float* base, size_t i, size_t stride)
+    {
+        return reinterpret_cast<float*>(reinterpret_cast<char*>(base) + i * stride);
+    }
+
+    // Per triangle normal (area weighted: the cross product, angle weighted: unit length) and, for
+    // angle weighting, the three corner angles. Arrays are padded to a multiple of 4 triangles.
+    struct FaceData
+    {
+        std::vector<float> normal[3];
+        std::vector<float> weight[3];
+    };
+
+    void ComputeFaces(FaceData& faces, const float* positions, size_t stride, const uint32_t* indicies, size_t triangleCount,
+        MeshNormals::Weighting weighting)
+    {
+        size_t blockCount = (triangleCount + 3) / 4;
+        bool angle = weighting == MeshNormals::Weighting::Angle;
+        for (int k = 0; k < 3; k++)
+        {
+            faces.normal[k].resize(blockCount * 4);
+            if (angle) faces.weight[k].resize(blockCount * 4);
+        }
+
+        Util::ParallelForRange(blockCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t block = begin; block < end; block++)
+            {
+                // gather 4 triangles into SoA, missing lanes of the last block read zeros
+                static const float zeros[3] = {0.f, 0.f, 0.f};
+                const float* corners[4][3];
+                for (size_t lane = 0; lane < 4; lane++)
+                {
+                    size_t t = block * 4 + lane;
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        corners[lane][corner] = t < triangleCount ? At(positions, indicies[t * 3 + corner], stride) : zeros;
+                    }
+                }
+                Float4 p[3][3];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        p[corner][axis] = Set(corners[0][corner][axis], corners[1][corner][axis], corners[2][corner][axis], corners[3][corner][axis]);
+                    }
+                }
+
+                Float4 e01[3], e02[3], e12[3];
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    e01[axis] = Sub(p[1][axis], p[0][axis]);
+                    e02[axis] = Sub(p[2][axis], p[0][axis]);
+                    e12[axis] = Sub(p[2][axis], p[1][axis]);
+                }
+                Float4 n[3] =
+                {
+                    Sub(Mul(e01[1], e02[2]), Mul(e01[2], e02[1])),
+                    Sub(Mul(e01[2], e02[0]), Mul(e01[0], e02[2])),
+                    Sub(Mul(e01[0], e02[1]), Mul(e01[1], e02[0])),
+                };
+
+                size_t offset = block * 4;
+                if (!angle)
+                {
+                    for (int axis = 0; axis < 3; axis++) Store(&faces.normal[axis][offset], n[axis]);
+                    continue;
+                }
+
+                Float4 inverse = InverseLength(Dot(n, n));
+                for (int axis = 0; axis < 3; axis++) Store(&faces.normal[axis][offset], Mul(n[axis], inverse));
+
+                Float4 zero = Set1(0.f);
+                Float4 e10[3], e20[3], e21[3];
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    e10[axis] = Sub(zero, e01[axis]);
+                    e20[axis] = Sub(zero, e02[axis]);
+                    e21[axis] = Sub(zero, e12[axis]);
+                }
+                Store(&faces.weight[0][offset], Angle(e01, e02));
+                Store(&faces.weight[1][offset], Angle(e12, e10));
+                Store(&faces.weight[2][offset], Angle(e20, e21));
+            }
+        });
+    }
+}
+
+namespace MeshNormals
+{
+    Adjacency BuildAdjacency(const uint32_t* indicies, size_t indexCount, size_t vertexCount)
+    {
+        Adjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        indexCount -= indexCount % 3;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            adjacency.offsets[indicies[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            adjacency.offsets[v + 1] += adjacency.offsets[v];
+        }
+
+        // corners of each vertex in ascending order, so the sums don't depend on scheduling
+        adjacency.corners.resize(indexCount);
+        std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            adjacency.corners[fill[indicies[i]]++] = static_cast<uint32_t>(i);
+        }
+        return adjacency;
+    }
+
+    void ComputeNormals(float* normals, const float* positions, size_t vertexCount, size_t stride,
+        const uint32_t* indicies, size_t indexCount, const Adjacency& adjacency, Weighting weighting)
+    {
+        FaceData faces;
+        ComputeFaces(faces, positions, stride, indicies, indexCount / 3, weighting);
+        bool angle = weighting == Weighting::Angle;
+
+        size_t blockCount = (vertexCount + 3) / 4;
+        Util::ParallelForRange(blockCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t block = begin; block < end; block++)
+            {
+                alignas(16) float sums[3][4] = {};
+                size_t laneCount = std::min<size_t>(4, vertexCount - block * 4);
+                for (size_t lane = 0; lane < laneCount; lane++)
+                {
+                    size_t v = block * 4 + lane;
+                    float x = 0.f, y = 0.f, z = 0.f;
+                    for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++)
+                    {
+                        uint32_t corner = adjacency.corners[i];
+                        uint32_t t = corner / 3;
+                        float w = angle ? faces.weight[corner % 3][t] : 1.f;
+                        x += w * faces.normal[0][t];
+                        y += w * faces.normal[1][t];
+                        z += w * faces.normal[2][t];
+                    }
+                    sums[0][lane] = x;
+                    sums[1][lane] = y;
+                    sums[2][lane] = z;
+                }
+
+                Float4 n[3] = {Load(sums[0]), Load(sums[1]), Load(sums[2])};
+                Float4 inverse = InverseLength(Dot(n, n));
+                for (int axis = 0; axis < 3; axis++) Store(sums[axis], Mul(n[axis], inverse));
+                for (size_t lane = 0; lane < laneCount; lane++)
+                {
+                    float* normal = At(normals, block * 4 + lane, stride);
+                    normal[0] = sums[0][lane];
+                    normal[1] = sums[1][lane];
+                    normal[2] = sums[2][lane];
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef __MESHNORMALS_H__
+#define __MESHNORMALS_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Smooth vertex normals as a gather: face normals are computed 4 triangles at a time (SoA, SSE2/NEON),
+// then every vertex sums its own corners through a vertex -> corner adjacency, so vertices can be
+// processed in parallel without write conflicts.
+namespace MeshNormals
+{
+    enum class Weighting
+    {
+        Area,       // face normals weighted by triangle area
+        Angle       // weighted by the corner angle, independent of how the surface is triangulated
+    };
+
+    // CSR: the corners (triangle * 3 + k) referencing vertex v are corners[offsets[v], offsets[v + 1])
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> corners;
+    };
+
+    Adjacency BuildAdjacency(const uint32_t* indicies, size_t indexCount, size_t vertexCount);
+
+    // positions and normals: xyz floats every stride bytes, unreferenced vertices get a zero normal
+    void ComputeNormals(float* normals, const float* positions, size_t vertexCount, size_t stride,
+        const uint32_t* indicies, size_t indexCount, const Adjacency& adjacency, Weighting weighting = Weighting::Area);
+}
+#endif
@@ -0,0 +1,658 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // LRU size simulated while optimizing, scores are tuned for it but the order works for smaller caches too
+    constexpr uint32_t S_CACHE_SIZE = 32;
+    constexpr uint32_t S_VALENCE_TABLE_SIZE = 64;
+
+    struct ScoreTable
+    {
+        float cache[S_CACHE_SIZE];
+        float valence[S_VALENCE_TABLE_SIZE];
+
+        ScoreTable()
+        {
+            const float cacheDecayPower = 1.5f;
+            const float lastTriangleScore = 0.75f;
+            for (uint32_t i = 0; i < S_CACHE_SIZE; i++)
+            {
+                // the three vertices of the last triangle get a fixed score so that
+                // strips do not simply follow the most recent edge
+                cache[i] = i < 3 ? lastTriangleScore :
+                    std::pow(1.f - static_cast<float>(i - 3) / (S_CACHE_SIZE - 3), cacheDecayPower);
+            }
+
+            // boost vertices with few triangles left so they get finished and leave the cache
+            const float valenceBoostScale = 2.f;
+            const float valenceBoostPower = 0.5f;
+            valence[0] = 0.f;
+            for (uint32_t i = 1; i < S_VALENCE_TABLE_SIZE; i++)
+            {
+                valence[i] = valenceBoostScale * std::pow(static_cast<float>(i), -valenceBoostPower);
+            }
+        }
+    };
+
+    const ScoreTable& GetScoreTable()
+    {
+        static const ScoreTable table;
+        return table;
+    }
+
+    float VertexScore(int cachePosition, uint32_t liveTriangles)
+    {
+        if (liveTriangles == 0) return -1.f;
+
+        auto& table = GetScoreTable();
+        float score = cachePosition >= 0 ? table.cache[cachePosition] : 0.f;
+        score += liveTriangles < S_VALENCE_TABLE_SIZE ? table.valence[liveTriangles] :
+            2.f / std::sqrt(static_cast<float>(liveTriangles));
+        return score;
+    }
+
+    // spread the low 10 bits of v so there are two zero bits between each
+    uint32_t Part1By2(uint32_t v)
+    {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0xff0000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    const float* PositionAt(const float* positions, size_t positionStride, size_t i)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + i * positionStride);
+    }
+
+    // FIFO post-transform cache used to find cluster boundaries, Reset() empties it without clearing memory
+    class FifoCache
+    {
+        std::vector<uint32_t> m_insertedAt;
+        uint32_t m_time = 0;
+        uint32_t m_resetAt = 0;
+        uint32_t m_size;
+
+    public:
+        FifoCache(size_t vertexCount, uint32_t size) : m_insertedAt(vertexCount, 0), m_size(size) {}
+
+        void Reset() { m_resetAt = m_time; }
+
+        // returns the number of misses of a triangle
+        uint32_t Update(const uint32_t* triangle)
+        {
+            uint32_t misses = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t& insertedAt = m_insertedAt[triangle[k]];
+                if (insertedAt <= m_resetAt || m_time - insertedAt >= m_size)
+                {
+                    insertedAt = ++m_time;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+    };
+
+    // 30-bit Morton codes of points quantized to 10 bits per axis inside their bounds
+    class MortonEncoder
+    {
+        float m_min[3];
+        float m_scale;
+
+    public:
+        MortonEncoder(const float* positions, size_t vertexCount, size_t positionStride)
+        {
+            float maxs[3] = {};
+            for (int k = 0; k < 3; k++)
+            {
+                m_min[k] = vertexCount ? positions[k] : 0.f;
+                maxs[k] = m_min[k];
+            }
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                const float* p = PositionAt(positions, positionStride, i);
+                for (int k = 0; k < 3; k++)
+                {
+                    m_min[k] = std::min(m_min[k], p[k]);
+                    maxs[k] = std::max(maxs[k], p[k]);
+                }
+            }
+            // one scale for all axes keeps the cells cubic
+            float extent = std::max(maxs[0] - m_min[0], std::max(maxs[1] - m_min[1], maxs[2] - m_min[2]));
+            m_scale = extent > 0.f ? 1023.f / extent : 0.f;
+        }
+
+        uint32_t Encode(float x, float y, float z) const
+        {
+            auto quantize = [&](float value, int k) { return static_cast<uint32_t>((value - m_min[k]) * m_scale + 0.5f); };
+            return Part1By2(quantize(x, 0)) | (Part1By2(quantize(y, 1)) << 1) | (Part1By2(quantize(z, 2)) << 2);
+        }
+    };
+}
+
+namespace MeshOptimizer
+{
+    void OptimizeVertexCache(uint32_t* indicies, size_t indexCount, size_t vertexCount)
+    {
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0) return;
+
+        // vertex -> triangle adjacency, compressed rows
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            liveTriangles[indicies[i]]++;
+        }
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+            {
+                adjacency[fill[indicies[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            vertexScore[v] = VertexScore(-1, liveTriangles[v]);
+        }
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+
+        std::vector<uint32_t> result(triangleCount * 3);
+        uint32_t cache[S_CACHE_SIZE + 3];
+        uint32_t newCache[S_CACHE_SIZE + 3];
+        uint32_t cacheCount = 0;
+
+        size_t cursor = 0;
+        int64_t best = 0;
+        for (size_t output = 0; output < triangleCount; output++)
+        {
+            // nothing in the cache has triangles left, continue with the next triangle in input order
+            if (best < 0)
+            {
+                while (emitted[cursor]) cursor++;
+                best = static_cast<int64_t>(cursor);
+            }
+
+            const uint32_t* triangle = indicies + best * 3;
+            result[output * 3    ] = triangle[0];
+            result[output * 3 + 1] = triangle[1];
+            result[output * 3 + 2] = triangle[2];
+            emitted[best] = 1;
+
+            // detach the triangle from its vertices
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t v = triangle[k];
+                uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+                uint32_t* end = begin + liveTriangles[v];
+                uint32_t* it = std::find(begin, end, static_cast<uint32_t>(best));
+                if (it != end)
+                {
+                    *it = *(end - 1);
+                    liveTriangles[v]--;
+                }
+            }
+
+            // LRU update: the triangle's vertices go to the front
+            uint32_t newCount = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                if (std::find(newCache, newCache + newCount, triangle[k]) == newCache + newCount)
+                {
+                    newCache[newCount++] = triangle[k];
+                }
+            }
+            for (uint32_t i = 0; i < cacheCount; i++)
+            {
+                uint32_t v = cache[i];
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                {
+                    newCache[newCount++] = v;
+                }
+            }
+
+            for (uint32_t i = 0; i < newCount; i++)
+            {
+                uint32_t v = newCache[i];
+                cachePosition[v] = i < S_CACHE_SIZE ? static_cast<int>(i) : -1;
+                vertexScore[v] = VertexScore(cachePosition[v], liveTriangles[v]);
+            }
+
+            // only triangles around cached vertices changed score, the best of them is next
+            best = -1;
+            float bestScore = 0.f;
+            for (uint32_t i = 0; i < newCount; i++)
+            {
+                uint32_t v = newCache[i];
+                const uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+                for (const uint32_t* it = begin; it != begin + liveTriangles[v]; it++)
+                {
+                    uint32_t t = *it;
+                    float score = vertexScore[indicies[t * 3]] + vertexScore[indicies[t * 3 + 1]] + vertexScore[indicies[t * 3 + 2]];
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        best = t;
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCount, S_CACHE_SIZE);
+            std::copy(newCache, newCache + cacheCount, cache);
+        }
+
+        std::copy(result.begin(), result.end(), indicies);
+    }
+
+    CacheStats SimulateVertexCache(const uint32_t* indicies, size_t indexCount, size_t vertexCount,
+        CacheType type, uint32_t cacheSize)
+    {
+        CacheStats stats;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || cacheSize == 0) return stats;
+
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        uint32_t transforms = 0;
+
+        if (type == CacheType::FIFO)
+        {
+            // a vertex is cached while fewer than cacheSize misses happened since it was inserted
+            std::vector<uint32_t> insertedAt(vertexCount, 0);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+            {
+                uint32_t v = indicies[i];
+                referenced[v] = 1;
+                if (insertedAt[v] == 0 || transforms + 1 - insertedAt[v] > cacheSize)
+                {
+                    insertedAt[v] = ++transforms;
+                }
+            }
+        }
+        else
+        {
+            std::vector<uint32_t> cache;
+            cache.reserve(cacheSize);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+            {
+                uint32_t v = indicies[i];
+                referenced[v] = 1;
+                auto it = std::find(cache.begin(), cache.end(), v);
+                if (it == cache.end())
+                {
+                    transforms++;
+                    if (cache.size() == cacheSize) cache.pop_back();
+                    cache.insert(cache.begin(), v);
+                }
+                else
+                {
+                    std::rotate(cache.begin(), it, it + 1);
+                }
+            }
+        }
+
+        size_t referencedCount = std::count(referenced.begin(), referenced.end(), 1);
+        stats.transforms = transforms;
+        stats.acmr = static_cast<double>(transforms) / triangleCount;
+        stats.atvr = referencedCount ? static_cast<double>(transforms) / referencedCount : 0.;
+        return stats;
+    }
+
+    size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indicies, size_t indexCount, size_t vertexCount)
+    {
+        const uint32_t unused = 0xffffffffu;
+        std::fill(remap, remap + vertexCount, unused);
+
+        uint32_t next = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = indicies[i];
+            if (remap[v] == unused) remap[v] = next++;
+        }
+        size_t referenced = next;
+
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] == unused) remap[v] = next++;
+        }
+        return referenced;
+    }
+
+    void SpatialSortRemap(uint32_t* remap, const float* positions, size_t vertexCount, size_t positionStride)
+    {
+        MortonEncoder encoder(positions, vertexCount, positionStride);
+
+        // (code, old index) pairs, the index breaks ties so the order is deterministic
+        std::vector<std::pair<uint32_t, uint32_t>> keys(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const float* p = PositionAt(positions, positionStride, i);
+            keys[i] = {encoder.Encode(p[0], p[1], p[2]), static_cast<uint32_t>(i)};
+        }
+        std::sort(keys.begin(), keys.end());
+
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            remap[keys[i].second] = static_cast<uint32_t>(i);
+        }
+    }
+
+    void SpatialSortTriangles(uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+    {
+        MortonEncoder encoder(positions, vertexCount, positionStride);
+
+        size_t triangleCount = indexCount / 3;
+        std::vector<std::pair<uint32_t, uint32_t>> keys(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const float* a = PositionAt(positions, positionStride, indicies[t * 3]);
+            const float* b = PositionAt(positions, positionStride, indicies[t * 3 + 1]);
+            const float* c = PositionAt(positions, positionStride, indicies[t * 3 + 2]);
+            keys[t] = {encoder.Encode((a[0] + b[0] + c[0]) / 3.f, (a[1] + b[1] + c[1]) / 3.f, (a[2] + b[2] + c[2]) / 3.f),
+                static_cast<uint32_t>(t)};
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<uint32_t> sorted(triangleCount * 3);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            std::memcpy(&sorted[t * 3], indicies + keys[t].second * 3, 3 * sizeof(uint32_t));
+        }
+        std::copy(sorted.begin(), sorted.end(), indicies);
+    }
+
+    void RemapIndexBuffer(uint32_t* indicies, size_t indexCount, const uint32_t* remap)
+    {
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            indicies[i] = remap[indicies[i]];
+        }
+    }
+
+    void RemapVertexBuffer(void* vertices, size_t vertexCount, size_t vertexStride, const uint32_t* remap)
+    {
+        auto data = static_cast<char*>(vertices);
+        std::vector<char> source(data, data + vertexCount * vertexStride);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            std::memcpy(data + remap[v] * vertexStride, source.data() + v * vertexStride, vertexStride);
+        }
+    }
+
+    FetchStats AnalyzeVertexFetch(const uint32_t* indicies, size_t indexCount, size_t vertexCount, size_t vertexStride)
+    {
+        FetchStats stats;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexStride == 0) return stats;
+
+        constexpr size_t lineSize = 64;
+        constexpr size_t lineCount = 16 * 1024 / lineSize;
+        std::vector<uint64_t> tags(lineCount, ~0ull);
+        std::vector<uint8_t> referenced(vertexCount, 0);
+
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            uint32_t v = indicies[i];
+            referenced[v] = 1;
+
+            uint64_t first = static_cast<uint64_t>(v) * vertexStride / lineSize;
+            uint64_t last = (static_cast<uint64_t>(v) * vertexStride + vertexStride - 1) / lineSize;
+            for (uint64_t line = first; line <= last; line++)
+            {
+                uint64_t& tag = tags[line % lineCount];
+                if (tag != line)
+                {
+                    tag = line;
+                    stats.bytesFetched += lineSize;
+                }
+            }
+        }
+
+        size_t referencedCount = std::count(referenced.begin(), referenced.end(), 1);
+        stats.bytesPerTriangle = static_cast<double>(stats.bytesFetched) / triangleCount;
+        stats.overfetch = referencedCount ? static_cast<double>(stats.bytesFetched) / (referencedCount * vertexStride) : 0.;
+        return stats;
+    }
+
+    void OptimizeOverdraw(uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount,
+        size_t positionStride, float threshold)
+    {
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0) return;
+
+        const uint32_t cacheSize = 16;
+        FifoCache cache(vertexCount, cacheSize);
+
+        // hard boundaries: a triangle missing all three vertices starts a new strip anyway
+        std::vector<uint32_t> hardBoundaries;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (cache.Update(indicies + t * 3) == 3) hardBoundaries.push_back(static_cast<uint32_t>(t));
+        }
+        hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+        // soft boundaries: split a hard cluster wherever the running ACMR is still within
+        // threshold of the whole cluster, smaller clusters sort better
+        std::vector<uint32_t> clusters;
+        for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+        {
+            uint32_t begin = hardBoundaries[h];
+            uint32_t end = hardBoundaries[h + 1];
+
+            cache.Reset();
+            uint32_t clusterMisses = 0;
+            for (uint32_t t = begin; t < end; t++)
+            {
+                clusterMisses += cache.Update(indicies + t * 3);
+            }
+            float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+            cache.Reset();
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+            clusters.push_back(begin);
+            for (uint32_t t = begin; t < end; t++)
+            {
+                runningMisses += cache.Update(indicies + t * 3);
+                runningTriangles++;
+                if (t + 1 < end && runningMisses <= clusterThreshold * runningTriangles)
+                {
+                    clusters.push_back(t + 1);
+                    cache.Reset();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+        // occlusion potential: how far the cluster lies out from the mesh center along its own normal
+        double meshCenter[3] = {};
+        double meshArea = 0.;
+        std::vector<float> clusterCenters((clusters.size() - 1) * 3);
+        std::vector<float> clusterNormals((clusters.size() - 1) * 3);
+        for (size_t c = 0; c + 1 < clusters.size(); c++)
+        {
+            double center[3] = {};
+            double normal[3] = {};
+            double area = 0.;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const float* a = PositionAt(positions, positionStride, indicies[t * 3]);
+                const float* b = PositionAt(positions, positionStride, indicies[t * 3 + 1]);
+                const float* d = PositionAt(positions, positionStride, indicies[t * 3 + 2]);
+                double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                double ad[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+                double n[3] = {ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0]};
+                double triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int k = 0; k < 3; k++)
+                {
+                    center[k] += (a[k] + b[k] + d[k]) / 3. * triangleArea;
+                    normal[k] += n[k];
+                }
+                area += triangleArea;
+            }
+            double normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (int k = 0; k < 3; k++)
+            {
+                meshCenter[k] += center[k];
+                clusterCenters[c * 3 + k] = static_cast<float>(area > 0. ? center[k] / area : 0.);
+                clusterNormals[c * 3 + k] = static_cast<float>(normalLength > 0. ? normal[k] / normalLength : 0.);
+            }
+            meshArea += area;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            meshCenter[k] = meshArea > 0. ? meshCenter[k] / meshArea : 0.;
+        }
+
+        std::vector<std::pair<float, uint32_t>> order(clusters.size() - 1);
+        for (size_t c = 0; c < order.size(); c++)
+        {
+            float potential = 0.f;
+            for (int k = 0; k < 3; k++)
+            {
+                potential += (clusterCenters[c * 3 + k] - static_cast<float>(meshCenter[k])) * clusterNormals[c * 3 + k];
+            }
+            order[c] = {-potential, static_cast<uint32_t>(c)};
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<uint32_t> result;
+        result.reserve(triangleCount * 3);
+        for (auto& cluster: order)
+        {
+            result.insert(result.end(), indicies + clusters[cluster.second] * 3, indicies + clusters[cluster.second + 1] * 3);
+        }
+        std::copy(result.begin(), result.end(), indicies);
+    }
+
+    OverdrawStats AnalyzeOverdraw(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount,
+        size_t positionStride)
+    {
+        OverdrawStats stats;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0) return stats;
+
+        // bounding sphere (box center) so every view fits the whole mesh
+        float minP[3], maxP[3];
+        for (int k = 0; k < 3; k++) minP[k] = maxP[k] = positions[k];
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const float* p = PositionAt(positions, positionStride, i);
+            for (int k = 0; k < 3; k++)
+            {
+                minP[k] = std::min(minP[k], p[k]);
+                maxP[k] = std::max(maxP[k], p[k]);
+            }
+        }
+        float center[3] = {(minP[0] + maxP[0]) / 2, (minP[1] + maxP[1]) / 2, (minP[2] + maxP[2]) / 2};
+        float radius = 0.f;
+        for (int k = 0; k < 3; k++) radius += (maxP[k] - center[k]) * (maxP[k] - center[k]);
+        radius = std::sqrt(radius);
+        if (radius <= 0.f) return stats;
+
+        constexpr int size = 256;
+        std::vector<float> depth(size * size);
+        std::vector<float> projected(vertexCount * 3);
+
+        const float directions[14][3] = {
+            { 1, 0, 0}, {-1, 0, 0}, {0,  1, 0}, {0, -1, 0}, {0, 0,  1}, {0, 0, -1},
+            { 1, 1, 1}, { 1, 1, -1}, { 1, -1, 1}, { 1, -1, -1},
+            {-1, 1, 1}, {-1, 1, -1}, {-1, -1, 1}, {-1, -1, -1},
+        };
+        for (auto& direction: directions)
+        {
+            // view basis: forward, and two axes perpendicular to it
+            float forward[3];
+            float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+            for (int k = 0; k < 3; k++) forward[k] = direction[k] / length;
+            float up[3] = {0, 1, 0};
+            if (std::abs(forward[1]) > 0.9f)
+            {
+                up[1] = 0;
+                up[2] = 1;
+            }
+            float right[3] = {up[1] * forward[2] - up[2] * forward[1], up[2] * forward[0] - up[0] * forward[2], up[0] * forward[1] - up[1] * forward[0]};
+            length = std::sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+            for (int k = 0; k < 3; k++) right[k] /= length;
+            float top[3] = {forward[1] * right[2] - forward[2] * right[1], forward[2] * right[0] - forward[0] * right[2], forward[0] * right[1] - forward[1] * right[0]};
+
+            float scale = size / (2.f * radius);
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                const float* p = PositionAt(positions, positionStride, i);
+                float d[3] = {p[0] - center[0], p[1] - center[1], p[2] - center[2]};
+                projected[i * 3    ] = (d[0] * right[0] + d[1] * right[1] + d[2] * right[2]) * scale + size / 2.f;
+                projected[i * 3 + 1] = (d[0] * top[0] + d[1] * top[1] + d[2] * top[2]) * scale + size / 2.f;
+                projected[i * 3 + 2] = d[0] * forward[0] + d[1] * forward[1] + d[2] * forward[2];
+            }
+
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                const float* a = &projected[indicies[t * 3] * 3];
+                const float* b = &projected[indicies[t * 3 + 1] * 3];
+                const float* c = &projected[indicies[t * 3 + 2] * 3];
+
+                float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+                if (area == 0.f) continue;
+                // both faces are drawn, flip back facing triangles to a positive area
+                if (area < 0.f)
+                {
+                    std::swap(b, c);
+                    area = -area;
+                }
+
+                int x0 = std::max(0, static_cast<int>(std::floor(std::min(a[0], std::min(b[0], c[0])))));
+                int x1 = std::min(size - 1, static_cast<int>(std::ceil(std::max(a[0], std::max(b[0], c[0])))));
+                int y0 = std::max(0, static_cast<int>(std::floor(std::min(a[1], std::min(b[1], c[1])))));
+                int y1 = std::min(size - 1, static_cast<int>(std::ceil(std::max(a[1], std::max(b[1], c[1])))));
+
+                for (int y = y0; y <= y1; y++)
+                {
+                    float py = y + 0.5f;
+                    for (int x = x0; x <= x1; x++)
+                    {
+                        float px = x + 0.5f;
+                        // edge functions, sampled at the pixel center
+                        float w0 = (c[0] - b[0]) * (py - b[1]) - (c[1] - b[1]) * (px - b[0]);
+                        float w1 = (a[0] - c[0]) * (py - c[1]) - (a[1] - c[1]) * (px - c[0]);
+                        float w2 = (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+                        if (w0 < 0.f || w1 < 0.f || w2 < 0.f) continue;
+
+                        float z = (w0 * a[2] + w1 * b[2] + w2 * c[2]) / area;
+                        float& stored = depth[y * size + x];
+                        if (z < stored)
+                        {
+                            if (stored == std::numeric_limits<float>::max()) stats.pixelsCovered++;
+                            stored = z;
+                            stats.pixelsShaded++;
+                        }
+                    }
+                }
+            }
+        }
+
+        stats.overdraw = stats.pixelsCovered ? static_cast<double>(stats.pixelsShaded) / stats.pixelsCovered : 0.;
+        return stats;
+    }
+}
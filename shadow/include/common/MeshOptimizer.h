@@ -0,0 +1,76 @@
+#ifndef __MESHOPTIMIZER_H__
+#define __MESHOPTIMIZER_H__
+
+#include <cstdint>
+#include <cstddef>
+
+// Offline index/vertex buffer optimizations for triangle lists, run once when a model
+// is loaded from source (the result is what ends up in the mesh cache).
+namespace MeshOptimizer
+{
+    // Reorders triangles in place for the GPU post-transform vertex cache
+    // (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+    void OptimizeVertexCache(uint32_t* indicies, size_t indexCount, size_t vertexCount);
+
+    enum class CacheType
+    {
+        FIFO,
+        LRU
+    };
+
+    struct CacheStats
+    {
+        uint32_t transforms = 0;    // cache misses = vertex shader invocations
+        double acmr = 0.;           // transforms per triangle, 0.5 is the best a regular grid gets
+        double atvr = 0.;           // transforms per referenced vertex, 1.0 is optimal
+    };
+
+    // CPU simulation of a post-transform cache with cacheSize entries
+    CacheStats SimulateVertexCache(const uint32_t* indicies, size_t indexCount, size_t vertexCount,
+        CacheType type, uint32_t cacheSize);
+
+    // Builds remap[old] = new so vertices are numbered in the order the triangles first
+    // reference them, unreferenced vertices go to the end. Returns the referenced count.
+    size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indicies, size_t indexCount, size_t vertexCount);
+
+    // Builds remap[old] = new sorting vertices along a Morton (Z-order) curve of their positions,
+    // for scans whose file order has no spatial coherence. positions: xyz floats every positionStride bytes.
+    void SpatialSortRemap(uint32_t* remap, const float* positions, size_t vertexCount, size_t positionStride);
+
+    // Sorts triangles along the Morton curve of their centroids. Run before OptimizeVertexCache,
+    // whose restarts then stay spatially close.
+    void SpatialSortTriangles(uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+    void RemapIndexBuffer(uint32_t* indicies, size_t indexCount, const uint32_t* remap);
+    void RemapVertexBuffer(void* vertices, size_t vertexCount, size_t vertexStride, const uint32_t* remap);
+
+    struct FetchStats
+    {
+        uint64_t bytesFetched = 0;      // cache line bytes read from the vertex buffer
+        double bytesPerTriangle = 0.;
+        double overfetch = 0.;          // bytesFetched / (referenced vertices * stride), 1.0 is optimal
+    };
+
+    // CPU simulation of vertex fetch through a 16 KB direct mapped cache with 64 byte lines
+    FetchStats AnalyzeVertexFetch(const uint32_t* indicies, size_t indexCount, size_t vertexCount, size_t vertexStride);
+
+    // Splits a vertex cache optimized index buffer into clusters and sorts them by occlusion
+    // potential, so outward facing parts are drawn first from any direction (Sander et al.,
+    // "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"). threshold bounds
+    // the allowed ACMR loss per cluster, 1.05 keeps the order within 5% of the input.
+    void OptimizeOverdraw(uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount,
+        size_t positionStride, float threshold = 1.05f);
+
+    struct OverdrawStats
+    {
+        uint64_t pixelsCovered = 0;
+        uint64_t pixelsShaded = 0;  // fragments passing a LESS depth test in submission order
+        double overdraw = 0.;       // shaded / covered, 1.0 means every pixel is shaded once
+    };
+
+    // Software depth-only rasterization of both faces into a 256x256 target, orthographic
+    // views along the 6 axes and the 8 cube diagonals, summed.
+    OverdrawStats AnalyzeOverdraw(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount,
+        size_t positionStride);
+}
+#endif
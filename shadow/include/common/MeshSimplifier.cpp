@@ -0,0 +1,508 @@
+#include "MeshSimplifier.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    using MeshSimplifier::Options;
+    using MeshSimplifier::LodLevel;
+
+    // border edges get a plane perpendicular to the surface, weighted relative to the face planes
+    constexpr float S_BORDER_WEIGHT = 10.f;
+    // a collapse may not turn any remaining triangle by more than acos(0.25)
+    constexpr float S_FLIP_THRESHOLD = 0.25f;
+    // share of the cheapest candidates a pass may use, the rest waits for the next pass
+    constexpr double S_PASS_CANDIDATES = 0.3;
+
+    enum VertexKind : uint8_t
+    {
+        FREE,
+        BORDER,     // may only collapse along a border edge
+        LOCKED
+    };
+
+    struct Quadric
+    {
+        float a00, a01, a02, a11, a12, a22;
+        float b0, b1, b2;
+        float c;
+        float w;
+    };
+
+    // weight * (dot(n, p) + d)^2
+    void AddPlane(Quadric& q, float nx, float ny, float nz, float d, float weight)
+    {
+        q.a00 += weight * nx * nx;
+        q.a01 += weight * nx * ny;
+        q.a02 += weight * nx * nz;
+        q.a11 += weight * ny * ny;
+        q.a12 += weight * ny * nz;
+        q.a22 += weight * nz * nz;
+        q.b0 += weight * nx * d;
+        q.b1 += weight * ny * d;
+        q.b2 += weight * nz * d;
+        q.c += weight * d * d;
+        q.w += weight;
+    }
+
+    void AddQuadric(Quadric& q, const Quadric& r)
+    {
+        q.a00 += r.a00; q.a01 += r.a01; q.a02 += r.a02;
+        q.a11 += r.a11; q.a12 += r.a12; q.a22 += r.a22;
+        q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+        q.c += r.c;
+        q.w += r.w;
+    }
+
+    float Evaluate(const Quadric& q, const float* p)
+    {
+        float x = p[0], y = p[1], z = p[2];
+        float result = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+            2.f * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+            2.f * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+        return std::max(0.f, result);
+    }
+
+    void Normal(const float* p0, const float* p1, const float* p2, float* n)
+    {
+        float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    struct Candidate
+    {
+        float cost;
+        float error;        // mean squared distance, without the attribute term
+        uint32_t from;
+        uint32_t to;
+    };
+
+    class Simplifier
+    {
+        size_t m_vertexCount;
+        const float* m_normals;
+        const float* m_uvs;
+        size_t m_stride;
+        Options m_options;
+
+        std::vector<float> m_positions;     // scaled into the unit box
+        float m_scale = 1.f;
+        std::vector<uint8_t> m_kind;
+        std::vector<Quadric> m_quadrics;
+        std::vector<uint32_t> m_indicies;   // current level, wedge ids
+        float m_maxError = 0.f;
+
+        // vertex -> triangles of m_indicies
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_adjacency;
+
+        // best collapse of every vertex, recomputed when it is marked dirty
+        std::vector<Candidate> m_candidates;
+        std::vector<uint8_t> m_dirty;
+
+        const float* Attribute(const float* base, uint32_t v) const
+        {
+            return reinterpret_cast<const float*>(reinterpret_cast<const char*>(base) + v * m_stride);
+        }
+
+        void BuildAdjacency()
+        {
+            m_offsets.assign(m_vertexCount + 1, 0);
+            for (uint32_t v: m_indicies)
+            {
+                m_offsets[v + 1]++;
+            }
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                m_offsets[v + 1] += m_offsets[v];
+            }
+            m_adjacency.resize(m_indicies.size());
+            std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+            for (size_t i = 0; i < m_indicies.size(); i++)
+            {
+                m_adjacency[fill[m_indicies[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // Vertices identical in every attribute become one wedge, wedges sharing only the position
+        // sit on a seam
+        void Weld(const float* positions, std::vector<uint32_t>& wedge, std::vector<uint8_t>& seam) const
+        {
+            auto key = [&](uint32_t v, float* out)
+            {
+                const float* p = Attribute(positions, v);
+                out[0] = p[0]; out[1] = p[1]; out[2] = p[2];
+                for (int k = 0; k < 3; k++) out[3 + k] = m_normals ? Attribute(m_normals, v)[k] : 0.f;
+                for (int k = 0; k < 2; k++) out[6 + k] = m_uvs ? Attribute(m_uvs, v)[k] : 0.f;
+            };
+            std::vector<uint32_t> order(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; v++) order[v] = static_cast<uint32_t>(v);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+            {
+                float ka[8], kb[8];
+                key(a, ka);
+                key(b, kb);
+                int result = std::memcmp(ka, kb, sizeof(ka));
+                return result < 0 || (result == 0 && a < b);
+            });
+
+            wedge.resize(m_vertexCount);
+            seam.assign(m_vertexCount, 0);
+            for (size_t begin = 0, end; begin < m_vertexCount; begin = end)
+            {
+                // [begin, end) share the position, the first of each attribute run is the wedge
+                float first[8];
+                key(order[begin], first);
+                size_t wedgeCount = 0;
+                float previous[8] = {};
+                for (end = begin; end < m_vertexCount; end++)
+                {
+                    float current[8];
+                    key(order[end], current);
+                    if (std::memcmp(current, first, sizeof(float) * 3) != 0) break;
+                    if (end == begin || std::memcmp(current, previous, sizeof(current)) != 0)
+                    {
+                        wedgeCount++;
+                        wedge[order[end]] = order[end];
+                    }
+                    else
+                    {
+                        wedge[order[end]] = wedge[order[end - 1]];
+                    }
+                    std::memcpy(previous, current, sizeof(current));
+                }
+                if (wedgeCount > 1)
+                {
+                    for (size_t i = begin; i < end; i++) seam[order[i]] = 1;
+                }
+            }
+        }
+
+        void ClassifyVertices(const std::vector<uint8_t>& seam)
+        {
+            m_kind.assign(m_vertexCount, LOCKED);
+            Util::ParallelForRange(m_vertexCount, 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; v++)
+                {
+                    if (seam[v] || m_offsets[v] == m_offsets[v + 1]) continue;
+
+                    // around a manifold vertex every edge to a neighbor is used once in each direction,
+                    // an edge used in one direction only is a border
+                    bool border = false, nonManifold = false;
+                    for (uint32_t i = m_offsets[v]; i < m_offsets[v + 1]; i++)
+                    {
+                        uint32_t next, prev;
+                        Around(m_adjacency[i], static_cast<uint32_t>(v), next, prev);
+                        int nextOut = 0, nextIn = 0, prevOut = 0, prevIn = 0;
+                        for (uint32_t j = m_offsets[v]; j < m_offsets[v + 1]; j++)
+                        {
+                            uint32_t n, p;
+                            Around(m_adjacency[j], static_cast<uint32_t>(v), n, p);
+                            nextOut += n == next;
+                            nextIn += p == next;
+                            prevOut += n == prev;
+                            prevIn += p == prev;
+                        }
+                        nonManifold = nonManifold || nextOut > 1 || nextIn > 1 || prevOut > 1 || prevIn > 1;
+                        border = border || nextIn == 0 || prevOut == 0;
+                    }
+
+                    if (nonManifold) m_kind[v] = LOCKED;
+                    else if (border) m_kind[v] = m_options.lockBorder ? LOCKED : BORDER;
+                    else m_kind[v] = FREE;
+                }
+            });
+        }
+
+        // the vertices following and preceding v in triangle t
+        void Around(uint32_t t, uint32_t v, uint32_t& next, uint32_t& prev) const
+        {
+            const uint32_t* triangle = &m_indicies[t * 3];
+            int k = triangle[0] == v ? 0 : (triangle[1] == v ? 1 : 2);
+            next = triangle[(k + 1) % 3];
+            prev = triangle[(k + 2) % 3];
+        }
+
+        // area weighted face planes, plus perpendicular planes along border edges
+        void AccumulateQuadrics()
+        {
+            m_quadrics.assign(m_vertexCount, Quadric{});
+            Util::ParallelForRange(m_vertexCount, 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; v++)
+                {
+                    Quadric& q = m_quadrics[v];
+                    for (uint32_t i = m_offsets[v]; i < m_offsets[v + 1]; i++)
+                    {
+                        const uint32_t* triangle = &m_indicies[m_adjacency[i] * 3];
+                        const float* p0 = &m_positions[triangle[0] * 3];
+                        float n[3];
+                        Normal(p0, &m_positions[triangle[1] * 3], &m_positions[triangle[2] * 3], n);
+                        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                        if (length == 0.f) continue;
+                        n[0] /= length; n[1] /= length; n[2] /= length;
+                        float d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+                        AddPlane(q, n[0], n[1], n[2], d, length * 0.5f);
+
+                        if (m_kind[v] != BORDER) continue;
+                        uint32_t next, prev;
+                        Around(m_adjacency[i], static_cast<uint32_t>(v), next, prev);
+                        for (uint32_t other: {next, prev})
+                        {
+                            if (EdgeTriangles(static_cast<uint32_t>(v), other) != 1) continue;
+                            const float* a = &m_positions[v * 3];
+                            const float* b = &m_positions[other * 3];
+                            float edge[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                            float edgeLength = std::sqrt(edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+                            float m[3] = {edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0]};
+                            float mLength = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+                            if (mLength == 0.f) continue;
+                            m[0] /= mLength; m[1] /= mLength; m[2] /= mLength;
+                            AddPlane(q, m[0], m[1], m[2], -(m[0] * a[0] + m[1] * a[1] + m[2] * a[2]), S_BORDER_WEIGHT * edgeLength * edgeLength);
+                        }
+                    }
+                }
+            });
+        }
+
+        uint32_t EdgeTriangles(uint32_t a, uint32_t b) const
+        {
+            uint32_t count = 0;
+            for (uint32_t i = m_offsets[a]; i < m_offsets[a + 1]; i++)
+            {
+                const uint32_t* triangle = &m_indicies[m_adjacency[i] * 3];
+                count += triangle[0] == b || triangle[1] == b || triangle[2] == b;
+            }
+            return count;
+        }
+
+        // cheapest allowed collapse starting at v, cost is infinite when there is none
+        Candidate BestCollapse(uint32_t v) const
+        {
+            Candidate best = {std::numeric_limits<float>::infinity(), 0.f, v, v};
+            if (m_kind[v] == LOCKED) return best;
+
+            const Quadric& q = m_quadrics[v];
+            for (uint32_t i = m_offsets[v]; i < m_offsets[v + 1]; i++)
+            {
+                uint32_t next, prev;
+                Around(m_adjacency[i], v, next, prev);
+                // around an interior vertex every neighbor follows it in exactly one triangle
+                for (uint32_t to: {next, prev})
+                {
+                    if (m_kind[v] == FREE && to == prev) continue;
+                    if (m_kind[v] == BORDER && EdgeTriangles(v, to) != 1) continue;
+
+                    float distance = Evaluate(q, &m_positions[to * 3]);
+                    float attribute = 0.f;
+                    if (m_normals)
+                    {
+                        const float* a = Attribute(m_normals, v);
+                        const float* b = Attribute(m_normals, to);
+                        attribute += m_options.normalWeight * ((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+                    }
+                    if (m_uvs)
+                    {
+                        const float* a = Attribute(m_uvs, v);
+                        const float* b = Attribute(m_uvs, to);
+                        attribute += m_options.uvWeight * ((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]));
+                    }
+                    float cost = distance + attribute * q.w;
+                    if (cost < best.cost || (cost == best.cost && to < best.to))
+                    {
+                        best.cost = cost;
+                        best.error = q.w > 0.f ? distance / q.w : 0.f;
+                        best.to = to;
+                    }
+                }
+            }
+            return best;
+        }
+
+        // no triangle left around from may turn over when from moves onto to
+        bool PreservesOrientation(uint32_t from, uint32_t to) const
+        {
+            for (uint32_t i = m_offsets[from]; i < m_offsets[from + 1]; i++)
+            {
+                const uint32_t* triangle = &m_indicies[m_adjacency[i] * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+                const float* p[3];
+                const float* moved[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = &m_positions[triangle[k] * 3];
+                    moved[k] = triangle[k] == from ? &m_positions[to * 3] : p[k];
+                }
+                float before[3], after[3];
+                Normal(p[0], p[1], p[2], before);
+                Normal(moved[0], moved[1], moved[2], after);
+                float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                float lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                    (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                if (dot <= S_FLIP_THRESHOLD * lengths) return false;
+            }
+            return true;
+        }
+
+        // one round of non-overlapping collapses, returns false when nothing could collapse
+        bool Pass(size_t targetTriangles)
+        {
+            size_t triangleCount = m_indicies.size() / 3;
+            BuildAdjacency();
+
+            // only vertices whose neighborhood changed in the last pass need a new candidate
+            Util::ParallelForRange(m_vertexCount, 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; v++)
+                {
+                    if (!m_dirty[v]) continue;
+                    m_candidates[v] = BestCollapse(static_cast<uint32_t>(v));
+                    m_dirty[v] = 0;
+                }
+            });
+            std::vector<uint32_t> order;
+            for (size_t v = 0; v < m_vertexCount; v++)
+            {
+                if (std::isfinite(m_candidates[v].cost)) order.push_back(static_cast<uint32_t>(v));
+            }
+            if (order.empty()) return false;
+            auto cheaper = [&](uint32_t a, uint32_t b)
+            {
+                float costA = m_candidates[a].cost, costB = m_candidates[b].cost;
+                return costA < costB || (costA == costB && a < b);
+            };
+            // the cheapest share in cost order, the rest only when none of those can collapse
+            size_t considered = std::max<size_t>(1, static_cast<size_t>(order.size() * S_PASS_CANDIDATES));
+            std::nth_element(order.begin(), order.begin() + considered - 1, order.end(), cheaper);
+            std::sort(order.begin(), order.begin() + considered, cheaper);
+
+            std::vector<uint32_t> collapse(m_vertexCount);
+            for (size_t v = 0; v < m_vertexCount; v++) collapse[v] = static_cast<uint32_t>(v);
+            size_t removed = 0;
+            for (size_t i = 0; i < order.size() && triangleCount - removed > targetTriangles; i++)
+            {
+                if (i == considered)
+                {
+                    if (removed > 0) break;
+                    std::sort(order.begin() + considered, order.end(), cheaper);
+                }
+                const Candidate& c = m_candidates[order[i]];
+                if (m_dirty[c.from] || m_dirty[c.to]) continue;
+                if (!PreservesOrientation(c.from, c.to)) continue;
+
+                collapse[c.from] = c.to;
+                removed += EdgeTriangles(c.from, c.to);
+                // the triangles around from change, nothing else in them may collapse this pass
+                for (uint32_t k = m_offsets[c.from]; k < m_offsets[c.from + 1]; k++)
+                {
+                    const uint32_t* triangle = &m_indicies[m_adjacency[k] * 3];
+                    m_dirty[triangle[0]] = m_dirty[triangle[1]] = m_dirty[triangle[2]] = 1;
+                }
+                AddQuadric(m_quadrics[c.to], m_quadrics[c.from]);
+                m_maxError = std::max(m_maxError, c.error);
+            }
+            if (removed == 0) return false;
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                uint32_t a = collapse[m_indicies[t * 3]];
+                uint32_t b = collapse[m_indicies[t * 3 + 1]];
+                uint32_t c = collapse[m_indicies[t * 3 + 2]];
+                if (a == b || b == c || a == c) continue;
+                m_indicies[write++] = a;
+                m_indicies[write++] = b;
+                m_indicies[write++] = c;
+            }
+            m_indicies.resize(write);
+            return true;
+        }
+
+    public:
+        Simplifier(const uint32_t* indicies, size_t indexCount, const float* positions, const float* normals, const float* uvs,
+            size_t vertexCount, size_t stride, const Options& options)
+            : m_vertexCount(vertexCount), m_normals(normals), m_uvs(uvs), m_stride(stride), m_options(options)
+        {
+            // work in the unit box so the error and attribute weights don't depend on the model size
+            float boundsMin[3] = {0.f, 0.f, 0.f}, boundsMax[3] = {0.f, 0.f, 0.f};
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                const float* p = Attribute(positions, static_cast<uint32_t>(v));
+                for (int k = 0; k < 3; k++)
+                {
+                    boundsMin[k] = v == 0 ? p[k] : std::min(boundsMin[k], p[k]);
+                    boundsMax[k] = v == 0 ? p[k] : std::max(boundsMax[k], p[k]);
+                }
+            }
+            float extent = std::max(boundsMax[0] - boundsMin[0], std::max(boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]));
+            m_scale = extent > 0.f ? extent : 1.f;
+            m_positions.resize(vertexCount * 3);
+            Util::ParallelForRange(vertexCount, 16384, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; v++)
+                {
+                    const float* p = Attribute(positions, static_cast<uint32_t>(v));
+                    for (int k = 0; k < 3; k++) m_positions[v * 3 + k] = (p[k] - boundsMin[k]) / m_scale;
+                }
+            });
+
+            std::vector<uint32_t> wedge;
+            std::vector<uint8_t> seam;
+            Weld(positions, wedge, seam);
+            m_indicies.reserve(indexCount);
+            for (size_t t = 0; t + 2 < indexCount; t += 3)
+            {
+                uint32_t a = wedge[indicies[t]], b = wedge[indicies[t + 1]], c = wedge[indicies[t + 2]];
+                if (a == b || b == c || a == c) continue;
+                m_indicies.push_back(a);
+                m_indicies.push_back(b);
+                m_indicies.push_back(c);
+            }
+
+            BuildAdjacency();
+            ClassifyVertices(seam);
+            AccumulateQuadrics();
+            m_candidates.resize(m_vertexCount);
+            m_dirty.assign(m_vertexCount, 1);
+        }
+
+        void Simplify(size_t targetTriangles)
+        {
+            while (m_indicies.size() / 3 > targetTriangles && Pass(targetTriangles))
+            {
+            }
+        }
+
+        const std::vector<uint32_t>& GetIndicies() const { return m_indicies; }
+        float GetError() const { return std::sqrt(m_maxError) * m_scale; }
+    };
+}
+
+namespace MeshSimplifier
+{
+    std::vector<LodLevel> GenerateLods(const uint32_t* indicies, size_t indexCount,
+        const float* positions, const float* normals, const float* uvs, size_t vertexCount, size_t vertexStride,
+        const float* ratios, size_t ratioCount, const Options& options)
+    {
+        std::vector<LodLevel> levels(ratioCount);
+        if (ratioCount == 0 || vertexCount == 0) return levels;
+
+        Simplifier simplifier(indicies, indexCount, positions, normals, uvs, vertexCount, vertexStride, options);
+        for (size_t i = 0; i < ratioCount; i++)
+        {
+            simplifier.Simplify(static_cast<size_t>(indexCount / 3 * static_cast<double>(ratios[i])));
+            levels[i].indicies = simplifier.GetIndicies();
+            levels[i].error = simplifier.GetError();
+        }
+        return levels;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef __MESHSIMPLIFIER_H__
+#define __MESHSIMPLIFIER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Quadric error metric simplification (Garland & Heckbert, "Surface Simplification Using Quadric
+// Error Metrics") by half-edge collapses, so every level indexes the original vertex buffer.
+namespace MeshSimplifier
+{
+    struct Options
+    {
+        // cost of a squared attribute difference, next to the mean squared distance with the mesh
+        // scaled into a unit box: 1e-5 makes a 90 degree normal change cost like moving 0.45% of the size
+        float normalWeight = 1e-5f;
+        float uvWeight = 1e-3f;
+        // border vertices stay in place, otherwise they may only slide along the border
+        bool lockBorder = true;
+    };
+
+    struct LodLevel
+    {
+        std::vector<uint32_t> indicies;
+        float error = 0.f;      // estimated distance to the source surface in model space
+    };
+
+    // One level per ratio (fraction of the source triangles, descending), each simplified further
+    // from the previous one. A level stops early when no collapse is left, vertices on a UV/normal
+    // seam, at non-manifold edges and (with lockBorder) on a border never move.
+    // positions / normals / uvs: xyz / xyz / xy floats every vertexStride bytes, normals and uvs may be null.
+    std::vector<LodLevel> GenerateLods(const uint32_t* indicies, size_t indexCount,
+        const float* positions, const float* normals, const float* uvs, size_t vertexCount, size_t vertexStride,
+        const float* ratios, size_t ratioCount, const Options& options = Options());
+}
+#endif
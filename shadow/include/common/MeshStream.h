@@ -0,0 +1,29 @@
+#ifndef __MESHSTREAM_H__
+#define __MESHSTREAM_H__
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Side channel of the loaders for progressive display: positions and triangle indices are handed
+// out in file order while parsing, before Reconstruct / welding optimizations and in source coordinates.
+namespace MeshStream
+{
+    template<typename T>
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+
+        // once before any data, 0 when the format does not tell. indexCount is a hint (faces * 3),
+        // polygons with more than 3 vertices produce more
+        virtual void OnBegin(size_t /*vertexCount*/, size_t /*indexCount*/) {}
+        // appended after the positions already sent
+        virtual void OnPositions(const std::array<T, 3>* positions, size_t count) = 0;
+        // whole triangles, only referencing positions that were already sent
+        virtual void OnIndicies(const uint32_t* indicies, size_t count) = 0;
+        // the loader is done, nothing follows
+        virtual void OnEnd() {}
+    };
+}
+#endif
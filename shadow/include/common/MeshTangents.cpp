@@ -0,0 +1,287 @@
+#include "MeshTangents.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHTANGENTS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MESHTANGENTS_NEON
+#endif
+
+namespace
+{
+    inline const float* At(const float* base, size_t i, size_t stride)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(base) + i * stride);
+    }
+
+    inline float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // 归一化，零向量返回 false
+    inline bool Normalize(float v[3])
+    {
+        float lengthSquared = Dot(v, v);
+        if (!(lengthSquared > 0.f)) return false;
+        float inverse = 1.f / std::sqrt(lengthSquared);
+        for (int k = 0; k < 3; k++) v[k] *= inverse;
+        return true;
+    }
+
+    // v 减去在 n 上的分量
+    inline void Project(float v[3], const float n[3])
+    {
+        float d = Dot(v, n);
+        for (int k = 0; k < 3; k++) v[k] -= n[k] * d;
+    }
+
+    // UV 三角形的有向面积的符号，退化时为 0
+    inline int8_t Orientation(const float* uv0, const float* uv1, const float* uv2)
+    {
+        float area = (uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) - (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]);
+        return area > 0.f ? 1 : (area < 0.f ? -1 : 0);
+    }
+
+    std::vector<int8_t> FaceOrientations(const uint32_t* indicies, size_t triangleCount, const float* uvs, size_t stride)
+    {
+        std::vector<int8_t> orientation(triangleCount);
+        Util::ParallelForRange(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+            {
+                const uint32_t* triangle = indicies + t * 3;
+                orientation[t] = Orientation(At(uvs, triangle[0], stride), At(uvs, triangle[1], stride), At(uvs, triangle[2], stride));
+            }
+        });
+        return orientation;
+    }
+
+    // 每个三角形 dP/du 的方向（单位长度），UV 退化或和位置共线时为零向量
+    std::vector<float> FaceTangents(const float* positions, const float* uvs, size_t stride,
+        const uint32_t* indicies, size_t triangleCount)
+    {
+        std::vector<float> tangents(triangleCount * 3);
+        Util::ParallelForRange(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+            {
+                const uint32_t* triangle = indicies + t * 3;
+                const float* p0 = At(positions, triangle[0], stride);
+                const float* p1 = At(positions, triangle[1], stride);
+                const float* p2 = At(positions, triangle[2], stride);
+                const float* uv0 = At(uvs, triangle[0], stride);
+                const float* uv1 = At(uvs, triangle[1], stride);
+                const float* uv2 = At(uvs, triangle[2], stride);
+
+                float s1 = uv1[0] - uv0[0], t1 = uv1[1] - uv0[1];
+                float s2 = uv2[0] - uv0[0], t2 = uv2[1] - uv0[1];
+                float area = s1 * t2 - s2 * t1;
+                // (d1 * t2 - d2 * t1) / area，只需要方向，除法换成乘符号
+                float sign = area > 0.f ? 1.f : (area < 0.f ? -1.f : 0.f);
+                float* tangent = &tangents[t * 3];
+                for (int k = 0; k < 3; k++)
+                {
+                    tangent[k] = ((p1[k] - p0[k]) * t2 - (p2[k] - p0[k]) * t1) * sign;
+                }
+                if (!Normalize(tangent)) tangent[0] = tangent[1] = tangent[2] = 0.f;
+            }
+        });
+        return tangents;
+    }
+
+    // n 的平面内任取一个方向，用于所有三角形 UV 都退化的顶点
+    void AnyPerpendicular(float out[3], const float n[3])
+    {
+        float axis[3] = {0.f, 0.f, 0.f};
+        float ax = std::abs(n[0]), ay = std::abs(n[1]), az = std::abs(n[2]);
+        axis[ax <= ay && ax <= az ? 0 : (ay <= az ? 1 : 2)] = 1.f;
+        for (int k = 0; k < 3; k++) out[k] = axis[k];
+        Project(out, n);
+        if (!Normalize(out))
+        {
+            out[0] = 1.f;
+            out[1] = out[2] = 0.f;
+        }
+    }
+
+    inline uint32_t Quantize10(float v)
+    {
+        v = std::min(std::max(v, -1.f), 1.f);
+        return static_cast<uint32_t>(v * 511.5f + 512.f);
+    }
+}
+
+namespace MeshTangents
+{
+    std::vector<uint32_t> SplitMirrored(uint32_t* indicies, size_t indexCount, size_t vertexCount,
+        const float* uvs, size_t stride, const MeshNormals::Adjacency& adjacency)
+    {
+        size_t triangleCount = indexCount / 3;
+        auto orientation = FaceOrientations(indicies, triangleCount, uvs, stride);
+
+        // 两种朝向都有的顶点
+        std::vector<uint8_t> mirrored(vertexCount);
+        Util::ParallelForRange(vertexCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; v++)
+            {
+                bool positive = false, negative = false;
+                for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++)
+                {
+                    int8_t o = orientation[adjacency.corners[i] / 3];
+                    positive |= o > 0;
+                    negative |= o < 0;
+                }
+                mirrored[v] = positive && negative;
+            }
+        });
+
+        // 按顶点顺序编号，结果和线程数无关
+        std::vector<uint32_t> sources;
+        std::vector<uint32_t> copyOf(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            if (!mirrored[v]) continue;
+            copyOf[v] = static_cast<uint32_t>(vertexCount + sources.size());
+            sources.push_back(static_cast<uint32_t>(v));
+        }
+
+        Util::ParallelForRange(triangleCount, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+            {
+                if (orientation[t] >= 0) continue;
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t& index = indicies[t * 3 + k];
+                    if (mirrored[index]) index = copyOf[index];
+                }
+            }
+        });
+        return sources;
+    }
+
+    void ComputeTangents(float* tangents, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const uint32_t* indicies, size_t indexCount, const MeshNormals::Adjacency& adjacency)
+    {
+        size_t triangleCount = indexCount / 3;
+        auto orientation = FaceOrientations(indicies, triangleCount, uvs, stride);
+        auto faceTangents = FaceTangents(positions, uvs, stride, indicies, triangleCount);
+
+        Util::ParallelForRange(vertexCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; v++)
+            {
+                const float* n = At(normals, v, stride);
+                const float* p = At(positions, v, stride);
+
+                // 没有拆分过镜像的网格按多数三角形的朝向
+                int balance = 0;
+                for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++)
+                {
+                    balance += orientation[adjacency.corners[i] / 3];
+                }
+                int8_t handedness = balance < 0 ? -1 : 1;
+
+                float sum[3] = {0.f, 0.f, 0.f};
+                for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++)
+                {
+                    uint32_t corner = adjacency.corners[i];
+                    uint32_t t = corner / 3;
+                    if (orientation[t] != handedness) continue;
+
+                    float tangent[3] = {faceTangents[t * 3], faceTangents[t * 3 + 1], faceTangents[t * 3 + 2]};
+                    Project(tangent, n);
+                    if (!Normalize(tangent)) continue;
+
+                    // 顶角投影到法线平面上的角度作为权重
+                    const float* a = At(positions, indicies[t * 3 + (corner + 1) % 3], stride);
+                    const float* b = At(positions, indicies[t * 3 + (corner + 2) % 3], stride);
+                    float e1[3] = {a[0] - p[0], a[1] - p[1], a[2] - p[2]};
+                    float e2[3] = {b[0] - p[0], b[1] - p[1], b[2] - p[2]};
+                    Project(e1, n);
+                    Project(e2, n);
+                    if (!Normalize(e1) || !Normalize(e2)) continue;
+                    float angle = std::acos(std::min(std::max(Dot(e1, e2), -1.f), 1.f));
+
+                    for (int k = 0; k < 3; k++) sum[k] += angle * tangent[k];
+                }
+
+                float* out = tangents + v * 4;
+                if (!Normalize(sum)) AnyPerpendicular(sum, n);
+                out[0] = sum[0];
+                out[1] = sum[1];
+                out[2] = sum[2];
+                out[3] = handedness;
+            }
+        });
+    }
+
+    uint32_t PackTangent(const float tangent[4])
+    {
+        return Quantize10(tangent[0]) | Quantize10(tangent[1]) << 10 | Quantize10(tangent[2]) << 20 |
+            (tangent[3] > 0.f ? 3u : 0u) << 30;
+    }
+
+    void UnpackTangent(uint32_t packed, float tangent[4])
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            tangent[k] = ((packed >> (10 * k)) & 1023u) / 1023.f * 2.f - 1.f;
+        }
+        tangent[3] = (packed >> 30) == 3u ? 1.f : -1.f;
+    }
+
+    void PackTangents(uint32_t* packed, const float* tangents, size_t count)
+    {
+        size_t i = 0;
+#if defined(MESHTANGENTS_SSE2)
+        // 4 个切线转置成 SoA，每个分量一次量化
+        const __m128 lower = _mm_set1_ps(-1.f), upper = _mm_set1_ps(1.f);
+        const __m128 scale = _mm_set1_ps(511.5f), bias = _mm_set1_ps(512.f);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(tangents + i * 4);
+            __m128 y = _mm_loadu_ps(tangents + i * 4 + 4);
+            __m128 z = _mm_loadu_ps(tangents + i * 4 + 8);
+            __m128 w = _mm_loadu_ps(tangents + i * 4 + 12);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128i result = _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(w, _mm_setzero_ps())), _mm_set1_epi32(static_cast<int>(3u << 30)));
+            __m128 axes[3] = {x, y, z};
+            for (int k = 0; k < 3; k++)
+            {
+                __m128 v = _mm_min_ps(_mm_max_ps(axes[k], lower), upper);
+                __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), bias));
+                // 移位数必须是常量
+                if (k == 1) q = _mm_slli_epi32(q, 10);
+                else if (k == 2) q = _mm_slli_epi32(q, 20);
+                result = _mm_or_si128(result, q);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), result);
+        }
+#elif defined(MESHTANGENTS_NEON)
+        const float32x4_t lower = vdupq_n_f32(-1.f), upper = vdupq_n_f32(1.f);
+        const float32x4_t scale = vdupq_n_f32(511.5f), bias = vdupq_n_f32(512.f);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4x4_t t = vld4q_f32(tangents + i * 4);
+            uint32x4_t result = vandq_u32(vcgtq_f32(t.val[3], vdupq_n_f32(0.f)), vdupq_n_u32(3u << 30));
+            uint32x4_t q0 = vcvtq_u32_f32(vmlaq_f32(bias, vminq_f32(vmaxq_f32(t.val[0], lower), upper), scale));
+            uint32x4_t q1 = vcvtq_u32_f32(vmlaq_f32(bias, vminq_f32(vmaxq_f32(t.val[1], lower), upper), scale));
+            uint32x4_t q2 = vcvtq_u32_f32(vmlaq_f32(bias, vminq_f32(vmaxq_f32(t.val[2], lower), upper), scale));
+            result = vorrq_u32(result, vorrq_u32(q0, vorrq_u32(vshlq_n_u32(q1, 10), vshlq_n_u32(q2, 20))));
+            vst1q_u32(packed + i, result);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            packed[i] = PackTangent(tangents + i * 4);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef __MESHTANGENTS_H__
+#define __MESHTANGENTS_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MeshNormals.h"
+
+// MikkTSpace style tangent frames: every triangle's UV derivative direction is projected onto the
+// vertex normal's plane and averaged with corner angle weights, the bitangent is
+// w * cross(normal, tangent) with w the sign of the triangle's UV area. Vertices are gathered in
+// parallel through the MeshNormals vertex -> corner adjacency, like the normals.
+namespace MeshTangents
+{
+    // A vertex shared by triangles of both UV orientations (a mirrored UV seam) can't have one
+    // handedness: the corners of the negatively oriented triangles are moved to a copy appended after
+    // vertexCount. indicies are rewritten in place, returns the source vertex of each copy in order.
+    // The adjacency describes the mesh before the split and has to be rebuilt afterwards.
+    std::vector<uint32_t> SplitMirrored(uint32_t* indicies, size_t indexCount, size_t vertexCount,
+        const float* uvs, size_t stride, const MeshNormals::Adjacency& adjacency);
+
+    // positions, normals (unit length) and uvs: floats every stride bytes.
+    // tangents: 4 floats per vertex, xyz unit length and perpendicular to the normal, w = +1 / -1
+    void ComputeTangents(float* tangents, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const uint32_t* indicies, size_t indexCount, const MeshNormals::Adjacency& adjacency);
+
+    // DXGI_FORMAT_R10G10B10A2_UNORM: xyz * 0.5 + 0.5 in 10 bits each, alpha 3 for w > 0 and 0 otherwise,
+    // so the shader decodes the tangent as rgb * 2 - 1 and the handedness as a * 2 - 1
+    uint32_t PackTangent(const float tangent[4]);
+    void UnpackTangent(uint32_t packed, float tangent[4]);
+    // SSE2 / NEON, same results as PackTangent
+    void PackTangents(uint32_t* packed, const float* tangents, size_t count);
+}
+#endif
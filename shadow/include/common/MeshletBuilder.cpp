@@ -0,0 +1,499 @@
+#include "MeshletBuilder.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    using MeshletBuilder::Meshlet;
+    using MeshletBuilder::MeshletBounds;
+    using MeshletBuilder::MeshletData;
+    using MeshletBuilder::S_MAX_VERTICES;
+    using MeshletBuilder::S_MAX_TRIANGLES;
+
+    // triangles per parallel task; fixed so that region borders, and with them the meshlets,
+    // are the same for any number of threads
+    constexpr size_t S_REGION_TRIANGLES = 16384;
+    constexpr uint8_t S_NOT_IN_MESHLET = 0xff;
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    inline Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    inline Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    inline Vec3 operator*(const Vec3& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+    inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline Vec3 Cross(const Vec3& a, const Vec3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+
+    inline Vec3 PositionAt(const float* positions, size_t positionStride, uint32_t v)
+    {
+        auto p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * positionStride);
+        return {p[0], p[1], p[2]};
+    }
+
+    // Ritter's sphere, seeded with the most distant pair of axis extremes
+    void ComputeSphere(const Vec3* points, size_t count, Vec3& center, float& radius)
+    {
+        center = {0.f, 0.f, 0.f};
+        radius = 0.f;
+        if (count == 0) return;
+
+        size_t minIndex[3] = {0, 0, 0};
+        size_t maxIndex[3] = {0, 0, 0};
+        for (size_t i = 1; i < count; i++)
+        {
+            const float* p = &points[i].x;
+            for (int k = 0; k < 3; k++)
+            {
+                if (p[k] < (&points[minIndex[k]].x)[k]) minIndex[k] = i;
+                if (p[k] > (&points[maxIndex[k]].x)[k]) maxIndex[k] = i;
+            }
+        }
+
+        int axis = 0;
+        float axisDistance = -1.f;
+        for (int k = 0; k < 3; k++)
+        {
+            Vec3 d = points[maxIndex[k]] - points[minIndex[k]];
+            if (Dot(d, d) > axisDistance)
+            {
+                axisDistance = Dot(d, d);
+                axis = k;
+            }
+        }
+
+        center = (points[minIndex[axis]] + points[maxIndex[axis]]) * 0.5f;
+        radius = std::sqrt(axisDistance) * 0.5f;
+        for (size_t i = 0; i < count; i++)
+        {
+            Vec3 d = points[i] - center;
+            float distanceSquared = Dot(d, d);
+            if (distanceSquared > radius * radius)
+            {
+                float distance = std::sqrt(distanceSquared);
+                float grownRadius = (radius + distance) * 0.5f;
+                center = center + d * ((grownRadius - radius) / distance);
+                radius = grownRadius;
+            }
+        }
+    }
+
+    MeshletBounds ComputeBounds(const uint32_t* meshletVertices, uint32_t vertexCount, const uint8_t* meshletTriangles, uint32_t triangleCount,
+        const float* positions, size_t positionStride)
+    {
+        Vec3 points[S_MAX_VERTICES];
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            points[i] = PositionAt(positions, positionStride, meshletVertices[i]);
+        }
+
+        MeshletBounds bounds = {};
+        Vec3 center;
+        ComputeSphere(points, vertexCount, center, bounds.radius);
+
+        Vec3 normals[S_MAX_TRIANGLES];
+        Vec3 corners[S_MAX_TRIANGLES];
+        uint32_t normalCount = 0;
+        Vec3 axis = {0.f, 0.f, 0.f};
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            const uint8_t* triangle = meshletTriangles + t * 3;
+            Vec3 n = Cross(points[triangle[1]] - points[triangle[0]], points[triangle[2]] - points[triangle[0]]);
+            float length = std::sqrt(Dot(n, n));
+            // zero area triangles can't be backfacing
+            if (length == 0.f) continue;
+            normals[normalCount] = n * (1.f / length);
+            corners[normalCount] = points[triangle[0]];
+            axis = axis + normals[normalCount];
+            normalCount++;
+        }
+
+        float axisLength = std::sqrt(Dot(axis, axis));
+        float minDot = 1.f;
+        if (axisLength > 0.f)
+        {
+            axis = axis * (1.f / axisLength);
+            for (uint32_t t = 0; t < normalCount; t++)
+            {
+                minDot = std::min(minDot, Dot(axis, normals[t]));
+            }
+        }
+        else
+        {
+            axis = {0.f, 0.f, 1.f};
+            minDot = -1.f;
+        }
+
+        bounds.center[0] = center.x;
+        bounds.center[1] = center.y;
+        bounds.center[2] = center.z;
+        bounds.coneAxis[0] = axis.x;
+        bounds.coneAxis[1] = axis.y;
+        bounds.coneAxis[2] = axis.z;
+
+        // close to a hemisphere of normals the apex moves off to infinity, treat the cone as unusable
+        if (minDot <= 0.1f)
+        {
+            bounds.coneCutoff = 1.f;
+            bounds.coneApex[0] = center.x;
+            bounds.coneApex[1] = center.y;
+            bounds.coneApex[2] = center.z;
+            return bounds;
+        }
+
+        // slide the apex back along the axis until it is behind every triangle plane
+        float maxT = 0.f;
+        for (uint32_t t = 0; t < normalCount; t++)
+        {
+            float distance = Dot(center - corners[t], normals[t]) / Dot(axis, normals[t]);
+            maxT = std::max(maxT, distance);
+        }
+        Vec3 apex = center - axis * maxT;
+        bounds.coneApex[0] = apex.x;
+        bounds.coneApex[1] = apex.y;
+        bounds.coneApex[2] = apex.z;
+        bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        return bounds;
+    }
+
+    // Meshlets of triangles [firstTriangle, firstTriangle + triangleCount), offsets relative to this region
+    void BuildRegion(const uint32_t* indicies, size_t firstTriangle, size_t triangleCount, const float* positions, size_t positionStride,
+        MeshletData& out)
+    {
+        // region local vertex ids
+        const uint32_t* regionIndicies = indicies + firstTriangle * 3;
+        size_t cornerCount = triangleCount * 3;
+        std::vector<uint32_t> regionVertices(regionIndicies, regionIndicies + cornerCount);
+        std::sort(regionVertices.begin(), regionVertices.end());
+        regionVertices.erase(std::unique(regionVertices.begin(), regionVertices.end()), regionVertices.end());
+        size_t localVertexCount = regionVertices.size();
+
+        std::vector<uint32_t> corners(cornerCount);
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            corners[i] = static_cast<uint32_t>(std::lower_bound(regionVertices.begin(), regionVertices.end(), regionIndicies[i]) - regionVertices.begin());
+        }
+
+        // distinct vertices per triangle, degenerate triangles may repeat one
+        std::vector<uint8_t> distinct(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const uint32_t* c = &corners[t * 3];
+            distinct[t] = static_cast<uint8_t>(1 + (c[1] != c[0]) + (c[2] != c[0] && c[2] != c[1]));
+        }
+        auto isFirstOccurrence = [&](size_t t, int k)
+        {
+            const uint32_t* c = &corners[t * 3];
+            return (k == 0) || (k == 1 && c[1] != c[0]) || (k == 2 && c[2] != c[0] && c[2] != c[1]);
+        };
+
+        // vertex -> triangles, ascending triangle order
+        std::vector<uint32_t> adjacencyOffsets(localVertexCount + 1, 0);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                if (isFirstOccurrence(t, k)) adjacencyOffsets[corners[t * 3 + k] + 1]++;
+            }
+        }
+        for (size_t v = 0; v < localVertexCount; v++)
+        {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        std::vector<uint32_t> adjacency(adjacencyOffsets[localVertexCount]);
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    if (isFirstOccurrence(t, k)) adjacency[fill[corners[t * 3 + k]]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        // missing[t]: vertices of t not yet in the current meshlet, live[v]: unused triangles around v.
+        // The next triangle is the candidate (unused, sharing a vertex with the meshlet) with the fewest
+        // missing vertices, then the fewest live neighbors, so the meshlet fills its concave corners
+        // instead of leaving small holes that end up as nearly empty meshlets.
+        std::vector<uint8_t> missing(distinct);
+        std::vector<uint8_t> used(triangleCount, 0);
+        std::vector<uint8_t> isCandidate(triangleCount, 0);
+        std::vector<uint32_t> live(localVertexCount);
+        for (size_t v = 0; v < localVertexCount; v++)
+        {
+            live[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+        }
+        std::vector<uint8_t> localIndex(localVertexCount, S_NOT_IN_MESHLET);
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> touched;
+
+        uint32_t meshletVertices[S_MAX_VERTICES];
+        uint32_t meshletVertexCount = 0;
+        uint32_t meshletTriangleCount = 0;
+        size_t triangleStart = 0;
+
+        auto liveScore = [&](uint32_t t)
+        {
+            const uint32_t* c = &corners[t * 3];
+            uint32_t score = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                if (isFirstOccurrence(t, k)) score += live[c[k]];
+            }
+            return score;
+        };
+
+        // best unused candidate, used ones are dropped on the way; -1 when there is none
+        auto nextCandidate = [&]() -> int64_t
+        {
+            int64_t best = -1;
+            uint32_t bestMissing = 0, bestScore = 0;
+            for (size_t i = 0; i < candidates.size();)
+            {
+                uint32_t t = candidates[i];
+                if (used[t])
+                {
+                    isCandidate[t] = 0;
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                uint32_t score = liveScore(t);
+                if (best < 0 || missing[t] < bestMissing || (missing[t] == bestMissing &&
+                    (score < bestScore || (score == bestScore && t < best))))
+                {
+                    best = t;
+                    bestMissing = missing[t];
+                    bestScore = score;
+                }
+                i++;
+            }
+            return best;
+        };
+
+        auto flush = [&]()
+        {
+            if (meshletTriangleCount == 0) return;
+
+            Meshlet meshlet;
+            meshlet.vertexOffset = static_cast<uint32_t>(out.vertices.size());
+            meshlet.triangleOffset = static_cast<uint32_t>(triangleStart);
+            meshlet.vertexCount = meshletVertexCount;
+            meshlet.triangleCount = meshletTriangleCount;
+            for (uint32_t i = 0; i < meshletVertexCount; i++)
+            {
+                out.vertices.push_back(regionVertices[meshletVertices[i]]);
+                localIndex[meshletVertices[i]] = S_NOT_IN_MESHLET;
+            }
+            out.meshlets.push_back(meshlet);
+            out.bounds.push_back(ComputeBounds(&out.vertices[meshlet.vertexOffset], meshlet.vertexCount,
+                &out.triangles[meshlet.triangleOffset], meshlet.triangleCount, positions, positionStride));
+
+            for (uint32_t t: touched)
+            {
+                missing[t] = distinct[t];
+            }
+            touched.clear();
+            meshletVertexCount = 0;
+            meshletTriangleCount = 0;
+            triangleStart = out.triangles.size();
+        };
+
+        // the candidates left over border the finished meshlet, the next one starts from the best of them
+        auto nextSeed = [&]() -> int64_t
+        {
+            int64_t seed = -1;
+            uint32_t bestScore = 0;
+            for (uint32_t t: candidates)
+            {
+                isCandidate[t] = 0;
+                if (used[t]) continue;
+                uint32_t score = liveScore(t);
+                if (seed < 0 || score < bestScore || (score == bestScore && t < seed))
+                {
+                    seed = t;
+                    bestScore = score;
+                }
+            }
+            candidates.clear();
+            return seed;
+        };
+
+        size_t firstUnused = 0;
+        size_t remaining = triangleCount;
+        while (remaining > 0)
+        {
+            int64_t candidate = nextCandidate();
+            if (candidate >= 0 && (meshletVertexCount + missing[candidate] > S_MAX_VERTICES || meshletTriangleCount == S_MAX_TRIANGLES))
+            {
+                flush();
+                candidate = nextSeed();
+            }
+            else if (candidate < 0)
+            {
+                flush();
+            }
+            if (candidate < 0)
+            {
+                // nothing connected left, start over from the first unused triangle in input order
+                while (used[firstUnused]) firstUnused++;
+                candidate = static_cast<int64_t>(firstUnused);
+            }
+
+            auto t = static_cast<uint32_t>(candidate);
+            used[t] = 1;
+            remaining--;
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t v = corners[t * 3 + k];
+                if (isFirstOccurrence(t, k)) live[v]--;
+                if (localIndex[v] == S_NOT_IN_MESHLET)
+                {
+                    localIndex[v] = static_cast<uint8_t>(meshletVertexCount);
+                    meshletVertices[meshletVertexCount++] = v;
+                    for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+                    {
+                        uint32_t neighbor = adjacency[i];
+                        if (used[neighbor]) continue;
+                        missing[neighbor]--;
+                        touched.push_back(neighbor);
+                        if (!isCandidate[neighbor])
+                        {
+                            isCandidate[neighbor] = 1;
+                            candidates.push_back(neighbor);
+                        }
+                    }
+                }
+                out.triangles.push_back(localIndex[v]);
+            }
+            meshletTriangleCount++;
+        }
+        flush();
+    }
+}
+
+namespace MeshletBuilder
+{
+    MeshletData Build(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+    {
+        size_t triangleCount = indexCount / 3;
+        size_t regionCount = (triangleCount + S_REGION_TRIANGLES - 1) / S_REGION_TRIANGLES;
+        std::vector<MeshletData> regions(regionCount);
+        Util::ParallelFor(regionCount, [&](size_t r)
+        {
+            size_t first = r * S_REGION_TRIANGLES;
+            size_t count = std::min(S_REGION_TRIANGLES, triangleCount - first);
+            // 越界的索引会让包围球读到数组外
+            for (size_t i = first * 3; i < (first + count) * 3; i++)
+            {
+                if (indicies[i] >= vertexCount) throw std::runtime_error("MeshletBuilder: index out of range");
+            }
+            BuildRegion(indicies, first, count, positions, positionStride, regions[r]);
+        });
+
+        // concatenate in region order
+        MeshletData result;
+        size_t meshletCount = 0, vertexTotal = 0, triangleTotal = 0;
+        for (auto& region: regions)
+        {
+            meshletCount += region.meshlets.size();
+            vertexTotal += region.vertices.size();
+            triangleTotal += region.triangles.size();
+        }
+        result.meshlets.reserve(meshletCount);
+        result.bounds.reserve(meshletCount);
+        result.vertices.reserve(vertexTotal);
+        result.triangles.reserve(triangleTotal);
+        for (auto& region: regions)
+        {
+            auto vertexBase = static_cast<uint32_t>(result.vertices.size());
+            auto triangleBase = static_cast<uint32_t>(result.triangles.size());
+            for (auto meshlet: region.meshlets)
+            {
+                meshlet.vertexOffset += vertexBase;
+                meshlet.triangleOffset += triangleBase;
+                result.meshlets.push_back(meshlet);
+            }
+            result.bounds.insert(result.bounds.end(), region.bounds.begin(), region.bounds.end());
+            result.vertices.insert(result.vertices.end(), region.vertices.begin(), region.vertices.end());
+            result.triangles.insert(result.triangles.end(), region.triangles.begin(), region.triangles.end());
+            region = MeshletData();
+        }
+        return result;
+    }
+
+    bool IsValid(const MeshletData& data, size_t vertexCount)
+    {
+        if (data.bounds.size() != data.meshlets.size()) return false;
+        for (auto& meshlet: data.meshlets)
+        {
+            // 64 位里相加，坏的偏移不会回绕
+            if (meshlet.vertexCount > S_MAX_VERTICES || meshlet.triangleCount > S_MAX_TRIANGLES ||
+                uint64_t(meshlet.vertexOffset) + meshlet.vertexCount > data.vertices.size() ||
+                uint64_t(meshlet.triangleOffset) + uint64_t(meshlet.triangleCount) * 3 > data.triangles.size())
+            {
+                return false;
+            }
+            auto triangles = data.triangles.begin() + meshlet.triangleOffset;
+            if (std::any_of(triangles, triangles + meshlet.triangleCount * 3,
+                [&](uint8_t index) { return index >= meshlet.vertexCount; }))
+            {
+                return false;
+            }
+        }
+        return std::all_of(data.vertices.begin(), data.vertices.end(), [&](uint32_t v) { return v < vertexCount; });
+    }
+
+    Stats Analyze(const MeshletData& data)
+    {
+        Stats stats;
+        stats.meshletCount = data.meshlets.size();
+        if (stats.meshletCount == 0) return stats;
+
+        const float d = 0.57735027f;
+        const Vec3 views[14] =
+        {
+            { 1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+            { d, d, d}, { d, d, -d}, { d, -d, d}, { d, -d, -d},
+            {-d, d, d}, {-d, d, -d}, {-d, -d, d}, {-d, -d, -d},
+        };
+        const double radiansToDegrees = 180. / 3.14159265358979323846;
+
+        size_t culled = 0;
+        for (size_t i = 0; i < stats.meshletCount; i++)
+        {
+            auto& meshlet = data.meshlets[i];
+            auto& bounds = data.bounds[i];
+            stats.triangleCount += meshlet.triangleCount;
+            stats.vertexFill += static_cast<double>(meshlet.vertexCount) / S_MAX_VERTICES;
+            stats.triangleFill += static_cast<double>(meshlet.triangleCount) / S_MAX_TRIANGLES;
+            stats.averageRadius += bounds.radius;
+
+            if (bounds.coneCutoff >= 1.f)
+            {
+                stats.coneHistogram[6]++;
+                continue;
+            }
+            // coneCutoff = sin(half angle), the angle stays below acos(0.1)
+            double halfAngle = std::asin(bounds.coneCutoff) * radiansToDegrees;
+            stats.coneHistogram[std::min(5, static_cast<int>(halfAngle / 15.))]++;
+
+            // orthographic camera looking along view: every apex to camera direction is view
+            Vec3 axis = {bounds.coneAxis[0], bounds.coneAxis[1], bounds.coneAxis[2]};
+            for (auto& view: views)
+            {
+                if (Dot(view, axis) >= bounds.coneCutoff) culled++;
+            }
+        }
+        stats.vertexFill /= stats.meshletCount;
+        stats.triangleFill /= stats.meshletCount;
+        stats.averageRadius /= stats.meshletCount;
+        stats.coneCulled = static_cast<double>(culled) / (stats.meshletCount * 14.);
+        return stats;
+    }
+}
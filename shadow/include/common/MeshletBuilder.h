@@ -0,0 +1,72 @@
+#ifndef __MESHLETBUILDER_H__
+#define __MESHLETBUILDER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Splits a triangle list into small clusters (meshlets) for cluster culling and mesh shaders.
+// Each meshlet lists the mesh vertices it uses and its triangles as local uint8 indices into that list.
+namespace MeshletBuilder
+{
+    constexpr uint32_t S_MAX_VERTICES = 64;
+    constexpr uint32_t S_MAX_TRIANGLES = 124;
+
+    struct Meshlet
+    {
+        uint32_t vertexOffset;      // into MeshletData::vertices
+        uint32_t triangleOffset;    // into MeshletData::triangles, 3 entries per triangle
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+    };
+
+    // The meshlet is entirely backfacing for a camera at position c when
+    //   dot(normalize(coneApex - c), coneAxis) >= coneCutoff
+    // or, without the apex, dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius.
+    // coneCutoff is 1 when the normals spread too far for the cone to ever cull.
+    struct MeshletBounds
+    {
+        float center[3];
+        float radius;
+        float coneApex[3];
+        float coneAxis[3];
+        float coneCutoff;           // sin of the widest angle between the axis and a triangle normal
+    };
+
+    struct MeshletData
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<MeshletBounds> bounds;  // one per meshlet
+        std::vector<uint32_t> vertices;
+        std::vector<uint8_t> triangles;
+    };
+
+    // Greedy clustering that grows each meshlet over shared vertices, so feed it a vertex cache
+    // optimized index buffer. The triangles are cut into fixed size regions built in parallel,
+    // the result does not depend on the thread count. positions: xyz floats every positionStride bytes.
+    // Throws std::runtime_error for indices >= vertexCount.
+    MeshletData Build(const uint32_t* indicies, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+    // Checks that every meshlet's ranges lie inside data.vertices / data.triangles, respect S_MAX_VERTICES /
+    // S_MAX_TRIANGLES, local indices stay below the meshlet's vertexCount and vertex ids below vertexCount.
+    // Meant for meshlets read back from a file.
+    bool IsValid(const MeshletData& data, size_t vertexCount);
+
+    struct Stats
+    {
+        size_t meshletCount = 0;
+        size_t triangleCount = 0;
+        double vertexFill = 0.;         // average vertexCount / S_MAX_VERTICES
+        double triangleFill = 0.;       // average triangleCount / S_MAX_TRIANGLES
+        double averageRadius = 0.;
+        // normal cone half angle in 15 degree buckets [0, 15) ... [75, 90), the last one counts
+        // meshlets without a usable cone
+        uint32_t coneHistogram[7] = {};
+        // fraction of meshlets the cone test rejects, averaged over 14 orthographic views
+        // (6 axes and 8 cube diagonals)
+        double coneCulled = 0.;
+    };
+
+    Stats Analyze(const MeshletData& data);
+}
+#endif
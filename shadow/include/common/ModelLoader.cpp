@@ -1,50 +1,114 @@
 #include "ModelLoader.h"
 #include "PlyHelper.h"
 #include "ObjHelper.h"
+#include "BinaryPly.h"
+#include "IndexTripleMap.h"
+#include "Arena.h"
 #include <cassert>
+#include <stdexcept>
+#include <type_traits>
 
-std::unique_ptr<ModelLoader> ModelLoader::CreateModelLoader(ModelType type)
+template<typename T>
+std::unique_ptr<ModelLoader<T>> ModelLoader<T>::CreateModelLoader(ModelType type)
 {
     // path.substr(path.size() - 4, 4) != ".obj"
     switch (type)
     {
     case ModelType::PLY:
-        return std::make_unique<PLYModelLoader>();
+        return std::make_unique<PLYModelLoader<T>>();
     case ModelType::OBJ:
-        return std::make_unique<OBJModelLoader>();
+        return std::make_unique<OBJModelLoader<T>>();
     default:
-        throw std::exception("Unimplemented type");
+        throw std::runtime_error("Unimplemented type");
     }
     return nullptr;
 }
 
-std::vector<std::array<double, 3>> ModelLoader::GetPositions()
+template<typename T>
+Util::Span<const typename ModelLoader<T>::Vec3> ModelLoader<T>::GetPositions() const
 {
     return m_positions;
 }
-std::vector<std::array<double, 3>> ModelLoader::GetNormals()
+template<typename T>
+Util::Span<const typename ModelLoader<T>::Vec3> ModelLoader<T>::GetNormals() const
 {
     return m_normals;
 }
-std::vector<std::array<double, 3>> ModelLoader::GetUVWs()
+template<typename T>
+Util::Span<const typename ModelLoader<T>::Vec3> ModelLoader<T>::GetUVWs() const
 {
     return m_uvws;
 }
-std::vector<uint32_t> ModelLoader::GetIndicies()
+template<typename T>
+Util::Span<const uint32_t> ModelLoader<T>::GetIndicies() const
 {
     return m_indicies;
 }
+template<typename T>
+const MeshBounds::Aabb<T>& ModelLoader<T>::GetBounds() const
+{
+    return m_bounds;
+}
+
+template<typename T>
+std::vector<typename ModelLoader<T>::Vec3> ModelLoader<T>::TakePositions()
+{
+    return std::move(m_positions);
+}
+template<typename T>
+std::vector<typename ModelLoader<T>::Vec3> ModelLoader<T>::TakeNormals()
+{
+    return std::move(m_normals);
+}
+template<typename T>
+std::vector<typename ModelLoader<T>::Vec3> ModelLoader<T>::TakeUVWs()
+{
+    return std::move(m_uvws);
+}
+template<typename T>
+std::vector<uint32_t> ModelLoader<T>::TakeIndicies()
+{
+    return std::move(m_indicies);
+}
 
-void ModelLoader::SetPositions(std::vector<std::array<double, 3>>& positions)
+template<typename T>
+void ModelLoader<T>::SetStreamSink(MeshStream::Sink<T>* sink)
 {
-    m_positions = positions;
+    m_sink = sink;
+}
+
+template<typename T>
+void ModelLoader<T>::StreamLoaded()
+{
+    if (m_sink == nullptr) return;
+
+    // 与 BinaryPly 相同的块大小，sink 一侧再按自己的块大小拼接
+    constexpr size_t POSITION_BLOCK = 1024;
+    constexpr size_t INDEX_BLOCK = 3 * 4096;
+    m_sink->OnBegin(m_positions.size(), m_indicies.size());
+    for (size_t first = 0; first < m_positions.size(); first += POSITION_BLOCK)
+    {
+        m_sink->OnPositions(&m_positions[first], std::min(POSITION_BLOCK, m_positions.size() - first));
+    }
+    for (size_t first = 0; first < m_indicies.size(); first += INDEX_BLOCK)
+    {
+        m_sink->OnIndicies(&m_indicies[first], std::min(INDEX_BLOCK, m_indicies.size() - first));
+    }
+}
+
+template<typename T>
+void ModelLoader<T>::SetPositions(std::vector<Vec3>&& positions)
+{
+    m_positions = std::move(positions);
+    m_bounds = MeshBounds::ComputeAabb(m_positions.empty() ? nullptr : m_positions[0].data(), m_positions.size(), sizeof(Vec3));
 }
 
 // cut a polygon to several triangles
 // Note that the face list generates triangles in the order of a TRIANGLE FAN, not a TRIANGLE STRIP. In the example above, the first face
 //   4 0 1 2 3
 // Is composed of the triangles 0,1,2 and 0,2,3 and not 0,1,2 and 1,2,3.
-static void CutPolygon(std::vector<uint32_t>& polygon, std::vector<std::array<uint32_t, 3>>& triangles)
+template<typename Polygon>
+static void CutPolygon(const Polygon& polygon, std::pmr::vector<std::array<uint32_t, 3>>& triangles)
 {
     uint32_t i0 = 0;
     // uint32_t i1 = 1;
@@ -57,13 +121,24 @@ static void CutPolygon(std::vector<uint32_t>& polygon, std::vector<std::array<ui
     return ;
 }
 
-void ModelLoader::SetIndicies(std::vector<std::vector<uint32_t>>& faces)
+// 每个面的三角形放在线程的 arena 里，整个调用结束时释放
+template<typename Faces>
+static std::vector<uint32_t> Triangulate(const Faces& faces)
 {
+    size_t numIndicies = 0;
+    for (auto& face: faces)
+    {
+        if (face.size() >= 3) numIndicies += (face.size() - 2) * 3;
+    }
+
+    Util::ArenaScope scope;
+    std::pmr::vector<std::array<uint32_t, 3>> triangles(&Util::ThreadArena());
     std::vector<uint32_t> indicies;
+    indicies.reserve(numIndicies);
     for(auto& face: faces)
     {
         assert(face.size() >= 3 && "model format error.");
-        std::vector<std::array<uint32_t, 3>> triangles;
+        triangles.clear();
         CutPolygon(face, triangles);
         for (auto& tri: triangles)
         {
@@ -72,105 +147,154 @@ void ModelLoader::SetIndicies(std::vector<std::vector<uint32_t>>& faces)
             indicies.push_back(tri[2]);
         }
     }
-    
-    m_indicies.swap(indicies);
+    return indicies;
+}
+
+template<typename T>
+void ModelLoader<T>::SetIndicies(const std::vector<std::vector<uint32_t>>& faces)
+{
+    m_indicies = Triangulate(faces);
+}
+
+template<typename T>
+void ModelLoader<T>::SetIndicies(const std::vector<std::pmr::vector<uint32_t>>& faces)
+{
+    m_indicies = Triangulate(faces);
 }
 
-void ModelLoader::Reconstruct()
+template<typename T>
+void ModelLoader<T>::Reconstruct()
 {
     if (!m_initialized || m_positions.size() == 0) return;
 
-    float maxX, minX, maxY, minY, maxZ, minZ;
-    maxX = minX = m_positions[0][0];
-    maxY = minY = m_positions[0][1];
-    maxZ = minZ = m_positions[0][2];
+    // 包围盒在加载时已经统计，这里只剩一遍 p * scale + offset
+    m_bounds = MeshBounds::NormalizeToUnitBox(m_positions[0].data(), m_positions.size(), sizeof(Vec3), m_bounds);
+}
 
-    for (int i = 1; i < m_positions.size(); ++i)
+#ifdef _MSC_VER
+#pragma region PLY
+#endif
+// happly always reads positions as double
+template<typename T>
+static std::vector<std::array<T, 3>> NarrowPositions(std::vector<std::array<double, 3>>&& positions)
+{
+    if constexpr (std::is_same_v<T, double>)
     {
-        if (m_positions[i][0] > maxX) maxX = m_positions[i][0];
-        if (m_positions[i][0] < minX) minX = m_positions[i][0];
-        if (m_positions[i][1] > maxY) maxY = m_positions[i][1];
-        if (m_positions[i][1] < minY) minY = m_positions[i][1];
-        if (m_positions[i][2] > maxZ) maxZ = m_positions[i][2];
-        if (m_positions[i][2] < minZ) minZ = m_positions[i][2];
+        return std::move(positions);
     }
-
-    float offsetX = (maxX + minX) / 2.;
-    float offsetY = (maxY + minY) / 2.;
-    float offsetZ = (maxZ + minZ) / 2.;
-
-    float rangeX = maxX - minX;
-    float rangeY = maxY - minY;
-    float rangeZ = maxZ - minZ;
-    float range = std::max(rangeX, std::max(rangeY, rangeZ)) / 2.;
-
-    for (int i = 0; i < m_positions.size(); ++i)
+    else
     {
-        m_positions[i][0] = (m_positions[i][0] - offsetX) / range;
-        m_positions[i][1] = (m_positions[i][1] - offsetY) / range;
-        m_positions[i][2] = (m_positions[i][2] - offsetZ) / range;
+        std::vector<std::array<T, 3>> result(positions.size());
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            result[i] = {static_cast<T>(positions[i][0]), static_cast<T>(positions[i][1]), static_cast<T>(positions[i][2])};
+        }
+        return result;
     }
 }
 
-#pragma region PLY
-void PLYModelLoader::LoadFromFile(std::wstring& filePath)
+template<typename T>
+void PLYModelLoader<T>::LoadFromFile(std::wstring& filePath)
 {
-    happly::PLYData plyIn(Util::ToByteString(filePath));
-    SetPositions(plyIn.getVertexPositions());
-    SetIndicies(plyIn.getFaceIndices<uint32_t>());
-    m_uvws = std::vector<std::array<double, 3>>(m_positions.size());
+    auto path = Util::ToByteString(filePath);
+    if (!BinaryPly::Load(path, m_positions, m_indicies, &m_bounds, m_sink))
+    {
+        happly::PLYData plyIn(path);
+        SetPositions(NarrowPositions<T>(plyIn.getVertexPositions()));
+        SetIndicies(plyIn.getFaceIndices<uint32_t>());
+        StreamLoaded();
+    }
+    m_uvws = std::vector<Vec3>(m_positions.size());
     m_initialized = true;
+    if (m_sink != nullptr) m_sink->OnEnd();
 }
+#ifdef _MSC_VER
 #pragma endregion
+#endif
 
+#ifdef _MSC_VER
 #pragma region OBJ
-void OBJModelLoader::LoadFromFile(std::wstring& filePath)
+#endif
+template<typename T>
+void OBJModelLoader<T>::LoadFromFile(std::wstring& filePath)
 {
-    ObjHelper::ObjLoader objIn(Util::ToByteString(filePath));
-    auto positions = objIn.GetverticesPosition();
-    auto normals = objIn.GetVerticesNormal();
-    auto uvws = objIn.GetVerticesUVW();
-    auto faces = objIn.GetFaces();
+    ObjHelper::ObjLoader<T> objIn(Util::ToByteString(filePath));
+    auto faces = objIn.TakeFaces();
 
-    if (normals.size() == 0)
+    if (objIn.GetVerticesNormal().size() == 0)
     {
-        SetPositions(positions);
-        std::vector<std::vector<uint32_t>> facePositionIndex(faces.size());
-        for (int i = 0; i < faces.size(); i++)
+        m_bounds = objIn.GetPositionBounds();
+        m_positions = objIn.TakePositions();
+        m_uvws = std::vector<Vec3>(m_positions.size());
+        // 移动构造，索引数组留在 objIn 的 arena 中
+        std::vector<std::pmr::vector<uint32_t>> facePositionIndex;
+        facePositionIndex.reserve(faces.size());
+        for (size_t i = 0; i < faces.size(); i++)
         {
-            facePositionIndex[i] = faces[i].positionIndex;
+            facePositionIndex.push_back(std::move(faces[i].positionIndex));
         }
+        faces.clear();
+        faces.shrink_to_fit();
         SetIndicies(facePositionIndex);
     }
     // 模型中同一个点在不同面上的法线可能不同,
-    // 将顶点复制多份，保证一个顶点一个法线
+    // 按 (position, uv, normal) 索引三元组合并顶点，相同的三元组共享一个顶点
     else 
     {
-        std::vector<std::array<double, 3>> tempPos;
-        std::vector<std::array<double, 3>> tempNorms;
-        std::vector<std::array<double, 3>> tempUvws;
-        std::vector<std::vector<uint32_t>> tempFaceIndex;
+        auto& positions = objIn.GetverticesPosition();
+        auto& normals = objIn.GetVerticesNormal();
+        auto& uvws = objIn.GetVerticesUVW();
+
+        // 通常每个 v 至少对应一个顶点
+        Util::IndexTripleMap welded(positions.size());
+        const uint32_t none = 0xffffffffu;
+        // 只统计被面引用的位置
+        MeshBounds::Aabb<T> bounds;
+
+        std::vector<Vec3> tempPos;
+        std::vector<Vec3> tempNorms;
+        std::vector<Vec3> tempUvws;
+        std::vector<std::pmr::vector<uint32_t>> tempFaceIndex;
+        tempFaceIndex.reserve(faces.size());
+        tempPos.reserve(positions.size());
+        tempNorms.reserve(positions.size());
+        tempUvws.reserve(positions.size());
 
-        for (int i = 0; i < faces.size(); i++)
+        for (size_t i = 0; i < faces.size(); i++)
         {
-            tempFaceIndex.push_back(std::vector<uint32_t>(faces[i].positionIndex.size()));
-            for (int j = 0; j < faces[i].positionIndex.size(); j++)
+            for (size_t j = 0; j < faces[i].positionIndex.size(); j++)
             {
-                tempPos.push_back(positions[faces[i].positionIndex[j]]);
-                tempNorms.push_back(j < faces[i].normalIndex.size() ? 
-                    normals[faces[i].normalIndex[j]] : std::array<double, 3>{0., 0., 0.});
-                tempUvws.push_back(j < faces[i].uvwIndex.size() ? 
-                    uvws[faces[i].uvwIndex[j]] : std::array<double, 3>{0., 0., 0.});
+                uint32_t positionIndex = faces[i].positionIndex[j];
+                uint32_t uvwIndex = j < faces[i].uvwIndex.size() ? faces[i].uvwIndex[j] : none;
+                uint32_t normalIndex = j < faces[i].normalIndex.size() ? faces[i].normalIndex[j] : none;
 
-                tempFaceIndex[i][j] = tempPos.size() - 1;
+                auto next = static_cast<uint32_t>(tempPos.size());
+                uint32_t vertex = welded.FindOrInsert(positionIndex, uvwIndex, normalIndex, next);
+                if (vertex == next)
+                {
+                    tempPos.push_back(positions[positionIndex]);
+                    bounds.Extend(positions[positionIndex].data());
+                    tempNorms.push_back(normalIndex != none ? normals[normalIndex] : Vec3{0, 0, 0});
+                    tempUvws.push_back(uvwIndex != none ? uvws[uvwIndex] : Vec3{0, 0, 0});
+                }
+
+                // 原位置索引已经用过，直接改写成合并后顶点的索引
+                faces[i].positionIndex[j] = vertex;
             }
+            tempFaceIndex.push_back(std::move(faces[i].positionIndex));
         }
+        faces.clear();
+        faces.shrink_to_fit();
 
         m_positions.swap(tempPos);
         m_normals.swap(tempNorms);
         m_uvws.swap(tempUvws);
+        m_bounds = bounds;
         SetIndicies(tempFaceIndex);
     }
+    // 并行解析的块要等全部完成后才有全局索引，焊接也需要全部的面，所以解析完成后再整体输出
+    StreamLoaded();
+    if (m_sink != nullptr) m_sink->OnEnd();
     // SetPositions(objIn.GetverticesPosition());
     // auto normals = objIn.GetVerticesNormal();
     // if (normals.size() == 0)
@@ -231,4 +355,13 @@ void OBJModelLoader::LoadFromFile(std::wstring& filePath)
 //         }
 //     }
 // }
+#ifdef _MSC_VER
 #pragma endregion
+#endif
+
+template class ModelLoader<float>;
+template class ModelLoader<double>;
+template class PLYModelLoader<float>;
+template class PLYModelLoader<double>;
+template class OBJModelLoader<float>;
+template class OBJModelLoader<double>;
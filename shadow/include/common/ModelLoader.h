@@ -4,7 +4,11 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <memory_resource>
 #include <array>
+#include "Span.h"
+#include "MeshBounds.h"
+#include "MeshStream.h"
 
 enum class ModelType: uint32_t
 {
@@ -12,46 +16,99 @@ enum class ModelType: uint32_t
     OBJ
 };
 
+// T: storage precision of positions / normals / uvws. float is what Model consumes,
+// double is kept for callers that need the full precision of the source file.
+// Instantiated for float and double in ModelLoader.cpp.
+template<typename T = float>
 class ModelLoader
 {
+public:
+    using Scalar = T;
+    using Vec3 = std::array<T, 3>;
+
 protected:
-    std::vector<std::array<double, 3>> m_positions;
-    std::vector<std::array<double, 3>> m_normals;
-    std::vector<std::array<double, 3>> m_uvws;
+    std::vector<Vec3> m_positions;
+    std::vector<Vec3> m_normals;
+    std::vector<Vec3> m_uvws;
     std::vector<uint32_t> m_indicies;
+    // m_positions 的包围盒，由各 loader 在解析时统计
+    MeshBounds::Aabb<T> m_bounds;
+    MeshStream::Sink<T>* m_sink = nullptr;
     bool m_initialized = false;
 
     ModelLoader() = default;
 
 protected:
-    virtual void SetPositions(std::vector<std::array<double, 3>>& positions);
-    virtual void SetIndicies(std::vector<std::vector<uint32_t>>& faces);
+    // 同时重新统计包围盒
+    virtual void SetPositions(std::vector<Vec3>&& positions);
+    virtual void SetIndicies(const std::vector<std::vector<uint32_t>>& faces);
+    // 面的索引数组分配在 arena 中时（OBJ），不复制
+    void SetIndicies(const std::vector<std::pmr::vector<uint32_t>>& faces);
+    // 不能边解析边输出的路径在加载完成后把整个网格按块交给 sink
+    void StreamLoaded();
 
 public:
-    ~ModelLoader() = default;
+    virtual ~ModelLoader() = default;
     static std::unique_ptr<ModelLoader> CreateModelLoader(ModelType);
     
-    // 将模型移动放缩到 [-1,1]^3 的空间内
+    // 将模型移动放缩到 [-1,1]^3 的空间内，使用加载时统计的包围盒，只遍历一遍顶点
     void Reconstruct();
     virtual void LoadFromFile(std::wstring& filePath) = 0;
+    // 之后的 LoadFromFile 在解析的同时把网格交给 sink（源文件坐标，不受 Reconstruct 影响），nullptr 关闭。
+    // sink 在解析线程上被调用
+    void SetStreamSink(MeshStream::Sink<T>* sink);
 
-    std::vector<std::array<double, 3>> GetPositions();
+    // 只读视图，在对应的 Take*() 调用或 loader 析构后失效
+    Util::Span<const Vec3> GetPositions() const;
     // 未归一化的顶点法线
-    std::vector<std::array<double, 3>> GetNormals();
-    std::vector<std::array<double, 3>> GetUVWs();
-    std::vector<uint32_t> GetIndicies();
+    Util::Span<const Vec3> GetNormals() const;
+    Util::Span<const Vec3> GetUVWs() const;
+    Util::Span<const uint32_t> GetIndicies() const;
+    // GetPositions() 中所有位置的包围盒，Reconstruct 后为变换后的包围盒，TakePositions() 后仍然有效。
+    // PLY 和不带法线的 OBJ 包括没有被面引用的点；带法线的 OBJ 焊接后只剩被引用的位置，包围盒也只包括它们
+    const MeshBounds::Aabb<T>& GetBounds() const;
+
+    // 移出数据而不复制，之后 loader 中对应的数组为空
+    std::vector<Vec3> TakePositions();
+    std::vector<Vec3> TakeNormals();
+    std::vector<Vec3> TakeUVWs();
+    std::vector<uint32_t> TakeIndicies();
 };
 
-class PLYModelLoader : public ModelLoader
+template<typename T = float>
+class PLYModelLoader : public ModelLoader<T>
 {
+    using typename ModelLoader<T>::Vec3;
+    using ModelLoader<T>::m_positions;
+    using ModelLoader<T>::m_uvws;
+    using ModelLoader<T>::m_indicies;
+    using ModelLoader<T>::m_bounds;
+    using ModelLoader<T>::m_sink;
+    using ModelLoader<T>::m_initialized;
+    using ModelLoader<T>::SetPositions;
+    using ModelLoader<T>::SetIndicies;
+    using ModelLoader<T>::StreamLoaded;
+
 public:
     PLYModelLoader() = default;
     ~PLYModelLoader() = default;
     void LoadFromFile(std::wstring& filePath) override;
 };
 
-class OBJModelLoader : public ModelLoader
+template<typename T = float>
+class OBJModelLoader : public ModelLoader<T>
 {
+    using typename ModelLoader<T>::Vec3;
+    using ModelLoader<T>::m_positions;
+    using ModelLoader<T>::m_normals;
+    using ModelLoader<T>::m_uvws;
+    using ModelLoader<T>::m_bounds;
+    using ModelLoader<T>::m_sink;
+    using ModelLoader<T>::m_initialized;
+    using ModelLoader<T>::SetPositions;
+    using ModelLoader<T>::SetIndicies;
+    using ModelLoader<T>::StreamLoaded;
+
     // void SetIndiciesAndNormals(std::vector<std::vector<uint32_t>>& facesVertex,
     //      std::vector<std::vector<uint32_t>>& facesNormal,
     //      std::vector<std::array<double, 3>>& normals); // vertex/texture/normal
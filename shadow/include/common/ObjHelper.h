@@ -2,9 +2,19 @@
 #define __OBJHELPER_H__
 
 #include <fstream>
+#include <algorithm>
 #include <array>
 #include <vector>
+#include <memory>
+#include <memory_resource>
+#include <cstdlib>
+#include <stdexcept>
 #include "Utility.h"
+#include "Arena.h"
+#include "TextParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "MeshBounds.h"
 
 namespace ObjHelper
 {
@@ -13,20 +23,39 @@ namespace ObjHelper
     using std::vector;
     using std::string;
 
+    enum class ParseMode
+    {
+        Stream,   // std::getline + Split + strtod, the tokens of a line on the thread arena
+        Mapped,   // memory-mapped, tokenized in place
+        Parallel  // Mapped, split into per-core chunks
+    };
+
+    // T: storage precision of v/vn/vt, values are parsed as double and narrowed once
+    template<typename T = float>
     class ObjLoader
     {
     public:
+        using Vec3 = array<T, 3>;
+
+        // 索引数组分配在 loader 的 arena 中，只在 loader 存在期间有效（TakeFaces 之后也一样）
         struct Face
         {
-            vector<uint32_t> positionIndex;
-            vector<uint32_t> normalIndex;
-            vector<uint32_t> uvwIndex;
+            std::pmr::vector<uint32_t> positionIndex;
+            std::pmr::vector<uint32_t> normalIndex;
+            std::pmr::vector<uint32_t> uvwIndex;
+
+            Face() = default;
+            explicit Face(std::pmr::memory_resource* arena) : positionIndex(arena), normalIndex(arena), uvwIndex(arena) {}
         };
 
     private:
-        vector<array<double, 3>> m_positions;
-        vector<array<double, 3>> m_normals;
-        vector<array<double, 3>> m_uvws;
+        // 每个解析线程（块）一个，面的索引数组不经过全局堆。放在最前面，最后析构
+        vector<std::unique_ptr<Util::Arena>> m_arenas;
+        vector<Vec3> m_positions;
+        vector<Vec3> m_normals;
+        vector<Vec3> m_uvws;
+        // 解析 v 的同时统计，省去之后单独扫一遍
+        MeshBounds::Aabb<T> m_positionBounds;
 
         // vector<vector<uint32_t>> m_facesVertexIndex;
         // vector<vector<uint32_t>> m_facesVertexNormal;
@@ -39,66 +68,102 @@ namespace ObjHelper
             m_normals.clear();
             m_uvws.clear();
             m_faces.clear();
+            m_arenas.clear();
+            m_positionBounds = MeshBounds::Aabb<T>();
+        }
+
+        Util::Arena* NewArena()
+        {
+            m_arenas.push_back(std::make_unique<Util::Arena>());
+            return m_arenas.back().get();
         }
     public:
 
         ObjLoader() = delete;
         ~ObjLoader() = default;
-        ObjLoader(string& filePath)
+        ObjLoader(const string& filePath, ParseMode mode = ParseMode::Parallel)
         {
-            LoadFromFile(filePath);
+            LoadFromFile(filePath, mode);
         }
 
-        void LoadFromFile(string& filePath)
+        void LoadFromFile(const string& filePath, ParseMode mode = ParseMode::Parallel)
         {
             Clear();
+            if (mode == ParseMode::Mapped)
+            {
+                LoadFromMappedFile(filePath, 1);
+            }
+            else if (mode == ParseMode::Parallel)
+            {
+                LoadFromMappedFile(filePath, Util::WorkerCount());
+            }
+            else
+            {
+                LoadFromStream(filePath);
+            }
+        }
+
+    private:
+        void LoadFromStream(const string& filePath)
+        {
             ifstream in;
             in.open(filePath, ifstream::in);
             if (in.fail())
             {
-                throw std::exception("obj file cannot be opened.");
+                throw std::runtime_error("obj file cannot be opened.");
             }
 
+            Util::Arena* arena = NewArena();
+            // 每行的切分结果放在线程的 arena 里，每行结束时释放
+            using Tokens = std::pmr::vector<std::pmr::string>;
+            auto removeEmpty = [](Tokens& tokens)
+            {
+                tokens.erase(std::remove_if(tokens.begin(), tokens.end(), [](auto& token) { return token.empty(); }), tokens.end());
+            };
+
             string line;
             bool fail = false;
             while (!in.eof())
             {
                 std::getline(in, line);
-                vector<string> substr;
+                Util::ArenaScope scope;
+                Tokens substr(&Util::ThreadArena());
                 Util::Split(line, substr, ' ');
                 if (substr.size() == 0) continue;
+                // 多出来的分量（w、顶点颜色等）忽略，和 ParseChunk 一致
                 if (substr[0].compare("v") == 0)
                 {
-                    substr = Util::Filter(substr, "");
-                    if (substr.size() != 4)
+                    removeEmpty(substr);
+                    if (substr.size() < 4)
                     {
                         fail = true;
                         break;
                     }
 
-                    m_positions.emplace_back(array<double, 3>{std::stod(substr[1]), std::stod(substr[2]), std::stod(substr[3])});
+                    m_positions.emplace_back(Vec3{ToScalar(substr[1]), ToScalar(substr[2]), ToScalar(substr[3])});
+                    m_positionBounds.Extend(m_positions.back().data());
                 }
                 else if (substr[0].compare("vn") == 0)
                 {
-                    substr = Util::Filter(substr, "");
-                    if (substr.size() != 4)
+                    removeEmpty(substr);
+                    if (substr.size() < 4)
                     {
                         fail = true;
                         break;
                     }
 
-                    m_normals.emplace_back(array<double, 3>{std::stod(substr[1]), std::stod(substr[2]), std::stod(substr[3])});
+                    m_normals.emplace_back(Vec3{ToScalar(substr[1]), ToScalar(substr[2]), ToScalar(substr[3])});
                 }
                 else if (substr[0].compare("vt") == 0)
                 {
-                    substr = Util::Filter(substr, "");
+                    removeEmpty(substr);
                     if (substr.size() == 3)
                     {
-                        m_uvws.emplace_back(array<double, 3>{std::stod(substr[1]), std::stod(substr[2]), 0.});
+                        m_uvws.emplace_back(Vec3{ToScalar(substr[1]), ToScalar(substr[2]), T(0)});
                     }
-                    else if (substr.size() == 4)
+                    else if (substr.size() >= 4)
                     {
-                        m_uvws.emplace_back(array<double, 3>{std::stod(substr[1]), std::stod(substr[2]), std::stod(substr[3])});
+                        m_uvws.emplace_back(Vec3{ToScalar(substr[1]), ToScalar(substr[2]), ToScalar(substr[3])});
                     }
                     else
                     {
@@ -114,31 +179,29 @@ namespace ObjHelper
                         break;
                     }
 
-                    vector<uint32_t> faceVertexIndex;
-                    vector<uint32_t> faceVertexNormal;
-                    vector<uint32_t> faceVertexUVW;
-                    for (int i = 1; i < substr.size(); i++)
+                    Face face(arena);
+                    for (size_t i = 1; i < substr.size(); i++)
                     {
-                        vector<string> vertexInfo;
+                        Tokens vertexInfo(&Util::ThreadArena());
                         Util::Split(substr[i], vertexInfo, '/');
                         if (vertexInfo.size() == 1)
                         {
-                            auto x = std::stoi(vertexInfo[0]);
-                            faceVertexIndex.emplace_back(x - 1);
+                            auto x = ToIndex(vertexInfo[0]);
+                            face.positionIndex.emplace_back(x - 1);
                         }
                         else if (vertexInfo.size() == 2)
                         {
-                            faceVertexIndex.emplace_back(std::stoi(vertexInfo[0]) - 1);
-                            faceVertexUVW.emplace_back(std::stoi(vertexInfo[1]) - 1);
+                            face.positionIndex.emplace_back(ToIndex(vertexInfo[0]) - 1);
+                            face.uvwIndex.emplace_back(ToIndex(vertexInfo[1]) - 1);
                         }
                         else if (vertexInfo.size() == 3)
                         {
-                            faceVertexIndex.emplace_back(std::stoi(vertexInfo[0]) - 1);
+                            face.positionIndex.emplace_back(ToIndex(vertexInfo[0]) - 1);
                             if (vertexInfo[1].size() > 0)
                             {
-                                faceVertexUVW.emplace_back(std::stoi(vertexInfo[1]) - 1);
+                                face.uvwIndex.emplace_back(ToIndex(vertexInfo[1]) - 1);
                             }
-                            faceVertexNormal.emplace_back(std::stoi(vertexInfo[2]) - 1);
+                            face.normalIndex.emplace_back(ToIndex(vertexInfo[2]) - 1);
                         }
                         else
                         {
@@ -148,32 +211,302 @@ namespace ObjHelper
                     }
 
                     if (fail) break;
-                    m_faces.emplace_back(Face{faceVertexIndex, faceVertexNormal, faceVertexUVW});
+                    m_faces.emplace_back(std::move(face));
                 }
             }
 
             if (fail)
             {
-                throw std::exception("obj format error.");
+                throw std::runtime_error("obj format error.");
+            }
+        }
+
+        // std::stod / std::stoi on the arena strings, without converting them to std::string first
+        static T ToScalar(const std::pmr::string& str)
+        {
+            char* end;
+            double value = std::strtod(str.c_str(), &end);
+            if (end == str.c_str()) throw std::runtime_error("obj format error.");
+            return static_cast<T>(value);
+        }
+
+        static int ToIndex(const std::pmr::string& str)
+        {
+            char* end;
+            long value = std::strtol(str.c_str(), &end, 10);
+            if (end == str.c_str()) throw std::runtime_error("obj format error.");
+            return static_cast<int>(value);
+        }
+
+        // parse "x y z ..." into out, returns the number of values read
+        template<size_t N>
+        static size_t ParseValues(const char*& p, const char* end, array<T, N>& out)
+        {
+            size_t n = 0;
+            for (; n < N; n++)
+            {
+                Util::SkipBlanks(p, end);
+                double value;
+                if (!Util::ParseDouble(p, end, value)) break;
+                out[n] = static_cast<T>(value);
+            }
+            return n;
+        }
+
+        // 一段按行切分的文件内容的解析结果
+        struct Chunk
+        {
+            Util::Arena* arena = nullptr;
+            vector<Vec3> positions;
+            vector<Vec3> normals;
+            vector<Vec3> uvws;
+            vector<Face> faces;
+            MeshBounds::Aabb<T> positionBounds;
+
+            // Negative (relative) indices are resolved against the chunk-local counts,
+            // the listed slots need the v/vt/vn counts of all previous chunks added.
+            struct Fixup
+            {
+                uint32_t face;
+                uint32_t slot;
+                std::pmr::vector<uint32_t> Face::* indices;
+            };
+            vector<Fixup> fixups;
+        };
+
+        // OBJ 索引从 1 开始，负数表示相对于当前已读入数量的位置
+        static bool ParseIndex(const char*& p, const char* end, size_t count, uint32_t& out, bool& relative)
+        {
+            int64_t index;
+            if (!Util::ParseInt(p, end, index) || index == 0) return false;
+            relative = index < 0;
+            out = static_cast<uint32_t>(index > 0 ? index - 1 : static_cast<int64_t>(count) + index);
+            return true;
+        }
+
+        static bool ParseFaceIndex(const char*& p, const char* end, size_t count,
+            Chunk& chunk, Face& face, std::pmr::vector<uint32_t> Face::* indices)
+        {
+            uint32_t index;
+            bool relative;
+            if (!ParseIndex(p, end, count, index, relative)) return false;
+            if (relative)
+            {
+                auto slot = static_cast<uint32_t>((face.*indices).size());
+                chunk.fixups.push_back(typename Chunk::Fixup{static_cast<uint32_t>(chunk.faces.size()), slot, indices});
+            }
+            // arena 中扩容时旧的数组不会释放，按常见的三角形 / 四边形一次预留
+            if ((face.*indices).empty()) (face.*indices).reserve(4);
+            (face.*indices).push_back(index);
+            return true;
+        }
+
+        // "v/vt/vn", "v//vn", "v/vt" or "v"
+        static bool ParseFaceVertex(const char*& p, const char* end, Chunk& chunk, Face& face)
+        {
+            if (!ParseFaceIndex(p, end, chunk.positions.size(), chunk, face, &Face::positionIndex)) return false;
+            if (p == end || *p != '/') return true;
+
+            ++p;
+            if (p < end && *p != '/')
+            {
+                if (!ParseFaceIndex(p, end, chunk.uvws.size(), chunk, face, &Face::uvwIndex)) return false;
+            }
+            if (p == end || *p != '/') return true;
+
+            ++p;
+            return ParseFaceIndex(p, end, chunk.normals.size(), chunk, face, &Face::normalIndex);
+        }
+
+        // Same output as LoadFromStream, but without per-line allocations.
+        // Extra components on "v" / "vn" / "vt" lines (e.g. vertex colors) are ignored in both.
+        // [p, end) must start at the beginning of a line.
+        static bool ParseChunk(const char* p, const char* end, Chunk& chunk)
+        {
+            while (p < end)
+            {
+                Util::SkipBlanks(p, end);
+                const char* keyEnd = Util::TokenEnd(p, end);
+                size_t keyLength = keyEnd - p;
+                if (keyLength == 1 && p[0] == 'v')
+                {
+                    p = keyEnd;
+                    Vec3 value;
+                    if (ParseValues(p, end, value) != 3) return false;
+                    chunk.positions.emplace_back(value);
+                    chunk.positionBounds.Extend(value.data());
+                }
+                else if (keyLength == 2 && p[0] == 'v' && p[1] == 'n')
+                {
+                    p = keyEnd;
+                    Vec3 value;
+                    if (ParseValues(p, end, value) != 3) return false;
+                    chunk.normals.emplace_back(value);
+                }
+                else if (keyLength == 2 && p[0] == 'v' && p[1] == 't')
+                {
+                    p = keyEnd;
+                    Vec3 value = {0, 0, 0};
+                    if (ParseValues(p, end, value) < 2) return false;
+                    chunk.uvws.emplace_back(value);
+                }
+                else if (keyLength == 1 && p[0] == 'f')
+                {
+                    p = keyEnd;
+                    Face face(chunk.arena);
+                    while (true)
+                    {
+                        Util::SkipBlanks(p, end);
+                        if (p == end || *p == '\n') break;
+                        if (!ParseFaceVertex(p, end, chunk, face)) return false;
+                    }
+                    if (face.positionIndex.size() < 2) return false;
+                    chunk.faces.emplace_back(std::move(face));
+                }
+                // comments, groups, materials, ...
+                Util::SkipLine(p, end);
             }
+            return true;
         }
-    
-        auto GetverticesPosition() const
+
+        // 小于该大小的文件不值得多线程解析
+        static constexpr size_t S_MIN_CHUNK_SIZE = 1 << 20;
+
+        // Splits the mapped file at line boundaries into one chunk per worker and parses them
+        // concurrently. Face indices are global, so a prefix sum over the per-chunk v/vt/vn
+        // counts is used afterwards to place every chunk and fix up its relative indices.
+        void LoadFromMappedFile(const string& filePath, uint32_t maxChunks)
+        {
+            Util::MappedFile file(filePath);
+            if (!file.IsOpen())
+            {
+                throw std::runtime_error("obj file cannot be opened.");
+            }
+
+            const char* data = file.Data();
+            const size_t size = file.Size();
+            size_t chunkCount = std::max<size_t>(1, std::min<size_t>(maxChunks, size / S_MIN_CHUNK_SIZE));
+
+            vector<const char*> bounds{data};
+            for (size_t i = 1; i < chunkCount; i++)
+            {
+                const char* p = std::max(data + size * i / chunkCount, bounds.back());
+                Util::SkipLine(p, data + size);
+                if (p < data + size && p > bounds.back()) bounds.push_back(p);
+            }
+            bounds.push_back(data + size);
+            chunkCount = bounds.size() - 1;
+
+            if (chunkCount == 1)
+            {
+                Chunk chunk;
+                chunk.arena = NewArena();
+                if (!ParseChunk(data, data + size, chunk))
+                {
+                    throw std::runtime_error("obj format error.");
+                }
+                m_positions.swap(chunk.positions);
+                m_normals.swap(chunk.normals);
+                m_uvws.swap(chunk.uvws);
+                m_faces.swap(chunk.faces);
+                m_positionBounds = chunk.positionBounds;
+                return;
+            }
+
+            vector<Chunk> chunks(chunkCount);
+            for (auto& chunk: chunks) chunk.arena = NewArena();
+            vector<char> succeeded(chunkCount, 0);
+            Util::ParallelFor(chunkCount, [&](size_t i)
+            {
+                succeeded[i] = ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+            });
+            for (auto ok: succeeded)
+            {
+                if (!ok) throw std::runtime_error("obj format error.");
+            }
+            for (auto& chunk: chunks)
+            {
+                m_positionBounds.Merge(chunk.positionBounds);
+            }
+
+            // exclusive prefix sum of the per-chunk counts
+            struct Offsets { size_t positions, normals, uvws, faces; };
+            vector<Offsets> offsets(chunkCount + 1, Offsets{0, 0, 0, 0});
+            for (size_t i = 0; i < chunkCount; i++)
+            {
+                offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+                offsets[i + 1].normals   = offsets[i].normals   + chunks[i].normals.size();
+                offsets[i + 1].uvws      = offsets[i].uvws      + chunks[i].uvws.size();
+                offsets[i + 1].faces     = offsets[i].faces     + chunks[i].faces.size();
+            }
+            m_positions.resize(offsets[chunkCount].positions);
+            m_normals.resize(offsets[chunkCount].normals);
+            m_uvws.resize(offsets[chunkCount].uvws);
+
+            Util::ParallelFor(chunkCount, [&](size_t i)
+            {
+                auto& chunk = chunks[i];
+                auto& offset = offsets[i];
+                for (auto& fixup: chunk.fixups)
+                {
+                    auto& indices = chunk.faces[fixup.face].*fixup.indices;
+                    size_t base = fixup.indices == &Face::positionIndex ? offset.positions :
+                        fixup.indices == &Face::normalIndex ? offset.normals : offset.uvws;
+                    indices[fixup.slot] += static_cast<uint32_t>(base);
+                }
+
+                std::copy(chunk.positions.begin(), chunk.positions.end(), m_positions.begin() + offset.positions);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), m_normals.begin() + offset.normals);
+                std::copy(chunk.uvws.begin(), chunk.uvws.end(), m_uvws.begin() + offset.uvws);
+            });
+            // 移动构造保留各自的 arena，移动赋值到默认构造的 Face 会复制到全局堆
+            m_faces.reserve(offsets[chunkCount].faces);
+            for (auto& chunk: chunks)
+            {
+                std::move(chunk.faces.begin(), chunk.faces.end(), std::back_inserter(m_faces));
+            }
+        }
+
+    public:
+        const vector<Vec3>& GetverticesPosition() const
         {
             return m_positions;
         }
-        auto GetVerticesNormal() const
+        const vector<Vec3>& GetVerticesNormal() const
         {
             return m_normals;
         }
-        auto GetVerticesUVW() const
+        const vector<Vec3>& GetVerticesUVW() const
         {
             return m_uvws;
         }
-        auto GetFaces() const
+        const vector<Face>& GetFaces() const
         {
             return m_faces;
         }
+        // 所有 v 的包围盒，包括没有被面引用的点
+        const MeshBounds::Aabb<T>& GetPositionBounds() const
+        {
+            return m_positionBounds;
+        }
+
+        // 移出解析结果，之后 loader 中对应的数组为空
+        vector<Vec3> TakePositions()
+        {
+            return std::move(m_positions);
+        }
+        vector<Vec3> TakeNormals()
+        {
+            return std::move(m_normals);
+        }
+        vector<Vec3> TakeUVWs()
+        {
+            return std::move(m_uvws);
+        }
+        vector<Face> TakeFaces()
+        {
+            return std::move(m_faces);
+        }
     };
 
 }
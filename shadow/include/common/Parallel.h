@@ -0,0 +1,103 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util
+{
+    inline uint32_t WorkerCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // true while the thread runs a ParallelFor task: a nested ParallelFor runs inline instead of
+    // starting another WorkerCount() threads from every task
+    inline bool& SerialParallelFor()
+    {
+        thread_local bool serial = false;
+        return serial;
+    }
+
+    // set by TaskPool on its workers: tasks of the pool running or queued. ParallelFor runs inline while
+    // there is more than one, the pool keeps every core busy then; a task running alone keeps the threads
+    inline const std::atomic<size_t>*& PoolTaskCount()
+    {
+        thread_local const std::atomic<size_t>* count = nullptr;
+        return count;
+    }
+
+    // run func(i) for every i in [0, taskCount), tasks are handed out to up to WorkerCount() threads
+    // started for this call, the calling thread takes tasks too. Nested calls from a task run inline.
+    // The first exception thrown by a task is rethrown on the calling thread.
+    template<typename Func>
+    void ParallelFor(size_t taskCount, Func&& func)
+    {
+        if (taskCount == 0) return;
+
+        bool serial = SerialParallelFor() || (PoolTaskCount() != nullptr && *PoolTaskCount() > 1);
+        size_t threadCount = serial ? 1 : std::min<size_t>(taskCount, WorkerCount());
+        if (threadCount == 1)
+        {
+            for (size_t i = 0; i < taskCount; i++) func(i);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto worker = [&]()
+        {
+            bool& nested = SerialParallelFor();
+            bool previous = nested;
+            nested = true;
+            for (size_t i = next++; i < taskCount; i = next++)
+            {
+                try
+                {
+                    func(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+            nested = previous;
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; i++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread: threads)
+        {
+            thread.join();
+        }
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    // split [0, count) into ranges of at least minGrain elements, one task per range
+    template<typename Func>
+    void ParallelForRange(size_t count, size_t minGrain, Func&& func)
+    {
+        if (count == 0) return;
+        size_t taskCount = std::max<size_t>(1, std::min<size_t>(WorkerCount() * 4, count / std::max<size_t>(1, minGrain)));
+        ParallelFor(taskCount, [&](size_t task)
+        {
+            size_t begin = count * task / taskCount;
+            size_t end = count * (task + 1) / taskCount;
+            func(begin, end);
+        });
+    }
+}
+#endif
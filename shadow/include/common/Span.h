@@ -0,0 +1,41 @@
+#ifndef __SPAN_H__
+#define __SPAN_H__
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+namespace Util
+{
+    // non-owning view of a contiguous array (std::span is C++20)
+    template<typename T>
+    class Span
+    {
+        T* m_data = nullptr;
+        size_t m_size = 0;
+
+    public:
+        Span() = default;
+        Span(T* data, size_t size) : m_data(data), m_size(size) {}
+
+        template<typename U, typename Alloc,
+            typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+        Span(std::vector<U, Alloc>& v) : m_data(v.data()), m_size(v.size()) {}
+
+        template<typename U, typename Alloc,
+            typename = std::enable_if_t<std::is_convertible_v<const U(*)[], T(*)[]>>>
+        Span(const std::vector<U, Alloc>& v) : m_data(v.data()), m_size(v.size()) {}
+
+        T* data() const { return m_data; }
+        size_t size() const { return m_size; }
+        size_t size_bytes() const { return m_size * sizeof(T); }
+        bool empty() const { return m_size == 0; }
+
+        T* begin() const { return m_data; }
+        T* end() const { return m_data + m_size; }
+        T& operator[](size_t i) const { return m_data[i]; }
+
+        Span subspan(size_t offset, size_t count) const { return Span(m_data + offset, count); }
+    };
+}
+#endif
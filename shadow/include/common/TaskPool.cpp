@@ -0,0 +1,137 @@
+#include "TaskPool.h"
+
+namespace
+{
+    thread_local const Util::TaskPool* t_pool = nullptr;
+    thread_local int32_t t_worker = -1;
+}
+
+namespace Util
+{
+    TaskPool::TaskPool(uint32_t threadCount)
+    {
+        threadCount = std::max(1u, threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        m_threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            m_threads.emplace_back([this, i]() { Run(i); });
+        }
+    }
+
+    TaskPool::~TaskPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [&]() { return m_pendingCount == 0; });
+            m_quit = true;
+        }
+        m_queued.notify_all();
+        for (auto& thread: m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    int32_t TaskPool::CurrentWorker()
+    {
+        return t_worker;
+    }
+
+    void TaskPool::Submit(std::function<void()> task)
+    {
+        // 先入队再计数：m_queuedCount 不超过队列里的任务数，worker 按计数领取后一定取得到
+        uint32_t index = t_pool == this ? static_cast<uint32_t>(t_worker) : m_nextQueue++ % GetThreadCount();
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queuedCount++;
+            m_pendingCount++;
+        }
+        m_queued.notify_one();
+    }
+
+    void TaskPool::Wait()
+    {
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [&]() { return m_pendingCount == 0; });
+            error = m_error;
+            m_error = nullptr;
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    // 自己的队列从尾部取，其它队列从头部偷
+    bool TaskPool::TryTake(uint32_t index, std::function<void()>& task)
+    {
+        {
+            auto& own = *m_queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (uint32_t i = 1; i < GetThreadCount(); i++)
+        {
+            auto& victim = *m_queues[(index + i) % GetThreadCount()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TaskPool::Run(uint32_t index)
+    {
+        t_pool = this;
+        t_worker = static_cast<int32_t>(index);
+        // 同时还有别的任务在运行或排队时 ParallelFor 串行执行，单独运行的任务（例如只加载一个大文件）仍然用所有核
+        PoolTaskCount() = &m_pendingCount;
+
+        while (true)
+        {
+            // 在锁内领取一个任务
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_queued.wait(lock, [&]() { return m_quit || m_queuedCount > 0; });
+                if (m_quit) return;
+                m_queuedCount--;
+            }
+
+            // 领取的任务一定在某个队列里，只是可能被别的 worker 先取走了另一个队列里的，重新扫描即可
+            std::function<void()> task;
+            while (!TryTake(index, task)) {}
+
+            std::exception_ptr error;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error) m_error = error;
+            if (--m_pendingCount == 0) m_idle.notify_all();
+        }
+    }
+}
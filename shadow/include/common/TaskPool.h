@@ -0,0 +1,65 @@
+#ifndef __TASKPOOL_H__
+#define __TASKPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Parallel.h"
+
+namespace Util
+{
+    // Work stealing thread pool: every worker owns a deque, runs its own tasks newest first (a task
+    // submitted from a worker usually works on data that is still in its cache) and steals the oldest
+    // task of another worker when it runs dry. Tasks submitted from outside are dealt round robin.
+    // Util::ParallelFor called from a task runs inline while other tasks are running or queued, the pool
+    // already keeps every core busy then; a task running alone keeps the parallel loops.
+    class TaskPool
+    {
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::condition_variable m_idle;
+        size_t m_queuedCount = 0;       // submitted, not yet taken by a worker
+        std::atomic<size_t> m_pendingCount{0};  // submitted, not yet finished, changed under m_mutex
+        bool m_quit = false;
+        std::atomic<uint32_t> m_nextQueue{0};
+        std::atomic<uint64_t> m_steals{0};
+        std::exception_ptr m_error;
+
+        void Run(uint32_t index);
+        bool TryTake(uint32_t index, std::function<void()>& task);
+
+    public:
+        explicit TaskPool(uint32_t threadCount = WorkerCount());
+        // waits for the submitted tasks
+        ~TaskPool();
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator=(const TaskPool&) = delete;
+
+        // any thread, including the pool's workers
+        void Submit(std::function<void()> task);
+        // blocks until every submitted task finished, rethrows the first exception a task threw
+        void Wait();
+
+        uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+        // tasks run by another worker than the one whose deque they were in
+        uint64_t GetStealCount() const { return m_steals; }
+        // index of the calling worker, -1 outside the pool
+        static int32_t CurrentWorker();
+    };
+}
+#endif
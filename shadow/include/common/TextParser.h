@@ -0,0 +1,153 @@
+#ifndef __TEXTPARSER_H__
+#define __TEXTPARSER_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// 在内存中原地解析文本，不产生临时 string
+namespace Util
+{
+    inline bool IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    inline void SkipBlanks(const char*& p, const char* end)
+    {
+        while (p < end && IsBlank(*p)) ++p;
+    }
+
+    // move to the first char of the next line
+    inline void SkipLine(const char*& p, const char* end)
+    {
+        auto next = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        p = next ? next + 1 : end;
+    }
+
+    // [p, return) is a token, stops at blanks or '\n'
+    inline const char* TokenEnd(const char* p, const char* end)
+    {
+        while (p < end && !IsBlank(*p) && *p != '\n') ++p;
+        return p;
+    }
+
+    inline bool ParseInt(const char*& p, const char* end, int64_t& out)
+    {
+        const char* s = p;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
+        {
+            negative = *s == '-';
+            ++s;
+        }
+        if (s == end || !IsDigit(*s)) return false;
+
+        int64_t value = 0;
+        while (s < end && IsDigit(*s))
+        {
+            value = value * 10 + (*s - '0');
+            ++s;
+        }
+        out = negative ? -value : value;
+        p = s;
+        return true;
+    }
+
+    // Locale-free decimal parser.
+    // Values whose mantissa fits in 53 bits and whose decimal exponent is within +-22 are
+    // converted exactly (one correctly rounded multiply or divide), so the result matches strtod.
+    // Anything else (long mantissas, huge exponents, inf/nan) falls back to strtod on a copy of the token.
+    inline bool ParseDouble(const char*& p, const char* end, double& out)
+    {
+        static const double s_pow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        const char* s = p;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
+        {
+            negative = *s == '-';
+            ++s;
+        }
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+        while (s < end && IsDigit(*s))
+        {
+            if (mantissa != 0 || *s != '0') digits++;
+            mantissa = mantissa * 10 + (*s - '0');
+            anyDigit = true;
+            ++s;
+        }
+        if (s < end && *s == '.')
+        {
+            ++s;
+            while (s < end && IsDigit(*s))
+            {
+                if (mantissa != 0 || *s != '0') digits++;
+                mantissa = mantissa * 10 + (*s - '0');
+                exponent--;
+                anyDigit = true;
+                ++s;
+            }
+        }
+
+        bool fastPath = anyDigit && digits <= 19;
+        if (anyDigit && s < end && (*s == 'e' || *s == 'E'))
+        {
+            const char* e = s + 1;
+            int64_t exp10 = 0;
+            if (ParseInt(e, end, exp10))
+            {
+                if (exp10 > 10000 || exp10 < -10000) fastPath = false;
+                else exponent += static_cast<int>(exp10);
+                s = e;
+            }
+        }
+
+        if (fastPath && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / s_pow10[-exponent] : value * s_pow10[exponent];
+            out = negative ? -value : value;
+            p = s;
+            return true;
+        }
+
+        // slow path
+        const char* tokenEnd = TokenEnd(p, end);
+        char local[64];
+        std::string heap;
+        const char* buffer = local;
+        size_t length = tokenEnd - p;
+        if (length < sizeof(local))
+        {
+            std::memcpy(local, p, length);
+            local[length] = '\0';
+        }
+        else
+        {
+            heap.assign(p, length);
+            buffer = heap.c_str();
+        }
+
+        char* parsedEnd = nullptr;
+        double value = std::strtod(buffer, &parsedEnd);
+        if (parsedEnd == buffer) return false;
+        out = value;
+        p += parsedEnd - buffer;
+        return true;
+    }
+}
+#endif
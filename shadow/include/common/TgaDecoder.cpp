@@ -0,0 +1,262 @@
+#include "TgaDecoder.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TGADECODER_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TGADECODER_NEON
+#endif
+
+namespace
+{
+    constexpr size_t S_HEADER_SIZE = 18;
+    // 图像类型：2 未压缩真彩色，10 RLE 真彩色
+    constexpr uint8_t S_TYPE_TRUE_COLOR = 2;
+    constexpr uint8_t S_TYPE_RLE_TRUE_COLOR = 10;
+    // descriptor 第 4 位从右到左，第 5 位从上到下
+    constexpr uint8_t S_RIGHT_TO_LEFT = 0x10;
+    constexpr uint8_t S_TOP_DOWN = 0x20;
+    // 未压缩时每个任务至少转换的行数
+    constexpr size_t S_ROW_GRAIN = 64;
+
+    inline uint16_t ReadU16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | p[1] << 8);
+    }
+
+    // 像素数据的开始位置，放不下头时返回 0
+    size_t DataOffset(const uint8_t* data, size_t size)
+    {
+        if (size < S_HEADER_SIZE) return 0;
+        size_t offset = S_HEADER_SIZE + data[0];
+        // 真彩色图像也可以带调色板，跳过
+        if (data[1] != 0) offset += ReadU16(data + 5) * ((data[7] + 7) / 8);
+        return offset <= size ? offset : 0;
+    }
+
+    inline void ConvertPixel(const uint8_t* source, uint8_t* out, size_t bytesPerPixel)
+    {
+        out[0] = source[2];
+        out[1] = source[1];
+        out[2] = source[0];
+        out[3] = bytesPerPixel == 4 ? source[3] : 0xff;
+    }
+
+#if defined(TGADECODER_SSE2)
+    // BGRA -> RGBA：每个像素交换第 0 和第 2 个字节
+    inline __m128i SwapRedBlue(__m128i bgra)
+    {
+        __m128i rb = _mm_and_si128(bgra, _mm_set1_epi32(0x00ff00ff));
+        __m128i ga = _mm_andnot_si128(_mm_set1_epi32(0x00ff00ff), bgra);
+        return _mm_or_si128(ga, _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+    }
+
+    void ConvertBgra(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i bgra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), SwapRedBlue(bgra));
+        }
+        for (; i < count; i++) ConvertPixel(source + i * 4, out + i * 4, 4);
+    }
+
+    void ConvertBgr(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        // SSE2 没有字节重排：一次读 16 个字节，移位把第 1、2、3 个像素移到最低的 4 个字节再拼起来。
+        // 读 16 个字节需要后面还有至少 6 个像素
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+        size_t i = 0;
+        for (; i + 6 <= count; i += 4)
+        {
+            __m128i bgr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+            __m128i p01 = _mm_unpacklo_epi32(bgr, _mm_srli_si128(bgr, 3));
+            __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(bgr, 6), _mm_srli_si128(bgr, 9));
+            __m128i bgrx = _mm_unpacklo_epi64(p01, p23);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_or_si128(SwapRedBlue(bgrx), alpha));
+        }
+        for (; i < count; i++) ConvertPixel(source + i * 3, out + i * 4, 3);
+    }
+
+    void FillPixels(uint8_t* out, const uint8_t rgba[4], size_t count)
+    {
+        uint32_t pixel;
+        std::memcpy(&pixel, rgba, 4);
+        __m128i value = _mm_set1_epi32(static_cast<int>(pixel));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), value);
+        }
+        for (; i < count; i++) std::memcpy(out + i * 4, rgba, 4);
+    }
+#elif defined(TGADECODER_NEON)
+    void ConvertBgra(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16x4_t bgra = vld4q_u8(source + i * 4);
+            uint8x16x4_t rgba = {{bgra.val[2], bgra.val[1], bgra.val[0], bgra.val[3]}};
+            vst4q_u8(out + i * 4, rgba);
+        }
+        for (; i < count; i++) ConvertPixel(source + i * 4, out + i * 4, 4);
+    }
+
+    void ConvertBgr(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16x3_t bgr = vld3q_u8(source + i * 3);
+            uint8x16x4_t rgba = {{bgr.val[2], bgr.val[1], bgr.val[0], vdupq_n_u8(0xff)}};
+            vst4q_u8(out + i * 4, rgba);
+        }
+        for (; i < count; i++) ConvertPixel(source + i * 3, out + i * 4, 3);
+    }
+
+    void FillPixels(uint8_t* out, const uint8_t rgba[4], size_t count)
+    {
+        uint32_t pixel;
+        std::memcpy(&pixel, rgba, 4);
+        uint8x16_t value = vreinterpretq_u8_u32(vdupq_n_u32(pixel));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            vst1q_u8(out + i * 4, value);
+        }
+        for (; i < count; i++) std::memcpy(out + i * 4, rgba, 4);
+    }
+#else
+    void ConvertBgra(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) ConvertPixel(source + i * 4, out + i * 4, 4);
+    }
+
+    void ConvertBgr(const uint8_t* source, uint8_t* out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) ConvertPixel(source + i * 3, out + i * 4, 3);
+    }
+
+    void FillPixels(uint8_t* out, const uint8_t rgba[4], size_t count)
+    {
+        for (size_t i = 0; i < count; i++) std::memcpy(out + i * 4, rgba, 4);
+    }
+#endif
+
+    inline void ConvertPixels(const uint8_t* source, uint8_t* out, size_t count, size_t bytesPerPixel)
+    {
+        if (bytesPerPixel == 4) ConvertBgra(source, out, count);
+        else ConvertBgr(source, out, count);
+    }
+
+    // 文件中第 row 行（按存储顺序）在输出中的位置
+    inline uint8_t* OutputRow(uint8_t* destination, size_t rowPitch, const TgaDecoder::Info& info, size_t row)
+    {
+        size_t y = info.topDown ? row : info.height - 1 - row;
+        return destination + y * rowPitch;
+    }
+
+    bool DecodeRle(const uint8_t* input, const uint8_t* end, const TgaDecoder::Info& info, uint8_t* destination, size_t rowPitch)
+    {
+        size_t bytesPerPixel = info.bitsPerPixel / 8;
+        size_t row = 0;
+        size_t x = 0;
+        uint8_t* out = OutputRow(destination, rowPitch, info, 0);
+        while (row < info.height)
+        {
+            if (input == end) return false;
+            uint8_t packet = *input++;
+            size_t count = (packet & 0x7f) + 1;
+            bool run = (packet & 0x80) != 0;
+            uint8_t rgba[4];
+            if (run)
+            {
+                if (static_cast<size_t>(end - input) < bytesPerPixel) return false;
+                ConvertPixel(input, rgba, bytesPerPixel);
+                input += bytesPerPixel;
+            }
+            else if (static_cast<size_t>(end - input) < count * bytesPerPixel)
+            {
+                return false;
+            }
+
+            // 包可以跨行，写到行尾时换到下一行
+            while (count > 0)
+            {
+                if (row == info.height) return false;
+                size_t n = std::min(count, info.width - x);
+                if (run)
+                {
+                    FillPixels(out + x * 4, rgba, n);
+                }
+                else
+                {
+                    ConvertPixels(input, out + x * 4, n, bytesPerPixel);
+                    input += n * bytesPerPixel;
+                }
+                count -= n;
+                x += n;
+                if (x == info.width)
+                {
+                    x = 0;
+                    if (++row < info.height) out = OutputRow(destination, rowPitch, info, row);
+                }
+            }
+        }
+        return true;
+    }
+}
+
+namespace TgaDecoder
+{
+    bool ReadInfo(const uint8_t* data, size_t size, Info& info)
+    {
+        if (DataOffset(data, size) == 0) return false;
+
+        uint8_t colorMapType = data[1];
+        uint8_t imageType = data[2];
+        uint8_t bitsPerPixel = data[16];
+        uint8_t descriptor = data[17];
+        if (colorMapType > 1) return false;
+        if (imageType != S_TYPE_TRUE_COLOR && imageType != S_TYPE_RLE_TRUE_COLOR) return false;
+        if (bitsPerPixel != 24 && bitsPerPixel != 32) return false;
+        if (descriptor & S_RIGHT_TO_LEFT) return false;
+
+        info.width = ReadU16(data + 12);
+        info.height = ReadU16(data + 14);
+        info.bitsPerPixel = bitsPerPixel;
+        info.rle = imageType == S_TYPE_RLE_TRUE_COLOR;
+        info.topDown = (descriptor & S_TOP_DOWN) != 0;
+        return info.width > 0 && info.height > 0;
+    }
+
+    bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch)
+    {
+        Info info;
+        if (!ReadInfo(data, size, info) || rowPitch < info.width * size_t(4)) return false;
+
+        const uint8_t* input = data + DataOffset(data, size);
+        const uint8_t* end = data + size;
+        if (info.rle) return DecodeRle(input, end, info, destination, rowPitch);
+
+        // 未压缩的行互相独立，大图按行并行转换。文件末尾可能还有扩展区和文件尾，不检查
+        size_t bytesPerPixel = info.bitsPerPixel / 8;
+        size_t sourcePitch = info.width * bytesPerPixel;
+        if (static_cast<size_t>(end - input) / sourcePitch < info.height) return false;
+        Util::ParallelForRange(info.height, S_ROW_GRAIN, [&](size_t begin, size_t last)
+        {
+            for (size_t row = begin; row < last; row++)
+            {
+                ConvertPixels(input + row * sourcePitch, OutputRow(destination, rowPitch, info, row), info.width, bytesPerPixel);
+            }
+        });
+        return true;
+    }
+}
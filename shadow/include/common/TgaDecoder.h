@@ -0,0 +1,30 @@
+#ifndef __TGADECODER_H__
+#define __TGADECODER_H__
+
+#include <cstdint>
+#include <cstddef>
+
+// Truevision TGA reader for textures, without WIC. Covers the true-color images that texture tools
+// write: uncompressed and RLE, 24 and 32 bpp, bottom-up or top-down. Pixels are swizzled from BGR(A)
+// straight into RGBA8 rows (DXGI_FORMAT_R8G8B8A8_UNORM) 16 bytes at a time with SSE2 / NEON.
+namespace TgaDecoder
+{
+    struct Info
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t bitsPerPixel = 0;      // 24 or 32
+        bool rle = false;
+        bool topDown = false;
+    };
+
+    // false for files this decoder does not handle (color mapped, grayscale, 15 / 16 bpp,
+    // right-to-left) or a header that does not fit in size
+    bool ReadInfo(const uint8_t* data, size_t size, Info& info);
+
+    // writes height rows of width * 4 bytes, top row first, rowPitch bytes apart, e.g. straight into a
+    // mapped upload buffer with the footprint's RowPitch. 24 bpp gets alpha 255.
+    // Returns false for unsupported or truncated data
+    bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch);
+}
+#endif
@@ -0,0 +1,240 @@
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace UploadRing
+{
+    Ring::Ring(Device& device, uint32_t slotCount, size_t slotSize)
+        : m_device(device)
+        , m_slotCount(slotCount)
+        , m_slotSize(slotSize)
+        , m_slotFence(slotCount, 0)
+    {
+        if (slotCount < 3 || slotSize == 0) throw std::runtime_error("upload ring needs at least 3 slots.");
+        for (auto& visible: m_visible) visible = 0;
+        m_device.CreateStaging(slotCount, slotSize);
+    }
+
+    // 按轮转顺序取下一个空闲的 slot，最旧的拷贝还没完成时等待 GPU
+    void Ring::Acquire(Target target)
+    {
+        uint32_t slot = m_nextSlot;
+        while (static_cast<int32_t>(slot) == m_open[0].slot || static_cast<int32_t>(slot) == m_open[1].slot)
+        {
+            slot = (slot + 1) % m_slotCount;
+        }
+        m_nextSlot = (slot + 1) % m_slotCount;
+
+        uint64_t fence = m_slotFence[slot];
+        if (fence != 0 && !m_device.IsFenceComplete(fence))
+        {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            m_device.WaitForFence(fence);
+            m_stats.stalls++;
+            m_stats.stallSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        }
+
+        auto& open = m_open[static_cast<uint32_t>(target)];
+        open.slot = static_cast<int32_t>(slot);
+        open.used = 0;
+        open.data = m_device.GetStaging(slot);
+    }
+
+    void Ring::Submit(Target target)
+    {
+        auto t = static_cast<uint32_t>(target);
+        auto& open = m_open[t];
+        if (open.slot < 0) return;
+
+        // 索引引用的顶点必须先可见，拷贝按提交顺序完成
+        if (target == Target::Index) Submit(Target::Vertex);
+
+        if (open.used > 0)
+        {
+            uint64_t end = m_submitted[t] + open.used;
+            if (end > m_reserved[t]) Reserve(target, std::max(end, m_reserved[t] * 2));
+
+            uint64_t fence = m_device.Copy(static_cast<uint32_t>(open.slot), target, m_submitted[t], open.used);
+            m_slotFence[open.slot] = fence;
+            m_lastFence = fence;
+            m_submitted[t] = end;
+            m_stats.chunks++;
+            m_stats.bytes[t] += open.used;
+            {
+                std::lock_guard<std::mutex> lock(m_pendingMutex);
+                m_pending.push_back(Pending{fence, target, end});
+            }
+
+            uint32_t inFlight = 0;
+            for (auto slotFence: m_slotFence)
+            {
+                if (slotFence != 0 && !m_device.IsFenceComplete(slotFence)) inFlight++;
+            }
+            m_stats.peakSlotsInFlight = std::max(m_stats.peakSlotsInFlight, inFlight);
+        }
+        open = Open();
+    }
+
+    void Ring::Append(Target target, const void* data, size_t size)
+    {
+        auto t = static_cast<uint32_t>(target);
+        auto bytes = static_cast<const uint8_t*>(data);
+        m_appended[t] += size;
+        while (size > 0)
+        {
+            auto& open = m_open[t];
+            if (open.slot < 0) Acquire(target);
+
+            size_t count = std::min(size, m_slotSize - open.used);
+            std::memcpy(open.data + open.used, bytes, count);
+            open.used += count;
+            bytes += count;
+            size -= count;
+            if (open.used == m_slotSize) Submit(target);
+        }
+    }
+
+    void Ring::Reserve(Target target, uint64_t bytes)
+    {
+        auto t = static_cast<uint32_t>(target);
+        if (bytes <= m_reserved[t]) return;
+        m_device.Reserve(target, bytes);
+        m_reserved[t] = bytes;
+    }
+
+    void Ring::Flush()
+    {
+        Submit(Target::Vertex);
+        Submit(Target::Index);
+    }
+
+    void Ring::Finish()
+    {
+        Flush();
+        if (m_lastFence != 0) m_device.WaitForFence(m_lastFence);
+        GetVisibleBytes(Target::Vertex);
+    }
+
+    uint64_t Ring::GetVisibleBytes(Target target)
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        while (!m_pending.empty() && m_device.IsFenceComplete(m_pending.front().fence))
+        {
+            auto& pending = m_pending.front();
+            m_visible[static_cast<uint32_t>(pending.target)] = pending.end;
+            m_pending.pop_front();
+        }
+        return m_visible[static_cast<uint32_t>(target)];
+    }
+
+    MemoryDevice::MemoryDevice(std::chrono::microseconds copyLatency)
+        : m_latency(copyLatency)
+    {
+        m_worker = std::thread([this]() { Run(); });
+    }
+
+    MemoryDevice::~MemoryDevice()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_queued.notify_all();
+        m_worker.join();
+    }
+
+    void MemoryDevice::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_queued.wait(lock, [&]() { return m_quit || !m_queue.empty(); });
+            if (m_queue.empty()) return;
+
+            auto copy = m_queue.front();
+            lock.unlock();
+            if (m_latency.count() > 0) std::this_thread::sleep_for(m_latency);
+            lock.lock();
+
+            auto& buffer = m_buffers[static_cast<uint32_t>(copy.target)];
+            std::memcpy(buffer.data() + copy.offset, m_staging.data() + copy.slot * m_slotSize, copy.size);
+            m_queue.pop_front();
+            m_completedFence = copy.fence;
+            m_completed.notify_all();
+        }
+    }
+
+    void MemoryDevice::CreateStaging(uint32_t slotCount, size_t slotSize)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_staging.assign(slotCount * slotSize, 0);
+        m_slotSize = slotSize;
+        m_slotQueued.assign(slotCount, 0);
+    }
+
+    uint8_t* MemoryDevice::GetStaging(uint32_t slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_slotQueued[slot] > m_completedFence) m_stagingHazards++;
+        return m_staging.data() + slot * m_slotSize;
+    }
+
+    void MemoryDevice::Reserve(Target target, uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& buffer = m_buffers[static_cast<uint32_t>(target)];
+        if (buffer.size() < bytes) buffer.resize(bytes);
+    }
+
+    uint64_t MemoryDevice::Copy(uint32_t slot, Target target, uint64_t offset, uint64_t size)
+    {
+        uint64_t fence;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (offset + size > m_buffers[static_cast<uint32_t>(target)].size() || size > m_slotSize)
+            {
+                throw std::runtime_error("copy out of range.");
+            }
+            fence = ++m_submittedFence;
+            CopyRecord record{slot, target, offset, size, fence};
+            m_records.push_back(record);
+            m_queue.push_back(record);
+            m_slotQueued[slot] = fence;
+            m_peakStagingInFlight = std::max(m_peakStagingInFlight, m_queue.size() * m_slotSize);
+        }
+        m_queued.notify_one();
+        return fence;
+    }
+
+    bool MemoryDevice::IsFenceComplete(uint64_t fence)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_completedFence >= fence;
+    }
+
+    void MemoryDevice::WaitForFence(uint64_t fence)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_completed.wait(lock, [&]() { return m_completedFence >= fence; });
+    }
+
+    std::vector<MemoryDevice::CopyRecord> MemoryDevice::GetCopies() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_records;
+    }
+
+    uint64_t MemoryDevice::GetStagingHazards() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stagingHazards;
+    }
+
+    size_t MemoryDevice::GetPeakStagingInFlight() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peakStagingInFlight;
+    }
+}
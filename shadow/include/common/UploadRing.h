@@ -0,0 +1,169 @@
+#ifndef __UPLOADRING_H__
+#define __UPLOADRING_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Streams vertex / index bytes into two growing GPU buffers through a fixed ring of staging slots:
+// appended bytes fill a slot, a full slot becomes one copy command, and a producer that runs out of
+// free slots waits for the oldest copy (backpressure), so staging memory stays slotCount * slotSize.
+// The GPU side is behind Device, the D3D12 implementation lives with DXWindow, MemoryDevice stands in
+// for it where there is no GPU.
+namespace UploadRing
+{
+    enum class Target : uint32_t
+    {
+        Vertex,
+        Index
+    };
+    constexpr uint32_t S_TARGET_COUNT = 2;
+
+    // Copies execute and complete in submission order, fence values increase with every copy.
+    // IsFenceComplete may be called from another thread than the rest.
+    class Device
+    {
+    public:
+        virtual ~Device() = default;
+
+        // once, before anything else
+        virtual void CreateStaging(uint32_t slotCount, size_t slotSize) = 0;
+        // CPU writable memory of a slot, only touched when its last copy is complete
+        virtual uint8_t* GetStaging(uint32_t slot) = 0;
+        // the target buffer holds at least bytes afterwards, existing contents are kept
+        virtual void Reserve(Target target, uint64_t bytes) = 0;
+        // queues a copy of the first size bytes of slot to offset in target, returns its fence value
+        virtual uint64_t Copy(uint32_t slot, Target target, uint64_t offset, uint64_t size) = 0;
+        virtual bool IsFenceComplete(uint64_t fence) = 0;
+        virtual void WaitForFence(uint64_t fence) = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t chunks = 0;                        // copies submitted
+        uint64_t bytes[S_TARGET_COUNT] = {};
+        uint64_t stalls = 0;                        // slot acquisitions that had to wait for the GPU
+        double stallSeconds = 0.;
+        uint32_t peakSlotsInFlight = 0;
+    };
+
+    class Ring
+    {
+        struct Open
+        {
+            int32_t slot = -1;
+            size_t used = 0;
+            uint8_t* data = nullptr;
+        };
+        struct Pending
+        {
+            uint64_t fence;
+            Target target;
+            uint64_t end;
+        };
+
+        Device& m_device;
+        uint32_t m_slotCount;
+        size_t m_slotSize;
+        std::vector<uint64_t> m_slotFence;  // fence of the last copy out of each slot, 0 = none
+        uint32_t m_nextSlot = 0;
+        Open m_open[S_TARGET_COUNT];
+        uint64_t m_appended[S_TARGET_COUNT] = {};
+        uint64_t m_submitted[S_TARGET_COUNT] = {};
+        uint64_t m_reserved[S_TARGET_COUNT] = {};
+        uint64_t m_lastFence = 0;
+        Stats m_stats;
+
+        // submitted copies not known to be complete, polled from the consumer side
+        std::mutex m_pendingMutex;
+        std::deque<Pending> m_pending;
+        std::atomic<uint64_t> m_visible[S_TARGET_COUNT];
+
+        void Acquire(Target target);
+        void Submit(Target target);
+
+    public:
+        // slotCount >= 3: both targets may hold an open slot while a third is acquired
+        Ring(Device& device, uint32_t slotCount, size_t slotSize);
+        ~Ring() = default;
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        // Producer side, one thread.
+        // Index bytes never become visible before the vertex bytes appended ahead of them.
+        void Append(Target target, const void* data, size_t size);
+        // grow the target up front when the final size is known
+        void Reserve(Target target, uint64_t bytes);
+        // submit the partially filled slots
+        void Flush();
+        // Flush and wait until everything is visible
+        void Finish();
+        const Stats& GetStats() const { return m_stats; }
+
+        // Consumer side, any thread: bytes from the start of the target whose copies are complete
+        uint64_t GetVisibleBytes(Target target);
+    };
+
+    // GPU stand-in: staging and target buffers are plain memory, the copies run in submission order on a
+    // worker thread with an optional latency each. Every copy is recorded, and writes to a slot that
+    // still has a copy queued are counted, so ordering, backpressure and the memory bound can be checked
+    // without a GPU.
+    class MemoryDevice : public Device
+    {
+    public:
+        struct CopyRecord
+        {
+            uint32_t slot;
+            Target target;
+            uint64_t offset;
+            uint64_t size;
+            uint64_t fence;
+        };
+
+    private:
+        std::vector<uint8_t> m_staging;
+        size_t m_slotSize = 0;
+        std::vector<uint64_t> m_slotQueued;     // fence of the last copy queued from each slot
+        std::vector<uint8_t> m_buffers[S_TARGET_COUNT];
+        std::vector<CopyRecord> m_records;
+        std::deque<CopyRecord> m_queue;
+        uint64_t m_submittedFence = 0;
+        uint64_t m_completedFence = 0;
+        uint64_t m_stagingHazards = 0;
+        size_t m_peakStagingInFlight = 0;
+        std::chrono::microseconds m_latency;
+        bool m_quit = false;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_queued;
+        std::condition_variable m_completed;
+        std::thread m_worker;
+
+        void Run();
+
+    public:
+        explicit MemoryDevice(std::chrono::microseconds copyLatency = std::chrono::microseconds(0));
+        ~MemoryDevice() override;
+
+        void CreateStaging(uint32_t slotCount, size_t slotSize) override;
+        uint8_t* GetStaging(uint32_t slot) override;
+        void Reserve(Target target, uint64_t bytes) override;
+        uint64_t Copy(uint32_t slot, Target target, uint64_t offset, uint64_t size) override;
+        bool IsFenceComplete(uint64_t fence) override;
+        void WaitForFence(uint64_t fence) override;
+
+        // only meaningful once all copies are complete
+        const std::vector<uint8_t>& GetBuffer(Target target) const { return m_buffers[static_cast<uint32_t>(target)]; }
+        std::vector<CopyRecord> GetCopies() const;
+        uint64_t GetStagingHazards() const;
+        // most staging bytes referenced by queued copies at once
+        size_t GetPeakStagingInFlight() const;
+    };
+}
+#endif
@@ -15,23 +15,30 @@ namespace Util
         return converter.to_bytes(input);
     }
 
-    // split a string by token
-    void Split(std::string& in, std::vector<std::string>& out, char token)
+    inline std::wstring ToWideString(const std::string& input)
+    {
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+        return converter.from_bytes(input);
+    }
+
+    // split a string by token, out is any vector of strings (e.g. a std::pmr one on an arena)
+    template<typename String, typename Container>
+    inline void Split(const String& in, Container& out, char token)
     {
         out.clear();
-        int i = 0, last = 0;
+        size_t i = 0, last = 0;
         for (; i < in.size(); i++)
         {
             if (in[i] == token)
             {
-                out.emplace_back(in.substr(last, i - last));
+                out.emplace_back(in.data() + last, i - last);
                 last = i + 1;
             }
         }
-        out.emplace_back(in.substr(last, in.size() - last));
+        out.emplace_back(in.data() + last, in.size() - last);
     }
 
-    std::vector<std::string> Filter(std::vector<std::string>& in, std::string&& target)
+    inline std::vector<std::string> Filter(std::vector<std::string>& in, std::string&& target)
     {
         std::vector<std::string> out;
         for (auto& str: in)
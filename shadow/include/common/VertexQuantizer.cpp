@@ -0,0 +1,484 @@
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VERTEXQUANTIZER_SSE2
+#endif
+
+namespace
+{
+    constexpr float S_SNORM16_MAX = 32767.f;
+
+    inline const float* At(const float* base, size_t i, size_t stride)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(base) + i * stride);
+    }
+    inline float* At(float* base, size_t i, size_t stride)
+    {
+        return reinterpret_cast<float*>(reinterpret_cast<char*>(base) + i * stride);
+    }
+
+    inline uint32_t AsUInt(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    inline float AsFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline int16_t QuantizeSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lrint(std::min(std::max(value, -1.f), 1.f) * S_SNORM16_MAX));
+    }
+    // D3D maps -32768 and -32767 both to -1
+    inline float DequantizeSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) * (1.f / S_SNORM16_MAX), -1.f);
+    }
+
+    // L1 normalize onto the octahedron, fold the lower half over the diagonals
+    inline void EncodeOctahedral(float x, float y, float z, int16_t out[2])
+    {
+        float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+        if (l1 == 0.f)
+        {
+            z = 1.f;
+            l1 = 1.f;
+        }
+        float ox = x / l1;
+        float oy = y / l1;
+        if (z < 0.f)
+        {
+            float fx = (1.f - std::abs(oy)) * (ox >= 0.f ? 1.f : -1.f);
+            float fy = (1.f - std::abs(ox)) * (oy >= 0.f ? 1.f : -1.f);
+            ox = fx;
+            oy = fy;
+        }
+        out[0] = QuantizeSnorm16(ox);
+        out[1] = QuantizeSnorm16(oy);
+    }
+
+    inline void DecodeOctahedral(const int16_t in[2], float out[3])
+    {
+        float x = DequantizeSnorm16(in[0]);
+        float y = DequantizeSnorm16(in[1]);
+        float z = 1.f - std::abs(x) - std::abs(y);
+        float t = std::max(-z, 0.f);
+        x += x >= 0.f ? -t : t;
+        y += y >= 0.f ? -t : t;
+        float length = std::sqrt(x * x + y * y + z * z);
+        out[0] = x / length;
+        out[1] = y / length;
+        out[2] = z / length;
+    }
+
+    void EncodeVertex(VertexQuantizer::QuantizedVertex& v, const float* position, const float* normal, const float* uv,
+        const float invScale[3], const float offset[3])
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            v.position[k] = QuantizeSnorm16((position[k] - offset[k]) * invScale[k]);
+        }
+        v.position[3] = 0;
+        EncodeOctahedral(normal[0], normal[1], normal[2], v.normal);
+        v.uv[0] = VertexQuantizer::FloatToHalf(uv[0]);
+        v.uv[1] = VertexQuantizer::FloatToHalf(uv[1]);
+    }
+
+    void DecodeVertex(const VertexQuantizer::QuantizedVertex& v, float* position, float* normal, float* uv,
+        const float decodeScale[3], const float offset[3])
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            position[k] = std::max(static_cast<float>(v.position[k]) * (1.f / S_SNORM16_MAX), -1.f) * decodeScale[k] + offset[k];
+        }
+        DecodeOctahedral(v.normal, normal);
+        uv[0] = VertexQuantizer::HalfToFloat(v.uv[0]);
+        uv[1] = VertexQuantizer::HalfToFloat(v.uv[1]);
+    }
+
+#if defined(VERTEXQUANTIZER_SSE2)
+    inline __m128i QuantizeSnorm16(__m128 value)
+    {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(S_SNORM16_MAX)));
+    }
+    inline __m128 DequantizeSnorm16(__m128i value)
+    {
+        return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(value), _mm_set1_ps(1.f / S_SNORM16_MAX)), _mm_set1_ps(-1.f));
+    }
+
+    inline __m128 Abs(__m128 v)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+    }
+    // a where mask is set, b elsewhere
+    inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline void EncodeOctahedral(__m128 x, __m128 y, __m128 z, __m128i& outX, __m128i& outY)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 l1 = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+        __m128 degenerate = _mm_cmpeq_ps(l1, zero);
+        z = Select(degenerate, one, z);
+        l1 = Select(degenerate, one, l1);
+
+        __m128 ox = _mm_div_ps(x, l1);
+        __m128 oy = _mm_div_ps(y, l1);
+        __m128 signX = Select(_mm_cmpge_ps(ox, zero), one, _mm_set1_ps(-1.f));
+        __m128 signY = Select(_mm_cmpge_ps(oy, zero), one, _mm_set1_ps(-1.f));
+        __m128 fx = _mm_mul_ps(_mm_sub_ps(one, Abs(oy)), signX);
+        __m128 fy = _mm_mul_ps(_mm_sub_ps(one, Abs(ox)), signY);
+        __m128 lower = _mm_cmplt_ps(z, zero);
+        outX = QuantizeSnorm16(Select(lower, fx, ox));
+        outY = QuantizeSnorm16(Select(lower, fy, oy));
+    }
+
+    inline void DecodeOctahedral(__m128i inX, __m128i inY, __m128& x, __m128& y, __m128& z)
+    {
+        x = DequantizeSnorm16(inX);
+        y = DequantizeSnorm16(inY);
+        z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.f), Abs(x)), Abs(y));
+        __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+        // x += x >= 0 ? -t : t, x is never -0 here
+        const __m128 signBit = _mm_set1_ps(-0.f);
+        x = _mm_sub_ps(x, _mm_xor_ps(t, _mm_and_ps(x, signBit)));
+        y = _mm_sub_ps(y, _mm_xor_ps(t, _mm_and_ps(y, signBit)));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        x = _mm_div_ps(x, length);
+        y = _mm_div_ps(y, length);
+        z = _mm_div_ps(z, length);
+    }
+
+    // Round to nearest even, denormals, infinity and NaN handled like the scalar FloatToHalf.
+    // Results are sign extended 32-bit lanes, ready for _mm_packs_epi32.
+    inline __m128i FloatToHalf4(__m128 f)
+    {
+        const __m128i infinityOrNaN = _mm_set1_epi32(0x7c00);
+        const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);   // everything from here on is infinity
+        const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+        __m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.f));
+        __m128 absF = _mm_xor_ps(f, sign);
+        __m128i absBits = _mm_castps_si128(absF);
+
+        __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+        __m128i special = _mm_or_si128(infinityOrNaN, _mm_and_si128(isNaN, _mm_set1_epi32(0x200)));
+        __m128i isRegular = _mm_cmpgt_epi32(halfMax, absBits);
+        __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+
+        // the float add rounds the mantissa for us
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+        __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+        __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+        __m128i regular = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        __m128i result = _mm_or_si128(_mm_and_si128(isRegular, regular), _mm_andnot_si128(isRegular, special));
+        return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+    }
+
+    // h: half in the low 16 bits of each lane
+    inline __m128 HalfToFloat4(__m128i h)
+    {
+        const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+        __m128i exponentMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, exponentMantissa), 16);
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), magic);
+        __m128i wasInfinityOrNaN = _mm_cmpgt_epi32(exponentMantissa, _mm_set1_epi32(0x7bff));
+        __m128i infinityExponent = _mm_and_si128(wasInfinityOrNaN, _mm_set1_epi32(255 << 23));
+        return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infinityExponent)));
+    }
+
+    // 4 int32 lanes -> 4 int16 in the low 64 bits
+    inline __m128i Pack16(__m128i v)
+    {
+        return _mm_packs_epi32(v, v);
+    }
+#endif
+}
+
+namespace VertexQuantizer
+{
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits = AsUInt(value);
+        uint32_t sign = bits & 0x80000000u;
+        uint32_t absBits = bits ^ sign;
+
+        uint32_t result;
+        if (absBits >= (127u + 16) << 23)
+        {
+            result = absBits > 0x7f800000u ? 0x7e00 : 0x7c00;
+        }
+        else if (absBits < (127u - 14) << 23)
+        {
+            const uint32_t magic = ((127u - 15) + (23 - 10) + 1) << 23;
+            result = AsUInt(AsFloat(absBits) + AsFloat(magic)) - magic;
+        }
+        else
+        {
+            uint32_t mantissaOdd = (absBits >> 13) & 1;
+            result = (absBits + (0xfffu - ((127u - 15) << 23)) + mantissaOdd) >> 13;
+        }
+        return static_cast<uint16_t>(result | (sign >> 16));
+    }
+
+    float HalfToFloat(uint16_t value)
+    {
+        uint32_t exponentMantissa = value & 0x7fffu;
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        uint32_t bits = AsUInt(AsFloat(exponentMantissa << 13) * AsFloat((254u - 15) << 23));
+        if (exponentMantissa > 0x7bff) bits |= 255u << 23;
+        return AsFloat(bits | sign);
+    }
+
+    QuantizationParams ComputeQuantization(const float* positions, size_t vertexCount, size_t stride)
+    {
+        QuantizationParams params;
+        if (vertexCount == 0) return params;
+
+        float boundsMin[3] = {positions[0], positions[1], positions[2]};
+        float boundsMax[3] = {positions[0], positions[1], positions[2]};
+        size_t i = 1;
+#if defined(VERTEXQUANTIZER_SSE2)
+        __m128 vMin = _mm_setr_ps(positions[0], positions[1], positions[2], 0.f);
+        __m128 vMax = vMin;
+        // 16 byte loads read one float past xyz, stop before the last vertex
+        for (; i + 1 < vertexCount; i++)
+        {
+            __m128 p = _mm_loadu_ps(At(positions, i, stride));
+            vMin = _mm_min_ps(vMin, p);
+            vMax = _mm_max_ps(vMax, p);
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vMin);
+        std::copy(lanes, lanes + 3, boundsMin);
+        _mm_storeu_ps(lanes, vMax);
+        std::copy(lanes, lanes + 3, boundsMax);
+#endif
+        for (; i < vertexCount; i++)
+        {
+            const float* p = At(positions, i, stride);
+            for (int k = 0; k < 3; k++)
+            {
+                boundsMin[k] = std::min(boundsMin[k], p[k]);
+                boundsMax[k] = std::max(boundsMax[k], p[k]);
+            }
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            params.offset[k] = (boundsMin[k] + boundsMax[k]) * 0.5f;
+            float halfExtent = (boundsMax[k] - boundsMin[k]) * 0.5f;
+            // flat axis, every position quantizes to 0 and decodes to offset exactly
+            params.scale[k] = halfExtent > 0.f ? halfExtent : 1.f;
+        }
+        return params;
+    }
+
+    void Encode(QuantizedVertex* destination, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const QuantizationParams& params)
+    {
+        float invScale[3];
+        for (int k = 0; k < 3; k++)
+        {
+            invScale[k] = 1.f / params.scale[k];
+        }
+
+        size_t i = 0;
+#if defined(VERTEXQUANTIZER_SSE2)
+        const __m128 offsetX = _mm_set1_ps(params.offset[0]);
+        const __m128 offsetY = _mm_set1_ps(params.offset[1]);
+        const __m128 offsetZ = _mm_set1_ps(params.offset[2]);
+        const __m128 invScaleX = _mm_set1_ps(invScale[0]);
+        const __m128 invScaleY = _mm_set1_ps(invScale[1]);
+        const __m128 invScaleZ = _mm_set1_ps(invScale[2]);
+        // xyz loads read one float past the attribute, keep the last vertex for the scalar loop
+        for (; i + 4 < vertexCount; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(At(positions, i, stride));
+            __m128 y = _mm_loadu_ps(At(positions, i + 1, stride));
+            __m128 z = _mm_loadu_ps(At(positions, i + 2, stride));
+            __m128 w = _mm_loadu_ps(At(positions, i + 3, stride));
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128i px = QuantizeSnorm16(_mm_mul_ps(_mm_sub_ps(x, offsetX), invScaleX));
+            __m128i py = QuantizeSnorm16(_mm_mul_ps(_mm_sub_ps(y, offsetY), invScaleY));
+            __m128i pz = QuantizeSnorm16(_mm_mul_ps(_mm_sub_ps(z, offsetZ), invScaleZ));
+
+            x = _mm_loadu_ps(At(normals, i, stride));
+            y = _mm_loadu_ps(At(normals, i + 1, stride));
+            z = _mm_loadu_ps(At(normals, i + 2, stride));
+            w = _mm_loadu_ps(At(normals, i + 3, stride));
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128i nx, ny;
+            EncodeOctahedral(x, y, z, nx, ny);
+
+            __m128 uv01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(At(uvs, i, stride))),
+                reinterpret_cast<const __m64*>(At(uvs, i + 1, stride)));
+            __m128 uv23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(At(uvs, i + 2, stride))),
+                reinterpret_cast<const __m64*>(At(uvs, i + 3, stride)));
+            __m128i u = FloatToHalf4(_mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i v = FloatToHalf4(_mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(3, 1, 3, 1)));
+
+            // SoA -> 4 vertices of 8 int16: x y z 0 nx ny u v
+            __m128i xy = _mm_unpacklo_epi16(Pack16(px), Pack16(py));
+            __m128i zw = _mm_unpacklo_epi16(Pack16(pz), _mm_setzero_si128());
+            __m128i n = _mm_unpacklo_epi16(Pack16(nx), Pack16(ny));
+            __m128i uv = _mm_unpacklo_epi16(Pack16(u), Pack16(v));
+            __m128i position01 = _mm_unpacklo_epi32(xy, zw);
+            __m128i position23 = _mm_unpackhi_epi32(xy, zw);
+            __m128i attribute01 = _mm_unpacklo_epi32(n, uv);
+            __m128i attribute23 = _mm_unpackhi_epi32(n, uv);
+            __m128i* out = reinterpret_cast<__m128i*>(destination + i);
+            _mm_storeu_si128(out, _mm_unpacklo_epi64(position01, attribute01));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi64(position01, attribute01));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi64(position23, attribute23));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi64(position23, attribute23));
+        }
+#endif
+        for (; i < vertexCount; i++)
+        {
+            EncodeVertex(destination[i], At(positions, i, stride), At(normals, i, stride), At(uvs, i, stride),
+                invScale, params.offset);
+        }
+    }
+
+    void Decode(float* positions, float* normals, float* uvs, size_t stride,
+        const QuantizedVertex* source, size_t vertexCount, const QuantizationParams& params)
+    {
+        size_t i = 0;
+#if defined(VERTEXQUANTIZER_SSE2)
+        const __m128 offsetX = _mm_set1_ps(params.offset[0]);
+        const __m128 offsetY = _mm_set1_ps(params.offset[1]);
+        const __m128 offsetZ = _mm_set1_ps(params.offset[2]);
+        const __m128 scaleX = _mm_set1_ps(params.scale[0]);
+        const __m128 scaleY = _mm_set1_ps(params.scale[1]);
+        const __m128 scaleZ = _mm_set1_ps(params.scale[2]);
+        for (; i + 4 < vertexCount; i += 4)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(source + i);
+            __m128i v0 = _mm_loadu_si128(in);
+            __m128i v1 = _mm_loadu_si128(in + 1);
+            __m128i v2 = _mm_loadu_si128(in + 2);
+            __m128i v3 = _mm_loadu_si128(in + 3);
+
+            // 4 vertices of 8 int16 -> SoA pairs
+            __m128i t0 = _mm_unpacklo_epi32(v0, v1);
+            __m128i t1 = _mm_unpacklo_epi32(v2, v3);
+            __m128i t2 = _mm_unpackhi_epi32(v0, v1);
+            __m128i t3 = _mm_unpackhi_epi32(v2, v3);
+            __m128i xy = _mm_unpacklo_epi64(t0, t1);
+            __m128i zw = _mm_unpackhi_epi64(t0, t1);
+            __m128i n = _mm_unpacklo_epi64(t2, t3);
+            __m128i uv = _mm_unpackhi_epi64(t2, t3);
+
+            __m128 x = _mm_add_ps(_mm_mul_ps(DequantizeSnorm16(_mm_srai_epi32(_mm_slli_epi32(xy, 16), 16)), scaleX), offsetX);
+            __m128 y = _mm_add_ps(_mm_mul_ps(DequantizeSnorm16(_mm_srai_epi32(xy, 16)), scaleY), offsetY);
+            __m128 z = _mm_add_ps(_mm_mul_ps(DequantizeSnorm16(_mm_srai_epi32(_mm_slli_epi32(zw, 16), 16)), scaleZ), offsetZ);
+            __m128 w = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128 position[4] = {x, y, z, w};
+
+            __m128 nx, ny, nz, nw = _mm_setzero_ps();
+            DecodeOctahedral(_mm_srai_epi32(_mm_slli_epi32(n, 16), 16), _mm_srai_epi32(n, 16), nx, ny, nz);
+            _MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+            __m128 normal[4] = {nx, ny, nz, nw};
+
+            __m128 u = HalfToFloat4(_mm_and_si128(uv, _mm_set1_epi32(0xffff)));
+            __m128 v = HalfToFloat4(_mm_srli_epi32(uv, 16));
+            __m128 uv01 = _mm_unpacklo_ps(u, v);
+            __m128 uv23 = _mm_unpackhi_ps(u, v);
+
+            for (int k = 0; k < 4; k++)
+            {
+                _mm_storeu_ps(At(positions, i + k, stride), position[k]);
+                _mm_storeu_ps(At(normals, i + k, stride), normal[k]);
+                __m128 uvk = k < 2 ? uv01 : uv23;
+                if (k & 1) _mm_storeh_pi(reinterpret_cast<__m64*>(At(uvs, i + k, stride)), uvk);
+                else _mm_storel_pi(reinterpret_cast<__m64*>(At(uvs, i + k, stride)), uvk);
+            }
+        }
+#endif
+        for (; i < vertexCount; i++)
+        {
+            DecodeVertex(source[i], At(positions, i, stride), At(normals, i, stride), At(uvs, i, stride),
+                params.scale, params.offset);
+        }
+    }
+
+    ErrorStats MeasureError(const QuantizedVertex* quantized, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const QuantizationParams& params)
+    {
+        ErrorStats stats;
+        if (vertexCount == 0) return stats;
+
+        // decode a block at a time into position / normal / uv interleaved floats
+        const size_t blockSize = 1024;
+        const size_t decodedStride = 8 * sizeof(float);
+        float decoded[blockSize * 8];
+
+        double positionSquared = 0.;
+        double uvSquared = 0.;
+        double normalDegrees = 0.;
+        size_t normalCount = 0;
+        const double radiansToDegrees = 180. / 3.14159265358979323846;
+        for (size_t begin = 0; begin < vertexCount; begin += blockSize)
+        {
+            size_t count = std::min(blockSize, vertexCount - begin);
+            Decode(decoded, decoded + 3, decoded + 6, decodedStride, quantized + begin, count, params);
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* d = decoded + i * 8;
+                const float* p = At(positions, begin + i, stride);
+                const float* n = At(normals, begin + i, stride);
+                const float* t = At(uvs, begin + i, stride);
+
+                double distanceSquared = 0.;
+                for (int k = 0; k < 3; k++)
+                {
+                    double delta = static_cast<double>(d[k]) - p[k];
+                    distanceSquared += delta * delta;
+                }
+                positionSquared += distanceSquared;
+                stats.positionMax = std::max(stats.positionMax, std::sqrt(distanceSquared));
+
+                double length = std::sqrt(static_cast<double>(n[0]) * n[0] + static_cast<double>(n[1]) * n[1] + static_cast<double>(n[2]) * n[2]);
+                if (length > 0.)
+                {
+                    double cosine = (d[3] * n[0] + d[4] * n[1] + static_cast<double>(d[5]) * n[2]) / length;
+                    double degrees = std::acos(std::min(std::max(cosine, -1.), 1.)) * radiansToDegrees;
+                    stats.normalMaxDegrees = std::max(stats.normalMaxDegrees, degrees);
+                    normalDegrees += degrees;
+                    normalCount++;
+                }
+
+                for (int k = 0; k < 2; k++)
+                {
+                    double delta = std::abs(static_cast<double>(d[6 + k]) - t[k]);
+                    uvSquared += delta * delta;
+                    stats.uvMax = std::max(stats.uvMax, delta);
+                }
+            }
+        }
+        stats.positionRms = std::sqrt(positionSquared / vertexCount);
+        stats.uvRms = std::sqrt(uvSquared / (vertexCount * 2));
+        stats.normalMeanDegrees = normalCount > 0 ? normalDegrees / normalCount : 0.;
+        return stats;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef __VERTEXQUANTIZER_H__
+#define __VERTEXQUANTIZER_H__
+
+#include <cstdint>
+#include <cstddef>
+
+// Compact GPU vertex format, 16 bytes instead of 32:
+//   position  R16G16B16A16_SNORM  relative to the mesh bounds, w unused
+//   normal    R16G16_SNORM        octahedral encoding
+//   uv        R16G16_FLOAT        half floats
+// Encode/decode process 4 vertices per SSE2 iteration, with a scalar path for the rest.
+namespace VertexQuantizer
+{
+    struct QuantizedVertex
+    {
+        int16_t position[4];
+        int16_t normal[2];
+        uint16_t uv[2];
+    };
+    static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must stay 16 bytes");
+
+    // position = snorm * scale + offset, snorm in [-1, 1]
+    struct QuantizationParams
+    {
+        float scale[3] = {1.f, 1.f, 1.f};
+        float offset[3] = {0.f, 0.f, 0.f};
+    };
+
+    // Bounds of vertexCount xyz positions stored every stride bytes, as the center / half extent
+    // SNORM16 positions are relative to
+    QuantizationParams ComputeQuantization(const float* positions, size_t vertexCount, size_t stride);
+
+    // Source attributes are interleaved: position xyz, normal xyz and uv xy floats every stride bytes.
+    // Normals need not be unit length, zero normals encode as +z.
+    void Encode(QuantizedVertex* destination, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const QuantizationParams& params);
+
+    // Inverse of Encode. Destination attributes are written in ascending order with 16 byte stores,
+    // so the float after each position / normal is overwritten before it gets its own value.
+    void Decode(float* positions, float* normals, float* uvs, size_t stride,
+        const QuantizedVertex* source, size_t vertexCount, const QuantizationParams& params);
+
+    struct ErrorStats
+    {
+        double positionMax = 0.;        // model space distance
+        double positionRms = 0.;
+        double normalMaxDegrees = 0.;
+        double normalMeanDegrees = 0.;
+        double uvMax = 0.;              // per component
+        double uvRms = 0.;
+    };
+
+    // Round-trip error of quantized against the source attributes (same layout as Encode)
+    ErrorStats MeasureError(const QuantizedVertex* quantized, const float* positions, const float* normals, const float* uvs,
+        size_t vertexCount, size_t stride, const QuantizationParams& params);
+
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+}
+#endif
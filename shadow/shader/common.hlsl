@@ -21,4 +21,26 @@ ConstantBuffer<PassData> passCB : register(b1);
 
 Texture2D g_texture : register(t0);
 Texture2D g_shadowMap : register(t1);
-SamplerState g_sampler : register(s2);
\ No newline at end of file
+SamplerState g_sampler : register(s2);
+
+// FLAT_NORMAL: the vertices carry no normal (streamed preview), the pixel shader uses the face normal
+// QUANTIZED_VERTEX: position is R16G16B16A16_SNORM, its decode is folded into MVP/ModelMatrix,
+// normal is octahedral R16G16_SNORM, uv is R16G16_FLOAT
+#ifdef QUANTIZED_VERTEX
+#define VERTEX_POSITION float4
+#define VERTEX_NORMAL float2
+float3 DecodeNormal(float2 e)
+{
+    float3 n = float3(e, 1.f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.f ? -t : t;
+    return normalize(n);
+}
+#else
+#define VERTEX_POSITION float3
+#define VERTEX_NORMAL float3
+float3 DecodeNormal(float3 n)
+{
+    return n;
+}
+#endif
\ No newline at end of file
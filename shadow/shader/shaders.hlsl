@@ -2,8 +2,8 @@
 
 struct VSInput
 {
-    float3 position : POSITION;
-    float3 normal : NORMAL;
+    VERTEX_POSITION position : POSITION;
+    VERTEX_NORMAL normal : NORMAL;
     float2 uv : TEXCOORD;
 };
 
@@ -20,10 +20,14 @@ struct PSInput
 PSInput VSMain(VSInput input)
 {
     PSInput o;
-    o.position = mul(float4(input.position, 1.f), MVPCB.MVP);
+    o.position = mul(float4(input.position.xyz, 1.f), MVPCB.MVP);
     // o.normal = input.normal;
-    o.normal = normalize(mul(float4(input.normal, 0.f), MVPCB.ModelNegaTrans).xyz);
-    o.worldPos = mul(float4(input.position, 1.f), MVPCB.ModelMatrix);
+#ifdef FLAT_NORMAL
+    o.normal = float3(0.f, 0.f, 0.f);
+#else
+    o.normal = normalize(mul(float4(DecodeNormal(input.normal), 0.f), MVPCB.ModelNegaTrans).xyz);
+#endif
+    o.worldPos = mul(float4(input.position.xyz, 1.f), MVPCB.ModelMatrix);
     // o.textureColor = o.normal.xyz*0.5+0.5;
     o.textureColor = float3(0.5f, 0.5f, 0.5f);
     o.uv = input.uv;
@@ -33,6 +37,9 @@ PSInput VSMain(VSInput input)
 float4 PSMain(PSInput input) : SV_TARGET
 {
     float3 color = g_texture.Sample(g_sampler, input.uv).rgb;
+#ifdef FLAT_NORMAL
+    input.normal = normalize(cross(ddx(input.worldPos.xyz), ddy(input.worldPos.xyz)));
+#endif
     
     float3 viewDir = normalize(passCB.eyePos.xyz - input.worldPos.xyz);
     float r = length(passCB.lightPos.xyz - input.worldPos.xyz);
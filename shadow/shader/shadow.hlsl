@@ -2,8 +2,8 @@
 
 struct VSInput
 {
-    float3 position : POSITION;
-    float3 normal : NORMAL;
+    VERTEX_POSITION position : POSITION;
+    VERTEX_NORMAL normal : NORMAL;
     float2 uv : TEXCOORD;
 };
 
@@ -17,7 +17,7 @@ VSOutput VSMain(VSInput i)
 {
     VSOutput o;
     
-    float4 worldPos = mul(float4(i.position, 1.f), MVPCB.ModelMatrix);
+    float4 worldPos = mul(float4(i.position.xyz, 1.f), MVPCB.ModelMatrix);
     
     o.position = mul(worldPos, MVPCB.MVP);
     // o.worldPos = mul(float4(i.position, 1.f), MVPCB.ModelMatrix);
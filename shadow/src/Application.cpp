@@ -192,6 +192,34 @@ std::shared_ptr<Model> Application::GetModel() const
 {
     return m_model;
 }
+std::shared_ptr<ModelLoadHandle> Application::LoadModelAsync(ModelLoadDesc desc, LoadPriority priority)
+{
+    if (m_loadQueue == nullptr) m_loadQueue = std::make_unique<ModelLoadQueue>();
+    return m_loadQueue->Push(std::move(desc), priority);
+}
+void Application::SetPendingModel(const std::shared_ptr<ModelLoadHandle>& handle)
+{
+    m_pendingModel = handle;
+}
+std::shared_ptr<ModelLoadHandle> Application::GetPendingModel() const
+{
+    return m_pendingModel;
+}
+std::chrono::high_resolution_clock::time_point Application::GetStartTime() const
+{
+    return m_startTime;
+}
+void Application::SetStreamingModel(std::wstring model_name, ModelType modelType)
+{
+    m_streamingModelName = model_name;
+    m_streamingModelType = modelType;
+}
+bool Application::GetStreamingModel(std::wstring& model_name, ModelType& modelType) const
+{
+    model_name = m_streamingModelName;
+    modelType = m_streamingModelType;
+    return !m_streamingModelName.empty();
+}
 
 void Application::CreateInstance(HINSTANCE hInst)
 {
@@ -223,6 +251,9 @@ int Application::Run(std::shared_ptr<DXWindow> window)
         }
     }
 
+    // 先取消还没完成的加载，再销毁窗口和设备
+    if (m_pendingModel) m_pendingModel->Cancel();
+    m_loadQueue.reset();
     window->Destroy();
     m_device->Release();
     m_adapter->Release();
@@ -279,6 +310,7 @@ bool Application::IsWindowCreated() const
 
 Application::Application(HINSTANCE hInst) noexcept
 {
+    m_startTime = std::chrono::high_resolution_clock::now();
     m_assetsPath = shader_path;
 
     // Windows 10 Creators update adds Per Monitor V2 DPI awareness context.
@@ -4,9 +4,14 @@
 #include <dxgidebug.h>
 #include <algorithm>
 #include "Application.h"
+#include "common/MappedFile.h"
+#include "common/Utility.h"
+#include "common/TgaDecoder.h"
 
 #include <wincodec.h>   //for WIC
+#include <windowsx.h>   // for GET_X_LPARAM
 #include <cmath> // for ceil
+#include <stdexcept>
 
 DXWindow::DXWindow(const wchar_t* name, uint32_t w, uint32_t h) noexcept
     : m_name(name)
@@ -300,57 +305,49 @@ std::array<CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers()
 	return{ pointWarp, pointClamp, linearWarp, linearClamp, anisotropicWarp, anisotropicClamp };
 }
 
-void DXWindow::LoadAssets()
+static const D3D12_INPUT_ELEMENT_DESC g_floatVertexLayout[] =
 {
-    // 1.
-    {
-        D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
-        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-        if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
-        {
-            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-            assert(false && "Root Signature Version error");
-        }
+    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+};
 
-        D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
-        
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[1] = {};
-        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
-        // TODO: sampler
+// VertexQuantizer::QuantizedVertex，SNORM/FLOAT16 由输入装配阶段转换成 float
+static const D3D12_INPUT_ELEMENT_DESC g_quantizedVertexLayout[] =
+{
+    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+};
 
-        // A single 32-bit constant root parameter that is used by the vertex shader.
-        CD3DX12_ROOT_PARAMETER1 rootParameters[3] = {};
-        rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
-        rootParameters[1].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
-        rootParameters[2].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
-        
-        // D3D12_STATIC_SAMPLER_DESC samplerDescs[1] = {};
-        auto samplerDescs = GetStaticSamplers();
+static const D3D_SHADER_MACRO g_quantizedVertexDefines[] =
+{
+    { "QUANTIZED_VERTEX", "1" },
+    { nullptr, nullptr }
+};
 
-        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(
-            _countof(rootParameters),
-            rootParameters,
-            samplerDescs.size(),
-            samplerDescs.data(),
-            rootSignatureFlags);
-        // rootSignatureDesc.Init(0, nullptr, 0, nullptr, rootSignatureFlags);
+static const D3D_SHADER_MACRO g_flatNormalDefines[] =
+{
+    { "FLAT_NORMAL", "1" },
+    { nullptr, nullptr }
+};
 
-        ComPtr<ID3DBlob> signature;
-        ComPtr<ID3DBlob> error;
-        // ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_1, &signature, &error));
-        ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error));
-        ThrowIfFailed(m_device->CreateRootSignature(
-            0,
-            signature->GetBufferPointer(),
-            signature->GetBufferSize(),
-            IID_PPV_ARGS(&m_RootSignature)));
-    }
+static D3D12_INPUT_LAYOUT_DESC GetInputLayout(VertexFormat format)
+{
+    if (format == VertexFormat::Quantized) return { g_quantizedVertexLayout, _countof(g_quantizedVertexLayout) };
+    return { g_floatVertexLayout, _countof(g_floatVertexLayout) };
+}
 
+// 流式加载的顶点是 Float32 且没有法线
+static const D3D_SHADER_MACRO* GetShaderDefines(VertexFormat format, bool flatNormals = false)
+{
+    if (flatNormals) return g_flatNormalDefines;
+    return format == VertexFormat::Quantized ? g_quantizedVertexDefines : nullptr;
+}
+
+// 模型的 PSO 依赖顶点格式，异步加载的模型换上时格式不同需要重建
+void DXWindow::CreateModelPipelineStates(VertexFormat vertexFormat, bool flatNormals)
+{
     // 2.
     {
         ComPtr<ID3DBlob> vertexShader;
@@ -364,24 +361,17 @@ void DXWindow::LoadAssets()
 
         ThrowIfFailed(D3DCompileFromFile(
             GetShaderFullPath(L"shaders.hlsl").c_str(),
-            nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1",
+            GetShaderDefines(vertexFormat, flatNormals), D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1",
             compileFlags, 0, &vertexShader, nullptr
             )
         );
         ThrowIfFailed(D3DCompileFromFile(
             GetShaderFullPath(L"shaders.hlsl").c_str(),
-            nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1",
+            GetShaderDefines(vertexFormat, flatNormals), D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1",
             compileFlags, 0, &pixelShader, nullptr
             )
         );
 
-        D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
-        {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-        };
-
         struct PipelineStateStream
         {
             CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
@@ -398,7 +388,7 @@ void DXWindow::LoadAssets()
         rtvFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
 
         pipelineStateStream.pRootSignature = m_RootSignature.Get();
-        pipelineStateStream.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
+        pipelineStateStream.InputLayout = GetInputLayout(vertexFormat);
         pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
         pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
         pipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
@@ -411,37 +401,188 @@ void DXWindow::LoadAssets()
         ThrowIfFailed(m_device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
     }
 
+    // shadow map PSO
+    {
+        ComPtr<ID3DBlob> vertexShader;
+        ComPtr<ID3DBlob> pixelShader;
+
+#if defined(_DEBUG)
+        UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+        UINT compileFlags = 0;
+#endif
+
+        ThrowIfFailed(D3DCompileFromFile(
+            GetShaderFullPath(L"shadow.hlsl").c_str(),
+            GetShaderDefines(vertexFormat, flatNormals), D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1",
+            compileFlags, 0, &vertexShader, nullptr
+        ));
+        ThrowIfFailed(D3DCompileFromFile(
+            GetShaderFullPath(L"shadow.hlsl").c_str(),
+            GetShaderDefines(vertexFormat, flatNormals), D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1",
+            compileFlags, 0, &pixelShader, nullptr
+        ));
+        
+
+        struct PipelineStateStream
+        {
+            CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
+            CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
+            CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
+            CD3DX12_PIPELINE_STATE_STREAM_VS VS;
+            CD3DX12_PIPELINE_STATE_STREAM_PS PS;
+            CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
+            CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
+            CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER Rasterizer;
+        };
+
+        D3D12_RT_FORMAT_ARRAY rtvFormats = {};
+        
+        PipelineStateStream shadowPipelineStateStream;
+        shadowPipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+        rtvFormats.NumRenderTargets = 0;
+        rtvFormats.RTFormats[0] = DXGI_FORMAT_UNKNOWN;
+        shadowPipelineStateStream.RTVFormats = rtvFormats;
+        shadowPipelineStateStream.pRootSignature = m_RootSignature.Get();
+        shadowPipelineStateStream.InputLayout = GetInputLayout(vertexFormat);
+        shadowPipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        shadowPipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+        shadowPipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+        CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
+        rasterizerDesc.DepthBias = 0;
+        rasterizerDesc.DepthBiasClamp = 0;
+        rasterizerDesc.SlopeScaledDepthBias = 1.f;
+        shadowPipelineStateStream.Rasterizer = CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER(rasterizerDesc);
+
+        D3D12_PIPELINE_STATE_STREAM_DESC shadowPipelineStateStreamDesc = {};
+        shadowPipelineStateStreamDesc.pPipelineStateSubobjectStream = &shadowPipelineStateStream;
+        shadowPipelineStateStreamDesc.SizeInBytes = sizeof(PipelineStateStream);
+        ThrowIfFailed(m_device->CreatePipelineState(&shadowPipelineStateStreamDesc, IID_PPV_ARGS(&m_shadowPipelineState)));
+    }
+}
+
+// 模型数据的只读视图，直接拷进 upload heap，不再复制一份 vector。
+// intermediate 缓冲要保留到 commandList 执行完
+void DXWindow::UploadModel(ComPtr<ID3D12GraphicsCommandList2> commandList,
+    ComPtr<ID3D12Resource>& intermediateVertexBuffer, ComPtr<ID3D12Resource>& intermediateIndexBuffer)
+{
+    auto numVertices = m_model->GetVerticesNum();
+    auto numIndicies = m_model->GetIndiciesNum();
+    auto vertexStride = m_model->GetVertexStride();
+    auto indexStride = m_model->GetIndexStride();
+
+    XMFLOAT3 decodeScale, decodeOffset;
+    m_model->GetPositionDecode(decodeScale, decodeOffset);
+    m_positionDecodeMatrix = XMMatrixScaling(decodeScale.x, decodeScale.y, decodeScale.z) *
+        XMMatrixTranslation(decodeOffset.x, decodeOffset.y, decodeOffset.z);
+
+    // Upload vertex buffer data.
+    UpdateBufferResource(commandList, &m_VertexBuffer, &intermediateVertexBuffer,
+        numVertices, vertexStride, m_model->GetVertexData());
+
+    // Create the vertex buffer view.
+    m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
+    m_VertexBufferView.SizeInBytes = numVertices * vertexStride;
+    m_VertexBufferView.StrideInBytes = vertexStride;
+
+    // Upload index buffer data.
+    UpdateBufferResource(commandList, &m_IndexBuffer, &intermediateIndexBuffer,
+        numIndicies, indexStride, m_model->GetIndexData());
+
+    // Create index buffer view.
+    m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
+    m_IndexBufferView.Format = m_model->GetIndexFormat() == IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    m_IndexBufferView.SizeInBytes = numIndicies * indexStride;
+}
+
+void DXWindow::LoadAssets()
+{
+    // input layout 和 shader 按模型的顶点格式选择
+    auto app = Application::GetInstance();
+    m_model = app->GetModel();
+    std::wstring streamingName;
+    ModelType streamingType;
+    if (m_model == nullptr && app->GetPendingModel())
+    {
+        // 异步加载完成前显示的占位模型，很小，同步加载
+        m_pendingModel = app->GetPendingModel();
+        m_model = std::make_shared<Model>(L"box.obj", ModelType::OBJ, true, false);
+    }
+    else if (m_model == nullptr && app->GetStreamingModel(streamingName, streamingType))
+    {
+        m_uploadDevice = std::make_unique<D3D12UploadDevice>(m_device);
+        m_streamingMesh = std::make_shared<StreamingMesh>(*m_uploadDevice);
+        m_streamingMesh->Start(streamingName, streamingType);
+    }
+    auto vertexFormat = m_model ? m_model->GetVertexFormat() : VertexFormat::Float32;
+    bool flatNormals = m_streamingMesh != nullptr;
+
+    // 1.
+    {
+        D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+        {
+            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+            assert(false && "Root Signature Version error");
+        }
+
+        D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
+            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
+        
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[1] = {};
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+        // TODO: sampler
+
+        // A single 32-bit constant root parameter that is used by the vertex shader.
+        CD3DX12_ROOT_PARAMETER1 rootParameters[3] = {};
+        rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
+        rootParameters[1].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
+        rootParameters[2].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
+        
+        // D3D12_STATIC_SAMPLER_DESC samplerDescs[1] = {};
+        auto samplerDescs = GetStaticSamplers();
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+        rootSignatureDesc.Init_1_1(
+            _countof(rootParameters),
+            rootParameters,
+            samplerDescs.size(),
+            samplerDescs.data(),
+            rootSignatureFlags);
+        // rootSignatureDesc.Init(0, nullptr, 0, nullptr, rootSignatureFlags);
+
+        ComPtr<ID3DBlob> signature;
+        ComPtr<ID3DBlob> error;
+        // ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_1, &signature, &error));
+        ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &error));
+        ThrowIfFailed(m_device->CreateRootSignature(
+            0,
+            signature->GetBufferPointer(),
+            signature->GetBufferSize(),
+            IID_PPV_ARGS(&m_RootSignature)));
+    }
+
+    // 2.
+    CreateModelPipelineStates(vertexFormat, flatNormals);
+
     auto commandList = m_commandQueue->GetCommandList(nullptr);
     
     ComPtr<ID3D12Resource> intermediateVertexBuffer;
     ComPtr<ID3D12Resource> intermediateIndexBuffer;
 
-    // 4.
+    // 4. 流式加载时缓冲由 m_uploadDevice 创建，视图在 UpdateStreamingMesh 中每帧更新
+    if (m_model)
+    {
+        UploadModel(commandList, intermediateVertexBuffer, intermediateIndexBuffer);
+    }
+    else
     {
-        m_model = Application::GetInstance()->GetModel();
-        auto vertices = m_model->GetVertices();
-        auto numVertices = m_model->GetVerticesNum();
-        auto indicies = m_model->GetIndicies();
-        auto numIndicies = m_model->GetIndiciesNum();
-
-
-        // Upload vertex buffer data.
-        UpdateBufferResource(commandList, &m_VertexBuffer, &intermediateVertexBuffer,
-            numVertices, sizeof(Vertex), vertices.data());
-
-        // Create the vertex buffer view.
-        m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
-        m_VertexBufferView.SizeInBytes = numVertices * sizeof(Vertex);
-        m_VertexBufferView.StrideInBytes = sizeof(Vertex);
-
-        // Upload index buffer data.
-        UpdateBufferResource(commandList, &m_IndexBuffer, &intermediateIndexBuffer,
-            numIndicies, sizeof(uint32_t), indicies.data());
-
-        // Create index buffer view.
-        m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
-        m_IndexBufferView.Format = DXGI_FORMAT_R32_UINT;
-        m_IndexBufferView.SizeInBytes = numIndicies * sizeof(uint32_t);
+        m_VertexBufferView = {};
+        m_IndexBufferView = {};
     }
 
     // constant upload buffer
@@ -478,6 +619,51 @@ void DXWindow::LoadAssets()
 
     // 2D texture
     ComPtr<ID3D12Resource> intermediateTextureBuffer;
+    std::wstring texturePath = GetAssetFullPath(L"model/african_head_diffuse.tga");
+    // std::wstring texturePath = GetAssetFullPath(L"model/bear.jpg");
+    if (texturePath.size() >= 4 && _wcsicmp(texturePath.c_str() + texturePath.size() - 4, L".tga") == 0)
+    {
+        // TGA 不经过 WIC，直接解码成 RGBA8 写进上传缓冲区
+        Util::MappedFile file(Util::ToByteString(texturePath));
+        auto data = reinterpret_cast<const uint8_t*>(file.Data());
+        TgaDecoder::Info info;
+        if (!file.IsOpen() || !TgaDecoder::ReadInfo(data, file.Size(), info)) throw std::runtime_error("unsupported TGA texture.");
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, info.width, info.height),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_texture)
+        ));
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        UINT64 bufferSize = 0;
+        auto textureDesc = m_texture->GetDesc();
+        m_device->GetCopyableFootprints(&textureDesc, 0, 1, 0, &footprint, nullptr, nullptr, &bufferSize);
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&intermediateTextureBuffer)
+        ));
+
+        // 行距按 footprint 的 RowPitch（256 字节对齐）
+        uint8_t* mapped = nullptr;
+        ThrowIfFailed(intermediateTextureBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+        bool decoded = TgaDecoder::Decode(data, file.Size(), mapped + footprint.Offset, footprint.Footprint.RowPitch);
+        intermediateTextureBuffer->Unmap(0, nullptr);
+        if (!decoded) throw std::runtime_error("corrupt TGA texture.");
+
+        CD3DX12_TEXTURE_COPY_LOCATION dst(m_texture.Get(), 0);
+        CD3DX12_TEXTURE_COPY_LOCATION src(intermediateTextureBuffer.Get(), footprint);
+        commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+    }
+    else
     {
         ComPtr<IWICImagingFactory> pIWICFactory;
         ThrowIfFailed(CoCreateInstance(
@@ -488,8 +674,7 @@ void DXWindow::LoadAssets()
         
         ComPtr<IWICBitmapDecoder> pIWICDecoder;
         ThrowIfFailed(pIWICFactory->CreateDecoderFromFilename(
-            GetAssetFullPath(L"model/african_head_diffuse.jpg").c_str(),
-            // GetAssetFullPath(L"model/bear.jpg").c_str(),
+            texturePath.c_str(),
             nullptr,
             GENERIC_READ,
             WICDecodeMetadataCacheOnDemand,
@@ -591,7 +776,8 @@ void DXWindow::LoadAssets()
         UpdateSubresources(commandList.Get(),
             m_texture.Get(), intermediateTextureBuffer.Get(),
             0, 0, 1, &subresourceData);
-
+    }
+    {
         CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
             m_texture.Get(),
             D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
@@ -599,7 +785,7 @@ void DXWindow::LoadAssets()
 
         m_textureView = {};
         m_textureView.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        m_textureView.Format = textureDesc.Format;
+        m_textureView.Format = m_texture->GetDesc().Format;
         m_textureView.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
         m_textureView.Texture2D.MipLevels = 1;
         m_device->CreateShaderResourceView(m_texture.Get(), &m_textureView, m_SRVDescriptorHeap->GetCPUHeapStartPtr());
@@ -607,72 +793,6 @@ void DXWindow::LoadAssets()
     
     // shadow map
     {
-        // shadow map PSO
-        {
-            ComPtr<ID3DBlob> vertexShader;
-            ComPtr<ID3DBlob> pixelShader;
-
-#if defined(_DEBUG)
-            UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-            UINT compileFlags = 0;
-#endif
-
-            ThrowIfFailed(D3DCompileFromFile(
-                GetShaderFullPath(L"shadow.hlsl").c_str(),
-                nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "VSMain", "vs_5_1",
-                compileFlags, 0, &vertexShader, nullptr
-            ));
-            ThrowIfFailed(D3DCompileFromFile(
-                GetShaderFullPath(L"shadow.hlsl").c_str(),
-                nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "PSMain", "ps_5_1",
-                compileFlags, 0, &pixelShader, nullptr
-            ));
-            
-
-            D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
-            {
-                { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-                { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-                { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-            };
-            
-            struct PipelineStateStream
-            {
-                CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
-                CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
-                CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
-                CD3DX12_PIPELINE_STATE_STREAM_VS VS;
-                CD3DX12_PIPELINE_STATE_STREAM_PS PS;
-                CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
-                CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS RTVFormats;
-                CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER Rasterizer;
-            };
-
-            D3D12_RT_FORMAT_ARRAY rtvFormats = {};
-            
-            PipelineStateStream shadowPipelineStateStream;
-            shadowPipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-            rtvFormats.NumRenderTargets = 0;
-            rtvFormats.RTFormats[0] = DXGI_FORMAT_UNKNOWN;
-            shadowPipelineStateStream.RTVFormats = rtvFormats;
-            shadowPipelineStateStream.pRootSignature = m_RootSignature.Get();
-            shadowPipelineStateStream.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-            shadowPipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-            shadowPipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
-            shadowPipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
-            CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
-            rasterizerDesc.DepthBias = 0;
-            rasterizerDesc.DepthBiasClamp = 0;
-            rasterizerDesc.SlopeScaledDepthBias = 1.f;
-            shadowPipelineStateStream.Rasterizer = CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER(rasterizerDesc);
-
-            D3D12_PIPELINE_STATE_STREAM_DESC shadowPipelineStateStreamDesc = {};
-            shadowPipelineStateStreamDesc.pPipelineStateSubobjectStream = &shadowPipelineStateStream;
-            shadowPipelineStateStreamDesc.SizeInBytes = sizeof(PipelineStateStream);
-            ThrowIfFailed(m_device->CreatePipelineState(&shadowPipelineStateStreamDesc, IID_PPV_ARGS(&m_shadowPipelineState)));
-        }
-
         // shadow map resource
         {
             m_shadowMapH = 2048;
@@ -797,8 +917,8 @@ void DXWindow::LoadAssets()
                 Vertex{XMFLOAT3(0.9, -0.9, 0), XMFLOAT3(0, 0, 1), XMFLOAT2(1, 1)}
             };
 
-            uint32_t indicies[] = { 0, 1, 2,  0, 2, 3};
-            // uint32_t indicies[] = { 0, 2, 1,  0, 3, 2};
+            uint16_t indicies[] = { 0, 1, 2,  0, 2, 3};
+            // uint16_t indicies[] = { 0, 2, 1,  0, 3, 2};
             
             UpdateBufferResource(commandList, &m_debugRectVertexBuffer, &debugIntermediateVertexBuffer,
                 _countof(vertices), sizeof(Vertex), vertices);
@@ -810,12 +930,12 @@ void DXWindow::LoadAssets()
 
             // Upload index buffer data.
             UpdateBufferResource(commandList, &m_debugRectIndexBuffer, &debugIntermediateIndexBuffer,
-                _countof(indicies), sizeof(uint32_t), indicies);
+                _countof(indicies), sizeof(uint16_t), indicies);
 
             // Create index buffer view.
             m_debugRectIndexBufferView.BufferLocation = m_debugRectIndexBuffer->GetGPUVirtualAddress();
-            m_debugRectIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
-            m_debugRectIndexBufferView.SizeInBytes = _countof(indicies) * sizeof(uint32_t);
+            m_debugRectIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+            m_debugRectIndexBufferView.SizeInBytes = _countof(indicies) * sizeof(uint16_t);
         }
     }
     m_commandQueue->ExecuteCommandList(commandList);
@@ -839,6 +959,10 @@ void DXWindow::Init(HWND hWnd)
 void DXWindow::Destroy()
 {
     m_commandQueue->Destory();
+    m_pendingModel.reset();
+    // 先停止后台加载，再释放它使用的 copy queue
+    m_streamingMesh.reset();
+    m_uploadDevice.reset();
     m_device->Release();
 
     m_swapChain.reset();
@@ -850,8 +974,8 @@ void DXWindow::Destroy()
 
     m_RootSignature->Release();
     m_PipelineState->Release();
-    m_VertexBuffer->Release();
-    m_IndexBuffer->Release();
+    if (m_VertexBuffer) m_VertexBuffer->Release();
+    if (m_IndexBuffer) m_IndexBuffer->Release();
     m_DepthBuffer->Release();
 
     m_texture->Release();
@@ -943,15 +1067,18 @@ void DXWindow::Update()
     // m_ModelMatrix = XMMatrixMultiply(XMMatrixMultiply(scale, rotation), translation); // C-style
     m_ModelMatrix = scale * rotation * translation;
 
+    SwapInPendingModel();
+    UpdateStreamingMesh();
+
     // Update the MVP matrix
     // XMMATRIX mvpMatrix = XMMatrixMultiply(m_ModelMatrix, m_ViewMatrix);
     // mvpMatrix = XMMatrixMultiply(mvpMatrix, m_ProjectionMatrix); // C-style
     // DXMath中矩阵是行主序，hlsl中是列主序，在C++层面做一层转置效率更高
-    auto mvp = m_ModelMatrix * m_camera->GetViewMatrix() * m_camera->GetProjectionMatrix();
+    auto mvp = m_positionDecodeMatrix * m_ModelMatrix * m_camera->GetViewMatrix() * m_camera->GetProjectionMatrix();
     g_MVPCB.mvp = XMMatrixTranspose(mvp);
     // mvp.r[3] = XMVectorSet(0.f, 0.f, 0.f, 1.f);
     g_MVPCB.modelMatrixNegaTrans = XMMatrixInverse(nullptr, m_ModelMatrix);
-    g_MVPCB.modelMatrix = XMMatrixTranspose(m_ModelMatrix);
+    g_MVPCB.modelMatrix = XMMatrixTranspose(m_positionDecodeMatrix * m_ModelMatrix);
 
     g_passData.eyePos = m_camera->GetPosition();
     angle = static_cast<float>(totalTime);
@@ -960,7 +1087,100 @@ void DXWindow::Update()
     // g_passData.lightPos = XMFLOAT4(0.f, 0.f, -2.f, 1.f);
 }
 
-inline XMMATRIX ShadowData()
+// 异步加载完成后换掉占位模型。换之前等 GPU 空闲，旧的缓冲和 PSO 可能还在使用；加载失败时保留占位模型
+void DXWindow::SwapInPendingModel()
+{
+    if (m_pendingModel == nullptr || !m_pendingModel->IsDone()) return;
+    auto handle = std::move(m_pendingModel);
+
+    std::shared_ptr<Model> model;
+    try
+    {
+        model = handle->Get();
+    }
+    catch (const std::exception& e)
+    {
+        OutputDebugStringA((std::string("async model load failed: ") + e.what() + "\n").c_str());
+        return;
+    }
+
+    m_commandQueue->Flush();
+    auto previousFormat = m_model->GetVertexFormat();
+    m_model = model;
+    if (m_model->GetVertexFormat() != previousFormat) CreateModelPipelineStates(m_model->GetVertexFormat(), false);
+
+    auto commandList = m_commandQueue->GetCommandList(nullptr);
+    ComPtr<ID3D12Resource> intermediateVertexBuffer;
+    ComPtr<ID3D12Resource> intermediateIndexBuffer;
+    UploadModel(commandList, intermediateVertexBuffer, intermediateIndexBuffer);
+    m_commandQueue->WaitForFenceValue(m_commandQueue->ExecuteCommandList(commandList));
+
+    auto readySeconds = std::chrono::duration<double>(
+        std::chrono::high_resolution_clock::now() - Application::GetInstance()->GetStartTime()).count();
+    char buffer[500];
+    sprintf_s(buffer, 500, "model ready: %.1f ms after start (queued %.1f ms, load %.1f ms)\n",
+        readySeconds * 1e3, handle->GetWaitSeconds() * 1e3, handle->GetLoadSeconds() * 1e3);
+    OutputDebugStringA(buffer);
+}
+
+// 流式加载时已经可见的部分：先读可见数量再取缓冲，扩容后的新缓冲包含之前所有拷贝完成的数据。
+// 位置按目前的包围盒归一化到 [-1,1]，和 Model::Reconstruct 一致
+void DXWindow::UpdateStreamingMesh()
+{
+    if (m_streamingMesh == nullptr) return;
+
+    auto numVertices = m_streamingMesh->GetVisibleVertexCount();
+    auto numIndicies = m_streamingMesh->GetVisibleIndexCount();
+    auto vertexBuffer = m_uploadDevice->GetBuffer(UploadRing::Target::Vertex);
+    auto indexBuffer = m_uploadDevice->GetBuffer(UploadRing::Target::Index);
+    if (numIndicies == 0 || vertexBuffer == nullptr || indexBuffer == nullptr) return;
+
+    m_VertexBufferView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
+    m_VertexBufferView.SizeInBytes = numVertices * sizeof(Vertex);
+    m_VertexBufferView.StrideInBytes = sizeof(Vertex);
+    m_IndexBufferView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
+    m_IndexBufferView.Format = DXGI_FORMAT_R32_UINT;
+    m_IndexBufferView.SizeInBytes = numIndicies * sizeof(uint32_t);
+
+    auto bounds = m_streamingMesh->GetBounds();
+    float range = std::max({bounds.max[0] - bounds.min[0], bounds.max[1] - bounds.min[1], bounds.max[2] - bounds.min[2]}) / 2;
+    if (!(range > 0.f)) return;
+    m_positionDecodeMatrix = XMMatrixTranslation(
+            -(bounds.max[0] + bounds.min[0]) / 2, -(bounds.max[1] + bounds.min[1]) / 2, -(bounds.max[2] + bounds.min[2]) / 2) *
+        XMMatrixScaling(1.f / range, 1.f / range, 1.f / range);
+}
+
+// 场景包围球：模型的包围球和地板（y = -1 处 4x4 的正方形）的包围球合并后变换到世界空间
+static void SceneBoundingSphere(const XMFLOAT3& modelCenter, float modelRadius, const XMMATRIX& modelMatrix, XMVECTOR& center, float& radius)
+{
+    XMVECTOR a = XMLoadFloat3(&modelCenter);
+    XMVECTOR b = XMVectorSet(0.f, -1.f, 0.f, 1.f);
+    float ra = modelRadius;
+    float rb = std::sqrt(8.f);
+    float d = XMVectorGetX(XMVector3Length(XMVectorSubtract(b, a)));
+    if (d + rb <= ra)
+    {
+        center = a;
+        radius = ra;
+    }
+    else if (d + ra <= rb)
+    {
+        center = b;
+        radius = rb;
+    }
+    else
+    {
+        radius = (d + ra + rb) / 2;
+        center = XMVectorLerp(a, b, (radius - ra) / d);
+    }
+
+    center = XMVector3TransformCoord(XMVectorSetW(center, 1.f), modelMatrix);
+    float scale = std::max({XMVectorGetX(XMVector3Length(modelMatrix.r[0])),
+        XMVectorGetX(XMVector3Length(modelMatrix.r[1])), XMVectorGetX(XMVector3Length(modelMatrix.r[2]))});
+    radius *= scale;
+}
+
+inline XMMATRIX ShadowData(FXMVECTOR sceneCenter, float sceneRadius)
 {
     // 主光才投射物体阴影
 	// XMVECTOR lightDir = XMLoadFloat3(&mRotatedLightDir[0]);
@@ -974,15 +1194,15 @@ inline XMMATRIX ShadowData()
 
 	// 将包围球变换到光源空间
 	XMFLOAT3 sphereCenterLS;
-	XMStoreFloat3(&sphereCenterLS, XMVector3TransformCoord(targetPos, lightView));
+	XMStoreFloat3(&sphereCenterLS, XMVector3TransformCoord(sceneCenter, lightView));
 
 	// 位于光源空间中包围场景的正交投影视景体
-	float l = sphereCenterLS.x - 3;//左端点
-	float b = sphereCenterLS.y - 3;//下端点
-	float n = sphereCenterLS.z - 3;//近端点
-	float r = sphereCenterLS.x + 3;//右端点
-	float t = sphereCenterLS.y + 3;//上端点
-	float f = sphereCenterLS.z + 3;//远端点
+	float l = sphereCenterLS.x - sceneRadius;//左端点
+	float b = sphereCenterLS.y - sceneRadius;//下端点
+	float n = sphereCenterLS.z - sceneRadius;//近端点
+	float r = sphereCenterLS.x + sceneRadius;//右端点
+	float t = sphereCenterLS.y + sceneRadius;//上端点
+	float f = sphereCenterLS.z + sceneRadius;//远端点
 
 	//构建LightToProject矩阵（灯光空间转NDC空间）
 	XMMATRIX lightProj = XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
@@ -1009,11 +1229,19 @@ inline void DXWindow::UpdateShadowPassData(ComPtr<ID3D12GraphicsCommandList2>& c
     // TODO: 现在是平行光照，从pos照向原点
     Camera* lightView = new OrthographicCamera(m_shadowMapW, m_shadowMapH, 0.1f, 100.f, g_passData.lightPos);
     MVPData lightMVP;
-    auto mvp = ShadowData();
+    // 正交视景体按场景包围球拟合，模型的包围球在加载时算好
+    XMVECTOR sceneCenter;
+    float sceneRadius;
+    // 流式加载的模型归一化到 [-1,1]，用盒子的外接球
+    XMFLOAT3 modelCenter(0.f, 0.f, 0.f);
+    float modelRadius = std::sqrt(3.f);
+    if (m_model) m_model->GetBoundingSphere(modelCenter, modelRadius);
+    SceneBoundingSphere(modelCenter, modelRadius, m_ModelMatrix, sceneCenter, sceneRadius);
+    auto mvp = ShadowData(sceneCenter, sceneRadius);
     // auto mvp = lightView->GetViewMatrix() * lightView->GetProjectionMatrix();
     lightMVP.mvp = XMMatrixTranspose(mvp);
     lightMVP.modelMatrixNegaTrans = XMMatrixInverse(nullptr, m_ModelMatrix);
-    lightMVP.modelMatrix = XMMatrixTranspose(m_ModelMatrix);
+    lightMVP.modelMatrix = XMMatrixTranspose(m_positionDecodeMatrix * m_ModelMatrix);
 
     BYTE* gpuMVPCB = g_gpuMVPCB + g_mvpSize;
     BYTE* gpuPassData = g_gpuPassData + g_passDataSize;
@@ -1026,6 +1254,21 @@ inline void DXWindow::UpdateShadowPassData(ComPtr<ID3D12GraphicsCommandList2>& c
     delete lightView;
 }
 
+// 16 位索引的大模型被切成多个子网格，每个子网格一次 draw；流式加载时只画已经可见的三角形
+void DXWindow::DrawModel(ComPtr<ID3D12GraphicsCommandList2>& commandList)
+{
+    if (m_streamingMesh)
+    {
+        auto numIndicies = m_IndexBufferView.SizeInBytes / sizeof(uint32_t);
+        if (numIndicies > 0) commandList->DrawIndexedInstanced(numIndicies, 1, 0, 0, 0);
+        return;
+    }
+    for (auto& submesh: m_model->GetSubmeshes())
+    {
+        commandList->DrawIndexedInstanced(submesh.indexCount, 1, submesh.indexOffset, submesh.baseVertex, 0);
+    }
+}
+
 void DXWindow::ShadowPass(ComPtr<ID3D12GraphicsCommandList2>& commandList)
 {
     commandList->SetPipelineState(m_shadowPipelineState.Get());
@@ -1047,7 +1290,7 @@ void DXWindow::ShadowPass(ComPtr<ID3D12GraphicsCommandList2>& commandList)
     commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     commandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
     commandList->IASetIndexBuffer(&m_IndexBufferView);
-    commandList->DrawIndexedInstanced(m_model->GetIndiciesNum(), 1, 0, 0, 0);
+    DrawModel(commandList);
 
     commandList->ResourceBarrier(1,
         &CD3DX12_RESOURCE_BARRIER::Transition(m_shadowMap.Get(),
@@ -1089,7 +1332,7 @@ void DXWindow::Render()
     commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     commandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
     commandList->IASetIndexBuffer(&m_IndexBufferView);
-    commandList->DrawIndexedInstanced(m_model->GetIndiciesNum(), 1, 0, 0, 0);
+    DrawModel(commandList);
 
     // shadow debug
     commandList->SetPipelineState(m_shadowDebugPipelineState.Get());
@@ -1099,6 +1342,18 @@ void DXWindow::Render()
     commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
     m_swapChain->Present(commandList);
+
+    // 首帧时间：从 Application 创建到第一次 Present
+    if (!m_firstFramePresented)
+    {
+        m_firstFramePresented = true;
+        auto firstFrameSeconds = std::chrono::duration<double>(
+            std::chrono::high_resolution_clock::now() - Application::GetInstance()->GetStartTime()).count();
+        char buffer[500];
+        sprintf_s(buffer, 500, "first frame: %.1f ms after start%s\n",
+            firstFrameSeconds * 1e3, m_pendingModel ? " (placeholder model)" : "");
+        OutputDebugStringA(buffer);
+    }
 }
 
 void DXWindow::UpdateWindowRect(uint32_t width, uint32_t height)
@@ -1218,6 +1473,47 @@ void DXWindow::ResizeDepthBuffer(uint32_t width, uint32_t height)
         m_DSVDescriptorHeap->GetCPUHeapStartPtr());
 }
 
+bool DXWindow::Pick(int x, int y, PickResult& result)
+{
+    // 流式显示的网格不在 CPU 上保留完整的索引，占位模型也不拾取
+    if (m_model == nullptr || m_pendingModel != nullptr) return false;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (!m_model->HasBvh()) m_model->BuildBvh();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // 像素中心在近平面和远平面上的点反投影回模型空间，CPU 上的顶点没有量化，不需要 m_positionDecodeMatrix
+    auto view = m_camera->GetViewMatrix();
+    auto projection = m_camera->GetProjectionMatrix();
+    float px = x + 0.5f;
+    float py = y + 0.5f;
+    float width = static_cast<float>(m_width);
+    float height = static_cast<float>(m_height);
+    XMVECTOR nearPoint = XMVector3Unproject(XMVectorSet(px, py, 0.f, 1.f), 0.f, 0.f, width, height, 0.f, 1.f,
+        projection, view, m_ModelMatrix);
+    XMVECTOR farPoint = XMVector3Unproject(XMVectorSet(px, py, 1.f, 1.f), 0.f, 0.f, width, height, 0.f, 1.f,
+        projection, view, m_ModelMatrix);
+
+    // t 在 [0, 1) 内即在视锥内
+    ModelHit hit;
+    bool found = m_model->Intersect(nearPoint, farPoint - nearPoint, 1.f, hit);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    if (t1 - t0 > std::chrono::milliseconds(1))
+    {
+        char buffer[500];
+        sprintf_s(buffer, 500, "pick: built BVH in %.1f ms\n", std::chrono::duration<double>(t1 - t0).count() * 1e3);
+        OutputDebugStringA(buffer);
+    }
+    if (!found) return false;
+
+    result.triangle = hit.triangle;
+    result.barycentrics = hit.barycentrics;
+    XMStoreFloat3(&result.worldPosition, XMVector3TransformCoord(XMLoadFloat3(&hit.position), m_ModelMatrix));
+    result.seconds = std::chrono::duration<double>(t2 - t1).count();
+    return true;
+}
+
 LRESULT DXWindow::OnWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     if (IsInitialized())
@@ -1256,6 +1552,19 @@ LRESULT DXWindow::OnWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPara
         // not handled.
         case WM_SYSCHAR:
         break;
+        case WM_LBUTTONDOWN:
+        {
+            PickResult pick;
+            if (Pick(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), pick))
+            {
+                char buffer[500];
+                sprintf_s(buffer, 500, "pick: triangle %u, barycentrics (%.3f, %.3f), position (%.4f, %.4f, %.4f), %.3f ms\n",
+                    pick.triangle, pick.barycentrics.x, pick.barycentrics.y,
+                    pick.worldPosition.x, pick.worldPosition.y, pick.worldPosition.z, pick.seconds * 1e3);
+                OutputDebugStringA(buffer);
+            }
+        }
+        break;
         case WM_SIZE:
         {
             RECT clientRect = {};
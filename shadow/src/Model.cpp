@@ -1,99 +1,402 @@
 #include "Model.h"
 #include "path.h"
 #include "common/ModelLoader.h"
+#include "common/MeshCache.h"
+#include "common/MeshOptimizer.h"
+#include "common/MeshNormals.h"
+#include "common/MeshTangents.h"
+#include "common/Utility.h"
+
+#include <algorithm>
 
 std::wstring Model::GetModelFullPath(std::wstring model_name)
 {
     return std::wstring(model_path) + model_name;
 }
 
-Model::Model(std::wstring model_name, ModelType type, bool reconstruct) noexcept
+std::wstring Model::GetCacheFullPath(std::wstring& filePath)
 {
-    auto loader = ModelLoader::CreateModelLoader(type);
-    loader->LoadFromFile(Model::GetModelFullPath(model_name));
+    return filePath + L".meshcache";
+}
+
+Model::Model(std::wstring model_name, ModelType type, bool reconstruct, bool useCache, bool spatialSort, VertexFormat vertexFormat,
+    bool tangents)
+{
+    auto filePath = Model::GetModelFullPath(model_name);
+
+    MeshCache::Key key;
+    uint32_t options = static_cast<uint32_t>(type) | (reconstruct ? 1u << 8 : 0u) | (spatialSort ? 1u << 9 : 0u) |
+        (tangents ? 1u << 10 : 0u);
+    useCache = useCache && MeshCache::MakeKey(Util::ToByteString(filePath), options, sizeof(Vertex), key);
+
+    if (!useCache || !LoadFromCache(filePath, key))
+    {
+        LoadFromFile(filePath, type, reconstruct, spatialSort, tangents);
+        if (useCache) SaveToCache(filePath, key);
+    }
+
+    AddFloor();
+    BuildIndexBuffer();
+    BuildVertexBuffer(vertexFormat);
+}
+
+void Model::LoadFromFile(std::wstring& filePath, ModelType type, bool reconstruct, bool spatialSort, bool tangents)
+{
+    auto loader = ModelLoader<float>::CreateModelLoader(type);
+    loader->LoadFromFile(filePath);
     if (reconstruct)
     {
         loader->Reconstruct();
     }
     
-    auto positions = loader->GetPositions();
-    auto uvws = loader->GetUVWs();
-    m_vertices = std::vector<Vertex>(positions.size());
-    for (int i = 0; i < m_vertices.size(); ++i)
+    // loader 中的数组转换完立即释放，避免两份顶点数据同时存在
     {
-        m_vertices[i].position = XMFLOAT3(positions[i][0], positions[i][1], positions[i][2]);
-        m_vertices[i].normal   = XMFLOAT3(0.f, 0.f, 0.f);
-        m_vertices[i].uv       = XMFLOAT2(uvws[i][0], 1-uvws[i][1]);
+        auto positions = loader->TakePositions();
+        auto uvws = loader->TakeUVWs();
+        m_vertices = std::vector<Vertex>(positions.size());
+        for (size_t i = 0; i < m_vertices.size(); ++i)
+        {
+            m_vertices[i].position = XMFLOAT3(positions[i][0], positions[i][1], positions[i][2]);
+            m_vertices[i].normal   = XMFLOAT3(0.f, 0.f, 0.f);
+            m_vertices[i].uv       = XMFLOAT2(uvws[i][0], 1-uvws[i][1]);
+        }
     }
 
-    auto indicies = loader->GetIndicies();
-    m_indicies.swap(indicies);
+    m_indicies = loader->TakeIndicies();
 
     auto normals = loader->GetNormals();
     if (normals.size() == 0) CalculateVertexNormal();
     else
     {
-        for (int i = 0; i < m_vertices.size(); ++i)
+        for (size_t i = 0; i < m_vertices.size(); ++i)
         {
             auto ret = XMVector3Normalize(XMVectorSet(normals[i][0], normals[i][1], normals[i][2], 0.f));
             XMStoreFloat3(&m_vertices[i].normal, ret);
         }
     }
-    
+
+    // 镜像接缝拆分出的顶点随后和其它顶点一起重排
+    if (tangents) CalculateTangents();
+    CalculateBounds(loader->GetBounds());
+    Optimize(spatialSort);
+    // 按最终的三角形顺序切分 meshlet，随缓存保存
+    if (!m_vertices.empty())
+        m_meshlets = MeshletBuilder::Build(m_indicies.data(), m_indicies.size(), &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+}
+
+// 源文件中的三角形和顶点顺序对 GPU 不友好，从源文件加载时重排一次，结果随缓存保存
+void Model::Optimize(bool spatialSort)
+{
+    if (m_vertices.empty()) return;
+
+    std::vector<uint32_t> remap(m_vertices.size());
+    if (spatialSort)
+    {
+        // 扫描得到的模型文件顺序没有空间连续性，先按 Morton 曲线排列顶点和三角形
+        MeshOptimizer::SpatialSortRemap(remap.data(), &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+        MeshOptimizer::RemapIndexBuffer(m_indicies.data(), m_indicies.size(), remap.data());
+        MeshOptimizer::RemapVertexBuffer(m_vertices.data(), m_vertices.size(), sizeof(Vertex), remap.data());
+        if (!m_tangents.empty()) MeshOptimizer::RemapVertexBuffer(m_tangents.data(), m_tangents.size(), sizeof(uint32_t), remap.data());
+        MeshOptimizer::SpatialSortTriangles(m_indicies.data(), m_indicies.size(), &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+    }
+
+    MeshOptimizer::OptimizeVertexCache(m_indicies.data(), m_indicies.size(), m_vertices.size());
+    // 按簇重排减少主 pass 和 shadow pass 的 overdraw，顶点缓存命中率损失控制在 5% 内。
+    // 大模型在每个 16 位子网格内部重排，簇不会跨子网格打乱，BuildIndexBuffer 切分时复制的顶点更少
+    // 段内重排和之后的顶点重新编号都不改变每段引用的顶点，分界保存下来给 BuildIndexBuffer 使用
+    m_submeshRanges = SplitSubmeshes(m_indicies, m_vertices.size());
+    auto& ranges = m_submeshRanges;
+    for (size_t i = 0; i + 1 < ranges.size(); i++)
+    {
+        MeshOptimizer::OptimizeOverdraw(m_indicies.data() + size_t(ranges[i]) * 3, size_t(ranges[i + 1] - ranges[i]) * 3,
+            &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+    }
+
+    // 顶点按三角形第一次引用的顺序重新编号
+    MeshOptimizer::OptimizeVertexFetchRemap(remap.data(), m_indicies.data(), m_indicies.size(), m_vertices.size());
+    MeshOptimizer::RemapIndexBuffer(m_indicies.data(), m_indicies.size(), remap.data());
+    MeshOptimizer::RemapVertexBuffer(m_vertices.data(), m_vertices.size(), sizeof(Vertex), remap.data());
+    if (!m_tangents.empty()) MeshOptimizer::RemapVertexBuffer(m_tangents.data(), m_tangents.size(), sizeof(uint32_t), remap.data());
+}
+
+bool Model::LoadFromCache(std::wstring& filePath, const MeshCache::Key& key)
+{
+    MeshCache::CacheFile cache;
+    if (!cache.Open(Util::ToByteString(GetCacheFullPath(filePath)), key)) return false;
+
+    // 直接解码到数组里，损坏的缓存当作过期处理
+    auto& header = cache.GetHeader();
+    m_vertices.resize(header.vertexCount);
+    m_indicies.resize(header.indexCount);
+    m_tangents.resize(header.tangentCount);
+    auto submeshRanges = cache.GetSubmeshRanges();
+    m_submeshRanges.assign(submeshRanges, submeshRanges + header.submeshRangeCount);
+    // 子网格分界要覆盖全部三角形
+    bool validRanges = m_submeshRanges.empty() ? m_indicies.empty() :
+        m_submeshRanges.front() == 0 && m_submeshRanges.back() == m_indicies.size() / 3 &&
+        std::is_sorted(m_submeshRanges.begin(), m_submeshRanges.end());
+    if (!validRanges || !cache.DecodeVertices(m_vertices.data()) || !cache.DecodeIndicies(m_indicies.data()) ||
+        !cache.DecodeTangents(m_tangents.data()))
+    {
+        m_submeshRanges.clear();
+        m_vertices.clear();
+        m_indicies.clear();
+        m_tangents.clear();
+        return false;
+    }
+    m_boundsMin = XMFLOAT3(header.boundsMin);
+    m_boundsMax = XMFLOAT3(header.boundsMax);
+    m_boundingSphere = XMFLOAT4(header.boundingSphere);
+
+    auto meshlets = cache.GetMeshlets();
+    auto meshletBounds = cache.GetMeshletBounds();
+    auto meshletVertices = cache.GetMeshletVertices();
+    auto meshletTriangles = cache.GetMeshletTriangles();
+    m_meshlets.meshlets.assign(meshlets, meshlets + header.meshletCount);
+    m_meshlets.bounds.assign(meshletBounds, meshletBounds + header.meshletCount);
+    m_meshlets.vertices.assign(meshletVertices, meshletVertices + header.meshletVertexCount);
+    m_meshlets.triangles.assign(meshletTriangles, meshletTriangles + header.meshletTriangleCount);
+    // meshlet 的范围和索引不对的话 BuildIndexBuffer 重映射时会越界
+    if (!MeshletBuilder::IsValid(m_meshlets, m_vertices.size()))
+    {
+        m_meshlets = MeshletBuilder::MeshletData();
+        m_submeshRanges.clear();
+        m_vertices.clear();
+        m_indicies.clear();
+        m_tangents.clear();
+        return false;
+    }
+    return true;
+}
+
+void Model::SaveToCache(std::wstring& filePath, const MeshCache::Key& key) const
+{
+    // 写缓存失败不影响模型本身
+    MeshCache::Write(Util::ToByteString(GetCacheFullPath(filePath)), key,
+        m_vertices.data(), m_vertices.size(),
+        m_indicies.data(), m_indicies.size(),
+        m_tangents.data(), m_tangents.size(),
+        m_submeshRanges.data(), m_submeshRanges.size(),
+        &m_boundsMin.x, &m_boundsMax.x, &m_boundingSphere.x,
+        m_meshlets);
+}
+
+void Model::CalculateBounds(const MeshBounds::Aabb<float>& aabb)
+{
+    if (m_vertices.empty() || aabb.IsEmpty()) return;
+
+    m_boundsMin = XMFLOAT3(aabb.min);
+    m_boundsMax = XMFLOAT3(aabb.max);
+    auto sphere = MeshBounds::ComputeSphere(&m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex), aabb);
+    m_boundingSphere = XMFLOAT4(sphere.center[0], sphere.center[1], sphere.center[2], sphere.radius);
+}
+
+void Model::AddFloor()
+{
     m_vertices.push_back(Vertex{XMFLOAT3( 2,-1,-2), XMFLOAT3(0,1,0), XMFLOAT2(0,0)});
     m_vertices.push_back(Vertex{XMFLOAT3( 2,-1, 2), XMFLOAT3(0,1,0), XMFLOAT2(0,0)});
     m_vertices.push_back(Vertex{XMFLOAT3(-2,-1, 2), XMFLOAT3(0,1,0), XMFLOAT2(0,0)});
     m_vertices.push_back(Vertex{XMFLOAT3(-2,-1,-2), XMFLOAT3(0,1,0), XMFLOAT2(0,0)});
+    if (!m_tangents.empty())
+    {
+        const float tangent[4] = {1.f, 0.f, 0.f, 1.f};
+        m_tangents.resize(m_vertices.size(), MeshTangents::PackTangent(tangent));
+    }
     auto numVertices = m_vertices.size();
     m_indicies.push_back(numVertices-4);m_indicies.push_back(numVertices-1);m_indicies.push_back(numVertices-3);
     m_indicies.push_back(numVertices-3);m_indicies.push_back(numVertices-1);m_indicies.push_back(numVertices-2);
 }
 
-static DirectX::XMVECTOR operator-(const DirectX::XMFLOAT3& A, const DirectX::XMFLOAT3& B)
+// 顶点数不超过 65536 时整个模型直接使用 16 位索引。更大的模型按 SplitSubmeshes 切成子网格，
+// 每个子网格的顶点连续排列并用 base vertex 偏移，子网格边界上共享的顶点会复制一份。
+// 复制导致顶点数增加超过 10% 时保持 32 位索引
+void Model::BuildIndexBuffer()
 {
-    return DirectX::XMVectorSet(A.x - B.x, A.y - B.y, A.z - B.z, 0.f);
+    m_indicies16.resize(m_indicies.size());
+    m_submeshes.clear();
+
+    if (m_vertices.size() <= S_SUBMESH_VERTICES)
+    {
+        for (size_t i = 0; i < m_indicies.size(); i++)
+        {
+            m_indicies16[i] = static_cast<uint16_t>(m_indicies[i]);
+        }
+        m_submeshes.push_back(Submesh{0, static_cast<uint32_t>(m_indicies.size()), 0});
+        m_indexFormat = IndexFormat::UInt16;
+        return;
+    }
+
+    const uint32_t none = UINT32_MAX;
+    std::vector<uint32_t> submeshOf(m_vertices.size(), none);
+    std::vector<uint32_t> localIndex(m_vertices.size());
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> tangents;
+    std::vector<uint32_t> indicies(m_indicies.size());
+    vertices.reserve(m_vertices.size());
+
+    // Optimize 的分界之后是地板，单独成一个子网格
+    std::vector<uint32_t> ranges = m_submeshRanges;
+    if (ranges.empty()) ranges.push_back(0);
+    auto triangleCount = static_cast<uint32_t>(m_indicies.size() / 3);
+    if (ranges.back() < triangleCount) ranges.push_back(triangleCount);
+    for (uint32_t submesh = 0; submesh + 1 < ranges.size(); submesh++)
+    {
+        auto baseVertex = static_cast<uint32_t>(vertices.size());
+        for (size_t i = size_t(ranges[submesh]) * 3; i < size_t(ranges[submesh + 1]) * 3; i++)
+        {
+            uint32_t v = m_indicies[i];
+            if (submeshOf[v] != submesh)
+            {
+                submeshOf[v] = submesh;
+                localIndex[v] = static_cast<uint32_t>(vertices.size()) - baseVertex;
+                vertices.push_back(m_vertices[v]);
+                if (!m_tangents.empty()) tangents.push_back(m_tangents[v]);
+            }
+            m_indicies16[i] = static_cast<uint16_t>(localIndex[v]);
+            indicies[i] = baseVertex + localIndex[v];
+        }
+        m_submeshes.push_back(Submesh{static_cast<uint32_t>(ranges[submesh] * 3),
+            static_cast<uint32_t>((ranges[submesh + 1] - ranges[submesh]) * 3), static_cast<int32_t>(baseVertex)});
+    }
+
+    if (vertices.size() * 10 > m_vertices.size() * 11)
+    {
+        m_indicies16.clear();
+        m_indicies16.shrink_to_fit();
+        m_submeshes.assign(1, Submesh{0, static_cast<uint32_t>(m_indicies.size()), 0});
+        m_indexFormat = IndexFormat::UInt32;
+        return;
+    }
+
+    // 没有被三角形引用的顶点保留在最后。meshlet 引用每个顶点第一次复制的位置
+    std::vector<uint32_t> remap(m_vertices.size(), none);
+    for (size_t i = 0; i < m_indicies.size(); i++)
+    {
+        if (remap[m_indicies[i]] == none) remap[m_indicies[i]] = indicies[i];
+    }
+    for (size_t v = 0; v < m_vertices.size(); v++)
+    {
+        if (submeshOf[v] == none)
+        {
+            remap[v] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(m_vertices[v]);
+            if (!m_tangents.empty()) tangents.push_back(m_tangents[v]);
+        }
+    }
+    for (auto& v: m_meshlets.vertices)
+    {
+        v = remap[v];
+    }
+    m_vertices.swap(vertices);
+    m_tangents.swap(tangents);
+    m_indicies.swap(indicies);
+    m_indexFormat = IndexFormat::UInt16;
 }
-static DirectX::XMFLOAT3 operator+=(DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+
+// 量化范围取包括地板在内的全部顶点的包围盒，CPU 端仍保留 float 顶点
+void Model::BuildVertexBuffer(VertexFormat vertexFormat)
 {
-    a.x += b.x;
-    a.y += b.y;
-    a.z += b.z;
-    return a;
+    m_vertexFormat = vertexFormat;
+    m_quantization = VertexQuantizer::QuantizationParams();
+    m_quantizedVertices.clear();
+    if (vertexFormat != VertexFormat::Quantized || m_vertices.empty()) return;
+
+    m_quantization = VertexQuantizer::ComputeQuantization(&m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+    m_quantizedVertices.resize(m_vertices.size());
+    VertexQuantizer::Encode(m_quantizedVertices.data(), &m_vertices[0].position.x, &m_vertices[0].normal.x, &m_vertices[0].uv.x,
+        m_vertices.size(), sizeof(Vertex), m_quantization);
 }
 
-void Model::CalculateVertexNormal()
+// 按三角形顺序贪心切分，每段引用的不同顶点数不超过 S_SUBMESH_VERTICES。
+// 返回三角形下标的分界点，第 i 段为 [ranges[i], ranges[i + 1])
+std::vector<uint32_t> Model::SplitSubmeshes(const std::vector<uint32_t>& indicies, size_t vertexCount)
 {
-    for (int i = 0; i + 2 < m_indicies.size(); i += 3)
+    auto triangleCount = static_cast<uint32_t>(indicies.size() / 3);
+    std::vector<uint32_t> ranges{0};
+    if (vertexCount <= S_SUBMESH_VERTICES)
     {
-        auto A = m_vertices[m_indicies[i    ]].position;
-        auto B = m_vertices[m_indicies[i + 1]].position;
-        auto C = m_vertices[m_indicies[i + 2]].position;
-        auto AB = B - A;
-        auto AC = C - A;
-
-        DirectX::XMFLOAT3 normal;
-        XMStoreFloat3(&normal, XMVector3Cross(AB, AC));
+        ranges.push_back(triangleCount);
+        return ranges;
+    }
 
-        m_vertices[m_indicies[i    ]].normal += normal;
-        m_vertices[m_indicies[i + 1]].normal += normal;
-        m_vertices[m_indicies[i + 2]].normal += normal;
+    std::vector<uint32_t> submeshOf(vertexCount, UINT32_MAX);
+    uint32_t submesh = 0;
+    uint32_t used = 0;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        const uint32_t* triangle = &indicies[size_t(t) * 3];
+        uint32_t added = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+            if (submeshOf[triangle[k]] != submesh && !repeated) added++;
+        }
+        if (used + added > S_SUBMESH_VERTICES)
+        {
+            ranges.push_back(t);
+            submesh++;
+            used = 0;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            if (submeshOf[triangle[k]] != submesh)
+            {
+                submeshOf[triangle[k]] = submesh;
+                used++;
+            }
+        }
     }
+    if (ranges.back() != triangleCount) ranges.push_back(triangleCount);
+    return ranges;
+}
+
+// 按顶点收集相邻三角形的法线，邻接表只建一次，顶点之间可以并行
+void Model::CalculateVertexNormal()
+{
+    if (m_vertices.empty()) return;
+    auto adjacency = MeshNormals::BuildAdjacency(m_indicies.data(), m_indicies.size(), m_vertices.size());
+    MeshNormals::ComputeNormals(&m_vertices[0].normal.x, &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex),
+        m_indicies.data(), m_indicies.size(), adjacency, MeshNormals::Weighting::Area);
+}
 
-    for (int i = 0; i < m_vertices.size(); ++i)
+// Model 的 uv 已经翻转了 v，切线空间按 DirectX 的纹理坐标计算。镜像 UV 接缝上的顶点先复制一份，
+// 每个顶点只有一种手性，复制的顶点接在最后，之后的 Optimize 会一起重排
+void Model::CalculateTangents()
+{
+    if (m_vertices.empty()) return;
+    auto adjacency = MeshNormals::BuildAdjacency(m_indicies.data(), m_indicies.size(), m_vertices.size());
+    auto sources = MeshTangents::SplitMirrored(m_indicies.data(), m_indicies.size(), m_vertices.size(),
+        &m_vertices[0].uv.x, sizeof(Vertex), adjacency);
+    if (!sources.empty())
     {
-        auto ret = XMVector3Normalize(XMLoadFloat3(&m_vertices[i].normal));
-        XMStoreFloat3(&m_vertices[i].normal, ret);
+        m_vertices.reserve(m_vertices.size() + sources.size());
+        for (auto source: sources) m_vertices.push_back(m_vertices[source]);
+        adjacency = MeshNormals::BuildAdjacency(m_indicies.data(), m_indicies.size(), m_vertices.size());
     }
+
+    std::vector<float> tangents(m_vertices.size() * 4);
+    MeshTangents::ComputeTangents(tangents.data(), &m_vertices[0].position.x, &m_vertices[0].normal.x, &m_vertices[0].uv.x,
+        m_vertices.size(), sizeof(Vertex), m_indicies.data(), m_indicies.size(), adjacency);
+    m_tangents.resize(m_vertices.size());
+    MeshTangents::PackTangents(m_tangents.data(), tangents.data(), m_vertices.size());
 }
 
-std::vector<Vertex> Model::GetVertices() const
+Util::Span<const Vertex> Model::GetVertices() const
 {
     return m_vertices;
 }
-std::vector<uint32_t> Model::GetIndicies() const
+Util::Span<const uint32_t> Model::GetIndicies() const
 {
     return m_indicies;
 }
+std::vector<Vertex> Model::TakeVertices()
+{
+    return std::move(m_vertices);
+}
+std::vector<uint32_t> Model::TakeIndicies()
+{
+    return std::move(m_indicies);
+}
 uint32_t Model::GetVerticesNum() const
 {
     return m_vertices.size();
@@ -101,4 +404,113 @@ uint32_t Model::GetVerticesNum() const
 uint32_t Model::GetIndiciesNum() const
 {
     return m_indicies.size();
+}
+IndexFormat Model::GetIndexFormat() const
+{
+    return m_indexFormat;
+}
+uint32_t Model::GetIndexStride() const
+{
+    return m_indexFormat == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+const void* Model::GetIndexData() const
+{
+    return m_indexFormat == IndexFormat::UInt16 ? static_cast<const void*>(m_indicies16.data()) : m_indicies.data();
+}
+Util::Span<const Submesh> Model::GetSubmeshes() const
+{
+    return m_submeshes;
+}
+VertexFormat Model::GetVertexFormat() const
+{
+    return m_vertexFormat;
+}
+uint32_t Model::GetVertexStride() const
+{
+    return m_vertexFormat == VertexFormat::Quantized ? sizeof(VertexQuantizer::QuantizedVertex) : sizeof(Vertex);
+}
+const void* Model::GetVertexData() const
+{
+    return m_vertexFormat == VertexFormat::Quantized ? static_cast<const void*>(m_quantizedVertices.data()) : m_vertices.data();
+}
+void Model::GetPositionDecode(XMFLOAT3& scale, XMFLOAT3& offset) const
+{
+    scale = XMFLOAT3(m_quantization.scale[0], m_quantization.scale[1], m_quantization.scale[2]);
+    offset = XMFLOAT3(m_quantization.offset[0], m_quantization.offset[1], m_quantization.offset[2]);
+}
+void Model::GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const
+{
+    boundsMin = m_boundsMin;
+    boundsMax = m_boundsMax;
+}
+void Model::GetBoundingSphere(XMFLOAT3& center, float& radius) const
+{
+    center = XMFLOAT3(m_boundingSphere.x, m_boundingSphere.y, m_boundingSphere.z);
+    radius = m_boundingSphere.w;
+}
+Util::Span<const uint32_t> Model::GetTangents() const
+{
+    return m_tangents;
+}
+const MeshletBuilder::MeshletData& Model::GetMeshlets() const
+{
+    return m_meshlets;
+}
+
+void Model::GenerateLods(Util::Span<const float> ratios, const MeshSimplifier::Options& options)
+{
+    m_lods.clear();
+    // 地板的两个三角形在索引最后
+    if (m_indicies.size() <= 6) return;
+    size_t indexCount = m_indicies.size() - 6;
+    m_lods = MeshSimplifier::GenerateLods(m_indicies.data(), indexCount,
+        &m_vertices[0].position.x, &m_vertices[0].normal.x, &m_vertices[0].uv.x, m_vertices.size(), sizeof(Vertex),
+        ratios.data(), ratios.size(), options);
+}
+Util::Span<const MeshSimplifier::LodLevel> Model::GetLods() const
+{
+    return m_lods;
+}
+void Model::BuildBvh()
+{
+    m_bvh = MeshBvh::Bvh4();
+    // 地板的两个三角形在索引最后
+    if (m_indicies.size() <= 6) return;
+    size_t indexCount = m_indicies.size() - 6;
+    auto bvh = MeshBvh::Build(m_indicies.data(), indexCount, &m_vertices[0].position.x, m_vertices.size(), sizeof(Vertex));
+    m_bvh = MeshBvh::Collapse(bvh);
+}
+bool Model::HasBvh() const
+{
+    return !m_bvh.nodes.empty();
+}
+bool Model::Intersect(FXMVECTOR origin, FXMVECTOR direction, float tMax, ModelHit& hit) const
+{
+    // TakeVertices / TakeIndicies 之后不能再查询
+    if (m_bvh.nodes.empty() || m_vertices.empty()) return false;
+
+    MeshBvh::Ray ray;
+    XMFLOAT3 o, d;
+    XMStoreFloat3(&o, origin);
+    XMStoreFloat3(&d, direction);
+    ray.origin[0] = o.x; ray.origin[1] = o.y; ray.origin[2] = o.z;
+    ray.direction[0] = d.x; ray.direction[1] = d.y; ray.direction[2] = d.z;
+    ray.tMax = tMax;
+
+    MeshBvh::Hit bvhHit;
+    if (!MeshBvh::Intersect(m_bvh, ray, bvhHit)) return false;
+
+    hit.triangle = bvhHit.triangle;
+    hit.barycentrics = XMFLOAT2(bvhHit.u, bvhHit.v);
+    hit.t = bvhHit.t;
+    // 用重心坐标插值顶点，和渲染的三角形一致
+    auto& v0 = m_vertices[m_indicies[bvhHit.triangle * 3 + 0]].position;
+    auto& v1 = m_vertices[m_indicies[bvhHit.triangle * 3 + 1]].position;
+    auto& v2 = m_vertices[m_indicies[bvhHit.triangle * 3 + 2]].position;
+    float w = 1.f - bvhHit.u - bvhHit.v;
+    hit.position = XMFLOAT3(
+        w * v0.x + bvhHit.u * v1.x + bvhHit.v * v2.x,
+        w * v0.y + bvhHit.u * v1.y + bvhHit.v * v2.y,
+        w * v0.z + bvhHit.u * v1.z + bvhHit.v * v2.z);
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "ModelLoadQueue.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+ModelLoadHandle::ModelLoadHandle(ModelLoadDesc desc, LoadPriority priority, uint64_t sequence)
+    : m_desc(std::move(desc))
+    , m_priority(priority)
+    , m_sequence(sequence)
+    , m_future(m_promise.get_future().share())
+    , m_requestTime(std::chrono::high_resolution_clock::now())
+{
+}
+
+bool ModelLoadHandle::Transition(State from, State to)
+{
+    return m_state.compare_exchange_strong(from, to);
+}
+
+void ModelLoadHandle::Cancel()
+{
+    if (Transition(State::Queued, State::Cancelled) || Transition(State::Loading, State::Cancelled))
+    {
+        m_promise.set_exception(std::make_exception_ptr(std::runtime_error("model loading cancelled.")));
+    }
+}
+
+ModelLoadHandle::State ModelLoadHandle::GetState() const
+{
+    return m_state;
+}
+
+bool ModelLoadHandle::IsDone() const
+{
+    auto state = GetState();
+    return state != State::Queued && state != State::Loading;
+}
+
+std::shared_ptr<Model> ModelLoadHandle::Get() const
+{
+    return m_future.get();
+}
+
+std::shared_future<std::shared_ptr<Model>> ModelLoadHandle::GetFuture() const
+{
+    return m_future;
+}
+
+const ModelLoadDesc& ModelLoadHandle::GetDesc() const
+{
+    return m_desc;
+}
+
+LoadPriority ModelLoadHandle::GetPriority() const
+{
+    return m_priority;
+}
+
+double ModelLoadHandle::GetWaitSeconds() const
+{
+    return m_waitSeconds;
+}
+
+double ModelLoadHandle::GetLoadSeconds() const
+{
+    return m_loadSeconds;
+}
+
+std::chrono::high_resolution_clock::time_point ModelLoadHandle::GetRequestTime() const
+{
+    return m_requestTime;
+}
+
+ModelLoadQueue::ModelLoadQueue()
+{
+    m_worker = std::thread([this]() { Run(); });
+}
+
+ModelLoadQueue::~ModelLoadQueue()
+{
+    std::vector<std::shared_ptr<ModelLoadHandle>> queue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        queue.swap(m_queue);
+    }
+    for (auto& handle: queue) handle->Cancel();
+    m_queued.notify_all();
+    m_worker.join();
+}
+
+std::shared_ptr<ModelLoadHandle> ModelLoadQueue::Push(ModelLoadDesc desc, LoadPriority priority)
+{
+    std::shared_ptr<ModelLoadHandle> handle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        handle = std::make_shared<ModelLoadHandle>(std::move(desc), priority, m_sequence++);
+        m_queue.push_back(handle);
+    }
+    m_queued.notify_one();
+    return handle;
+}
+
+void ModelLoadQueue::Run()
+{
+    while (true)
+    {
+        std::shared_ptr<ModelLoadHandle> handle;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.wait(lock, [&]() { return m_quit || !m_queue.empty(); });
+            if (m_quit) return;
+
+            // 优先级最高的请求中最早提交的
+            auto next = std::min_element(m_queue.begin(), m_queue.end(), [](auto& a, auto& b)
+            {
+                if (a->m_priority != b->m_priority) return a->m_priority > b->m_priority;
+                return a->m_sequence < b->m_sequence;
+            });
+            handle = *next;
+            m_queue.erase(next);
+        }
+
+        // 排队时已经取消
+        if (!handle->Transition(ModelLoadHandle::State::Queued, ModelLoadHandle::State::Loading)) continue;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        handle->m_waitSeconds = std::chrono::duration<double>(t0 - handle->m_requestTime).count();
+        std::shared_ptr<Model> model;
+        std::exception_ptr error;
+        try
+        {
+            auto& desc = handle->m_desc;
+            model = std::make_shared<Model>(desc.model_name, desc.modelType, desc.reconstruct, desc.useCache,
+                desc.spatialSort, desc.vertexFormat, desc.tangents);
+            if (desc.bvh) model->BuildBvh();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        handle->m_loadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+
+        // 加载期间被取消时 promise 已经设置，结果直接丢弃
+        if (error)
+        {
+            if (handle->Transition(ModelLoadHandle::State::Loading, ModelLoadHandle::State::Failed))
+            {
+                handle->m_promise.set_exception(error);
+            }
+        }
+        else if (handle->Transition(ModelLoadHandle::State::Loading, ModelLoadHandle::State::Ready))
+        {
+            handle->m_promise.set_value(model);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#include "StreamingMesh.h"
+#include "path.h"
+#include "common/ModelLoader.h"
+
+#include <stdexcept>
+
+StreamingMesh::StreamingMesh(UploadRing::Device& device, uint32_t slotCount, size_t slotSize)
+    : m_ring(device, slotCount, slotSize)
+{
+}
+
+StreamingMesh::~StreamingMesh()
+{
+    Cancel();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void StreamingMesh::Start(std::wstring model_name, ModelType modelType)
+{
+    auto filePath = std::wstring(model_path) + model_name;
+    m_thread = std::thread([this, filePath, modelType]() mutable
+    {
+        try
+        {
+            auto loader = ModelLoader<float>::CreateModelLoader(modelType);
+            loader->SetStreamSink(this);
+            loader->LoadFromFile(filePath);
+        }
+        catch (...)
+        {
+            m_error = std::current_exception();
+        }
+        // 出错或取消时已经提交的部分仍然保留
+        m_ring.Finish();
+        m_finished = true;
+    });
+}
+
+void StreamingMesh::Cancel()
+{
+    m_cancelled = true;
+}
+
+void StreamingMesh::Wait()
+{
+    if (m_thread.joinable()) m_thread.join();
+    if (m_error) std::rethrow_exception(m_error);
+}
+
+bool StreamingMesh::IsFinished() const
+{
+    return m_finished;
+}
+
+void StreamingMesh::CheckCancelled() const
+{
+    if (m_cancelled) throw std::runtime_error("model loading cancelled.");
+}
+
+uint32_t StreamingMesh::GetVisibleVertexCount()
+{
+    return static_cast<uint32_t>(m_ring.GetVisibleBytes(UploadRing::Target::Vertex) / sizeof(Vertex));
+}
+
+uint32_t StreamingMesh::GetVisibleIndexCount()
+{
+    auto count = static_cast<uint32_t>(m_ring.GetVisibleBytes(UploadRing::Target::Index) / sizeof(uint32_t));
+    return count - count % 3;
+}
+
+MeshBounds::Aabb<float> StreamingMesh::GetBounds() const
+{
+    std::lock_guard<std::mutex> lock(m_boundsMutex);
+    return m_bounds;
+}
+
+const UploadRing::Stats& StreamingMesh::GetStats() const
+{
+    return m_ring.GetStats();
+}
+
+void StreamingMesh::OnBegin(size_t vertexCount, size_t indexCount)
+{
+    m_ring.Reserve(UploadRing::Target::Vertex, vertexCount * sizeof(Vertex));
+    m_ring.Reserve(UploadRing::Target::Index, indexCount * sizeof(uint32_t));
+}
+
+void StreamingMesh::OnPositions(const std::array<float, 3>* positions, size_t count)
+{
+    CheckCancelled();
+    MeshBounds::Aabb<float> bounds;
+    m_block.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        m_block[i].position = XMFLOAT3(positions[i][0], positions[i][1], positions[i][2]);
+        m_block[i].normal = XMFLOAT3(0.f, 0.f, 0.f);
+        m_block[i].uv = XMFLOAT2(0.f, 0.f);
+        bounds.Extend(positions[i].data());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_boundsMutex);
+        m_bounds.Merge(bounds);
+    }
+    m_ring.Append(UploadRing::Target::Vertex, m_block.data(), count * sizeof(Vertex));
+}
+
+void StreamingMesh::OnIndicies(const uint32_t* indicies, size_t count)
+{
+    CheckCancelled();
+    m_ring.Append(UploadRing::Target::Index, indicies, count * sizeof(uint32_t));
+}
+
+void StreamingMesh::OnEnd()
+{
+    m_ring.Flush();
+}
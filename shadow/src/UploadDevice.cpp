@@ -0,0 +1,96 @@
+#include "UploadDevice.h"
+#include "helper.h"
+
+D3D12UploadDevice::D3D12UploadDevice(ComPtr<ID3D12Device2> device)
+    : m_device(device)
+{
+    m_copyQueue = std::make_shared<CommandQueue>(m_device, D3D12_COMMAND_LIST_TYPE_COPY);
+}
+
+D3D12UploadDevice::~D3D12UploadDevice()
+{
+    m_copyQueue->Destory();
+    if (m_staging) m_staging->Unmap(0, nullptr);
+}
+
+void D3D12UploadDevice::CreateStaging(uint32_t slotCount, size_t slotSize)
+{
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(slotCount * slotSize),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_staging)));
+    // upload heap 可以一直 Map，CPU 只写不读
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_staging->Map(0, &readRange, reinterpret_cast<void**>(&m_stagingData)));
+    m_slotSize = slotSize;
+}
+
+uint8_t* D3D12UploadDevice::GetStaging(uint32_t slot)
+{
+    return m_stagingData + slot * m_slotSize;
+}
+
+void D3D12UploadDevice::Reserve(UploadRing::Target target, uint64_t bytes)
+{
+    auto t = static_cast<uint32_t>(target);
+    if (bytes <= m_capacity[t]) return;
+
+    // copy queue 只能访问 COMMON 状态的资源，buffer 在 direct queue 上会隐式提升为需要的状态
+    ComPtr<ID3D12Resource> buffer;
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(bytes),
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&buffer)));
+
+    ComPtr<ID3D12Resource> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+        previous = m_buffers[t];
+    }
+    // 已有内容在同一个 copy queue 上搬过去，排在之前所有拷贝之后
+    if (previous)
+    {
+        auto commandList = m_copyQueue->GetCommandList(nullptr);
+        commandList->CopyBufferRegion(buffer.Get(), 0, previous.Get(), 0, m_capacity[t]);
+        m_copyQueue->WaitForFenceValue(m_copyQueue->ExecuteCommandList(commandList));
+    }
+
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+    if (previous) m_retired.push_back(previous);
+    m_buffers[t] = buffer;
+    m_capacity[t] = bytes;
+}
+
+uint64_t D3D12UploadDevice::Copy(uint32_t slot, UploadRing::Target target, uint64_t offset, uint64_t size)
+{
+    ComPtr<ID3D12Resource> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+        buffer = m_buffers[static_cast<uint32_t>(target)];
+    }
+    auto commandList = m_copyQueue->GetCommandList(nullptr);
+    commandList->CopyBufferRegion(buffer.Get(), offset, m_staging.Get(), slot * m_slotSize, size);
+    return m_copyQueue->ExecuteCommandList(commandList);
+}
+
+bool D3D12UploadDevice::IsFenceComplete(uint64_t fence)
+{
+    return m_copyQueue->IsFenceComplete(fence);
+}
+
+void D3D12UploadDevice::WaitForFence(uint64_t fence)
+{
+    m_copyQueue->WaitForFenceValue(fence);
+}
+
+ComPtr<ID3D12Resource> D3D12UploadDevice::GetBuffer(UploadRing::Target target) const
+{
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+    return m_buffers[static_cast<uint32_t>(target)];
+}
@@ -26,11 +26,16 @@ int CALLBACK wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdL
 
     auto app = Application::GetInstance();
 
-    // auto model = make_shared<Model>(L"bun_zipper.ply", ModelType::PLY, true);
-    auto model = make_shared<Model>(L"african_head.obj", ModelType::OBJ);
+    // 模型在后台加载，窗口和管线同时初始化，加载完成前显示占位模型
+    // auto request = app->LoadModelAsync({ L"bun_zipper.ply", ModelType::PLY, true });
+    auto request = app->LoadModelAsync({ L"african_head.obj", ModelType::OBJ, false, true, false, VertexFormat::Quantized, false, true });
+    app->SetPendingModel(request);
+    // auto model = make_shared<Model>(L"african_head.obj", ModelType::OBJ, false, true, false, VertexFormat::Quantized);
     // auto model = make_shared<Model>(L"box.obj", ModelType::OBJ);
     //auto model = make_shared<Model>(L"box.ply", ModelType::PLY);
-    app->SetModel(model);
+    // app->SetModel(model);
+    // 没有 SetModel / SetPendingModel 时窗口在后台流式加载，解析过程中逐步显示
+    // app->SetStreamingModel(L"bun_zipper.ply", ModelType::PLY);
 
     auto window = make_shared<DXWindow>(L"Learn DX12");
     auto hWnd = app->CreateWindow(hInstance, window.get());
@@ -0,0 +1,225 @@
+// TgaDecoder only: images are generated, encoded here and decoded again, so no texture files are needed.
+#include "common/TgaDecoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    int s_failures = 0;
+
+    void Check(bool condition, const char* what, uint32_t width, uint32_t height, uint32_t bitsPerPixel, bool rle, bool topDown)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s (%ux%u, %u bpp, %s, %s)\n", what, width, height, bitsPerPixel, rle ? "rle" : "raw",
+                topDown ? "top-down" : "bottom-up");
+            s_failures++;
+        }
+    }
+
+    struct Image
+    {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> rgba;      // top row first
+    };
+
+    // 随机长度的同色段加噪声，RLE 编码时两种包都会出现。同色段按存储顺序排，会跨过存储的行尾
+    Image MakeImage(uint32_t width, uint32_t height, bool topDown, std::mt19937& random)
+    {
+        Image image{width, height, std::vector<uint8_t>(size_t(width) * height * 4)};
+        size_t i = 0;
+        while (i < size_t(width) * height)
+        {
+            uint8_t color[4] = {uint8_t(random()), uint8_t(random()), uint8_t(random()), uint8_t(random())};
+            size_t run = random() % 4 == 0 ? 1 + random() % 300 : 1;
+            for (size_t k = 0; k < run && i < size_t(width) * height; k++, i++)
+            {
+                size_t row = i / width;
+                size_t y = topDown ? row : height - 1 - row;
+                std::memcpy(&image.rgba[(y * width + i % width) * 4], color, 4);
+            }
+        }
+        return image;
+    }
+
+    // 第 row 个存储行对应的图像行
+    const uint8_t* SourceRow(const Image& image, bool topDown, uint32_t row)
+    {
+        uint32_t y = topDown ? row : image.height - 1 - row;
+        return &image.rgba[size_t(y) * image.width * 4];
+    }
+
+    void PutPixel(std::vector<uint8_t>& out, const uint8_t* rgba, uint32_t bytesPerPixel)
+    {
+        out.push_back(rgba[2]);
+        out.push_back(rgba[1]);
+        out.push_back(rgba[0]);
+        if (bytesPerPixel == 4) out.push_back(rgba[3]);
+    }
+
+    // 像素按存储顺序连成一串编码，RLE 包不在行尾截断。crossingPackets 返回跨行的包数
+    std::vector<uint8_t> Encode(const Image& image, uint32_t bitsPerPixel, bool rle, bool topDown, size_t& crossingPackets)
+    {
+        std::vector<uint8_t> file(18, 0);
+        const char id[] = "test";
+        file[0] = sizeof(id) - 1;
+        file[2] = rle ? 10 : 2;
+        file[12] = uint8_t(image.width);
+        file[13] = uint8_t(image.width >> 8);
+        file[14] = uint8_t(image.height);
+        file[15] = uint8_t(image.height >> 8);
+        file[16] = uint8_t(bitsPerPixel);
+        file[17] = uint8_t((topDown ? 0x20 : 0) | (bitsPerPixel == 32 ? 8 : 0));
+        file.insert(file.end(), id, id + file[0]);
+
+        uint32_t bytesPerPixel = bitsPerPixel / 8;
+        std::vector<const uint8_t*> pixels;
+        for (uint32_t row = 0; row < image.height; row++)
+        {
+            const uint8_t* source = SourceRow(image, topDown, row);
+            for (uint32_t x = 0; x < image.width; x++) pixels.push_back(source + x * 4);
+        }
+        // 24 bpp 只比较 RGB
+        auto same = [&](size_t a, size_t b) { return std::memcmp(pixels[a], pixels[b], bytesPerPixel == 4 ? 4 : 3) == 0; };
+
+        crossingPackets = 0;
+        if (!rle)
+        {
+            for (auto pixel: pixels) PutPixel(file, pixel, bytesPerPixel);
+            return file;
+        }
+        size_t i = 0;
+        while (i < pixels.size())
+        {
+            size_t count = 1;
+            if (i + 1 < pixels.size() && same(i, i + 1))
+            {
+                while (count < 128 && i + count < pixels.size() && same(i, i + count)) count++;
+                file.push_back(uint8_t(0x80 | (count - 1)));
+                PutPixel(file, pixels[i], bytesPerPixel);
+            }
+            else
+            {
+                while (count < 128 && i + count < pixels.size() && !(i + count + 1 < pixels.size() && same(i + count, i + count + 1))) count++;
+                file.push_back(uint8_t(count - 1));
+                for (size_t k = 0; k < count; k++) PutPixel(file, pixels[i + k], bytesPerPixel);
+            }
+            if (i / image.width != (i + count - 1) / image.width) crossingPackets++;
+            i += count;
+        }
+        return file;
+    }
+
+    void TestImage(uint32_t width, uint32_t height, uint32_t bitsPerPixel, bool rle, bool topDown, std::mt19937& random)
+    {
+        Image image = MakeImage(width, height, topDown, random);
+        size_t crossingPackets;
+        auto file = Encode(image, bitsPerPixel, rle, topDown, crossingPackets);
+
+        TgaDecoder::Info info;
+        bool ok = TgaDecoder::ReadInfo(file.data(), file.size(), info);
+        Check(ok && info.width == width && info.height == height && info.bitsPerPixel == bitsPerPixel &&
+            info.rle == rle && info.topDown == topDown, "header", width, height, bitsPerPixel, rle, topDown);
+
+        // 行距比一行大，多出来的字节不能被写
+        const uint8_t guard = 0xcd;
+        size_t rowPitch = size_t(width) * 4 + 12;
+        std::vector<uint8_t> decoded(rowPitch * height, guard);
+        ok = TgaDecoder::Decode(file.data(), file.size(), decoded.data(), rowPitch);
+        bool same = ok;
+        bool padding = true;
+        for (uint32_t y = 0; y < height && same; y++)
+        {
+            const uint8_t* out = &decoded[y * rowPitch];
+            const uint8_t* expected = &image.rgba[size_t(y) * width * 4];
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t alpha = bitsPerPixel == 32 ? expected[x * 4 + 3] : 0xff;
+                same &= std::memcmp(out + x * 4, expected + x * 4, 3) == 0 && out[x * 4 + 3] == alpha;
+            }
+            for (size_t k = size_t(width) * 4; k < rowPitch; k++) padding &= out[k] == guard;
+        }
+        Check(ok, "decode succeeds", width, height, bitsPerPixel, rle, topDown);
+        Check(same, "pixels match", width, height, bitsPerPixel, rle, topDown);
+        Check(padding, "row padding untouched", width, height, bitsPerPixel, rle, topDown);
+        if (rle && height > 1) Check(crossingPackets > 0, "packets cross rows", width, height, bitsPerPixel, rle, topDown);
+
+        // 任何截断都要失败，不能越界读（用 sanitizer 运行时能发现）
+        bool truncated = true;
+        size_t step = std::max<size_t>(1, file.size() / 500);
+        for (size_t size = 0; size < file.size(); size += (size < 64 ? 1 : step))
+        {
+            std::vector<uint8_t> part(file.begin(), file.begin() + size);
+            truncated &= !TgaDecoder::Decode(part.data(), part.size(), decoded.data(), rowPitch);
+        }
+        std::vector<uint8_t> part(file.begin(), file.end() - 1);
+        truncated &= !TgaDecoder::Decode(part.data(), part.size(), decoded.data(), rowPitch);
+        Check(truncated, "truncated input fails", width, height, bitsPerPixel, rle, topDown);
+
+        Check(!TgaDecoder::Decode(file.data(), file.size(), decoded.data(), size_t(width) * 4 - 1), "short row pitch fails",
+            width, height, bitsPerPixel, rle, topDown);
+    }
+
+    void TestInvalid()
+    {
+        std::mt19937 random(7);
+        Image image = MakeImage(4, 4, false, random);
+        size_t crossingPackets;
+        auto valid = Encode(image, 32, false, false, crossingPackets);
+        TgaDecoder::Info info;
+
+        auto rejected = [&](size_t offset, uint8_t value)
+        {
+            auto file = valid;
+            file[offset] = value;
+            return !TgaDecoder::ReadInfo(file.data(), file.size(), info);
+        };
+        Check(rejected(2, 1), "color mapped rejected", 4, 4, 32, false, false);
+        Check(rejected(2, 3), "grayscale rejected", 4, 4, 32, false, false);
+        Check(rejected(16, 16), "16 bpp rejected", 4, 4, 32, false, false);
+        Check(rejected(17, 0x10), "right-to-left rejected", 4, 4, 32, false, false);
+        Check(rejected(12, 0) && rejected(14, 0), "empty image rejected", 4, 4, 32, false, false);
+        Check(!TgaDecoder::ReadInfo(valid.data(), 17, info), "short header rejected", 4, 4, 32, false, false);
+
+        // 游程包比剩下的像素多：不能写到最后一行之后
+        auto overrun = Encode(image, 32, true, false, crossingPackets);
+        overrun.resize(18 + overrun[0]);
+        const uint8_t run[] = {0xff, 1, 2, 3, 4};
+        overrun.insert(overrun.end(), run, run + sizeof(run));
+        std::vector<uint8_t> decoded(4 * 4 * 4);
+        Check(!TgaDecoder::Decode(overrun.data(), overrun.size(), decoded.data(), 16), "packet past the last row fails", 4, 4, 32, true, false);
+    }
+}
+
+int main()
+{
+    std::mt19937 random(2024);
+    const uint32_t sizes[][2] = {{1, 1}, {1, 9}, {3, 2}, {17, 5}, {130, 3}, {300, 200}};
+    for (auto& size: sizes)
+    {
+        for (uint32_t bitsPerPixel: {24u, 32u})
+        {
+            for (bool rle: {false, true})
+            {
+                for (bool topDown: {false, true})
+                {
+                    TestImage(size[0], size[1], bitsPerPixel, rle, topDown, random);
+                }
+            }
+        }
+    }
+    TestInvalid();
+
+    if (s_failures > 0)
+    {
+        std::printf("%d checks failed\n", s_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
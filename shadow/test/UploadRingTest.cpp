@@ -0,0 +1,178 @@
+// UploadRing + MemoryDevice only, no GPU and no Model.h, so it builds and runs on any platform.
+#include "common/UploadRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int s_failures = 0;
+
+    void Check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            s_failures++;
+        }
+    }
+
+    struct TestVertex
+    {
+        uint32_t id;
+        float position[3];
+    };
+
+    void TestInvalidArguments()
+    {
+        UploadRing::MemoryDevice device;
+        bool thrown = false;
+        try
+        {
+            UploadRing::Ring ring(device, 2, 1024);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        Check(thrown, "ring with 2 slots throws std::runtime_error");
+
+        UploadRing::MemoryDevice small;
+        small.CreateStaging(3, 64);
+        small.Reserve(UploadRing::Target::Vertex, 64);
+        thrown = false;
+        try
+        {
+            small.Copy(0, UploadRing::Target::Vertex, 32, 64);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        Check(thrown, "copy past the target throws std::runtime_error");
+    }
+
+    // 随机大小的顶点和索引交替追加，ring 比数据小得多、每次拷贝有延迟，生产者必须等待。
+    // 另一个线程同时读可见字节数，索引可见时它引用的顶点必须已经可见
+    void TestStreaming(uint32_t slotCount, size_t slotSize, std::chrono::microseconds latency)
+    {
+        std::mt19937 random(slotCount * 7919u + static_cast<uint32_t>(slotSize));
+        std::vector<TestVertex> vertices;
+        std::vector<uint32_t> indicies;
+        while (vertices.size() < 20000)
+        {
+            size_t count = 1 + random() % 300;
+            for (size_t i = 0; i < count; i++)
+            {
+                auto id = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(TestVertex{id, {float(id), float(id) * 0.5f, -float(id)}});
+            }
+            size_t triangles = random() % 200;
+            for (size_t i = 0; i < triangles * 3; i++)
+            {
+                indicies.push_back(static_cast<uint32_t>(random() % vertices.size()));
+            }
+        }
+
+        UploadRing::MemoryDevice device(latency);
+        UploadRing::Ring ring(device, slotCount, slotSize);
+
+        std::atomic<bool> done{false};
+        std::atomic<bool> monotonic{true};
+        std::atomic<bool> ordered{true};
+        std::thread consumer([&]()
+        {
+            uint64_t lastIndex = 0;
+            uint64_t lastVertex = 0;
+            while (!done)
+            {
+                // 先读索引再读顶点：顶点只会变多
+                uint64_t indexBytes = ring.GetVisibleBytes(UploadRing::Target::Index);
+                uint64_t vertexBytes = ring.GetVisibleBytes(UploadRing::Target::Vertex);
+                if (indexBytes < lastIndex || vertexBytes < lastVertex) monotonic = false;
+                for (uint64_t k = lastIndex / sizeof(uint32_t); k < indexBytes / sizeof(uint32_t); k++)
+                {
+                    if (indicies[k] >= vertexBytes / sizeof(TestVertex)) ordered = false;
+                }
+                lastIndex = indexBytes;
+                lastVertex = vertexBytes;
+                std::this_thread::yield();
+            }
+        });
+
+        size_t vertexOffset = 0;
+        size_t indexOffset = 0;
+        size_t seen = 0;
+        while (vertexOffset < vertices.size() || indexOffset < indicies.size())
+        {
+            // 追加到下一批索引引用的最大顶点为止
+            size_t indexEnd = std::min(indicies.size(), indexOffset + 3 * (1 + random() % 150));
+            for (size_t k = indexOffset; k < indexEnd; k++) seen = std::max<size_t>(seen, indicies[k] + 1);
+            if (indexEnd == indicies.size()) seen = vertices.size();
+            if (seen > vertexOffset)
+            {
+                ring.Append(UploadRing::Target::Vertex, vertices.data() + vertexOffset, (seen - vertexOffset) * sizeof(TestVertex));
+                vertexOffset = seen;
+            }
+            ring.Append(UploadRing::Target::Index, indicies.data() + indexOffset, (indexEnd - indexOffset) * sizeof(uint32_t));
+            indexOffset = indexEnd;
+            if (random() % 8 == 0) ring.Flush();
+        }
+        ring.Finish();
+        done = true;
+        consumer.join();
+
+        auto& stats = ring.GetStats();
+        auto& vertexBuffer = device.GetBuffer(UploadRing::Target::Vertex);
+        auto& indexBuffer = device.GetBuffer(UploadRing::Target::Index);
+        Check(ring.GetVisibleBytes(UploadRing::Target::Vertex) == vertices.size() * sizeof(TestVertex), "all vertex bytes visible");
+        Check(ring.GetVisibleBytes(UploadRing::Target::Index) == indicies.size() * sizeof(uint32_t), "all index bytes visible");
+        Check(vertexBuffer.size() >= vertices.size() * sizeof(TestVertex)
+            && std::memcmp(vertexBuffer.data(), vertices.data(), vertices.size() * sizeof(TestVertex)) == 0, "vertex buffer identical");
+        Check(indexBuffer.size() >= indicies.size() * sizeof(uint32_t)
+            && std::memcmp(indexBuffer.data(), indicies.data(), indicies.size() * sizeof(uint32_t)) == 0, "index buffer identical");
+        Check(monotonic, "visible bytes never decrease");
+        Check(ordered, "visible indices only reference visible vertices");
+
+        // 每个目标的拷贝首尾相接，都不超过一个 slot
+        uint64_t end[UploadRing::S_TARGET_COUNT] = {};
+        bool contiguous = true;
+        for (auto& copy: device.GetCopies())
+        {
+            auto t = static_cast<uint32_t>(copy.target);
+            contiguous &= copy.offset == end[t] && copy.size > 0 && copy.size <= slotSize && copy.slot < slotCount;
+            end[t] = copy.offset + copy.size;
+        }
+        Check(contiguous, "copies are contiguous per target and fit a slot");
+        Check(device.GetStagingHazards() == 0, "no slot written while its copy is queued");
+        Check(device.GetPeakStagingInFlight() <= slotCount * slotSize, "staging in flight bounded by the ring");
+        Check(stats.peakSlotsInFlight <= slotCount, "slots in flight bounded by the ring");
+        if (latency.count() > 0) Check(stats.stalls > 0, "producer waits for the GPU");
+
+        std::printf("ring %u x %zu: %llu copies, %llu stalls, peak %u slots in flight\n", slotCount, slotSize,
+            static_cast<unsigned long long>(stats.chunks), static_cast<unsigned long long>(stats.stalls), stats.peakSlotsInFlight);
+    }
+}
+
+int main()
+{
+    TestInvalidArguments();
+    TestStreaming(3, 4096, std::chrono::microseconds(50));
+    TestStreaming(4, 64 * 1024, std::chrono::microseconds(200));
+    TestStreaming(8, 1000, std::chrono::microseconds(0));
+
+    if (s_failures > 0)
+    {
+        std::printf("%d checks failed\n", s_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}